@@ -124,6 +124,8 @@ void ArduinoOutput::handleEvent (const EventChannel* eventInfo, const MidiMessag
         {
             if (inputChannel == -1 || eventChannel == inputChannel)
             {
+                LatencyProbe::markTimestamp (LatencyProbe::OUTPUT_HANDLED, ttl->getTimestamp());
+
                 if (eventId == 0)
                 {
                     arduino.sendDigital (outputChannel, ARD_LOW);
@@ -32,6 +32,7 @@ SpikeDetector::SpikeDetector()
       overflowBufferSize    (100)
     , currentElectrode      (-1)
     , uniqueID              (0)
+    , quantizeWaveforms     (false)
 {
     setProcessorType (PROCESSOR_TYPE_FILTER);
 
@@ -100,6 +101,7 @@ void SpikeDetector::createSpikeChannels()
 		}
 		SpikeChannel* spk = new SpikeChannel(SpikeChannel::typeFromNumChannels(nChans), this, chans);
 		spk->setNumSamples(elec->prePeakSamples, elec->postPeakSamples);
+		spk->setWaveformEncoding(quantizeWaveforms ? SpikeChannel::INT16_WAVEFORM : SpikeChannel::FLOAT_WAVEFORM);
 		spikeChannelArray.add(spk);
 	}
 }
@@ -575,8 +577,23 @@ bool SpikeDetector::samplesAvailable (int nSamples)
 }
 
 
+void SpikeDetector::setQuantizeWaveforms (bool quantize)
+{
+    quantizeWaveforms = quantize;
+}
+
+
+bool SpikeDetector::getQuantizeWaveforms() const
+{
+    return quantizeWaveforms;
+}
+
+
 void SpikeDetector::saveCustomParametersToXml (XmlElement* parentElement)
 {
+    XmlElement* waveformNode = parentElement->createNewChildElement ("WAVEFORMS");
+    waveformNode->setAttribute ("quantized", quantizeWaveforms);
+
     for (int i = 0; i < electrodes.size(); ++i)
     {
         XmlElement* electrodeNode = parentElement->createNewChildElement ("ELECTRODE");
@@ -609,7 +626,11 @@ void SpikeDetector::loadCustomParametersFromXml()
 
         forEachXmlChildElement (*parametersAsXml, xmlNode)
         {
-            if (xmlNode->hasTagName ("ELECTRODE"))
+            if (xmlNode->hasTagName ("WAVEFORMS"))
+            {
+                setQuantizeWaveforms (xmlNode->getBoolAttribute ("quantized", false));
+            }
+            else if (xmlNode->hasTagName ("ELECTRODE"))
             {
                 ++electrodeIndex;
 
@@ -143,6 +143,12 @@ public:
 
     double getChannelThreshold (int electrodeNum, int channelNum) const;
 
+    /** Sends the waveforms as int16 samples scaled by the bitVolts of their channels, which
+        halves the size of every spike. Takes effect on the next signal chain update. */
+    void setQuantizeWaveforms (bool quantize);
+
+    bool getQuantizeWaveforms() const;
+
 
 private:
 
@@ -175,6 +181,8 @@ private:
     OwnedArray<SimpleElectrode> electrodes;
     int uniqueID;
 
+    bool quantizeWaveforms;
+
     // void createSpikeEvent(int& peakIndex,
     // 					  int& electrodeNumber,
     // 					  int& currentChannel,
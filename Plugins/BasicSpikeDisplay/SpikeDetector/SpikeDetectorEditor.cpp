@@ -104,6 +104,14 @@ SpikeDetectorEditor::SpikeDetectorEditor(GenericProcessor* parentNode, bool useD
     e3->setBounds(130,110,70,10);
     electrodeEditorButtons.add(e3);
 
+    quantizeButton = new ElectrodeEditorButton("INT16",font);
+    quantizeButton->setClickingTogglesState(true);
+    quantizeButton->setTooltip("Send spike waveforms as 16-bit integers");
+    quantizeButton->setToggleState(processor->getQuantizeWaveforms(), dontSendNotification);
+    quantizeButton->addListener(this);
+    addAndMakeVisible(quantizeButton);
+    quantizeButton->setBounds(140,80,50,10);
+
     thresholdSlider = new ThresholdSlider(font);
     thresholdSlider->setBounds(200,35,75,75);
     addAndMakeVisible(thresholdSlider);
@@ -233,6 +241,22 @@ void SpikeDetectorEditor::buttonEvent(Button* button)
 
         return;
 
+    }
+    else if (button == quantizeButton)
+    {
+        if (acquisitionIsActive)
+        {
+            CoreServices::sendStatusMessage("Stop acquisition before changing the waveform format.");
+            quantizeButton->setToggleState(!button->getToggleState(), dontSendNotification);
+            return;
+        }
+
+        SpikeDetector* processor = (SpikeDetector*) getProcessor();
+        processor->setQuantizeWaveforms(button->getToggleState());
+
+		CoreServices::updateSignalChain(this);
+        return;
+
     }
     else if (button == plusButton)
     {
@@ -543,6 +567,9 @@ void SpikeDetectorEditor::comboBoxChanged(ComboBox* comboBox)
 
 void SpikeDetectorEditor::checkSettings()
 {
+    SpikeDetector* processor = (SpikeDetector*) getProcessor();
+    quantizeButton->setToggleState(processor->getQuantizeWaveforms(), dontSendNotification);
+
     electrodeList->setSelectedId(0);
     drawElectrodeButtons(0);
 
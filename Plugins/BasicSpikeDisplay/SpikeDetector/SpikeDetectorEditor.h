@@ -77,6 +77,7 @@ private:
     TriangleButton* upButton;
     TriangleButton* downButton;
     UtilityButton* plusButton;
+    ElectrodeEditorButton* quantizeButton;
 
     ThresholdSlider* thresholdSlider;
 
@@ -0,0 +1,372 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2019 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SpikeDensityRenderer.h"
+
+#include <cmath>
+
+// spikes queued per electrode between two frames of the renderer
+static const int spikeQueueSize = 64;
+// longest waveform that is drawn, per channel
+static const int maxSpikeSamples = 256;
+
+static const int waveformRows = 128;
+static const int columnsPerSample = 4;
+static const int projectionSize = 128;
+
+// time for a waveform drawn once to fade to half its brightness
+static const double waveformHalfLife = 1.0;
+// densities are scaled to the densest pixel, but no further than this, so that
+// waveforms that are no longer seen fade out instead of being brightened
+static const float minFullDensity = 16.0f;
+static const int frameInterval = 30; // ms
+
+
+SpikeDensity::SpikeDensity(int numChannels_) :
+    numChannels(numChannels_), numProjections(numChannels_ * (numChannels_ - 1) / 2),
+    spikeQueue(spikeQueueSize), channelsToClear(0), projectionsToClear(false),
+    numSpikeSamples(0), numColumns(0), projectionsChanged(false)
+{
+    queuedSpikes.malloc(spikeQueueSize * numChannels * maxSpikeSamples);
+    queuedSpikeSamples.malloc(spikeQueueSize);
+
+    rowPositions.malloc(maxSpikeSamples);
+    peaks.malloc(numChannels);
+
+    if (numProjections > 0)
+        projectionHistograms.calloc(numProjections * projectionSize * projectionSize);
+
+    for (int i = 0; i < numChannels; i++)
+    {
+        ranges.add(250.0f);
+        currentRanges.add(250.0f);
+        waveformImages.add(Image());
+        waveformBackImages.add(Image());
+    }
+
+    for (int i = 0; i < numProjections; i++)
+    {
+        projectionImages.add(Image());
+        projectionBackImages.add(Image());
+    }
+
+    // Densities are shown on a log scale, so a waveform seen once is still visible next
+    // to the ones seen thousands of times. Pixels are white, premultiplied by their alpha
+    for (int i = 0; i < 256; i++)
+    {
+        const uint32 alpha = (uint32) roundToInt(255.0 * std::log1p(i / 4.0) / std::log1p(255 / 4.0));
+        alphaTable[i] = alpha * 0x01010101;
+    }
+}
+
+SpikeDensity::~SpikeDensity()
+{
+}
+
+int SpikeDensity::getNumChannels() const
+{
+    return numChannels;
+}
+
+int SpikeDensity::getNumProjections() const
+{
+    return numProjections;
+}
+
+void SpikeDensity::getProjectionChannels(int projection, int nChannels, int* channel1, int* channel2)
+{
+    // pairs in the order (0,1), (0,2), (0,3), (1,2), (1,3), (2,3)
+    for (int i = 0; i < nChannels; i++)
+    {
+        for (int j = i + 1; j < nChannels; j++)
+        {
+            if (projection-- == 0)
+            {
+                *channel1 = i;
+                *channel2 = j;
+                return;
+            }
+        }
+    }
+
+    *channel1 = -1;
+    *channel2 = -1;
+}
+
+void SpikeDensity::addSpike(const SpikeEventView& spike)
+{
+    const int numSamples = spike.getChannelInfo()->getTotalSamples();
+
+    if (numSamples > maxSpikeSamples || (int) spike.getChannelInfo()->getNumChannels() != numChannels)
+        return;
+
+    int start1, size1, start2, size2;
+    spikeQueue.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 == 0)
+        return;
+
+    spike.copyWaveform(queuedSpikes + start1 * numChannels * maxSpikeSamples);
+    queuedSpikeSamples[start1] = numSamples;
+
+    spikeQueue.finishedWrite(1);
+}
+
+void SpikeDensity::setRange(int channel, float range)
+{
+    const ScopedLock sl(lock);
+
+    if (ranges[channel] != range)
+    {
+        ranges.set(channel, range);
+        channelsToClear |= 1 << channel;
+        projectionsToClear = true;
+    }
+}
+
+void SpikeDensity::clear()
+{
+    const ScopedLock sl(lock);
+
+    channelsToClear = (1 << numChannels) - 1;
+    projectionsToClear = true;
+}
+
+Image SpikeDensity::getWaveformImage(int channel) const
+{
+    const ScopedLock sl(lock);
+    return waveformImages[channel];
+}
+
+Image SpikeDensity::getProjectionImage(int projection) const
+{
+    const ScopedLock sl(lock);
+    return projectionImages[projection];
+}
+
+void SpikeDensity::resizeWaveformHistograms(int numSamples)
+{
+    numSpikeSamples = numSamples;
+    numColumns = (numSamples - 1) * columnsPerSample + 1;
+
+    waveformHistograms.calloc(numChannels * waveformRows * numColumns);
+}
+
+void SpikeDensity::rasterizeWaveform(float* histogram, const float* data, int numSamples, float range)
+{
+    // row of each sample, with positive values at the top
+    FloatVectorOperations::copyWithMultiply(rowPositions, data, -waveformRows / range, numSamples);
+    FloatVectorOperations::add(rowPositions, waveformRows * 0.5f, numSamples);
+
+    int previousRow = 0;
+
+    for (int column = 0; column < numColumns; column++)
+    {
+        const int sample = column / columnsPerSample;
+        const float fraction = (column % columnsPerSample) / (float) columnsPerSample;
+
+        float position = rowPositions[sample];
+
+        if (fraction > 0.0f)
+            position += fraction * (rowPositions[sample + 1] - position);
+
+        const int row = (int) std::floor(jlimit(-1.0f, (float) waveformRows, position));
+
+        // fills the rows between the previous point and this one, so the waveform stays connected
+        int first = row;
+
+        if (column > 0 && row != previousRow)
+            first = previousRow + (row > previousRow ? 1 : -1);
+
+        const int top = jmax(0, jmin(first, row));
+        const int bottom = jmin(waveformRows - 1, jmax(first, row));
+
+        for (int r = top; r <= bottom; r++)
+            histogram[r * numColumns + column] += 1.0f;
+
+        previousRow = row;
+    }
+}
+
+void SpikeDensity::renderImage(Image& image, const float* histogram, int width, int height)
+{
+    // an image still held by the message thread is left to it
+    if (! image.isValid() || image.getWidth() != width || image.getHeight() != height || image.getReferenceCount() > 1)
+        image = Image(Image::ARGB, width, height, false, SoftwareImageType());
+
+    const float maxDensity = FloatVectorOperations::findMaximum(histogram, width * height);
+    const float scale = 255.0f / jmax(maxDensity, minFullDensity);
+
+    Image::BitmapData pixels(image, Image::BitmapData::writeOnly);
+
+    for (int y = 0; y < height; y++)
+    {
+        uint32* line = reinterpret_cast<uint32*>(pixels.getLinePointer(y));
+        const float* densities = histogram + y * width;
+
+        for (int x = 0; x < width; x++)
+            line[x] = alphaTable[(int) (densities[x] * scale)];
+    }
+}
+
+void SpikeDensity::update(double elapsedSeconds)
+{
+    uint32 clearChannels;
+    bool clearProjections;
+
+    {
+        const ScopedLock sl(lock);
+
+        currentRanges = ranges;
+        clearChannels = channelsToClear;
+        clearProjections = projectionsToClear;
+        channelsToClear = 0;
+        projectionsToClear = false;
+    }
+
+    const int waveformSize = waveformRows * numColumns;
+
+    for (int ch = 0; ch < numChannels && numColumns > 0; ch++)
+    {
+        if (clearChannels & (1 << ch))
+            FloatVectorOperations::clear(waveformHistograms + ch * waveformSize, waveformSize);
+    }
+
+    if (clearProjections && numProjections > 0)
+    {
+        FloatVectorOperations::clear(projectionHistograms, numProjections * projectionSize * projectionSize);
+        projectionsChanged = true;
+    }
+
+    // older waveforms fade out
+    if (numColumns > 0)
+    {
+        FloatVectorOperations::multiply(waveformHistograms, (float) std::pow(0.5, elapsedSeconds / waveformHalfLife),
+                                        numChannels * waveformSize);
+    }
+
+    int start1, size1, start2, size2;
+    const int numQueued = spikeQueue.getNumReady();
+    spikeQueue.prepareToRead(numQueued, start1, size1, start2, size2);
+
+    for (int i = 0; i < numQueued; i++)
+    {
+        const int slot = i < size1 ? start1 + i : start2 + i - size1;
+        const float* data = queuedSpikes + slot * numChannels * maxSpikeSamples;
+        const int numSamples = queuedSpikeSamples[slot];
+
+        if (numSamples < 2)
+            continue;
+
+        if (numSamples != numSpikeSamples)
+            resizeWaveformHistograms(numSamples);
+
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            const float* channelData = data + ch * numSamples;
+
+            rasterizeWaveform(waveformHistograms + ch * waveformRows * numColumns, channelData, numSamples, currentRanges[ch]);
+            peaks[ch] = FloatVectorOperations::findMaximum(channelData, numSamples);
+        }
+
+        for (int p = 0; p < numProjections; p++)
+        {
+            int ch1, ch2;
+            getProjectionChannels(p, numChannels, &ch1, &ch2);
+
+            const int x = (int) (peaks[ch1] / currentRanges[ch1] * projectionSize);
+            const int y = projectionSize - 1 - (int) (peaks[ch2] / currentRanges[ch2] * projectionSize);
+
+            if (x >= 0 && x < projectionSize && y >= 0 && y < projectionSize)
+                projectionHistograms[(p * projectionSize + y) * projectionSize + x] += 1.0f;
+        }
+
+        projectionsChanged = true;
+    }
+
+    spikeQueue.finishedRead(numQueued);
+
+    if (numColumns == 0)
+        return;
+
+    for (int ch = 0; ch < numChannels; ch++)
+        renderImage(waveformBackImages.getReference(ch), waveformHistograms + ch * waveformSize, numColumns, waveformRows);
+
+    if (projectionsChanged)
+    {
+        for (int p = 0; p < numProjections; p++)
+            renderImage(projectionBackImages.getReference(p), projectionHistograms + p * projectionSize * projectionSize,
+                        projectionSize, projectionSize);
+    }
+
+    const ScopedLock sl(lock);
+
+    waveformImages.swapWith(waveformBackImages);
+
+    if (projectionsChanged)
+        projectionImages.swapWith(projectionBackImages);
+
+    projectionsChanged = false;
+}
+
+// --------------------------------------------------
+
+SpikeDensityRenderer::SpikeDensityRenderer() : Thread("Spike density renderer")
+{
+}
+
+SpikeDensityRenderer::~SpikeDensityRenderer()
+{
+    stopThread(1000);
+}
+
+void SpikeDensityRenderer::addDensity(SpikeDensity* density)
+{
+    const ScopedLock sl(densityLock);
+    densities.addIfNotAlreadyThere(density);
+}
+
+void SpikeDensityRenderer::removeDensity(SpikeDensity* density)
+{
+    const ScopedLock sl(densityLock);
+    densities.removeFirstMatchingValue(density);
+}
+
+void SpikeDensityRenderer::run()
+{
+    double lastFrame = Time::getMillisecondCounterHiRes();
+
+    while (! threadShouldExit())
+    {
+        wait(frameInterval);
+
+        const double now = Time::getMillisecondCounterHiRes();
+        const double elapsedSeconds = (now - lastFrame) / 1000.0;
+        lastFrame = now;
+
+        const ScopedLock sl(densityLock);
+
+        for (int i = 0; i < densities.size(); i++)
+            densities[i]->update(elapsedSeconds);
+    }
+}
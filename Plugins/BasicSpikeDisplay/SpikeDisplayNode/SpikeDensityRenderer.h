@@ -0,0 +1,146 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2019 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SPIKEDENSITYRENDERER_H_
+#define SPIKEDENSITYRENDERER_H_
+
+#include <ProcessorHeaders.h>
+#include <VisualizerWindowHeaders.h>
+
+class SpikeDensityRenderer;
+
+/**
+
+  Accumulates the spikes of one electrode into density images: a 2D histogram of the
+  waveform of each channel, which fades over time, and one of the peak amplitudes of
+  each pair of channels, which is kept until it is cleared.
+
+  Spikes are queued by the processing thread and drawn into the histograms by the
+  SpikeDensityRenderer thread, so every spike costs the same to show however many
+  arrive between two repaints. The axes only blit the latest images.
+
+  @see SpikeDensityRenderer, WaveAxes, ProjectionAxes
+
+*/
+
+class SpikeDensity
+{
+public:
+    SpikeDensity(int numChannels);
+    ~SpikeDensity();
+
+    /** Queues a spike to be drawn. Called from the processing thread. Spikes that arrive
+        while the queue is full are not drawn */
+    void addSpike(const SpikeEventView& spike);
+
+    /** Sets the range of a channel, in microvolts. The histograms that use the channel are cleared */
+    void setRange(int channel, float range);
+
+    void clear();
+
+    int getNumChannels() const;
+    int getNumProjections() const;
+
+    /** Returns the latest image of a channel's waveforms, with positive values at the top */
+    Image getWaveformImage(int channel) const;
+
+    /** Returns the latest image of a projection, with the peaks of the first channel of the
+        pair along x and those of the second along y, from 0 at the bottom left */
+    Image getProjectionImage(int projection) const;
+
+    /** Returns the channels shown by a projection, in the order of the PROJ1x2... axes types */
+    static void getProjectionChannels(int projection, int numChannels, int* channel1, int* channel2);
+
+private:
+    friend class SpikeDensityRenderer;
+
+    /** Draws the queued spikes and renders new images. Called by the renderer thread */
+    void update(double elapsedSeconds);
+
+    void resizeWaveformHistograms(int numSamples);
+    void rasterizeWaveform(float* histogram, const float* data, int numSamples, float range);
+    void renderImage(Image& image, const float* histogram, int width, int height);
+
+    const int numChannels;
+    const int numProjections;
+
+    // spikes waiting to be drawn, each in a slot of numChannels * maxSpikeSamples floats
+    AbstractFifo spikeQueue;
+    HeapBlock<float> queuedSpikes;
+    HeapBlock<int> queuedSpikeSamples;
+
+    // settings changed by the message thread, guarded by lock
+    CriticalSection lock;
+    Array<float> ranges;
+    uint32 channelsToClear;
+    bool projectionsToClear;
+
+    Array<Image> waveformImages;
+    Array<Image> projectionImages;
+
+    // owned by the renderer thread
+    Array<float> currentRanges;
+    int numSpikeSamples;
+    int numColumns;
+    HeapBlock<float> waveformHistograms;
+    HeapBlock<float> projectionHistograms;
+    HeapBlock<float> rowPositions;
+    HeapBlock<float> peaks;
+    bool projectionsChanged;
+
+    Array<Image> waveformBackImages;
+    Array<Image> projectionBackImages;
+
+    uint32 alphaTable[256];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpikeDensity);
+};
+
+/**
+
+  The thread that draws the spikes of every SpikeDensity, at a steady rate.
+
+  @see SpikeDensity, SpikeDisplayCanvas
+
+*/
+
+class SpikeDensityRenderer : public Thread
+{
+public:
+    SpikeDensityRenderer();
+    ~SpikeDensityRenderer();
+
+    void addDensity(SpikeDensity* density);
+    void removeDensity(SpikeDensity* density);
+
+    void run() override;
+
+private:
+    CriticalSection densityLock;
+    Array<SpikeDensity*> densities;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpikeDensityRenderer);
+};
+
+
+#endif  // SPIKEDENSITYRENDERER_H_
@@ -28,6 +28,8 @@ SpikeDisplayCanvas::SpikeDisplayCanvas(SpikeDisplayNode* n) :
     processor(n), newSpike(false)
 {
 
+    densityRenderer = new SpikeDensityRenderer();
+
     viewport = new Viewport();
     spikeDisplay = new SpikeDisplay(this, viewport);
     thresholdCoordinator = new SpikeThresholdCoordinator();
@@ -73,6 +75,8 @@ void SpikeDisplayCanvas::beginAnimation()
 {
     std::cout << "SpikeDisplayCanvas beginning animation." << std::endl;
 
+    densityRenderer->startThread();
+
     startCallbacks();
 }
 
@@ -81,6 +85,13 @@ void SpikeDisplayCanvas::endAnimation()
     std::cout << "SpikeDisplayCanvas ending animation." << std::endl;
 
     stopCallbacks();
+
+    densityRenderer->stopThread(1000);
+}
+
+SpikeDensityRenderer* SpikeDisplayCanvas::getDensityRenderer()
+{
+    return densityRenderer;
 }
 
 void SpikeDisplayCanvas::update()
@@ -451,9 +462,9 @@ void SpikeDisplay::invertSpikes(bool shouldInvert_)
     //std::cout << "Invert spikes? " << shouldInvert_ << std::endl;
 }
 
-void SpikeDisplay::plotSpike(const SpikeEvent* spike, int electrodeNum)
+void SpikeDisplay::plotSpike(const SpikeEventView& spike, int electrodeNum)
 {
-    spikePlots[electrodeNum]->processSpikeObject(spike);
+    spikePlots[electrodeNum]->addSpike(spike);
 }
 
 void SpikeDisplay::registerThresholdCoordinator(SpikeThresholdCoordinator* stc)
@@ -546,6 +557,9 @@ SpikePlot::SpikePlot(SpikeDisplayCanvas* sdc, int elecNum, int p, String name_)
             nChannels = 1;
     }
 
+    density = new SpikeDensity(nChannels);
+    canvas->getDensityRenderer()->addDensity(density);
+
     initAxes();
 
     for (int i = 0; i < nChannels; i++)
@@ -566,6 +580,8 @@ SpikePlot::~SpikePlot()
     {
         thresholdCoordinator->unregisterSpikePlot(this);
     }
+
+    canvas->getDensityRenderer()->removeDensity(density);
 }
 
 void SpikePlot::paint(Graphics& g)
@@ -582,33 +598,10 @@ void SpikePlot::paint(Graphics& g)
 
 }
 
-void SpikePlot::processSpikeObject(const SpikeEvent* s)
+void SpikePlot::addSpike(const SpikeEventView& s)
 {
-    // std::cout << "ElectrodePlot::processSpikeObject()" << std::endl;
-
-    // first, check if it's above threshold
-    // bool aboveThreshold = false;
-
-    // for (int i = 0; i < nWaveAx; i++)
-    // {
-    //     aboveThreshold = aboveThreshold | wAxes[i]->checkThreshold(s);
-    // }
-
-    // if (aboveThreshold)
-    // {
-    for (int i = 0; i < nWaveAx; i++)
-        wAxes[i]->updateSpikeData(s);
-
-    for (int i = 0; i < nProjAx; i++)
-        pAxes[i]->updateSpikeData(s);
-    // }
-
-    //     if (aboveThreshold && isRecording)
-    //     {
-    //         // write spike to disk
-    //       writeSpike(s);
-    //     }
-
+    // the renderer thread draws it into the waveform and projection images
+    density->addSpike(s);
 }
 
 void SpikePlot::select()
@@ -627,7 +620,7 @@ void SpikePlot::initAxes()
 
     for (int i = 0; i < nWaveAx; i++)
     {
-        WaveAxes* wAx = new WaveAxes(WAVE1 + i);
+        WaveAxes* wAx = new WaveAxes(WAVE1 + i, density);
         wAxes.add(wAx);
         addAndMakeVisible(wAx);
         ranges.add(250.0f); // default range is 250 microvolts
@@ -635,7 +628,7 @@ void SpikePlot::initAxes()
 
     for (int i = 0; i < nProjAx; i++)
     {
-        ProjectionAxes* pAx = new ProjectionAxes(PROJ1x2 + i);
+        ProjectionAxes* pAx = new ProjectionAxes(PROJ1x2 + i, density);
         pAxes.add(pAx);
         addAndMakeVisible(pAx);
     }
@@ -727,17 +720,16 @@ void SpikePlot::setLimitsOnAxes()
 {
     //std::cout<<"SpikePlot::setLimitsOnAxes()"<<std::endl;
 
+    // The projections use the ranges of the two waveform dims they represent,
+    // which the density images share
     for (int i = 0; i < nWaveAx; i++)
+    {
         wAxes[i]->setRange(ranges[i]);
+        density->setRange(i, ranges[i]);
+    }
 
-    // Each projection sets its limits using the limits of the two waveform dims it represents.
-    // Convert projection number to indices, and then set the limits using those indices
-    int j1, j2;
     for (int i = 0; i < nProjAx; i++)
-    {
-        pAxes[i]->n2ProjIdx(pAxes[i]->getType(), &j1, &j2);
-        pAxes[i]->setRange(ranges[j1], ranges[j2]);
-    }
+        pAxes[i]->repaint();
 }
 
 void SpikePlot::initLimits()
@@ -777,6 +769,8 @@ void SpikePlot::clear()
 {
     std::cout << "SpikePlot::clear()" << std::endl;
 
+    density->clear();
+
     for (int i = 0; i < nWaveAx; i++)
         wAxes[i]->clear();
     for (int i = 0; i < nProjAx; i++)
@@ -863,13 +857,11 @@ void SpikePlot::invertSpikes(bool shouldInvert)
 // --------------------------------------------------
 
 
-WaveAxes::WaveAxes(int channel) : GenericAxes(channel),
+WaveAxes::WaveAxes(int channel, SpikeDensity* density_) : GenericAxes(channel),
     drawGrid(true),
     displayThresholdLevel(0.0f),
     detectorThresholdLevel(0.0f),
-    spikesReceivedSinceLastRedraw(0),
-    spikeIndex(0),
-    bufferSize(5),
+    density(density_),
     range(250.0f),
     isOverThresholdSlider(false),
     isDraggingThresholdSlider(false),
@@ -883,11 +875,6 @@ WaveAxes::WaveAxes(int channel) : GenericAxes(channel),
     thresholdColour = Colours::red;
 
     font = Font("Small Text",10,Font::plain);
-
-    for (int n = 0; n < bufferSize; n++)
-    {
-        spikeBuffer.add(nullptr);
-    }
 }
 
 void WaveAxes::setRange(float r)
@@ -912,91 +899,24 @@ void WaveAxes::paint(Graphics& g)
     if (drawGrid)
         drawWaveformGrid(g);
 
-    // draw the threshold line and labels
-    drawThresholdSlider(g);
-    //drawBoundingBox(g);
-
-    // if no spikes have been received then don't plot anything
-    if (!gotFirstSpike)
-    {
-        return;
-    }
-
+    // draw the density of the recent waveforms, flipped when the spikes are inverted
+    Image waveforms = density->getWaveformImage(type);
 
-    for (int spikeNum = 0; spikeNum < bufferSize; spikeNum++)
+    if (waveforms.isValid())
     {
+        float h = getHeight();
+        AffineTransform transform = AffineTransform::scale(getWidth() / float(waveforms.getWidth()),
+                                                           h / float(waveforms.getHeight()));
 
-        if (spikeNum != spikeIndex)
-        {
-            g.setColour(Colours::grey);
-            plotSpike(spikeBuffer[spikeNum], g);
-        }
+        if (spikesInverted)
+            transform = transform.scaled(1.0f, -1.0f).translated(0.0f, h);
 
+        g.drawImageTransformed(waveforms, transform);
     }
 
-    
-    plotSpike(spikeBuffer[spikeIndex], g);
-
-
-    spikesReceivedSinceLastRedraw = 0;
-
-}
-
-void WaveAxes::plotSpike(const SpikeEvent* s, Graphics& g)
-{
-	if (!s) return;
-
-    float h = getHeight();
-
-    //compute the spatial width for each waveform sample
-	int nSamples = s->getChannelInfo()->getTotalSamples();
-	float dx = getWidth() / float(nSamples);
-
-    //TODO: check for special metadata for this
-	//if (s.sortedId > 0)
-    //   g.setColour(Colour(s.color[0],s.color[1],s.color[2]));
-    //else
-       g.setColour(Colours::white);
-
-    // type corresponds to channel so we need to calculate the starting
-    // sample based upon which channel is getting plotted
-    int sampIdx = nSamples*type; //spikeBuffer[0].nSamples * type; //
-
-    int dSamples = 1;
-
-    float x = 0.0f;
-	const float* data = s->getDataPointer();
-
-	for (int i = 0; i < nSamples - 1; i++)
-	{
-		//std::cout << s.data[sampIdx] << std::endl;
-
-
-
-		float s1, s2;
-
-		if (spikesInverted)
-		{
-			s1 = h / 2 + data[sampIdx] / range * h;
-			s2 = h / 2 + data[sampIdx + 1] / range * h;
-		}
-		else
-		{
-			s1 = h / 2 - data[sampIdx] / range * h;
-			s2 = h / 2 - data[sampIdx + 1] / range * h;
-
-		}
-		g.drawLine(x,
-			s1,
-			x + dx,
-			s2);
-
-
-
-
-		sampIdx += dSamples;
-		x += dx;
-	}
+    // draw the threshold line and labels
+    drawThresholdSlider(g);
+    //drawBoundingBox(g);
 
 }
 
@@ -1044,31 +964,6 @@ void WaveAxes::drawWaveformGrid(Graphics& g)
 
 }
 
-bool WaveAxes::updateSpikeData(const SpikeEvent* s)
-{
-    if (!gotFirstSpike)
-    {
-        gotFirstSpike = true;
-    }
-
-    if (spikesReceivedSinceLastRedraw < bufferSize)
-    {
-
-        SpikeEvent* newSpike = new SpikeEvent(*s);
-
-        spikeIndex++;
-        spikeIndex %= bufferSize;
-
-        spikeBuffer.set(spikeIndex, newSpike);
-
-        spikesReceivedSinceLastRedraw++;
-
-    }
-
-    return true;
-
-}
-
 bool WaveAxes::checkThreshold(const SpikeEvent* s)
 {
 	int nSamples = s->getChannelInfo()->getTotalSamples();
@@ -1092,15 +987,6 @@ bool WaveAxes::checkThreshold(const SpikeEvent* s)
 
 void WaveAxes::clear()
 {
-
-    spikeBuffer.clear();
-    spikeIndex = 0;
-
-    for (int n = 0; n < bufferSize; n++)
-    {
-        spikeBuffer.add(nullptr);
-    }
-
     repaint();
 }
 
@@ -1234,113 +1120,26 @@ void WaveAxes::setDisplayThreshold(float threshold)
 
 // --------------------------------------------------
 
-ProjectionAxes::ProjectionAxes(int projectionNum) : GenericAxes(projectionNum), imageDim(500),
-    rangeX(250), rangeY(250), spikesReceivedSinceLastRedraw(0)
+ProjectionAxes::ProjectionAxes(int projectionNum, SpikeDensity* density_) : GenericAxes(projectionNum),
+    density(density_)
 {
-    projectionImage = Image(Image::RGB, imageDim, imageDim, true);
-
-    clear();
-    //Graphics g(projectionImage);
-    //g.setColour(Colours::red);
-    //g.fillEllipse(20, 20, 300, 200);
-
     n2ProjIdx(projectionNum, &ampDim1, &ampDim2);
-
-
-}
-
-void ProjectionAxes::setRange(float x, float y)
-{
-    rangeX = (int) x;
-    rangeY = (int) y;
-
-    //std::cout << "Setting range to " << x << " " << y << std::endl;
-
-    repaint();
 }
 
 void ProjectionAxes::paint(Graphics& g)
 {
-    //g.setColour(Colours::orange);
-    //g.fillRect(5,5,getWidth()-5, getHeight()-5);
-
-    g.drawImage(projectionImage,
-                0, 0, getWidth(), getHeight(),
-                0, imageDim-rangeY, rangeX, rangeY);
-}
-
-bool ProjectionAxes::updateSpikeData(const SpikeEvent* s)
-{
-    if (!gotFirstSpike)
-    {
-        gotFirstSpike = true;
-    }
-
-    int idx1, idx2;
-    calcWaveformPeakIdx(s, ampDim1, ampDim2, &idx1, &idx2);
-
-    // add peaks to image
-    Colour col;
-
-	//Again, fix this adding proper metadata check
-    //if (s.sortedId > 0)
-    //    col = Colour(s.color[0], s.color[1], s.color[2]);
-    //else
-        col = Colours::white;
-
-	const float* data = s->getDataPointer();
-    updateProjectionImage(data[idx1], data[idx2], 1, col);
-
-    return true;
-}
-
-void ProjectionAxes::updateProjectionImage(float x, float y, float gain, Colour col)
-{
-    Graphics g(projectionImage);
-
-    // h/2 + float(s.data[sampIdx]-32768)/float(*s.gain)*1000.0f / range * h;
-
-    if (gain != 0)
-    {
-		float xf = x;
-        float yf = float(imageDim) - y; // in microvolts
-
-        g.setColour(col);
-        g.fillEllipse(xf,yf,2.0f,2.0f);
-    }
-
-}
-
-void ProjectionAxes::calcWaveformPeakIdx(const SpikeEvent* s, int d1, int d2, int* idx1, int* idx2)
-{
+    g.fillAll(Colours::black);
 
-    float max1 = -1*pow(2.0,15);
-    float max2 = max1;
-	int nSamples = s->getChannelInfo()->getTotalSamples();
-	const float* data = s->getDataPointer();
+    Image projection = density->getProjectionImage(type - PROJ1x2);
 
-    for (int i = 0; i < nSamples; i++)
-    {
-        if (data[d1*nSamples + i] > max1)
-        {
-            *idx1 = d1*nSamples+i;
-            max1 = data[*idx1];
-        }
-        if (data[d2*nSamples+i] > max2)
-        {
-            *idx2 = d2*nSamples+i;
-            max2 = data[*idx2];
-        }
-    }
+    if (projection.isValid())
+        g.drawImage(projection,
+                    0, 0, getWidth(), getHeight(),
+                    0, 0, projection.getWidth(), projection.getHeight());
 }
 
-
-
 void ProjectionAxes::clear()
 {
-    projectionImage.clear(Rectangle<int>(0, 0, projectionImage.getWidth(), projectionImage.getHeight()),
-                          Colours::black);
-
     repaint();
 }
 
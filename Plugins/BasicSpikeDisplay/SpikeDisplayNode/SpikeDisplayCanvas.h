@@ -27,6 +27,7 @@
 #include <VisualizerWindowHeaders.h>
 
 #include "SpikeDisplayNode.h"
+#include "SpikeDensityRenderer.h"
 
 #include <vector>
 
@@ -104,8 +105,13 @@ public:
 
     void loadVisualizerParameters(XmlElement* xml);
 
+    SpikeDensityRenderer* getDensityRenderer();
+
 private:
 
+    // declared first, so it outlives the plots that use it
+    ScopedPointer<SpikeDensityRenderer> densityRenderer;
+
     ScopedPointer<SpikeDisplay> spikeDisplay;
     ScopedPointer<Viewport> viewport;
 
@@ -141,7 +147,7 @@ public:
 
     void mouseDown(const MouseEvent& event);
 
-    void plotSpike(const SpikeEvent* spike, int electrodeNum);
+    void plotSpike(const SpikeEventView& spike, int electrodeNum);
 
     void invertSpikes(bool);
 
@@ -204,7 +210,8 @@ public:
     void select();
     void deselect();
 
-    void processSpikeObject(const SpikeEvent* s);
+    /** Queues a spike to be drawn. Called from the processing thread */
+    void addSpike(const SpikeEventView& s);
 
     SpikeDisplayCanvas* canvas;
 
@@ -262,6 +269,8 @@ private:
 
     WeakReference<SpikeThresholdCoordinator> thresholdCoordinator;
 
+    ScopedPointer<SpikeDensity> density;
+
 };
 
 /**
@@ -314,23 +323,20 @@ protected:
 
 /**
 
-  Class for drawing spike waveforms.
+  Class for drawing spike waveforms, as the density image of the channel's recent spikes.
 
 */
 
 class WaveAxes : public GenericAxes
 {
 public:
-    WaveAxes(int channel);
+    WaveAxes(int channel, SpikeDensity* density);
     ~WaveAxes() {}
 
-    bool updateSpikeData(const SpikeEvent* s);
     bool checkThreshold(const SpikeEvent* spike);
 
     void paint(Graphics& g);
 
-    void plotSpike(const SpikeEvent* s, Graphics& g);
-
     void clear();
 
     void mouseMove(const MouseEvent& event);
@@ -374,14 +380,9 @@ private:
 
     void drawThresholdSlider(Graphics& g);
 
-    int spikesReceivedSinceLastRedraw;
-
     Font font;
 
-   OwnedArray<SpikeEvent> spikeBuffer;
-
-    int spikeIndex;
-    int bufferSize;
+    SpikeDensity* density;
 
     float range;
 
@@ -401,45 +402,27 @@ private:
 
 /**
 
-  Class for drawing the peak projections of spike waveforms.
+  Class for drawing the peak projections of spike waveforms, as a density image.
 
 */
 
 class ProjectionAxes : public GenericAxes
 {
 public:
-    ProjectionAxes(int projectionNum);
+    ProjectionAxes(int projectionNum, SpikeDensity* density);
     ~ProjectionAxes() {}
 
-    bool updateSpikeData(const SpikeEvent* s);
-
     void paint(Graphics& g);
 
     void clear();
 
-    void setRange(float, float);
-
     static void n2ProjIdx(int i, int* p1, int* p2);
 
 private:
 
-    void updateProjectionImage(float, float, float, Colour);
-
-    void calcWaveformPeakIdx(const SpikeEvent*, int, int, int*, int*);
-
     int ampDim1, ampDim2;
 
-    Image projectionImage;
-
-    Colour pointColour;
-    Colour gridColour;
-
-    int imageDim;
-
-    int rangeX;
-    int rangeY;
-
-    int spikesReceivedSinceLastRedraw;
+    SpikeDensity* density;
 
 };
 
@@ -29,7 +29,6 @@
 
 SpikeDisplayNode::SpikeDisplayNode()
     : GenericProcessor  ("Spike Viewer")
-    , displayBufferSize (5)
     ,  redrawRequested  (false)
     , isRecording       (false)
 {
@@ -61,8 +60,7 @@ void SpikeDisplayNode::updateSettings()
 		elec->numChannels = spikeChannelArray[i]->getNumChannels();
 		elec->bitVolts = spikeChannelArray[i]->getChannelBitVolts(0); //lets assume all channels have the same bitvolts
 		elec->name = spikeChannelArray[i]->getName();
-		elec->currentSpikeIndex = 0;
-		elec->mostRecentSpikes.ensureStorageAllocated(displayBufferSize);
+		elec->spikePlot = nullptr;
 
 		for (int j = 0; j < elec->numChannels; ++j)
 		{
@@ -195,6 +193,9 @@ void SpikeDisplayNode::process (AudioSampleBuffer& buffer)
         {
             Electrode* e = electrodes[i];
 
+            if (e->spikePlot == nullptr)
+                continue;
+
             // update thresholds
             for (int j = 0; j < e->numChannels; ++j)
             {
@@ -203,14 +204,6 @@ void SpikeDisplayNode::process (AudioSampleBuffer& buffer)
 
                 e->spikePlot->setDetectorThresholdForChannel (j, e->detectorThresholds[j]);
             }
-
-            // transfer buffered spikes to spike plot
-            for (int j = 0; j < e->currentSpikeIndex; ++j)
-            {
-                //std::cout << "Transferring spikes." << std::endl;
-                e->spikePlot->processSpikeObject (e->mostRecentSpikes[j]);
-                e->currentSpikeIndex = 0;
-            }
         }
 
         redrawRequested = false;
@@ -220,10 +213,10 @@ void SpikeDisplayNode::process (AudioSampleBuffer& buffer)
 
 void SpikeDisplayNode::handleSpike(const SpikeChannel* spikeInfo, const MidiMessage& event, int samplePosition)
 {
-	SpikeEventPtr newSpike = SpikeEvent::deserializeFromMessage(event, spikeInfo);
-	if (!newSpike) return;
+	SpikeEventView spike(event, spikeInfo);
+	if (!spike.isValid()) return;
 
-	int electrodeNum = getSpikeChannelIndex(newSpike);
+	int electrodeNum = getSpikeChannelIndex(spikeInfo->getSourceIndex(), spikeInfo->getSourceNodeID(), spikeInfo->getSubProcessorIdx());
 
 	Electrode* e = electrodes[electrodeNum];
 	// std::cout << electrodeNum << std::endl;
@@ -233,9 +226,9 @@ void SpikeDisplayNode::handleSpike(const SpikeChannel* spikeInfo, const MidiMess
 	// update threshold / check threshold
 	for (int i = 0; i < e->numChannels; ++i)
 	{
-		e->detectorThresholds.set(i, float(newSpike->getThreshold(i))); // / float(newSpike.gain[i]));
+		e->detectorThresholds.set(i, spike.getThreshold(i)); // / float(newSpike.gain[i]));
 
-		aboveThreshold = aboveThreshold | checkThreshold(i, e->displayThresholds[i], newSpike);
+		aboveThreshold = aboveThreshold | checkThreshold(i, e->displayThresholds[i], spike);
 	}
 
 	if (aboveThreshold)
@@ -245,26 +238,22 @@ void SpikeDisplayNode::handleSpike(const SpikeChannel* spikeInfo, const MidiMess
 		{
 			//CoreServices::RecordNode::writeSpike(newSpike, spikeInfo);
 		}
-		// add to buffer
-		if (e->currentSpikeIndex < displayBufferSize)
+		// every spike is queued for drawing, straight from the message
+		if (e->spikePlot != nullptr)
 		{
-			//This releases the spike from the smart pointer to avoid copies, so it's done latest.
-			e->mostRecentSpikes.set(e->currentSpikeIndex, newSpike.release());
-			e->currentSpikeIndex++;
+			e->spikePlot->addSpike(spike);
 		}
-
-		
 	}
 }
 
 
-bool SpikeDisplayNode::checkThreshold (int chan, float thresh, SpikeEvent* s)
+bool SpikeDisplayNode::checkThreshold (int chan, float thresh, const SpikeEventView& s)
 {
-	int nSamples = getSpikeChannel(getSpikeChannelIndex(s))->getTotalSamples();
+	int nSamples = s.getChannelInfo()->getTotalSamples();
 
     for (int i = 0; i < nSamples-1; ++i)
     {
-        if  (s->getDataPointer(chan)[i]  > thresh)
+        if  (s.getSample(chan, i)  > thresh)
         {
             return true;
         }
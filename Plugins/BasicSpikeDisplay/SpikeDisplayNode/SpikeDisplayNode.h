@@ -66,7 +66,7 @@ public:
     void addSpikePlotForElectrode (SpikePlot* sp, int i);
     void removeSpikePlots();
 
-    bool checkThreshold (int, float, SpikeEvent*);
+    bool checkThreshold (int, float, const SpikeEventView&);
 
 
 private:
@@ -76,13 +76,10 @@ private:
 
         int numChannels;
         int recordIndex;
-        int currentSpikeIndex;
 
         Array<float> displayThresholds;
         Array<float> detectorThresholds;
 
-        OwnedArray<SpikeEvent> mostRecentSpikes;
-
 		float bitVolts;
 
         SpikePlot* spikePlot;
@@ -90,7 +87,6 @@ private:
 
     OwnedArray<Electrode> electrodes;
 
-    int displayBufferSize;
     bool redrawRequested;
 
     // members for recording
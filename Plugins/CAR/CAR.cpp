@@ -22,6 +22,7 @@
 */
 
 #include <stdio.h>
+#include <algorithm>
 
 #include "CAR.h"
 #include "CAREditor.h"
@@ -29,10 +30,12 @@
 
 CAR::CAR()
     : GenericProcessor ("Common Avg Ref") //, threshold(200.0), state(true)
+    , m_referenceMode (MEAN_REFERENCE)
+    , m_numGroups (1)
 {
     setProcessorType (PROCESSOR_TYPE_FILTER);
 
-    m_avgBuffer = AudioSampleBuffer (1, 10000); // 1-dimensional buffer to hold the avg
+    m_avgBuffer = AudioSampleBuffer (1, CAR_TILE_SIZE); // 1-dimensional buffer to hold the avg of a tile
 }
 
 
@@ -63,45 +66,150 @@ void CAR::setGainLevel (float newGain)
 
 void CAR::process (AudioSampleBuffer& buffer)
 {
-    const int numSamples            = buffer.getNumSamples();
-    const int numReferenceChannels  = m_referenceChannels.size();
-    const int numAffectedChannels   = m_affectedChannels.size();
+    const ScopedLock myScopedLock (objectLock);
+
+    const int numSamples = buffer.getNumSamples();
+    const int numGroups  = m_groups.size();
 
     // There are no sense to do any processing if either number of reference or affected channels is zero.
-    if (! numReferenceChannels
-        || ! numAffectedChannels)
+    if (! numGroups)
     {
         return;
     }
 
-    m_avgBuffer.clear();
+    m_gainLevel.updateTarget();
+    const float gain = -1.0f * m_gainLevel.getNextValue() / 100.f;
+
+    float* reference = m_avgBuffer.getWritePointer (0);
 
-    for (int i = 0; i < numReferenceChannels; ++i)
+    for (int startSample = 0; startSample < numSamples; startSample += CAR_TILE_SIZE)
     {
-        m_avgBuffer.addFrom (0,                         // destChannel
-                             0,                         // destStartSample
-                             buffer,                    // source
-                             m_referenceChannels[i],    // sourceChannel
-                             0,                         // sourceStartSample
-                             numSamples,                // numSamples
-                             1.0f);                     // gain to apply
+        const int tileSize = jmin (CAR_TILE_SIZE, numSamples - startSample);
+
+        for (int g = 0; g < numGroups; ++g)
+        {
+            const ReferenceGroup* group = m_groups[g];
+            const int numReferenceChannels = group->referenceChannels.size();
+            float groupGain = gain;
+
+            if (m_referenceMode == MEDIAN_REFERENCE)
+            {
+                computeMedianReference (buffer, group->referenceChannels, startSample, tileSize, reference);
+            }
+            else
+            {
+                FloatVectorOperations::copy (reference,
+                                             buffer.getReadPointer (group->referenceChannels[0], startSample),
+                                             tileSize);
+
+                for (int i = 1; i < numReferenceChannels; ++i)
+                {
+                    FloatVectorOperations::add (reference,
+                                                buffer.getReadPointer (group->referenceChannels[i], startSample),
+                                                tileSize);
+                }
+
+                // the division by the number of channels is folded into the gain
+                groupGain /= float (numReferenceChannels);
+            }
+
+            for (int i = 0; i < group->affectedChannels.size(); ++i)
+            {
+                FloatVectorOperations::addWithMultiply (buffer.getWritePointer (group->affectedChannels[i], startSample),
+                                                        reference,
+                                                        groupGain,
+                                                        tileSize);
+            }
+        }
     }
+}
 
-    m_avgBuffer.applyGain (1.0f / float (numReferenceChannels));
 
-    m_gainLevel.updateTarget();
-    const float gain = -1.0f * m_gainLevel.getNextValue() / 100.f;
+void CAR::computeMedianReference (const AudioSampleBuffer& buffer, const Array<int>& channels,
+                                  int startSample, int numSamples, float* dest)
+{
+    const int numChannels = channels.size();
+
+    // transpose the tile so the values of each sample are contiguous
+    for (int i = 0; i < numChannels; ++i)
+    {
+        const float* src = buffer.getReadPointer (channels[i], startSample);
+        float* dst = m_medianBuffer + i;
+
+        for (int n = 0; n < numSamples; ++n)
+            dst[n * numChannels] = src[n];
+    }
+
+    const int middle = numChannels / 2;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        float* values = m_medianBuffer + n * numChannels;
+        std::nth_element (values, values + middle, values + numChannels);
+        float median = values[middle];
+
+        if ((numChannels & 1) == 0)
+            median = 0.5f * (median + *std::max_element (values, values + middle));
+
+        dest[n] = median;
+    }
+}
+
+
+void CAR::updateSettings()
+{
+    const ScopedLock myScopedLock (objectLock);
+
+    updateReferenceGroups();
+}
+
 
-    for (int i = 0; i < numAffectedChannels; ++i)
+void CAR::updateReferenceGroups()
+{
+    const int numChannels = getNumInputs();
+    const int numGroups = jmax (1, m_numGroups);
+
+    OwnedArray<ReferenceGroup> groups;
+    for (int g = 0; g < numGroups; ++g)
+        groups.add (new ReferenceGroup);
+
+    int maxReferenceChannels = 0;
+
+    if (numChannels > 0)
     {
-        buffer.addFrom (m_affectedChannels[i],  // destChannel
-                        0,                      // destStartSample
-                        m_avgBuffer,            // source
-                        0,                      // sourceChannel
-                        0,                      // sourceStartSample
-                        numSamples,             // numSamples
-                        gain);                  // gain to apply
+        for (int i = 0; i < m_referenceChannels.size(); ++i)
+        {
+            const int channel = m_referenceChannels[i];
+            if (channel < numChannels)
+                groups[channel * numGroups / numChannels]->referenceChannels.add (channel);
+        }
+
+        for (int i = 0; i < m_affectedChannels.size(); ++i)
+        {
+            const int channel = m_affectedChannels[i];
+            if (channel < numChannels)
+                groups[channel * numGroups / numChannels]->affectedChannels.add (channel);
+        }
     }
+
+    // groups without reference or affected channels need no processing
+    m_groups.clear();
+    while (groups.size() > 0)
+    {
+        ReferenceGroup* group = groups.removeAndReturn (0);
+
+        if (group->referenceChannels.size() > 0 && group->affectedChannels.size() > 0)
+        {
+            maxReferenceChannels = jmax (maxReferenceChannels, group->referenceChannels.size());
+            m_groups.add (group);
+        }
+        else
+        {
+            delete group;
+        }
+    }
+
+    m_medianBuffer.malloc (jmax (1, maxReferenceChannels) * CAR_TILE_SIZE);
 }
 
 
@@ -110,6 +218,7 @@ void CAR::setReferenceChannels (const Array<int>& newReferenceChannels)
     const ScopedLock myScopedLock (objectLock);
 
     m_referenceChannels = Array<int> (newReferenceChannels);
+    updateReferenceGroups();
 }
 
 
@@ -118,24 +227,50 @@ void CAR::setAffectedChannels (const Array<int>& newAffectedChannels)
     const ScopedLock myScopedLock (objectLock);
 
     m_affectedChannels = Array<int> (newAffectedChannels);
+    updateReferenceGroups();
 }
 
 
 void CAR::setReferenceChannelState (int channel, bool newState)
 {
+    const ScopedLock myScopedLock (objectLock);
+
     if (! newState)
         m_referenceChannels.removeFirstMatchingValue (channel);
     else
         m_referenceChannels.addIfNotAlreadyThere (channel);
+
+    updateReferenceGroups();
 }
 
 
 void CAR::setAffectedChannelState (int channel, bool newState)
 {
+    const ScopedLock myScopedLock (objectLock);
+
     if (! newState)
         m_affectedChannels.removeFirstMatchingValue (channel);
     else
         m_affectedChannels.addIfNotAlreadyThere (channel);
+
+    updateReferenceGroups();
+}
+
+
+void CAR::setReferenceMode (ReferenceMode newMode)
+{
+    const ScopedLock myScopedLock (objectLock);
+
+    m_referenceMode = newMode;
+}
+
+
+void CAR::setNumGroups (int newNumGroups)
+{
+    const ScopedLock myScopedLock (objectLock);
+
+    m_numGroups = jmax (1, newNumGroups);
+    updateReferenceGroups();
 }
 
 void CAR::saveCustomChannelParametersToXml(XmlElement* channelElement,
@@ -160,21 +295,31 @@ void CAR::loadCustomChannelParametersFromXml(XmlElement* channelElement,
 {
     if (channelType == InfoObjectCommon::DATA_CHANNEL)
     {
+        const ScopedLock myScopedLock (objectLock);
+
         int channelNumber = channelElement->getIntAttribute("number");
 
         forEachXmlChildElementWithTagName(*channelElement, groupState, "GROUPSTATE")
         {
             if (groupState->hasAttribute("reference"))
             {
-                bool isReferenceChannel = groupState->getBoolAttribute("reference");
-                setReferenceChannelState(channelNumber, isReferenceChannel);
+                if (groupState->getBoolAttribute("reference"))
+                    m_referenceChannels.addIfNotAlreadyThere (channelNumber);
+                else
+                    m_referenceChannels.removeFirstMatchingValue (channelNumber);
             }
 
             if (groupState->hasAttribute("affected"))
             {
-                bool isAffectedChannel = groupState->getBoolAttribute("affected");
-                setAffectedChannelState(channelNumber, isAffectedChannel);
+                if (groupState->getBoolAttribute("affected"))
+                    m_affectedChannels.addIfNotAlreadyThere (channelNumber);
+                else
+                    m_affectedChannels.removeFirstMatchingValue (channelNumber);
             }
         }
+
+        // the reference groups are built once, when the last channel has been loaded
+        if (channelElement->getNextElementWithTagName ("CHANNEL") == nullptr)
+            updateReferenceGroups();
     }
 }
\ No newline at end of file
@@ -31,10 +31,18 @@
 
 #include <ProcessorHeaders.h>
 
+/** Number of samples processed per tile. All the channels of a tile stay in cache
+    between computing the reference and subtracting it. */
+#define CAR_TILE_SIZE 128
+
 /**
     This is a simple filter that subtracts the average of all other channels from 
     each channel. The gain parameter allows you to subtract a percentage of the total avg.
 
+    The median can be used instead of the mean (common median reference), and the channels
+    can be split into contiguous groups (e.g. one per shank), each one referenced only to
+    the reference channels in its own group.
+
     See Ludwig et al. 2009 Using a common average reference to improve cortical
     neuron recordings from microelectrode arrays. J. Neurophys, 2009 for a detailed
     discussion
@@ -62,6 +70,15 @@ public:
     */
     void process (AudioSampleBuffer& buffer) override;
 
+    /** Called when the channel count changes, to recompute the reference groups */
+    void updateSettings() override;
+
+    enum ReferenceMode
+    {
+        MEAN_REFERENCE = 0,
+        MEDIAN_REFERENCE
+    };
+
     /** Returns the current gain level that is set in the processor */
     float getGainLevel();
 
@@ -80,6 +97,13 @@ public:
     void setReferenceChannelState (int channel, bool newState);
     void setAffectedChannelState  (int channel, bool newState);
 
+    ReferenceMode getReferenceMode() const      { return m_referenceMode; }
+    void setReferenceMode (ReferenceMode newMode);
+
+    /** Channels are split into this many contiguous groups, each referenced independently */
+    int getNumGroups() const                    { return m_numGroups; }
+    void setNumGroups (int newNumGroups);
+
     /** Saving/loading channel parameters */
     void saveCustomChannelParametersToXml(XmlElement* channelElement,
         int channelNumber, InfoObjectCommon::InfoObjectType channelType);
@@ -87,10 +111,32 @@ public:
         InfoObjectCommon::InfoObjectType channelType);
 
 private:
+    struct ReferenceGroup
+    {
+        Array<int> referenceChannels;
+        Array<int> affectedChannels;
+    };
+
+    /** Rebuilds m_groups from the channel selections. Must be called with objectLock held. */
+    void updateReferenceGroups();
+
+    /** Computes the median across the reference channels of a group for one tile */
+    void computeMedianReference (const AudioSampleBuffer& buffer, const Array<int>& channels,
+                                 int startSample, int numSamples, float* dest);
+
     LinearSmoothedValueAtomic<float> m_gainLevel;
 
+    /** Holds the reference of the group being processed for the current tile */
     AudioSampleBuffer m_avgBuffer;
 
+    /** Tile of reference samples transposed to sample-major order for the median */
+    HeapBlock<float> m_medianBuffer;
+
+    OwnedArray<ReferenceGroup> m_groups;
+
+    ReferenceMode m_referenceMode;
+    int m_numGroups;
+
     /** We should add this for safety to prevent any app crashes or invalid data processing.
         Since we use m_referenceChannels and m_affectedChannels arrays in the process() function,
         which works in audioThread, we may stumble upon the situation when we start changing
@@ -34,7 +34,9 @@ CAREditor::CAREditor (GenericProcessor* parentProcessor, bool useDefaultParamete
     : GenericEditor (parentProcessor, useDefaultParameterEditors)
     , m_currentChannelsView          (REFERENCE_CHANNELS)
     , m_channelSelectorButtonManager (new LinearButtonGroupManager)
+    , m_referenceModeButtonManager   (new LinearButtonGroupManager)
     , m_gainSlider                   (new ParameterSlider (0.0, 100.0, 100.0, Font("Default", 13.f, Font::plain)))
+    , m_numGroupsComboBox            (new ComboBox ("Groups"))
 {
     TextButton* referenceChannelsButton = new TextButton ("Reference", "Switch to reference channels");
     referenceChannelsButton->setClickingTogglesState (true);
@@ -61,6 +63,38 @@ CAREditor::CAREditor (GenericProcessor* parentProcessor, bool useDefaultParamete
     m_channelSelectorButtonManager->setColour (LinearButtonGroupManager::accentColourId, COLOUR_ACCENT);
     addAndMakeVisible (m_channelSelectorButtonManager);
 
+    TextButton* meanButton = new TextButton ("Mean", "Subtract the mean of the reference channels");
+    meanButton->setClickingTogglesState (true);
+    meanButton->setToggleState (true, dontSendNotification);
+    meanButton->setColour (TextButton::buttonColourId,     Colour (0x0));
+    meanButton->setColour (TextButton::buttonOnColourId,   Colour (0x0));
+    meanButton->setColour (TextButton::textColourOffId,    COLOUR_PRIMARY);
+    meanButton->setColour (TextButton::textColourOnId,     COLOUR_ACCENT);
+
+    TextButton* medianButton = new TextButton ("Median", "Subtract the median of the reference channels");
+    medianButton->setClickingTogglesState (true);
+    medianButton->setColour (TextButton::buttonColourId,     Colour (0x0));
+    medianButton->setColour (TextButton::buttonOnColourId,   Colour (0x0));
+    medianButton->setColour (TextButton::textColourOffId,    COLOUR_PRIMARY);
+    medianButton->setColour (TextButton::textColourOnId,     COLOUR_ACCENT);
+
+    m_referenceModeButtonManager->addButton (meanButton);
+    m_referenceModeButtonManager->addButton (medianButton);
+    m_referenceModeButtonManager->setRadioButtonMode (true);
+    m_referenceModeButtonManager->setButtonListener (this);
+    m_referenceModeButtonManager->setButtonsLookAndFeel (m_materialButtonLookAndFeel);
+    m_referenceModeButtonManager->setColour (ButtonGroupManager::backgroundColourId,   Colours::white);
+    m_referenceModeButtonManager->setColour (ButtonGroupManager::outlineColourId,      Colour (0x0));
+    m_referenceModeButtonManager->setColour (LinearButtonGroupManager::accentColourId, COLOUR_ACCENT);
+    addAndMakeVisible (m_referenceModeButtonManager);
+
+    for (int i = 1; i <= 8; ++i)
+        m_numGroupsComboBox->addItem (String (i) + (i == 1 ? " group" : " groups"), i);
+    m_numGroupsComboBox->setSelectedId (1, dontSendNotification);
+    m_numGroupsComboBox->setTooltip ("Split the channels into contiguous groups (e.g. shanks), each referenced independently");
+    m_numGroupsComboBox->addListener (this);
+    addAndMakeVisible (m_numGroupsComboBox);
+
     m_gainSlider->setColour (Slider::rotarySliderFillColourId, Colour::fromRGB (255, 193, 7));
     m_gainSlider->setName ("Gain (%)");
     m_gainSlider->addListener (this);
@@ -93,7 +127,9 @@ void CAREditor::paint (Graphics& g)
 
 void CAREditor::resized()
 {
-    m_channelSelectorButtonManager->setBounds (110, 50, 150, 36);
+    m_channelSelectorButtonManager->setBounds (110, 30, 150, 30);
+    m_referenceModeButtonManager->setBounds   (110, 66, 150, 26);
+    m_numGroupsComboBox->setBounds            (110, 98, 150, 20);
 
     m_gainSlider->setBounds (15, 30, 80, 80);
 
@@ -119,6 +155,14 @@ void CAREditor::buttonClicked (Button* buttonThatWasClicked)
 
         m_currentChannelsView = AFFECTED_CHANNELS;
     }
+    else if (buttonName.startsWith ("mean"))
+    {
+        static_cast<CAR*> (getProcessor())->setReferenceMode (CAR::MEAN_REFERENCE);
+    }
+    else if (buttonName.startsWith ("median"))
+    {
+        static_cast<CAR*> (getProcessor())->setReferenceMode (CAR::MEDIAN_REFERENCE);
+    }
 
     GenericEditor::buttonClicked (buttonThatWasClicked);
 }
@@ -138,6 +182,15 @@ void CAREditor::channelChanged (int channel, bool newState)
 }
 
 
+void CAREditor::comboBoxChanged (ComboBox* comboBoxThatHasChanged)
+{
+    if (comboBoxThatHasChanged == m_numGroupsComboBox)
+    {
+        static_cast<CAR*> (getProcessor())->setNumGroups (m_numGroupsComboBox->getSelectedId());
+    }
+}
+
+
 void CAREditor::sliderEvent (Slider* sliderWhichValueHasChanged)
 {
     auto processor = static_cast<CAR*> (getProcessor());
@@ -153,6 +206,8 @@ void CAREditor::saveCustomParameters(XmlElement* xml)
 
     XmlElement* paramValues = xml->createNewChildElement("VALUES");
     paramValues->setAttribute("gainLevel", processor->getGainLevel());
+    paramValues->setAttribute("referenceMode", (int) processor->getReferenceMode());
+    paramValues->setAttribute("numGroups", processor->getNumGroups());
 }
 
 void CAREditor::loadCustomParameters(XmlElement* xml)
@@ -163,5 +218,11 @@ void CAREditor::loadCustomParameters(XmlElement* xml)
     {
         double gain = xmlNode->getDoubleAttribute("gainLevel", m_gainSlider->getValue());
         m_gainSlider->setValue(gain, sendNotificationSync);
+
+        const bool useMedian = xmlNode->getIntAttribute("referenceMode", CAR::MEAN_REFERENCE) == CAR::MEDIAN_REFERENCE;
+        processor->setReferenceMode(useMedian ? CAR::MEDIAN_REFERENCE : CAR::MEAN_REFERENCE);
+        m_referenceModeButtonManager->getButtonAt(useMedian ? 1 : 0)->setToggleState(true, dontSendNotification);
+
+        m_numGroupsComboBox->setSelectedId(xmlNode->getIntAttribute("numGroups", 1), sendNotificationSync);
     }
 }
\ No newline at end of file
@@ -39,6 +39,7 @@ class ParameterSlider;
    @see CAR
 */
 class CAREditor : public GenericEditor
+                , public ComboBox::Listener
 {
 public:
     CAREditor (GenericProcessor* parentProcessor, bool useDefaultParameterEditors);
@@ -52,6 +53,10 @@ public:
     // ==========================================================
     void buttonClicked (Button* buttonThatWasClicked) override;
 
+    // ComboBox::Listener methods
+    // ==========================================================
+    void comboBoxChanged (ComboBox* comboBoxThatHasChanged) override;
+
     // GenericEditor methods
     // =========================================================
     /** This methods is called when any sliders that we are listen for change their values */
@@ -72,7 +77,9 @@ private:
     ChannelsType m_currentChannelsView;
 
     ScopedPointer<LinearButtonGroupManager> m_channelSelectorButtonManager;
+    ScopedPointer<LinearButtonGroupManager> m_referenceModeButtonManager;
     ScopedPointer<ParameterSlider>          m_gainSlider;
+    ScopedPointer<ComboBox>                 m_numGroupsComboBox;
 
     // LookAndFeel
     SharedResourcePointer<MaterialButtonLookAndFeel> m_materialButtonLookAndFeel;
@@ -0,0 +1,367 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+#include "EcubePacketAssembler.h"
+
+#if JUCE_INTEL && ! (JUCE_MINGW && ! defined (__SSE2__))
+ #define ECUBE_USE_SSE 1
+ #include <emmintrin.h>
+#endif
+
+static const float headstageScale = 6.25e3f / 32768; // Microvolts per bit for the headstage channels
+static const float panelScale = 10.0f / 32768;       // Volts per bit for front panel analog input
+static const int numPanelChannels = 32;
+static const int numDigitalChannels = 64;
+
+// Stream IDs spanning more than this are looked up by search instead of with a table
+static const int maxIndexTableSize = 1 << 16;
+
+static const char bits_port0[16] = { 23, 22, -1, 14, 11, -1, -1, 28, 12, 10, 27, 26, -1, -1, -1, -1 };
+static const char bits_port1[16] = { 20, 21, 19, 18, 13, 6, 4, 5, 3, 2, -1, -1, 29, -1, 24, 25 };
+static const char bits_port2[16] = { 16, 17, 15, 8, 9, 7, 0, 1, 31, 30, -1, -1, -1, -1, -1, -1 };
+
+// Builds bit conversion table for 8 bits of raw data
+static void build_bit_conversion_table(uint32* table, const char* bits)
+{
+    for (uint16 i = 0; i < 256; i++)
+    {
+        uint8 is = (uint8) i;
+        uint32 outval = 0;
+        for (uint16 j = 0; j < 8; j++)
+        {
+            if ((is & 1) && bits[j]>=0)
+            {
+                outval |= (uint32)1<<bits[j];
+            }
+            is >>= 1;
+        }
+        table[i] = outval;
+    }
+}
+
+static void build_bit_conversion_tables(uint32* tables)
+{
+    // Bit conversion tables have 256 uint32s for each 8 bits of ecube ports
+    // Each sparse 16-bit port has two such tables
+    // The structure in memory is {tbl_port0l, tbl_port0h, tbl_port1l, tbl_port1h, tbl_port2l, tbl_port2h)
+    build_bit_conversion_table(tables        , bits_port0);
+    build_bit_conversion_table(tables + 0x100, bits_port0 + 8);
+    build_bit_conversion_table(tables + 0x200, bits_port1);
+    build_bit_conversion_table(tables + 0x300, bits_port1 + 8);
+    build_bit_conversion_table(tables + 0x400, bits_port2);
+    build_bit_conversion_table(tables + 0x500, bits_port2 + 8);
+}
+
+EcubePacketAssembler::EcubePacketAssembler(DataFormat format, const Array<int>& streamIds, uint32 sampleTime80MHz)
+    : dataFormat(format),
+      numStreams(streamIds.size()),
+      numChannels(format == dfSeparateChannelsAnalog ? streamIds.size()
+                  : format == dfInterleavedChannelsAnalog ? numPanelChannels : numDigitalChannels),
+      sampleTime(sampleTime80MHz),
+      firstStreamId(0),
+      packetCapacity(0),
+      packetSize(0),
+      timestampLocked(false),
+      packetTimestamp(0),
+      packetTimestamp64(0)
+{
+    // Every buffer names its stream, so the lookup is a table rather than a map
+    if (streamIds.size() > 0)
+    {
+        int lastStreamId = streamIds[0];
+        firstStreamId = streamIds[0];
+
+        for (int i = 1; i < streamIds.size(); i++)
+        {
+            firstStreamId = jmin(firstStreamId, streamIds[i]);
+            lastStreamId = jmax(lastStreamId, streamIds[i]);
+        }
+
+        if ((int64) lastStreamId - firstStreamId < maxIndexTableSize)
+        {
+            channelIndexTable.insertMultiple(0, -1, lastStreamId - firstStreamId + 1);
+
+            for (int i = 0; i < streamIds.size(); i++)
+                channelIndexTable.set(streamIds[i] - firstStreamId, i);
+        }
+        else
+        {
+            streamIdList = streamIds;
+        }
+    }
+
+    if (dataFormat == dfDigital)
+    {
+        bitConversionTables.malloc(0x600);
+        build_bit_conversion_tables(bitConversionTables);
+    }
+}
+
+EcubePacketAssembler::~EcubePacketAssembler()
+{
+}
+
+EcubePacketAssembler::DataFormat EcubePacketAssembler::getDataFormat() const
+{
+    return dataFormat;
+}
+
+int EcubePacketAssembler::getNumChannels() const
+{
+    return numChannels;
+}
+
+void EcubePacketAssembler::reset()
+{
+    timestampLocked = false;
+    packetSize = 0;
+}
+
+int EcubePacketAssembler::getChannelIndex(int streamId) const
+{
+    if (streamIdList.size() > 0)
+        return streamIdList.indexOf(streamId);
+
+    const int64 offset = (int64) streamId - firstStreamId;
+
+    if (offset < 0 || offset >= channelIndexTable.size())
+        return -1;
+
+    return channelIndexTable.getUnchecked((int) offset);
+}
+
+void EcubePacketAssembler::convertSamples(float* dest, const int16* src, float scale, int numSamples)
+{
+    int i = 0;
+
+#if ECUBE_USE_SSE
+    const __m128 gain = _mm_set1_ps(scale);
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*) (src + i));
+
+        // duplicating each sample into both halves of a 32-bit lane and shifting right
+        // sign-extends it
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), gain));
+        _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), gain));
+    }
+#endif
+
+    for (; i < numSamples; i++)
+        dest[i] = src[i] * scale;
+}
+
+void EcubePacketAssembler::advanceTimestamp(uint32 timestamp)
+{
+    if (timestampLocked)
+        packetTimestamp64 += (uint32) (timestamp - packetTimestamp); // wraps around with the eCube timestamp
+    else
+        packetTimestamp64 = timestamp;
+
+    packetTimestamp = timestamp;
+    timestampLocked = true;
+}
+
+void EcubePacketAssembler::startPacket(uint32 timestamp, int numSamples)
+{
+    advanceTimestamp(timestamp);
+
+    if (numSamples > packetCapacity)
+    {
+        packetCapacity = numSamples;
+        packet.malloc(numChannels * packetCapacity);
+        packetEventCodes.malloc(packetCapacity);
+    }
+
+    packetSize = numSamples;
+
+    for (int ch = 0; ch < numChannels; ch++)
+        FloatVectorOperations::clear(packet + ch * packetCapacity, packetSize);
+
+    zeromem(packetEventCodes, sizeof(uint64) * packetSize);
+}
+
+void EcubePacketAssembler::flushPacket(DataBuffer* dest)
+{
+    // Convert eCube 80MHz timestamp into a sample count
+    writeToBuffer(dest, packet, packetCapacity, packetEventCodes, packetSize, packetTimestamp64 / sampleTime);
+}
+
+void EcubePacketAssembler::writeToBuffer(DataBuffer* dest, const float* planes, int planeSize, const uint64* eventCodes,
+                                         int numSamples, int64 firstTimestamp)
+{
+    int startIndex[2], blockSize[2];
+    dest->prepareToWrite(numSamples, startIndex[0], blockSize[0], startIndex[1], blockSize[1]);
+
+    int offset = 0;
+
+    for (int b = 0; b < 2; b++)
+    {
+        if (blockSize[b] <= 0)
+            continue;
+
+        for (int ch = 0; ch < numChannels; ch++)
+            FloatVectorOperations::copy(dest->getWritePointer(ch, startIndex[b]), planes + ch * planeSize + offset, blockSize[b]);
+
+        int64* timestamps = dest->getTimestampPointer(startIndex[b]);
+
+        for (int i = 0; i < blockSize[b]; i++)
+            timestamps[i] = firstTimestamp + offset + i;
+
+        memcpy(dest->getEventCodePointer(startIndex[b]), eventCodes + offset, sizeof(uint64) * blockSize[b]);
+
+        offset += blockSize[b];
+    }
+
+    // samples that don't fit are lost, as they were with addToBuffer()
+    dest->finishedWrite(offset);
+}
+
+bool EcubePacketAssembler::addBuffer(int streamId, uint32 timestamp, const void* data, int numBytes, DataBuffer* dest)
+{
+    const int channel = getChannelIndex(streamId);
+
+    if (channel < 0)
+        return false;
+
+    const int numSamples = numBytes / 2; // Data size is given in bytes, not in samples
+
+    if (dataFormat == dfSeparateChannelsAnalog)
+    {
+        // Buffers less than a sample apart belong to the same packet. A buffer with another
+        // timestamp or size starts a new packet, and the current one is complete
+        if (!timestampLocked
+            || (timestamp - packetTimestamp >= sampleTime && packetTimestamp - timestamp >= sampleTime)
+            || numSamples != packetSize)
+        {
+            if (timestampLocked)
+                flushPacket(dest);
+
+            startPacket(timestamp, numSamples);
+        }
+
+        convertSamples(packet + channel * packetCapacity, (const int16*) data, headstageScale, numSamples);
+    }
+    else if (dataFormat == dfInterleavedChannelsAnalog)
+    {
+        advanceTimestamp(timestamp);
+        addInterleavedSamples((const int16*) data, numSamples, dest);
+    }
+    else // Digital data
+    {
+        const uint32 tsdif = timestamp - packetTimestamp;
+
+        if (!timestampLocked
+            || (timestamp != packetTimestamp && tsdif != 5 && tsdif != 10 && tsdif != 0xFFFFFFFB && tsdif != 0xFFFFFFFA)
+            || numSamples != packetSize)
+        {
+            if (timestampLocked)
+                flushPacket(dest);
+
+            startPacket(timestamp, numSamples);
+        }
+
+        addDigitalSamples(channel, (const uint16*) data, numSamples);
+    }
+
+    return true;
+}
+
+void EcubePacketAssembler::addInterleavedSamples(const int16* data, int numSamples, DataBuffer* dest)
+{
+    const int numFrames = numSamples / numPanelChannels;
+
+    if (numFrames > packetCapacity)
+    {
+        packetCapacity = numFrames;
+        packet.malloc(numChannels * packetCapacity);
+        packetEventCodes.malloc(packetCapacity);
+    }
+
+    zeromem(packetEventCodes, sizeof(uint64) * numFrames);
+
+    for (int ch = 0; ch < numPanelChannels; ch++)
+    {
+        float* plane = packet + ch * packetCapacity;
+        const int16* src = data + ch;
+
+        for (int i = 0; i < numFrames; i++)
+            plane[i] = src[i * numPanelChannels] * panelScale; // Convert into volts
+    }
+
+    // Convert eCube's 80MHz timestamps into number of samples on the Panel Analog input
+    writeToBuffer(dest, packet, packetCapacity, packetEventCodes, numFrames, packetTimestamp64 / sampleTime);
+}
+
+void EcubePacketAssembler::addDigitalSamples(int channel, const uint16* data, int numSamples)
+{
+    const char* pbits;
+    const uint32* pconvtbl;
+    switch (channel)
+    {
+        case 0:
+        case 3:
+            pbits = bits_port0;
+            pconvtbl = bitConversionTables;
+            break;
+        case 1:
+        case 4:
+            pbits = bits_port1;
+            pconvtbl = bitConversionTables + 0x200;
+            break;
+        case 2:
+        case 5:
+        default:
+            pbits = bits_port2;
+            pconvtbl = bitConversionTables + 0x400;
+            break;
+    }
+    const int bitchn_offset = channel >= 3 ? 32 : 0;
+    const uint8 dword_shift = channel >= 3 ? 32 : 0;
+
+    for (int j = 0; j < numSamples; j++)
+    {
+        const uint16 wrd = data[j];
+
+        // Convert the word into packed 32-bit representation for this port
+        const uint32 packedwrd = pconvtbl[wrd & 0xFF] | pconvtbl[0x100 + (wrd >> 8)];
+        packetEventCodes[j] |= (uint64) packedwrd << dword_shift;
+    }
+
+    for (int k = 0; k < 16; k++)
+    {
+        const int bitchn = pbits[k];
+
+        if (bitchn < 0)
+            continue;
+
+        float* plane = packet + (bitchn + bitchn_offset) * packetCapacity;
+        const uint16 msk = (uint16) (1 << k);
+
+        for (int j = 0; j < numSamples; j++)
+            plane[j] = (data[j] & msk) ? 5.0f : 0.0f; // Convert to 5V/0V values
+    }
+}
@@ -0,0 +1,119 @@
+/*
+   ------------------------------------------------------------------
+
+   This file is part of the Open Ephys GUI
+   Copyright (C) 2019 Open Ephys
+
+   ------------------------------------------------------------------
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __ECUBEPACKETASSEMBLER_H_5A2C91E3__
+#define __ECUBEPACKETASSEMBLER_H_5A2C91E3__
+
+
+#include <DataThreadHeaders.h>
+
+
+/**
+    Assembles the buffers streamed by an eCube into continuous samples.
+
+    It doesn't depend on the eCube API: every buffer is passed to addBuffer() as the API
+    delivers it, with its stream ID, 80 MHz timestamp and raw samples, so the assembly can
+    be run on recorded buffers without the hardware.
+
+    Headstage channels arrive as one buffer per channel, which are collected into a packet
+    until a buffer with another timestamp or size starts the next one. Each complete packet
+    is written to the DataBuffer at once.
+
+    @see EcubeThread
+*/
+class EcubePacketAssembler
+{
+public:
+    enum DataFormat
+    {
+        dfSeparateChannelsAnalog,
+        dfInterleavedChannelsAnalog,
+        dfDigital
+    };
+
+    /** streamIds holds the ID of each channel's stream, in channel order */
+    EcubePacketAssembler (DataFormat format, const Array<int>& streamIds, uint32 sampleTime80MHz);
+    ~EcubePacketAssembler();
+
+    DataFormat getDataFormat() const;
+
+    /** Returns the number of channels written to the DataBuffer */
+    int getNumChannels() const;
+
+    /** Discards the packet being assembled. Called when acquisition starts */
+    void reset();
+
+    /** Adds one eCube buffer, writing to dest whatever it completes.
+        Returns false if the stream isn't one of the assembler's channels. */
+    bool addBuffer (int streamId, uint32 timestamp, const void* data, int numBytes, DataBuffer* dest);
+
+    /** Converts int16 samples to scaled floats, using SSE2 where it is available */
+    static void convertSamples (float* dest, const int16* src, float scale, int numSamples);
+
+private:
+    /** Returns the channel fed by a stream, or -1 */
+    int getChannelIndex (int streamId) const;
+
+    /** Makes room for a packet of numSamples samples and clears it */
+    void startPacket (uint32 timestamp, int numSamples);
+
+    /** Writes the packet to the DataBuffer */
+    void flushPacket (DataBuffer* dest);
+
+    void addDigitalSamples (int channel, const uint16* data, int numSamples);
+    void addInterleavedSamples (const int16* data, int numSamples, DataBuffer* dest);
+
+    /** Writes numSamples samples, held one channel after another in planes, to the DataBuffer */
+    void writeToBuffer (DataBuffer* dest, const float* planes, int planeSize, const uint64* eventCodes,
+                        int numSamples, int64 firstTimestamp);
+
+    /** Accounts for the 32-bit timestamp wrapping around */
+    void advanceTimestamp (uint32 timestamp);
+
+    const DataFormat dataFormat;
+    const int numStreams;
+    const int numChannels;
+    const uint32 sampleTime;
+
+    // stream ID - firstStreamId -> channel index, or -1. Stream IDs too far apart for a
+    // table are searched for in streamIdList instead
+    Array<int> channelIndexTable;
+    Array<int> streamIdList;
+    int firstStreamId;
+
+    // the packet being assembled, one plane of packetCapacity samples per channel
+    HeapBlock<float> packet;
+    HeapBlock<uint64> packetEventCodes;
+    int packetCapacity;
+    int packetSize;
+
+    bool timestampLocked;
+    uint32 packetTimestamp;
+    int64 packetTimestamp64;
+
+    HeapBlock<uint32> bitConversionTables;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EcubePacketAssembler);
+};
+
+#endif  // __ECUBEPACKETASSEMBLER_H_5A2C91E3__
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "EcubeThread.h"
 #include "EcubeDialogComponent.h"
+#include "EcubePacketAssembler.h"
 #include <stdint.h>
 
 #ifdef ECUBE_COMPILE
@@ -33,12 +34,11 @@ class EcubeDevInt
 {
 public:
 
-    enum DataFormat
-    {
-        dfSeparateChannelsAnalog,
-        dfInterleavedChannelsAnalog,
-        dfDigital
-    };
+    typedef EcubePacketAssembler::DataFormat DataFormat;
+    static const DataFormat dfSeparateChannelsAnalog = EcubePacketAssembler::dfSeparateChannelsAnalog;
+    static const DataFormat dfInterleavedChannelsAnalog = EcubePacketAssembler::dfInterleavedChannelsAnalog;
+    static const DataFormat dfDigital = EcubePacketAssembler::dfDigital;
+
     IEcubePtr pEcube;
     IEcubeDevicePtr pDevice;
     IEcubeModulePtr pModule;
@@ -46,56 +46,14 @@ public:
     std::vector<IEcubeChannelPtr> vpChannels;
     IEcubeChannelPtr pSpeakerChannel;
     unsigned n_channel_objects;
-    std::map<int, int> chid_map;
+    Array<int> stream_ids;
     IEcubeAnalogAcquisitionPtr pStrmA;
     IEcubeDigitalInputStreamingPtr pStrmD;
-    HeapBlock<float, true> interleaving_buffer;
-    HeapBlock<uint64_t, true> event_buffer;
-    HeapBlock<uint32_t, true> bit_conversion_tables;
-    bool buf_timestamp_locked;
-    unsigned long buf_timestamp;
-    int64 buf_timestamp64;
-    unsigned long int_buf_size;
+    ScopedPointer<EcubePacketAssembler> assembler;
     DataFormat data_format;
     unsigned long sampletime_80mhz;
 };
 
-static const char bits_port0[16] = { 23, 22, -1, 14, 11, -1, -1, 28, 12, 10, 27, 26, -1, -1, -1, -1 };
-static const char bits_port1[16] = { 20, 21, 19, 18, 13, 6, 4, 5, 3, 2, -1, -1, 29, -1, 24, 25 };
-static const char bits_port2[16] = { 16, 17, 15, 8, 9, 7, 0, 1, 31, 30, -1, -1, -1, -1, -1, -1 };
-
-// Builds bit conversion table for 8 bits of raw data
-void build_bit_conversion_table(uint32_t* table, const char* bits)
-{
-    for (uint16_t i = 0; i < 256; i++)
-    {
-        uint8_t is = i;
-        uint32_t outval = 0;
-        for (uint16_t j = 0; j < 8; j++)
-        {
-            if ((is & 1) && bits[j]>=0)
-            {
-                outval |= (uint32_t)1<<bits[j];
-            }
-            is >>= 1;
-        }
-        table[i] = outval;
-    }
-}
-
-void build_bit_conversion_tables(uint32_t* tables)
-{
-    // Bit conversion tables have 256 uint64s for each 8 bits of ecube ports
-    // Each sparse 16-bit port has two such tables
-    // The structure in memory is {tbl_port0l, tbl_port0h, tbl_port1l, tbl_port1h, tbl_port2l, tbl_port2h)
-    build_bit_conversion_table(tables        , bits_port0);
-    build_bit_conversion_table(tables + 0x100, bits_port0 + 8);
-    build_bit_conversion_table(tables + 0x200, bits_port1);
-    build_bit_conversion_table(tables + 0x300, bits_port1 + 8);
-    build_bit_conversion_table(tables + 0x400, bits_port2);
-    build_bit_conversion_table(tables + 0x500, bits_port2 + 8);
-}
-
 static std::vector<std::wstring> SafeArrayToVecStr(SAFEARRAY* sa)
 {
     HRESULT hr;
@@ -221,15 +179,13 @@ EcubeThread::EcubeThread(SourceNode* sn) : DataThread(sn), numberingScheme(1), a
                             }
                             else
                                 pDevInt->pStrmA->AddChannel(pch);
-                            pDevInt->chid_map[pch->GetID()] = pDevInt->n_channel_objects;
+                            pDevInt->stream_ids.add(pch->GetID());
                             pDevInt->n_channel_objects++;
                             pDevInt->vpChannels.push_back(pch);
                         }
                     }
                 }
                 sourceBuffers.set(0,new DataBuffer(pDevInt->n_channel_objects, 10000));
-                // Create the interleaving buffer based on the number of channels
-                pDevInt->interleaving_buffer.malloc(sizeof(float)* 1500 * pDevInt->n_channel_objects);
             }
             else if (selmod == "Panel Analog Input")
             {
@@ -247,7 +203,7 @@ EcubeThread::EcubeThread(SourceNode* sn) : DataThread(sn), numberingScheme(1), a
                     }
                     else
                         pDevInt->pStrmA->AddChannel(pch);
-                    pDevInt->chid_map[pch->GetID()] = pDevInt->n_channel_objects;
+                    pDevInt->stream_ids.add(pch->GetID());
                     pDevInt->n_channel_objects++;
                 }
                 m_samplerate = component.GetSampleRate(); // Initial user-specified sample rate
@@ -257,8 +213,6 @@ EcubeThread::EcubeThread(SourceNode* sn) : DataThread(sn), numberingScheme(1), a
                 pDevInt->sampletime_80mhz *= 80000000 / pDevInt->pStrmA->GetSampleRateNum();
 
                 sourceBuffers.set(0,new DataBuffer(32, 10000));
-                // The interleaving buffer is there just for short->float conversion
-                pDevInt->interleaving_buffer.malloc(sizeof(float)* 1500);
             }
             else if (selmod == "Panel Digital Input")
             {
@@ -279,23 +233,17 @@ EcubeThread::EcubeThread(SourceNode* sn) : DataThread(sn), numberingScheme(1), a
                     }
                     else
                         pDevInt->pStrmD->AddChannel(pch);
-                    pDevInt->chid_map[pch->GetID()] = pDevInt->n_channel_objects;
+                    pDevInt->stream_ids.add(pch->GetID());
                     pDevInt->n_channel_objects++;
                 }
 
                 sourceBuffers.set(0,new DataBuffer(64, 10000));
-                // Create the interleaving buffer based on the number of digital ports
-                pDevInt->interleaving_buffer.malloc(sizeof(float)* 1500 * 64);
-                // Create the analog of interleaving buffer in packed format (int64)
-                pDevInt->event_buffer.malloc(sizeof(uint64_t)* 1500);
-                pDevInt->bit_conversion_tables.malloc(sizeof(uint32_t)* 0x600);
-                build_bit_conversion_tables(pDevInt->bit_conversion_tables);
             }
             else
                 throw std::runtime_error("Invlid module selection");
         }
 
-        pDevInt->buf_timestamp_locked = false;
+        pDevInt->assembler = new EcubePacketAssembler(pDevInt->data_format, pDevInt->stream_ids, pDevInt->sampletime_80mhz);
 
         setDefaultChannelNames();
 
@@ -439,8 +387,6 @@ bool EcubeThread::foundInputSource()
 bool EcubeThread::updateBuffer()
 {
     unsigned long ba;
-    ttlEventWords.set(0,0);
-    int nchan = pDevInt->n_channel_objects;
 
     if (pDevInt->data_format == EcubeDevInt::dfSeparateChannelsAnalog || pDevInt->data_format == EcubeDevInt::dfInterleavedChannelsAnalog)
         ba = pDevInt->pStrmA->WaitForData(100);
@@ -455,164 +401,9 @@ bool EcubeThread::updateBuffer()
                 ab = pDevInt->pStrmA->FetchNextBuffer();
             else
                 ab = pDevInt->pStrmD->FetchNextBuffer();
-            unsigned long chid = ab->GetStreamID();
-            std::map<int, int>::const_iterator chit = pDevInt->chid_map.find(chid);
-            if (chit != pDevInt->chid_map.end())
-            {
-                unsigned long bts = ab->GetTimestamp();
-                unsigned long datasize = ab->GetDataSize() / 2; // Data size is returned in bytes, not in samples
-
-                if (pDevInt->data_format == EcubeDevInt::dfSeparateChannelsAnalog)
-                {
-                    if (!pDevInt->buf_timestamp_locked || (bts - pDevInt->buf_timestamp >= pDevInt->sampletime_80mhz && pDevInt->buf_timestamp - bts >= pDevInt->sampletime_80mhz)
-                        /*bts != pDevInt->buf_timestamp*/
-                        || datasize != pDevInt->int_buf_size)
-                    {
-                        // The new buffer does not match interleaving buffer length, or has a different timestamp,
-                        // or interleaving buffer is empty
-                        if (pDevInt->buf_timestamp_locked)
-                        {
-                            // Interleaving buffer is not empty.
-                            // Send its contents out to the application
-                            int64 cts = pDevInt->buf_timestamp64 / pDevInt->sampletime_80mhz; // Convert eCube 80MHz timestamp into a 25kHz timestamp
-                            for (unsigned long j = 0; j < pDevInt->int_buf_size; j++)
-                            {
-								sourceBuffers[0]->addToBuffer(pDevInt->interleaving_buffer + j*nchan, &cts, &ttlEventWords.getReference(0), 1);
-                                cts++;
-                            }
-                            // Update the 64-bit timestamp, take account of its wrap-around
-                            unsigned tsdif = bts - pDevInt->buf_timestamp;
-                            pDevInt->buf_timestamp64 += tsdif;
-                        }
-                        else
-                        {
-                            // The interleaving buffer is empty
-                            pDevInt->buf_timestamp64 = bts;
-                        }
-                        pDevInt->int_buf_size = datasize;
-                        pDevInt->buf_timestamp = bts;
-                        pDevInt->buf_timestamp_locked = true;
-                        // Clear the interleaving buffer within the new packet's size
-                        memset(pDevInt->interleaving_buffer, 0, sizeof(float)*datasize*nchan);
-                    }
-                    chid = chit->second; // Adjust the channel id to become the channel index
-                    unsigned char* dp = ab->GetDataPointer();
-                    const short* pData = (const short*)dp;
-                    for (unsigned long j = 0; j < datasize; j++)
-                    {
-                        pDevInt->interleaving_buffer[chid + nchan*j] = pData[j] * 6.25e3 / 32768; // Convert into microvolts
-                    }
-                }
-                else if (pDevInt->data_format == EcubeDevInt::dfInterleavedChannelsAnalog)
-                {
-                    if (pDevInt->buf_timestamp_locked)
-                    {
-                        // Update the 64-bit timestamp, take care of its wrap-around
-                        unsigned tsdif = bts - pDevInt->buf_timestamp;
-                        pDevInt->buf_timestamp64 += tsdif;
-                    }
-                    else
-                    {
-                        pDevInt->buf_timestamp64 = bts;
-                    }
-                    pDevInt->buf_timestamp = bts;
-                    pDevInt->buf_timestamp_locked = true;
-                    unsigned char* dp = ab->GetDataPointer();
-                    const short* pData = (const short*)dp;
-                    for (unsigned j = 0; j < datasize; j++)
-                    {
-                        pDevInt->interleaving_buffer[j] = pData[j] * 10.0/32768; // Convert into volts
-                    }
-                    unsigned long datasam = datasize / 32;
-                    int64 cts = pDevInt->buf_timestamp64 / pDevInt->sampletime_80mhz; // Convert eCube's 80MHz timestamps into number of samples on the Panel Analog input (orig sample rate 1144)
-                    for (unsigned long j = 0; j < datasam; j++)
-                    {
-						sourceBuffers[0]->addToBuffer(pDevInt->interleaving_buffer + j * 32, &cts, &ttlEventWords.getReference(0), 1);
-                        cts++;
-                    }
-                }
-                else // Digital data
-                {
-                    unsigned tsdif = bts - pDevInt->buf_timestamp;
-                    if (!pDevInt->buf_timestamp_locked || (bts != pDevInt->buf_timestamp && tsdif!=5 && tsdif!=10 && tsdif!=0xFFFFFFFB && tsdif!=0xFFFFFFFA) || datasize != pDevInt->int_buf_size)
-                    {
-                        // The new buffer does not match interleaving buffer length, or has a different timestamp,
-                        // or interleaving buffer is empty
-                        if (pDevInt->buf_timestamp_locked)
-                        {
-                            // Interleaving buffer is not empty.
-                            // Send its contents out to the application
-                            int64 cts = pDevInt->buf_timestamp64 / pDevInt->sampletime_80mhz; // Convert eCube 80MHz timestamp into a 25kHz timestamp
-                            for (unsigned long j = 0; j < pDevInt->int_buf_size; j++)
-                            {
-                                sourceBuffers[0]->addToBuffer(pDevInt->interleaving_buffer + j*64, &cts, pDevInt->event_buffer+j, 1);
-                                cts++;
-                            }
-                            // Update the 64-bit timestamp, take account of its wrap-around
-                            pDevInt->buf_timestamp64 += tsdif;
-                        }
-                        else
-                        {
-                            // The interleaving buffer is empty
-                            pDevInt->buf_timestamp64 = bts;
-                        }
-                        pDevInt->buf_timestamp = bts;
-                        pDevInt->int_buf_size = datasize;
-                        pDevInt->buf_timestamp_locked = true;
-                        // Clear the interleaving buffer within the new packet's size
-                        memset(pDevInt->interleaving_buffer, 0, sizeof(float)*datasize*64);
-                        // Clear the event buffer as well
-                        memset(pDevInt->event_buffer, 0, sizeof(uint64_t)*datasize);
-                    }
-                    // Convert data from ecube buffer into the interleaving buffer format
-                    chid = chit->second; // Adjust the channel id to become the channel index
-                    unsigned char* dp = ab->GetDataPointer();
-                    const uint16_t* pData = (const uint16_t*)dp;
-                    const char* pbits;
-                    const uint32_t* pconvtbl;
-                    switch (chid)
-                    {
-                        case 0:
-                        case 3:
-                            pbits = bits_port0;
-                            pconvtbl = pDevInt->bit_conversion_tables;
-                            break;
-                        case 1:
-                        case 4:
-                            pbits = bits_port1;
-                            pconvtbl = pDevInt->bit_conversion_tables+0x200;
-                            break;
-                        case 2:
-                        case 5:
-                        default:
-                            pbits = bits_port2;
-                            pconvtbl = pDevInt->bit_conversion_tables + 0x400;
-                            break;
-                    }
-                    int bitchn_offset = chid >= 3 ? 32 : 0;
-                    uint8_t dword_shift = chid>=3 ? 32 : 0;
-                    for (unsigned long j = 0; j < datasize; j++)
-                    {
-                        uint16_t wrd = pData[j];
-
-                        // Convert the word into packed 32-bit representation for this port
-                        uint32_t packedwrd = pconvtbl[wrd & 0xFF] | pconvtbl[0x100 + (wrd >> 8)];
-                        pDevInt->event_buffer[j] |= (uint64_t)packedwrd << dword_shift;
 
-                        uint16_t msk = 1;
-                        for (unsigned long k = 0; k < 16; k++)
-                        {
-                            int bitchn = pbits[k];
-                            if (bitchn>=0)
-                            {
-                                float val = wrd&msk ? 5.0f : 0.0f; // Convert to 5V/0V values
-                                pDevInt->interleaving_buffer[bitchn + bitchn_offset + 64*j] = val;
-                            }
-                            msk <<= 1;
-                        }
-                    }
-                }
-            }
+            // Buffers of streams that aren't ours are skipped
+            pDevInt->assembler->addBuffer(ab->GetStreamID(), ab->GetTimestamp(), ab->GetDataPointer(), ab->GetDataSize(), sourceBuffers[0]);
         }
         if (pDevInt->data_format == EcubeDevInt::dfSeparateChannelsAnalog || pDevInt->data_format == EcubeDevInt::dfInterleavedChannelsAnalog)
             ba = pDevInt->pStrmA->GetBuffersAcquired();
@@ -624,7 +415,7 @@ bool EcubeThread::updateBuffer()
 
 bool EcubeThread::startAcquisition()
 {
-    pDevInt->buf_timestamp_locked = false;
+    pDevInt->assembler->reset();
     if (!isThreadRunning())
         startThread();
 
@@ -1,12 +1,26 @@
 #ifdef _WIN32
 #include <Windows.h>
+#else
+#include <sys/socket.h>
+#include <errno.h>
 #endif
 
+#include <limits>
+
 #include "EphysSocket.h"
 #include "EphysSocketEditor.h"
 
 using namespace EphysSocketNode;
 
+// Large enough for a second of 512 channels at 30 kHz, so bursts are not lost while the
+// thread is busy. The system may cap it lower
+static const int receiveBufferSize = 32 << 20;
+
+static void setReceiveBufferSize (int handle)
+{
+    setsockopt (handle, SOL_SOCKET, SO_RCVBUF, (const char*) &receiveBufferSize, sizeof (receiveBufferSize));
+}
+
 DataThread* EphysSocket::createDataThread(SourceNode *sn)
 {
     return new EphysSocket(sn);
@@ -14,12 +28,12 @@ DataThread* EphysSocket::createDataThread(SourceNode *sn)
 
 EphysSocket::EphysSocket(SourceNode* sn) : DataThread(sn)
 {
-    socket = new DatagramSocket();
-    socket->bindToPort(port);
-    connected = (socket->waitUntilReady(true, 1000) == 1); // Try to automatically open, dont worry if it does not work
-    sourceBuffers.add(new DataBuffer(num_channels, num_channels * num_samp * 4 * 5)); // start with 2 channels and automatically resize
-    recvbuf = (uint16_t *)malloc(num_channels * num_samp * 2);
-    convbuf = (float *)malloc(num_channels * num_samp * 4);
+    sourceBuffers.add(new DataBuffer(num_channels, jmax((int) sample_rate, num_samp * 8)));
+
+    packetBuffer.malloc(maxPackets * maxPacketSize);
+    packetSizes.malloc(maxPackets);
+
+    tryToConnect(); // Try to automatically open, dont worry if it does not work
 }
 
 GenericEditor* EphysSocket::createEditor(SourceNode* sn)
@@ -34,17 +48,12 @@ void EphysSocket::timerCallback()
 
 EphysSocket::~EphysSocket()
 {
-    free(recvbuf);
-    free(convbuf);
 }
 
 void EphysSocket::resizeChanSamp()
 {
-    sourceBuffers[0]->resize(num_channels, num_channels * num_samp * 4 * 5);
-    recvbuf = (uint16_t *)realloc(recvbuf, num_channels * num_samp * 2);
-    convbuf = (float *)realloc(convbuf, num_channels * num_samp * 4);
-    //timestamps.resize(num_samp);
-    //ttlEventWords.resize(num_samp);
+    // a second of data, and at least a few packets
+    sourceBuffers[0]->resize(num_channels, jmax((int) sample_rate, num_samp * 8));
 }
 
 int EphysSocket::getNumChannels() const
@@ -57,12 +66,12 @@ int EphysSocket::getNumDataOutputs(DataChannel::DataChannelTypes type, int subpr
     if (type == DataChannel::HEADSTAGE_CHANNEL)
         return num_channels;
     else
-        return 0; 
+        return 0;
 }
 
 int EphysSocket::getNumTTLOutputs(int subproc) const
 {
-    return 0; 
+    return 0;
 }
 
 float EphysSocket::getSampleRate(int subproc) const
@@ -72,7 +81,7 @@ float EphysSocket::getSampleRate(int subproc) const
 
 float EphysSocket::getBitVolts (const DataChannel* ch) const
 {
-    return 0.195f;
+    return data_scale;
 }
 
 bool EphysSocket::foundInputSource()
@@ -82,15 +91,39 @@ bool EphysSocket::foundInputSource()
 
 bool EphysSocket::startAcquisition()
 {
+    expectedSequence = 0;
+    expectedSample = 0;
+    receivedFirstPacket = false;
+
+    numDroppedPackets = 0;
+    numLatePackets = 0;
+    numMalformedPackets = 0;
+    numOverflowSamples = 0;
+
     startThread();
     return true;
 }
 
 void  EphysSocket::tryToConnect()
 {
-    socket->shutdown();
+    if (socket != nullptr)
+        socket->shutdown();
+
+    socket = nullptr;
+    connection = nullptr;
+    listener = nullptr;
+
+    if (protocol == TCP_SEQUENCED)
+    {
+        // the sender connects when it is ready, see receiveStream()
+        listener = new StreamingSocket();
+        connected = listener->createListener(port);
+        return;
+    }
+
     socket = new DatagramSocket();
     socket->bindToPort(port);
+    setReceiveBufferSize(socket->getRawSocketHandle());
     connected = (socket->waitUntilReady(true, 1000) == 1);
 }
 
@@ -104,29 +137,297 @@ bool EphysSocket::stopAcquisition()
     waitForThreadToExit(500);
 
     sourceBuffers[0]->clear();
+
+    if (numDroppedPackets > 0 || numLatePackets > 0 || numMalformedPackets > 0 || numOverflowSamples > 0)
+    {
+        std::cout << "Ephys Socket: " << numDroppedPackets << " packets dropped, " << numLatePackets
+                  << " arrived late and " << numMalformedPackets << " were malformed; "
+                  << numOverflowSamples << " samples did not fit in the buffer" << std::endl;
+    }
+
     return true;
 }
 
-bool EphysSocket::updateBuffer()
+int64 EphysSocket::getNumDroppedPackets() const
+{
+    return numDroppedPackets;
+}
+
+int64 EphysSocket::getNumLatePackets() const
+{
+    return numLatePackets;
+}
+
+int64 EphysSocket::getNumOverflowSamples() const
+{
+    return numOverflowSamples;
+}
+
+int EphysSocket::receiveDatagrams()
+{
+    if (socket == nullptr)
+        return -1;
+
+    // waits with a timeout, so the thread can still be stopped when nothing is sent
+    const int ready = socket->waitUntilReady(true, 100);
+
+    if (ready <= 0)
+        return ready;
+
+#ifdef __linux__
+    // drains every datagram that is waiting with a single call
+    struct mmsghdr messages[maxPackets];
+    struct iovec vectors[maxPackets];
+
+    zeromem(messages, sizeof(messages));
+
+    for (int i = 0; i < maxPackets; i++)
+    {
+        vectors[i].iov_base = packetBuffer + i * maxPacketSize;
+        vectors[i].iov_len = maxPacketSize;
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    const int numReceived = recvmmsg(socket->getRawSocketHandle(), messages, maxPackets, MSG_DONTWAIT, nullptr);
+
+    if (numReceived < 0)
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+
+    for (int i = 0; i < numReceived; i++)
+        packetSizes[i] = (messages[i].msg_hdr.msg_flags & MSG_TRUNC) ? -1 : (int) messages[i].msg_len;
+
+    return numReceived;
+#else
+    int numReceived = 0;
+
+    while (numReceived < maxPackets)
+    {
+        const int size = socket->read(packetBuffer + numReceived * maxPacketSize, maxPacketSize, false);
+
+        if (size < 0)
+            return numReceived > 0 ? numReceived : -1;
+
+        if (size == 0)
+            break;
+
+        packetSizes[numReceived++] = size;
+    }
+
+    return numReceived;
+#endif
+}
+
+int EphysSocket::receiveStream()
 {
-    int rc = socket->read(recvbuf, num_channels * num_samp * 2, true);
+    if (listener == nullptr)
+        return -1;
+
+    if (connection == nullptr)
+    {
+        if (listener->waitUntilReady(true, 100) != 1)
+            return 0;
+
+        connection = listener->waitForNextConnection();
+
+        if (connection == nullptr)
+            return 0;
 
-    if (rc == -1) return false;
+        setReceiveBufferSize(connection->getRawSocketHandle());
+
+        // a new sender starts its own count
+        receivedFirstPacket = false;
+
+        std::cout << "Ephys Socket: connected to " << connection->getHostName() << std::endl;
+    }
+
+    int numReceived = 0;
+
+    while (numReceived < maxPackets && connection->waitUntilReady(true, numReceived == 0 ? 100 : 0) == 1)
+    {
+        char* packet = packetBuffer + numReceived * maxPacketSize;
+
+        if (connection->read(packet, headerSize, true) != headerSize)
+        {
+            std::cout << "Ephys Socket: connection closed" << std::endl;
+            connection = nullptr;
+            break;
+        }
 
-    // Transpose because the chunkSize arguement in addToBuffer does not seem to do anything
-    if (transpose) {
-        int k = 0;
-        for (int i = 0; i < num_samp; i++) {
-            for (int j = 0; j < num_channels; j++) {
-                convbuf[k++] = 0.195 *  (float)(recvbuf[j*num_samp + i] - 32768);
+        // 65535 channels of 65535 samples don't fit in an int
+        const int64 announcedSize = (int64) ByteOrder::littleEndianShort(packet + 12) * ByteOrder::littleEndianShort(packet + 14) * 2;
+
+        // the stream can't be resynchronised after a bad header
+        if (announcedSize > maxPacketSize - headerSize)
+        {
+            std::cout << "Ephys Socket: packet of " << announcedSize << " bytes is too large, closing the connection" << std::endl;
+            connection = nullptr;
+            break;
+        }
+
+        const int payloadSize = (int) announcedSize;
+
+        if (payloadSize > 0 && connection->read(packet + headerSize, payloadSize, true) != payloadSize)
+        {
+            std::cout << "Ephys Socket: connection closed" << std::endl;
+            connection = nullptr;
+            break;
+        }
+
+        packetSizes[numReceived++] = headerSize + payloadSize;
+    }
+
+    return numReceived;
+}
+
+void EphysSocket::writeSamples(const uint16* samples, int packetSamples, int from, int count, int64 firstTimestamp)
+{
+    DataBuffer* buffer = sourceBuffers[0];
+    const float offset = (float) data_offset;
+
+    while (count > 0)
+    {
+        int index, run;
+
+        if (numWritten < blockSize1)
+        {
+            index = startIndex1 + numWritten;
+            run = jmin(count, blockSize1 - numWritten);
+        }
+        else
+        {
+            index = startIndex2 + numWritten - blockSize1;
+            run = jmin(count, blockSize1 + blockSize2 - numWritten);
+        }
+
+        if (run <= 0)
+        {
+            numOverflowSamples += count;
+            return;
+        }
+
+        for (int ch = 0; ch < num_channels; ch++)
+        {
+            float* dest = buffer->getWritePointer(ch, index);
+
+            if (samples == nullptr)
+            {
+                FloatVectorOperations::clear(dest, run);
+            }
+            else if (transpose)
+            {
+                const uint16* src = samples + ch * packetSamples + from;
+
+                for (int i = 0; i < run; i++)
+                    dest[i] = data_scale * ((float) src[i] - offset);
+            }
+            else
+            {
+                const uint16* src = samples + from * num_channels + ch;
+
+                for (int i = 0; i < run; i++)
+                    dest[i] = data_scale * ((float) src[i * num_channels] - offset);
             }
         }
-    } else {
-        for (int i = 0; i < num_samp * num_channels; i++)
-            convbuf[i] = 0.195 *  (float)(recvbuf[i] - 32768);
+
+        int64* ts = buffer->getTimestampPointer(index);
+        uint64* eventCodes = buffer->getEventCodePointer(index);
+
+        for (int i = 0; i < run; i++)
+        {
+            ts[i] = firstTimestamp + i;
+            eventCodes[i] = 0;
+        }
+
+        numWritten += run;
+        from += run;
+        count -= run;
+        firstTimestamp += run;
     }
+}
 
-    sourceBuffers[0]->addToBuffer(convbuf, &timestamps.getReference(0), &ttlEventWords.getReference(0), num_samp, 1);
+void EphysSocket::handlePacket(const char* packet, int size)
+{
+    if (protocol == UDP_RAW)
+    {
+        if (size != num_channels * num_samp * 2)
+        {
+            ++numMalformedPackets;
+            return;
+        }
+
+        writeSamples((const uint16*) packet, num_samp, 0, num_samp, expectedSample);
+        expectedSample += num_samp;
+        return;
+    }
+
+    if (size < headerSize)
+    {
+        ++numMalformedPackets;
+        return;
+    }
+
+    const uint32 sequence = ByteOrder::littleEndianInt(packet);
+    const int64 firstSample = (int64) ByteOrder::littleEndianInt64(packet + 4);
+    const int numChannels = ByteOrder::littleEndianShort(packet + 12);
+    const int numSamples = ByteOrder::littleEndianShort(packet + 14);
+
+    if (numChannels != num_channels || size != headerSize + (int64) numChannels * numSamples * 2)
+    {
+        ++numMalformedPackets;
+        return;
+    }
+
+    if (receivedFirstPacket)
+    {
+        // Gaps of up to a second are filled with zeros, so the following samples keep their
+        // place in time. Anything further off is a restarted sender, which is followed as is
+        const int64 maxGap = jmax((int64) sample_rate, (int64) numSamples);
+        const int64 gap = firstSample - expectedSample;
+
+        if (gap < 0 && gap >= -maxGap)
+        {
+            ++numLatePackets;
+            return;
+        }
+
+        if (gap > 0 && gap <= maxGap)
+        {
+            numDroppedPackets += jmax(1, (int) (sequence - expectedSequence));
+            writeSamples(nullptr, 0, 0, (int) gap, expectedSample);
+        }
+    }
+
+    receivedFirstPacket = true;
+
+    writeSamples((const uint16*) (packet + headerSize), numSamples, 0, numSamples, firstSample);
+
+    expectedSequence = sequence + 1;
+    expectedSample = firstSample + numSamples;
+}
+
+bool EphysSocket::updateBuffer()
+{
+    const int numPackets = (protocol == TCP_SEQUENCED) ? receiveStream() : receiveDatagrams();
+
+    if (numPackets < 0) return false;
+
+    if (numPackets == 0) return true;
+
+    // The whole batch is converted straight into the free space of the buffer
+    DataBuffer* buffer = sourceBuffers[0];
+    buffer->prepareToWrite(std::numeric_limits<int>::max(), startIndex1, blockSize1, startIndex2, blockSize2);
+    numWritten = 0;
+
+    for (int i = 0; i < numPackets; i++)
+    {
+        if (packetSizes[i] < 0)
+            ++numMalformedPackets;
+        else
+            handlePacket(packetBuffer + i * maxPacketSize, packetSizes[i]);
+    }
+
+    buffer->finishedWrite(numWritten);
 
     return true;
-}
\ No newline at end of file
+}
@@ -20,8 +20,28 @@ namespace EphysSocketNode
         float getBitVolts(const DataChannel* chan) const override;
         int getNumChannels() const;
 
+        /** How the data arrives. In the sequenced formats every packet starts with a 16 byte
+            little-endian header:
+
+                bytes 0-3   sequence number, incremented by one for every packet
+                bytes 4-11  sample number of the first sample in the packet
+                bytes 12-13 number of channels
+                bytes 14-15 number of samples
+
+            followed by the samples as uint16, channel by channel if transpose is set or
+            sample by sample otherwise. The raw format has no header, and every datagram
+            holds exactly num_channels * num_samp samples.
+        */
+        enum Protocol
+        {
+            UDP_RAW = 0,
+            UDP_SEQUENCED,
+            TCP_SEQUENCED
+        };
+
         // User defined
         int port = 5000;
+        int protocol = UDP_RAW;
         float sample_rate = 30e3;
         float data_scale = 0.195;
         uint16_t data_offset = 32768;
@@ -32,6 +52,15 @@ namespace EphysSocketNode
         void resizeChanSamp();
         void tryToConnect();
 
+        /** Packets that never arrived in the sequenced formats. Their samples are filled with zeros */
+        int64 getNumDroppedPackets() const;
+
+        /** Packets that arrived after later ones had been written, and were discarded */
+        int64 getNumLatePackets() const;
+
+        /** Samples discarded because the buffer was full */
+        int64 getNumOverflowSamples() const;
+
         GenericEditor* createEditor(SourceNode* sn);
         static DataThread* createDataThread(SourceNode* sn);
 
@@ -42,12 +71,42 @@ namespace EphysSocketNode
         bool stopAcquisition()  override;
         void timerCallback() override;
 
+        /** Receives as many packets as are waiting, up to maxPackets, and returns how many */
+        int receiveDatagrams();
+        int receiveStream();
+
+        /** Writes a packet to the buffer, filling the samples of missing packets before it */
+        void handlePacket (const char* packet, int size);
+
+        /** Writes count samples of a packet from sample 'from' on to the buffer, or zeros if
+            samples is null */
+        void writeSamples (const uint16* samples, int packetSamples, int from, int count, int64 firstTimestamp);
+
         bool connected = false;
 
-       ScopedPointer<DatagramSocket> socket;
+        ScopedPointer<DatagramSocket> socket;
+        ScopedPointer<StreamingSocket> listener;
+        ScopedPointer<StreamingSocket> connection;
+
+        static const int headerSize = 16;
+        static const int maxPacketSize = 65536;
+        static const int maxPackets = 64;
+
+        HeapBlock<char> packetBuffer;
+        HeapBlock<int> packetSizes;
+
+        // space reserved in the DataBuffer for the packets of one updateBuffer() call
+        int startIndex1, blockSize1, startIndex2, blockSize2;
+        int numWritten;
+
+        uint32 expectedSequence;
+        int64 expectedSample;
+        bool receivedFirstPacket;
 
-        uint16_t *recvbuf;
-        float *convbuf;
+        int64 numDroppedPackets;
+        int64 numLatePackets;
+        int64 numMalformedPackets;
+        int64 numOverflowSamples;
 
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EphysSocket);
     };
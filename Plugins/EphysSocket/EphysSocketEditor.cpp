@@ -32,6 +32,21 @@ EphysSocketEditor::EphysSocketEditor(GenericProcessor* parentNode, EphysSocket *
     portText->setBounds(5, 70, 65, 15);
     addAndMakeVisible(portText);
 
+    // Format
+    protocolLabel = new Label("Format", "Format");
+    protocolLabel->setFont(Font("Small Text", 10, Font::plain));
+    protocolLabel->setBounds(5, 90, 65, 8);
+    protocolLabel->setColour(Label::textColourId, Colours::darkgrey);
+    addAndMakeVisible(protocolLabel);
+
+    protocolBox = new ComboBox("Format");
+    protocolBox->addItem("UDP", EphysSocket::UDP_RAW + 1);
+    protocolBox->addItem("UDP seq.", EphysSocket::UDP_SEQUENCED + 1);
+    protocolBox->addItem("TCP seq.", EphysSocket::TCP_SEQUENCED + 1);
+    protocolBox->setSelectedId(node->protocol + 1, dontSendNotification);
+    protocolBox->setBounds(5, 100, 65, 15);
+    addAndMakeVisible(protocolBox);
+
     //---
 
     // Num chans
@@ -110,6 +125,7 @@ void EphysSocketEditor::startAcquisition()
 {
     // Disable the whole gui
     portText->setEnabled(false);
+    protocolBox->setEnabled(false);
     chanText->setEnabled(false);
     sampText->setEnabled(false);
     fsText->setEnabled(false);
@@ -133,6 +149,7 @@ void EphysSocketEditor::stopAcquisition()
 {
     // Reenable the whole gui
     portText->setEnabled(true);
+    protocolBox->setEnabled(true);
     chanText->setEnabled(true);
     sampText->setEnabled(true);
     fsText->setEnabled(true);
@@ -146,6 +163,7 @@ void EphysSocketEditor::buttonEvent(Button* button)
 {
     // Only one button
     node->port = portText->getText().getIntValue();
+    node->protocol = protocolBox->getSelectedId() - 1;
     node->tryToConnect();
 }
 
@@ -154,6 +172,7 @@ void EphysSocketEditor::saveEditorParameters(XmlElement* xmlNode)
     XmlElement* parameters = xmlNode->createNewChildElement("PARAMETERS");
 
     parameters->setAttribute("port", portText->getText());
+    parameters->setAttribute("protocol", protocolBox->getSelectedId() - 1);
     parameters->setAttribute("numchan", chanText->getText());
     parameters->setAttribute("numsamp", sampText->getText());
     parameters->setAttribute("fs", fsText->getText());
@@ -168,11 +187,18 @@ void EphysSocketEditor::loadEditorParameters(XmlElement* xmlNode)
         if (subNode->hasTagName("PARAMETERS"))
         {
             portText->setText(subNode->getStringAttribute("port", ""));
+            protocolBox->setSelectedId(subNode->getIntAttribute("protocol", EphysSocket::UDP_RAW) + 1, dontSendNotification);
             chanText->setText(subNode->getStringAttribute("numchan", ""));
             sampText->setText(subNode->getStringAttribute("numsamp", ""));
             fsText->setText(subNode->getStringAttribute("fs", ""));
             scaleText->setText(subNode->getStringAttribute("scale", ""));
             offsetText->setText(subNode->getStringAttribute("offset", ""));
+
+            if (protocolBox->getSelectedId() == 0)
+                protocolBox->setSelectedId(EphysSocket::UDP_RAW + 1, dontSendNotification);
+
+            // reconnects with the loaded port and format, so the node receives what the editor shows
+            buttonEvent(connectButton);
         }
     }
 }
@@ -43,6 +43,10 @@ namespace EphysSocketNode
         ScopedPointer<Label> portLabel;
         ScopedPointer<TextEditor> portText;
 
+        // Format
+        ScopedPointer<Label> protocolLabel;
+        ScopedPointer<ComboBox> protocolBox;
+
         // Chans
         ScopedPointer<Label> chanLabel;
         ScopedPointer<TextEditor> chanText;
@@ -189,18 +189,16 @@ void EvntTrigAvg::handleEvent(const EventChannel* eventInfo, const MidiMessage&
 
 void EvntTrigAvg::handleSpike(const SpikeChannel* spikeInfo, const MidiMessage& event, int samplePosition)
 {
-    SpikeEventPtr newSpike = SpikeEvent::deserializeFromMessage(event, spikeInfo);
-    if (!newSpike)
+    SpikeEventView newSpike(event, spikeInfo);
+    if (!newSpike.isValid())
         return;
     else {
-        // extract information from spike
+        // extract information from spike, only the timestamp and sorted ID are needed
         
-        const SpikeChannel* chan = newSpike->getChannelInfo();
-        Array<SourceChannelInfo> chanInfo = chan->getSourceChannelInfo();
-        //int chanIDX = chanInfo[0].channelIDX;
-        int electrode = getSpikeChannelIndex(newSpike);
+        //int chanIDX = spikeInfo->getSourceChannelInfo()[0].channelIDX;
+        int electrode = getSpikeChannelIndex(spikeInfo->getSourceIndex(), spikeInfo->getSourceNodeID(), spikeInfo->getSubProcessorIdx());
         //std::cout<<"chanIDX: " << chanIDX << "\n";
-        int sortedID = newSpike->getSortedID();
+        int sortedID = newSpike.getSortedID();
         //int electrode = electrodeMap[chanInfo];
         if(sortedID!=0 && sortedID>idIndex.size()){ // respond to new sortedID
             idIndex.push_back(spikeData[electrode].size());// update map of what sorted ID is on what electrode
@@ -224,9 +222,9 @@ void EvntTrigAvg::handleSpike(const SpikeChannel* spikeInfo, const MidiMessage&
         int relativeSortedID = 0;
         if (sortedID>0)
             relativeSortedID = idIndex[sortedID-1];
-        spikeData[electrode][0].push_back(newSpike->getTimestamp());
+        spikeData[electrode][0].push_back(newSpike.getTimestamp());
         if (sortedID>0)
-            spikeData[electrode][relativeSortedID].push_back(newSpike->getTimestamp());
+            spikeData[electrode][relativeSortedID].push_back(newSpike.getTimestamp());
     }
 }
 
@@ -82,6 +82,22 @@ FilterEditor::FilterEditor(GenericProcessor* parentNode, bool useDefaultParamete
     applyFilterOnChan->setTooltip("When this button is off, selected channels will not be filtered");
     addAndMakeVisible(applyFilterOnChan);
 
+    firModeButton = new UtilityButton("FIR",Font("Default", 10, Font::plain));
+    firModeButton->addListener(this);
+    firModeButton->setBounds(90,27,40,18);
+    firModeButton->setClickingTogglesState(true);
+    firModeButton->setTooltip("Use linear-phase FIR filters, which don't distort spike waveforms but delay the signal");
+    addAndMakeVisible(firModeButton);
+
+    partitionSizeSelector = new ComboBox("FIR partition size");
+    for (int size = 64; size <= 512; size *= 2)
+        partitionSizeSelector->addItem(String(size), size);
+    partitionSizeSelector->setSelectedId(256, dontSendNotification);
+    partitionSizeSelector->setBounds(85,47,55,18);
+    partitionSizeSelector->setTooltip("FIR block size in samples. Smaller blocks reduce the latency and increase the CPU load");
+    partitionSizeSelector->addListener(this);
+    addAndMakeVisible(partitionSizeSelector);
+
 }
 
 FilterEditor::~FilterEditor()
@@ -177,6 +193,15 @@ void FilterEditor::channelChanged (int channel, bool /*newState*/)
 
 }
 
+void FilterEditor::comboBoxChanged(ComboBox* comboBox)
+{
+    if (comboBox == partitionSizeSelector)
+    {
+        FilterNode* fn = (FilterNode*) getProcessor();
+        fn->setFirPartitionSize(partitionSizeSelector->getSelectedId());
+    }
+}
+
 void FilterEditor::buttonEvent(Button* button)
 {
 
@@ -186,6 +211,11 @@ void FilterEditor::buttonEvent(Button* button)
         fn->setApplyOnADC(applyFilterOnADC->getToggleState());
 
     }
+    else if (button == firModeButton)
+    {
+        FilterNode* fn = (FilterNode*) getProcessor();
+        fn->setFirMode(firModeButton->getToggleState());
+    }
     else if (button == applyFilterOnChan)
     {
         FilterNode* fn = (FilterNode*) getProcessor();
@@ -215,6 +245,8 @@ void FilterEditor::saveCustomParameters(XmlElement* xml)
     textLabelValues->setAttribute("HighCut",lastHighCutString);
     textLabelValues->setAttribute("LowCut",lastLowCutString);
     textLabelValues->setAttribute("ApplyToADC",	applyFilterOnADC->getToggleState());
+    textLabelValues->setAttribute("FIR", firModeButton->getToggleState());
+    textLabelValues->setAttribute("FIRPartitionSize", partitionSizeSelector->getSelectedId());
 }
 
 void FilterEditor::loadCustomParameters(XmlElement* xml)
@@ -229,6 +261,8 @@ void FilterEditor::loadCustomParameters(XmlElement* xml)
             resetToSavedText();
 
             applyFilterOnADC->setToggleState(xmlNode->getBoolAttribute("ApplyToADC",false), sendNotification);
+            partitionSizeSelector->setSelectedId(xmlNode->getIntAttribute("FIRPartitionSize", 256), sendNotificationSync);
+            firModeButton->setToggleState(xmlNode->getBoolAttribute("FIR", false), sendNotification);
         }
     }
 
@@ -38,7 +38,8 @@ class FilterViewport;
 */
 
 class FilterEditor : public GenericEditor,
-    public Label::Listener
+    public Label::Listener,
+    public ComboBox::Listener
 {
 public:
     FilterEditor(GenericProcessor* parentNode, bool useDefaultParameterEditors);
@@ -46,6 +47,7 @@ public:
 
     void buttonEvent(Button* button);
     void labelTextChanged(Label* label);
+    void comboBoxChanged(ComboBox* comboBox);
 
     void saveCustomParameters(XmlElement* xml);
     void loadCustomParameters(XmlElement* xml);
@@ -67,6 +69,8 @@ private:
     ScopedPointer<Label> lowCutValue;
     ScopedPointer<UtilityButton> applyFilterOnADC;
     ScopedPointer<UtilityButton> applyFilterOnChan;
+    ScopedPointer<UtilityButton> firModeButton;
+    ScopedPointer<ComboBox> partitionSizeSelector;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FilterEditor);
 
@@ -24,9 +24,15 @@
 #include "FilterNode.h"
 #include "FilterEditor.h"
 
+// Number of samples over which cutoff changes are smoothed. Transitions only
+// interpolate the coefficients of the filter, so they are cheap on any channel count.
+static const int filterTransitionSamples = 256;
+
 
 FilterNode::FilterNode()
     : GenericProcessor  ("Bandpass Filter")
+    , useFirFilters     (false)
+    , firPartitionSize  (256)
     , defaultLowCut     (300.0f)
     , defaultHighCut    (6000.0f)
 {
@@ -149,7 +155,7 @@ void FilterNode::updateSettings()
                          <Dsp::Butterworth::Design::BandPass    // design type
                          <2>,                                   // order
                          1,                                     // number of channels (must be const)
-                         Dsp::DirectFormII> (1));               // realization
+                         Dsp::DirectFormII> (filterTransitionSamples)); // realization
 
 
             //Parameter& p1 =  parameters.getReference(0);
@@ -183,6 +189,8 @@ void FilterNode::updateSettings()
     }
 
     setApplyOnADC (applyOnADC);
+
+    updateFirGroups();
 }
 
 
@@ -240,6 +248,9 @@ void FilterNode::setParameter (int parameterIndex, float newValue)
                              highCuts[currentChannel],
                              currentChannel);
 
+        if (useFirFilters)
+            updateFirGroups();
+
         editor->updateParameterButtons (parameterIndex);
     }
     // change channel bypass state
@@ -253,12 +264,35 @@ void FilterNode::setParameter (int parameterIndex, float newValue)
         {
             shouldFilterChannel.set (currentChannel, true);
         }
+
+        if (useFirFilters)
+            updateFirGroups();
     }
 }
 
 
 void FilterNode::process (AudioSampleBuffer& buffer)
 {
+    const ScopedLock firScopedLock (firLock);
+
+    // there are FIR groups only in FIR mode, and if some channel is filtered
+    if (firGroups.size() > 0)
+    {
+        float* channels[PartitionedConvolver::maxChannels];
+
+        for (int g = 0; g < firGroups.size(); ++g)
+        {
+            FirGroup* group = firGroups.getUnchecked (g);
+
+            for (int c = 0; c < group->channels.size(); ++c)
+                channels[c] = buffer.getWritePointer (group->channels[c]);
+
+            group->convolver.process (channels, group->channels.size(), getNumSamples (group->channels[0]));
+        }
+
+        return;
+    }
+
     for (int n = 0; n < getNumOutputs(); ++n)
     {
         if (shouldFilterChannel[n])
@@ -288,6 +322,105 @@ void FilterNode::setApplyOnADC (bool state)
 }
 
 
+void FilterNode::setFirMode (bool state)
+{
+    useFirFilters = state;
+    updateFirGroups();
+}
+
+
+bool FilterNode::getFirMode() const
+{
+    return useFirFilters;
+}
+
+
+void FilterNode::setFirPartitionSize (int size)
+{
+    if (size == firPartitionSize || ! isPowerOfTwo (size))
+        return;
+
+    firPartitionSize = size;
+
+    if (useFirFilters)
+        updateFirGroups();
+}
+
+
+int FilterNode::getFirPartitionSize() const
+{
+    return firPartitionSize;
+}
+
+
+void FilterNode::updateFirGroups()
+{
+    OwnedArray<FirGroup> newGroups;
+
+    if (useFirFilters)
+    {
+        const int numChannels = jmin (getNumInputs(), dataChannelArray.size(), lowCuts.size());
+
+        for (int n = 0; n < numChannels; ++n)
+        {
+            if (! shouldFilterChannel[n])
+                continue;
+
+            // kernels are shared, so this only designs one the first time a setting is used
+            PartitionedConvolver::KernelPtr kernel = PartitionedConvolver::getBandPassKernel (dataChannelArray[n]->getSampleRate(),
+                                                                                             lowCuts[n], highCuts[n],
+                                                                                             firPartitionSize);
+            const uint16 sourceNodeId    = dataChannelArray[n]->getSourceNodeID();
+            const uint16 subProcessorIdx = dataChannelArray[n]->getSubProcessorIdx();
+
+            FirGroup* group = nullptr;
+
+            for (int g = newGroups.size(); --g >= 0;)
+            {
+                FirGroup* candidate = newGroups.getUnchecked (g);
+
+                if (candidate->convolver.getKernel() == kernel
+                    && candidate->sourceNodeId == sourceNodeId
+                    && candidate->subProcessorIdx == subProcessorIdx
+                    && candidate->channels.size() < PartitionedConvolver::maxChannels)
+                {
+                    group = candidate;
+                    break;
+                }
+            }
+
+            if (group == nullptr)
+            {
+                group = newGroups.add (new FirGroup());
+                group->convolver.prepare (kernel);
+                group->sourceNodeId    = sourceNodeId;
+                group->subProcessorIdx = subProcessorIdx;
+            }
+
+            group->channels.add (n);
+        }
+    }
+
+    const ScopedLock firScopedLock (firLock);
+
+    // groups that didn't change keep filtering without restarting
+    for (int g = 0; g < newGroups.size(); ++g)
+    {
+        for (int old = 0; old < firGroups.size(); ++old)
+        {
+            if (firGroups[old]->convolver.getKernel() == newGroups[g]->convolver.getKernel()
+                && firGroups[old]->channels == newGroups[g]->channels)
+            {
+                newGroups.set (g, firGroups.removeAndReturn (old));
+                break;
+            }
+        }
+    }
+
+    firGroups.swapWith (newGroups);
+}
+
+
 void FilterNode::saveCustomChannelParametersToXml(XmlElement* channelInfo, int channelNumber, InfoObjectCommon::InfoObjectType channelType)
 {
     if (channelType == InfoObjectCommon::DATA_CHANNEL
@@ -324,5 +457,9 @@ void FilterNode::loadCustomChannelParametersFromXml(XmlElement* channelInfo, Inf
                 setFilterParameters (lowCuts[channelNum], highCuts[channelNum], channelNum);
             }
         }
+
+        // the FIR groups are built once, when the last channel has been loaded
+        if (useFirFilters && channelInfo->getNextElementWithTagName ("CHANNEL") == nullptr)
+            updateFirGroups();
     }
 }
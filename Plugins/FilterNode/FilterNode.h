@@ -60,17 +60,43 @@ public:
 
     void setApplyOnADC (bool state);
 
+    /** Switches between the IIR filters and linear-phase FIR filters, which preserve
+        spike waveforms at the cost of some latency */
+    void setFirMode (bool state);
+    bool getFirMode() const;
+
+    /** Sets the partition size, and therefore the added latency, of the FIR filters */
+    void setFirPartitionSize (int size);
+    int getFirPartitionSize() const;
+
 
 private:
     void setFilterParameters (double, double, int);
 
+    /** Regroups the channels filtered in FIR mode, keeping the state of the unchanged groups */
+    void updateFirGroups();
+
+    /** Channels from the same subprocessor that use the same FIR kernel */
+    struct FirGroup
+    {
+        PartitionedConvolver convolver;
+        Array<int> channels;
+        uint16 sourceNodeId;
+        uint16 subProcessorIdx;
+    };
+
     Array<double> lowCuts;
     Array<double> highCuts;
 
     OwnedArray<Dsp::Filter> filters;
     Array<bool> shouldFilterChannel;
 
+    OwnedArray<FirGroup> firGroups;
+    CriticalSection firLock;
+
     bool applyOnADC;
+    bool useFirFilters;
+    int firPartitionSize;
 
     double defaultLowCut;
     double defaultHighCut;
@@ -29,3 +29,4 @@ data from external hardware.
 #include "../../JuceLibraryCode/JuceHeader.h"
 #include "../../Source/Processors/DataThreads/DataThread.h"
 #include "../../Source/Processors/SourceNode/SourceNode.h"
+#include "../../Source/Utils/LatencyProbe.h"
@@ -26,3 +26,5 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "../../Source/Processors/Dsp/Dsp.h"
+#include "../../Source/Processors/Dsp/PartitionedConvolver.h"
+#include "../../Source/Processors/Dsp/PolyphaseResampler.h"
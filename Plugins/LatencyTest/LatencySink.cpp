@@ -0,0 +1,76 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "LatencySink.h"
+
+using namespace LatencyTest;
+
+LatencySink::LatencySink()
+    : GenericProcessor  ("Latency Sink")
+    , bytesEchoed       (0)
+{
+    setProcessorType (PROCESSOR_TYPE_SINK);
+}
+
+LatencySink::~LatencySink()
+{
+    serial.close();
+}
+
+bool LatencySink::enable()
+{
+    bytesEchoed = 0;
+    return serial.setup ("loopback", 115200);
+}
+
+bool LatencySink::disable()
+{
+    std::cout << "Latency Sink: " << bytesEchoed << " bytes echoed by the loopback port" << std::endl;
+    serial.close();
+    return true;
+}
+
+void LatencySink::process (AudioSampleBuffer& buffer)
+{
+    unsigned char echo[64];
+    int numRead;
+
+    while ((numRead = serial.readBytes (echo, sizeof (echo))) > 0)
+        bytesEchoed += numRead;
+
+    checkForEvents();
+}
+
+void LatencySink::handleEvent (const EventChannel* eventInfo, const MidiMessage& event, int sampleNum)
+{
+    if (Event::getEventType (event) != EventChannel::TTL)
+        return;
+
+    TTLEventPtr ttl = TTLEvent::deserializeFromMessage (event, eventInfo);
+
+    if (ttl->getState())
+    {
+        LatencyProbe::markTimestamp (LatencyProbe::OUTPUT_HANDLED, ttl->getTimestamp());
+        serial.writeByte (uint8 (ttl->getChannel() + 1));
+    }
+}
@@ -0,0 +1,63 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef LATENCYSINK_H_INCLUDED
+#define LATENCYSINK_H_INCLUDED
+
+#include <ProcessorHeaders.h>
+#include <SerialLib.h>
+
+namespace LatencyTest
+{
+    /**
+        Output sink that stands in for serial output devices when measuring latency.
+
+        Rising TTL edges are answered with a one-byte command written to a loopback
+        ofSerial port, going through the same path as the Arduino and Pulse Pal outputs
+        without needing the hardware. The echoed bytes are read back on the next block.
+
+        @see LatencyTestThread, LatencyProbe
+    */
+    class LatencySink : public GenericProcessor
+    {
+    public:
+        LatencySink();
+        ~LatencySink();
+
+        void process (AudioSampleBuffer& buffer) override;
+
+        void handleEvent (const EventChannel* eventInfo, const MidiMessage& event, int sampleNum) override;
+
+        bool enable() override;
+        bool disable() override;
+
+    private:
+        ofSerial serial;
+
+        int64 bytesEchoed;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LatencySink);
+    };
+}
+
+#endif  // LATENCYSINK_H_INCLUDED
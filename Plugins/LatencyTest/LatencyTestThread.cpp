@@ -0,0 +1,165 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "LatencyTestThread.h"
+
+using namespace LatencyTest;
+
+DataThread* LatencyTestThread::createDataThread (SourceNode* sn)
+{
+    return new LatencyTestThread (sn);
+}
+
+LatencyTestThread::LatencyTestThread (SourceNode* sn)
+    : DataThread        (sn)
+    , sampleRate        (30000.0f)
+    , pulseDuration     (30)
+    , pulseAmplitude    (500.0f)
+    , chunk             (numChannels * samplesPerChunk)
+    , startTicks        (0)
+    , samplesGenerated  (0)
+    , nextPulse         (0)
+{
+    sourceBuffers.add (new DataBuffer (numChannels, samplesPerChunk * 1000));
+
+    timestamps.insertMultiple (0, 0, samplesPerChunk);
+    ttlEventWords.insertMultiple (0, 0, samplesPerChunk);
+}
+
+LatencyTestThread::~LatencyTestThread()
+{
+}
+
+bool LatencyTestThread::foundInputSource()
+{
+    return true;
+}
+
+int LatencyTestThread::getNumDataOutputs (DataChannel::DataChannelTypes type, int subProcessor) const
+{
+    if (type == DataChannel::HEADSTAGE_CHANNEL)
+        return numChannels;
+    else
+        return 0;
+}
+
+int LatencyTestThread::getNumTTLOutputs (int subProcessor) const
+{
+    return 1;
+}
+
+float LatencyTestThread::getSampleRate (int subProcessor) const
+{
+    return sampleRate;
+}
+
+float LatencyTestThread::getBitVolts (const DataChannel* chan) const
+{
+    return 0.195f;
+}
+
+bool LatencyTestThread::startAcquisition()
+{
+    samplesGenerated = 0;
+    nextPulse = 0;
+    scheduleNextPulse();
+
+    sourceBuffers[0]->clear();
+
+    LatencyProbe::setEnabled (true);
+    LatencyProbe::beginRun ("chunks of " + String (samplesPerChunk) + " samples");
+
+    startTicks = Time::getHighResolutionTicks();
+    startThread();
+
+    return true;
+}
+
+bool LatencyTestThread::stopAcquisition()
+{
+    if (isThreadRunning())
+        signalThreadShouldExit();
+
+    waitForThreadToExit (500);
+
+    LatencyProbe::endRun();
+    LatencyProbe::setEnabled (false);
+
+    std::cout << LatencyProbe::getReport() << std::endl;
+
+    sourceBuffers[0]->clear();
+    return true;
+}
+
+void LatencyTestThread::scheduleNextPulse()
+{
+    // random intervals, so the pulses fall anywhere in the processing blocks
+    nextPulse += int64 (sampleRate * (0.2f + 0.1f * random.nextFloat()));
+}
+
+bool LatencyTestThread::updateBuffer()
+{
+    const double elapsed = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - startTicks);
+
+    if (int64 (elapsed * sampleRate) < samplesGenerated + samplesPerChunk)
+    {
+        sleep (1);
+        return true;
+    }
+
+    bool pulseStarted = false;
+    int64 pulseStart = nextPulse;
+
+    for (int i = 0; i < samplesPerChunk; ++i)
+    {
+        const int64 timestamp = samplesGenerated + i;
+        const bool high = timestamp >= nextPulse && timestamp < nextPulse + pulseDuration;
+
+        if (timestamp == nextPulse)
+            pulseStarted = true;
+
+        float* sample = chunk + i * numChannels;
+
+        for (int c = 0; c < numChannels; ++c)
+            sample[c] = 20.0f * (random.nextFloat() - 0.5f);
+
+        if (high)
+            sample[0] += pulseAmplitude;
+
+        timestamps.set (i, timestamp);
+        ttlEventWords.set (i, high ? 1 : 0);
+
+        if (timestamp == nextPulse + pulseDuration - 1)
+            scheduleNextPulse();
+    }
+
+    // registered before the write, so the audio thread can't read the pulse before it is known
+    if (pulseStarted)
+        LatencyProbe::markPulse (pulseStart, pulseDuration);
+
+    sourceBuffers[0]->addToBuffer (chunk, &timestamps.getReference (0), &ttlEventWords.getReference (0), samplesPerChunk, 1);
+
+    samplesGenerated += samplesPerChunk;
+
+    return true;
+}
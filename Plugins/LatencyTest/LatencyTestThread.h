@@ -0,0 +1,82 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef LATENCYTESTTHREAD_H_INCLUDED
+#define LATENCYTESTTHREAD_H_INCLUDED
+
+#include <DataThreadHeaders.h>
+
+namespace LatencyTest
+{
+    /**
+        Synthetic source for measuring the closed-loop latency of a signal chain.
+
+        Generates background noise paced in real time, with test pulses at random intervals.
+        Each pulse raises TTL line 0 and adds a square pulse to channel 0 for pulseDuration
+        samples, so it can be followed either as a TTL event or through a detector. The
+        pulses are registered with the LatencyProbe as they are written into the DataBuffer.
+
+        Each acquisition is a LatencyProbe run, whose report is printed when it stops.
+
+        @see LatencyProbe, LatencySink
+    */
+    class LatencyTestThread : public DataThread
+    {
+    public:
+        LatencyTestThread (SourceNode* sn);
+        ~LatencyTestThread();
+
+        bool foundInputSource() override;
+        int getNumDataOutputs (DataChannel::DataChannelTypes type, int subProcessor) const override;
+        int getNumTTLOutputs (int subProcessor) const override;
+        float getSampleRate (int subProcessor) const override;
+        float getBitVolts (const DataChannel* chan) const override;
+
+        static DataThread* createDataThread (SourceNode* sn);
+
+        static const int numChannels = 16;
+        static const int samplesPerChunk = 30;
+
+    private:
+        bool updateBuffer() override;
+        bool startAcquisition() override;
+        bool stopAcquisition() override;
+
+        void scheduleNextPulse();
+
+        const float sampleRate;
+        const int pulseDuration;
+        const float pulseAmplitude;
+
+        Random random;
+        HeapBlock<float> chunk;
+
+        int64 startTicks;
+        int64 samplesGenerated;
+        int64 nextPulse;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LatencyTestThread);
+    };
+}
+
+#endif  // LATENCYTESTTHREAD_H_INCLUDED
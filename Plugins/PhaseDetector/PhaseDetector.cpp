@@ -64,8 +64,11 @@ void PhaseDetector::addModule()
     m.samplesSinceTrigger = 5000;
     m.wasTriggered = false;
     m.phase = NO_PHASE;
+    m.usePrediction = false;
+    m.lastPhaseDifference = 0.0f;
 
     modules.add (m);
+    estimators.add (new PhaseEstimator());
 }
 
 
@@ -129,6 +132,14 @@ void PhaseDetector::setParameter (int parameterIndex, float newValue)
             module.isActive = false;
         }
     }
+    else if (parameterIndex == 5)   // prediction on/off
+    {
+        module.usePrediction = newValue > 0;
+    }
+    else if (parameterIndex == 6)   // latency compensation, in ms
+    {
+        estimators[activeModule]->setLatencyCompensation (newValue);
+    }
 }
 
 //Usually, to be more ordered, we'd create the event channels overriding the createEventChannels() method.
@@ -187,6 +198,35 @@ void PhaseDetector::updateSettings()
 
 bool PhaseDetector::enable()
 {
+    for (int m = 0; m < modules.size(); ++m)
+    {
+        DetectorModule& module = modules.getReference (m);
+        const DataChannel* in = getDataChannel (module.inputChan);
+
+        if (in != nullptr)
+            estimators[m]->prepare (in->getSampleRate());
+
+        module.lastPhaseDifference = 0.0f;
+    }
+
+    return true;
+}
+
+
+bool PhaseDetector::disable()
+{
+    for (int m = 0; m < modules.size(); ++m)
+    {
+        const PhaseEstimator* estimator = estimators[m];
+
+        if (modules[m].usePrediction && estimator->getNumMeasuredEvents() > 0)
+        {
+            std::cout << "Phase detector " << m + 1 << ": " << estimator->getNumMeasuredEvents()
+                      << " events measured, phase error " << estimator->getMeanPhaseError()
+                      << " +/- " << estimator->getPhaseErrorDeviation() << " degrees" << std::endl;
+        }
+    }
+
     return true;
 }
 
@@ -236,19 +276,51 @@ void PhaseDetector::process (AudioSampleBuffer& buffer)
             && module.inputChan >= 0
             && module.inputChan < buffer.getNumChannels())
         {
-            for (int i = 0; i < getNumSamples (module.inputChan); ++i)
+            const float* samples = buffer.getReadPointer (module.inputChan);
+            const int numSamples = getNumSamples (module.inputChan);
+            const int64 timestamp = getTimestamp (module.inputChan);
+
+            PhaseEstimator* estimator = estimators[m];
+            const float targetPhase = getTargetPhase (module.type);
+
+            for (int i = 0; i < numSamples; ++i)
             {
-                const float sample = *buffer.getReadPointer (module.inputChan, i);
+                const float sample = samples[i];
 
-                if (sample < module.lastSample
+                if (module.usePrediction)
+                {
+                    if (estimator->addSample (sample))
+                    {
+                        float difference = estimator->getPredictedPhase() - targetPhase;
+
+                        if (difference > float_Pi)
+                            difference -= 2 * float_Pi;
+                        else if (difference <= -float_Pi)
+                            difference += 2 * float_Pi;
+
+                        // the predicted phase just went past the target
+                        if (module.type != NONE
+                            && ! module.wasTriggered
+                            && module.lastPhaseDifference < 0
+                            && difference >= 0
+                            && difference < float_Pi / 2)
+                        {
+                            addTTLEvent (m, i, timestamp, true);
+                            estimator->registerEvent (targetPhase);
+                            module.samplesSinceTrigger = 0;
+                            module.wasTriggered = true;
+                        }
+
+                        module.lastPhaseDifference = difference;
+                    }
+                }
+                else if (sample < module.lastSample
                     && sample > 0
                     && module.phase != FALLING_POS)
                 {
                     if (module.type == PEAK)
                     {
-						uint8 ttlData = 1 << module.outputChan;
-						TTLEventPtr event = TTLEvent::createTTLEvent(moduleEventChannels[m], getTimestamp(module.inputChan) + i, &ttlData, sizeof(uint8), module.outputChan);
-						addEvent(moduleEventChannels[m], event, i);
+                        addTTLEvent (m, i, timestamp, true);
                         module.samplesSinceTrigger = 0;
                         module.wasTriggered = true;
                     }
@@ -261,9 +333,7 @@ void PhaseDetector::process (AudioSampleBuffer& buffer)
                 {
                     if (module.type == FALLING_ZERO)
                     {
-						uint8 ttlData = 1 << module.outputChan;
-						TTLEventPtr event = TTLEvent::createTTLEvent(moduleEventChannels[m], getTimestamp(module.inputChan) + i, &ttlData, sizeof(uint8), module.outputChan);
-						addEvent(moduleEventChannels[m], event, i);
+                        addTTLEvent (m, i, timestamp, true);
                         module.samplesSinceTrigger = 0;
                         module.wasTriggered = true;
                     }
@@ -274,9 +344,7 @@ void PhaseDetector::process (AudioSampleBuffer& buffer)
                 {
                     if (module.type == TROUGH)
                     {
-						uint8 ttlData = 1 << module.outputChan;
-						TTLEventPtr event = TTLEvent::createTTLEvent(moduleEventChannels[m], getTimestamp(module.inputChan) + i, &ttlData, sizeof(uint8), module.outputChan);
-						addEvent(moduleEventChannels[m], event, i);
+                        addTTLEvent (m, i, timestamp, true);
                         module.samplesSinceTrigger = 0;
                         module.wasTriggered = true;
                     }
@@ -289,9 +357,7 @@ void PhaseDetector::process (AudioSampleBuffer& buffer)
                 {
                     if (module.type == RISING_ZERO)
                     {
-						uint8 ttlData = 1 << module.outputChan;
-						TTLEventPtr event = TTLEvent::createTTLEvent(moduleEventChannels[m], getTimestamp(module.inputChan) + i, &ttlData, sizeof(uint8), module.outputChan);
-						addEvent(moduleEventChannels[m], event, i);
+                        addTTLEvent (m, i, timestamp, true);
                         module.samplesSinceTrigger = 0;
                         module.wasTriggered = true;
                     }
@@ -305,9 +371,7 @@ void PhaseDetector::process (AudioSampleBuffer& buffer)
                 {
                     if (module.samplesSinceTrigger > 1000)
                     {
-						uint8 ttlData = 0;
-						TTLEventPtr event = TTLEvent::createTTLEvent(moduleEventChannels[m], getTimestamp(module.inputChan) + i, &ttlData, sizeof(uint8), module.outputChan);
-						addEvent(moduleEventChannels[m], event, i);
+                        addTTLEvent (m, i, timestamp, false);
                         module.wasTriggered = false;
                     }
                     else
@@ -321,7 +385,24 @@ void PhaseDetector::process (AudioSampleBuffer& buffer)
 }
 
 
-void PhaseDetector::estimateFrequency()
+void PhaseDetector::addTTLEvent (int moduleIndex, int sampleIndex, int64 timestamp, bool state)
 {
+    const DetectorModule& module = modules.getReference (moduleIndex);
+
+    uint8 ttlData = state ? 1 << module.outputChan : 0;
+    TTLEventPtr event = TTLEvent::createTTLEvent (moduleEventChannels[moduleIndex], timestamp + sampleIndex, &ttlData, sizeof (uint8), module.outputChan);
+    addEvent (moduleEventChannels[moduleIndex], event, sampleIndex);
 }
 
+
+float PhaseDetector::getTargetPhase (ModuleType type)
+{
+    switch (type)
+    {
+        case PEAK:          return 0.0f;
+        case FALLING_ZERO:  return float_Pi / 2;
+        case TROUGH:        return float_Pi;
+        case RISING_ZERO:   return 3 * float_Pi / 2;
+        default:            return 0.0f;
+    }
+}
@@ -26,6 +26,7 @@
 
 
 #include <ProcessorHeaders.h>
+#include "PhaseEstimator.h"
 
 #define NUM_INTERVALS 5
 
@@ -34,6 +35,9 @@
 
     Uses peaks to estimate the phase of a continuous signal.
 
+    Modules can also predict the phase with a PhaseEstimator, to trigger at the
+    selected phase ahead of time and compensate for the latency of the loop.
+
     @see GenericProcessor, PhaseDetectorEditor
 */
 class PhaseDetector : public GenericProcessor
@@ -50,6 +54,7 @@ public:
     void setParameter (int parameterIndex, float newValue) override;
 
     bool enable() override;
+    bool disable() override;
 
     void updateSettings() override;
 
@@ -60,7 +65,7 @@ public:
 private:
     void handleEvent (const EventChannel* channelInfo, const MidiMessage& event, int sampleNum) override;
 
-    void estimateFrequency();
+    void addTTLEvent (int moduleIndex, int sampleIndex, int64 timestamp, bool state);
 
     enum ModuleType
     {
@@ -86,9 +91,16 @@ private:
 
         ModuleType type;
         PhaseType phase;
+
+        bool usePrediction;
+        float lastPhaseDifference;
     };
 
+    /** Phase of the analytic signal at which a module type triggers */
+    static float getTargetPhase (ModuleType type);
+
     Array<DetectorModule> modules;
+    OwnedArray<PhaseEstimator> estimators;
 
     int activeModule;
 
@@ -189,6 +189,8 @@ void PhaseDetectorEditor::saveCustomParameters(XmlElement* xml)
         d->setAttribute("INPUT",interfaces[i]->getInputChan());
         d->setAttribute("GATE",interfaces[i]->getGateChan());
         d->setAttribute("OUTPUT",interfaces[i]->getOutputChan());
+        d->setAttribute("PREDICT",interfaces[i]->getPrediction());
+        d->setAttribute("LATENCY",interfaces[i]->getLatencyCompensation());
     }
 }
 
@@ -211,6 +213,8 @@ void PhaseDetectorEditor::loadCustomParameters(XmlElement* xml)
             interfaces[i]->setInputChan(xmlNode->getIntAttribute("INPUT"));
             interfaces[i]->setGateChan(xmlNode->getIntAttribute("GATE"));
             interfaces[i]->setOutputChan(xmlNode->getIntAttribute("OUTPUT"));
+            interfaces[i]->setPrediction(xmlNode->getBoolAttribute("PREDICT", false));
+            interfaces[i]->setLatencyCompensation(xmlNode->getDoubleAttribute("LATENCY", 0.0));
 
             i++;
         }
@@ -293,6 +297,23 @@ DetectorInterface::DetectorInterface(PhaseDetector* pd, Colour c, int id) :
     outputSelector->setSelectedId(1);
     addAndMakeVisible(outputSelector);
 
+    predictionButton = new UtilityButton("PREDICT", Font("Small Text", 9, Font::plain));
+    predictionButton->setBounds(5,62,45,15);
+    predictionButton->setClickingTogglesState(true);
+    predictionButton->setTooltip("Predict the phase to trigger ahead of time, instead of detecting it after the fact");
+    predictionButton->addListener(this);
+    addAndMakeVisible(predictionButton);
+
+    latencyValue = new Label("latency", "0");
+    latencyValue->setBounds(55,62,30,15);
+    latencyValue->setFont(Font("Default", 12, Font::plain));
+    latencyValue->setColour(Label::textColourId, Colours::white);
+    latencyValue->setColour(Label::backgroundColourId, Colours::grey);
+    latencyValue->setEditable(true);
+    latencyValue->setTooltip("Latency between the event and the stimulation, in ms, which the prediction looks ahead");
+    latencyValue->addListener(this);
+    addAndMakeVisible(latencyValue);
+
 
     std::cout << "Updating channels" << std::endl;
 
@@ -341,6 +362,12 @@ void DetectorInterface::comboBoxChanged(ComboBox* c)
 
 void DetectorInterface::buttonClicked(Button* b)
 {
+    if (b == predictionButton)
+    {
+        processor->setActiveModule(idNum);
+        processor->setParameter(5, predictionButton->getToggleState() ? 1.0f : 0.0f);
+        return;
+    }
 
     ElectrodeButton* pb = (ElectrodeButton*) b;
 
@@ -352,6 +379,15 @@ void DetectorInterface::buttonClicked(Button* b)
 
 }
 
+void DetectorInterface::labelTextChanged(Label* label)
+{
+    float latency = jlimit(0.0f, 500.0f, label->getText().getFloatValue());
+    label->setText(String(latency), dontSendNotification);
+
+    processor->setActiveModule(idNum);
+    processor->setParameter(6, latency);
+}
+
 void DetectorInterface::updateChannels(int numChannels)
 {
 
@@ -383,6 +419,7 @@ void DetectorInterface::paint(Graphics& g)
     g.drawText("INPUT",50,10,85,10,Justification::right, true);
     g.drawText("GATE",50,35,85,10,Justification::right, true);
     g.drawText("OUTPUT",50,60,85,10,Justification::right, true);
+    g.drawText("ms",87,65,15,10,Justification::left, true);
 
 }
 
@@ -448,9 +485,37 @@ int DetectorInterface::getGateChan()
 {
     return gateSelector->getSelectedId()-2;
 }
+
+void DetectorInterface::setPrediction(bool state)
+{
+    predictionButton->setToggleState(state, dontSendNotification);
+
+    processor->setActiveModule(idNum);
+    processor->setParameter(5, state ? 1.0f : 0.0f);
+}
+
+void DetectorInterface::setLatencyCompensation(float milliseconds)
+{
+    latencyValue->setText(String(milliseconds), dontSendNotification);
+
+    processor->setActiveModule(idNum);
+    processor->setParameter(6, milliseconds);
+}
+
+bool DetectorInterface::getPrediction()
+{
+    return predictionButton->getToggleState();
+}
+
+float DetectorInterface::getLatencyCompensation()
+{
+    return latencyValue->getText().getFloatValue();
+}
 void DetectorInterface::setEnableStatus(bool status)
 {
 	inputSelector->setEnabled(status);
 	for (int i = 0; i < phaseButtons.size(); i++)
 		phaseButtons[i]->setEnabled(status);
+	predictionButton->setEnabled(status);
+	latencyValue->setEditable(status);
 }
\ No newline at end of file
@@ -0,0 +1,279 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2019 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PhaseEstimator.h"
+#include <cmath>
+
+
+PhaseEstimator::PhaseEstimator()
+    : forwardTransform      (transformOrder, false)
+    , inverseTransform      (transformOrder, true)
+    , decimationFactor      (1)
+    , decimatedSampleRate   (targetSampleRate)
+    , latencyCompensation   (0.0f)
+    , compensationSamples   (0)
+{
+    static_assert (historySize + forecastSize == transformSize, "the transform spans the history and the forecast");
+
+    history.allocate (historySize, true);
+    extended.allocate (transformSize, true);
+    transformInput.allocate (transformSize, true);
+    transformOutput.allocate (transformSize, true);
+
+    reset();
+}
+
+
+PhaseEstimator::~PhaseEstimator()
+{
+}
+
+
+void PhaseEstimator::prepare (float sampleRate)
+{
+    decimationFactor    = jmax (1, roundToInt (sampleRate / targetSampleRate));
+    decimatedSampleRate = sampleRate / decimationFactor;
+
+    setLatencyCompensation (latencyCompensation);
+    reset();
+}
+
+
+void PhaseEstimator::reset()
+{
+    decimationCount = 0;
+    decimationSum = 0;
+    numDecimatedSamples = 0;
+
+    FloatVectorOperations::clear (history, historySize);
+
+    for (int k = 0; k <= modelOrder; ++k)
+        coefficients[k] = 0;
+
+    samplesSinceModelUpdate = modelUpdateInterval;
+    predictedPhase = 0;
+
+    numPendingEvents = 0;
+    numMeasuredEvents = 0;
+    errorCosSum = 0;
+    errorSinSum = 0;
+}
+
+
+void PhaseEstimator::setLatencyCompensation (float milliseconds)
+{
+    latencyCompensation = jmax (0.0f, milliseconds);
+
+    // half the forecast is kept as margin from the end of the transform
+    compensationSamples = jmin (roundToInt (latencyCompensation * decimatedSampleRate / 1000.0f), forecastSize / 2);
+}
+
+
+void PhaseEstimator::addDecimatedSample (float sample)
+{
+    memmove (history, history + 1, (historySize - 1) * sizeof (float));
+    history[historySize - 1] = sample;
+    ++numDecimatedSamples;
+
+    if (numDecimatedSamples < historySize)
+        return;
+
+    measurePendingEvents();
+
+    if (++samplesSinceModelUpdate >= modelUpdateInterval)
+    {
+        fitModel();
+        samplesSinceModelUpdate = 0;
+    }
+
+    // forecast from the window without its mean
+    float mean = 0;
+    for (int n = 0; n < historySize; ++n)
+        mean += history[n];
+    mean /= historySize;
+
+    for (int n = 0; n < historySize; ++n)
+        extended[n] = history[n] - mean;
+
+    for (int n = historySize; n < transformSize; ++n)
+    {
+        double prediction = 0;
+        for (int k = 1; k <= modelOrder; ++k)
+            prediction += coefficients[k] * extended[n - k];
+        extended[n] = float (prediction);
+    }
+
+    predictedPhase = getAnalyticPhase (extended, historySize - 1 + compensationSamples);
+}
+
+
+void PhaseEstimator::fitModel()
+{
+    // biased autocorrelation of the window, which keeps the model stable
+    double mean = 0;
+    for (int n = 0; n < historySize; ++n)
+        mean += history[n];
+    mean /= historySize;
+
+    double r[modelOrder + 1];
+    for (int k = 0; k <= modelOrder; ++k)
+    {
+        double sum = 0;
+        for (int n = k; n < historySize; ++n)
+            sum += (history[n] - mean) * (history[n - k] - mean);
+        r[k] = sum / historySize;
+    }
+
+    for (int k = 0; k <= modelOrder; ++k)
+        coefficients[k] = 0;
+
+    if (r[0] <= 0)
+        return;
+
+    // Levinson-Durbin recursion
+    double error = r[0];
+    double previous[modelOrder + 1];
+
+    for (int i = 1; i <= modelOrder; ++i)
+    {
+        double acc = r[i];
+        for (int j = 1; j < i; ++j)
+            acc -= coefficients[j] * r[i - j];
+
+        const double reflection = acc / error;
+
+        for (int j = 1; j < i; ++j)
+            previous[j] = coefficients[j];
+
+        coefficients[i] = reflection;
+
+        for (int j = 1; j < i; ++j)
+            coefficients[j] = previous[j] - reflection * previous[i - j];
+
+        error *= (1 - reflection * reflection);
+
+        if (error <= 0)
+            break;
+    }
+}
+
+
+float PhaseEstimator::getAnalyticPhase (const float* data, int index)
+{
+    for (int n = 0; n < transformSize; ++n)
+    {
+        transformInput[n].r = data[n];
+        transformInput[n].i = 0;
+    }
+
+    forwardTransform.perform (transformInput, transformOutput);
+
+    // keep the positive frequencies only. The scale doesn't matter for the phase
+    for (int n = transformSize / 2 + 1; n < transformSize; ++n)
+    {
+        transformOutput[n].r = 0;
+        transformOutput[n].i = 0;
+    }
+
+    inverseTransform.perform (transformOutput, transformInput);
+
+    float phase = std::atan2 (transformInput[index].i, transformInput[index].r);
+
+    if (phase < 0)
+        phase += 2 * float_Pi;
+
+    return phase;
+}
+
+
+void PhaseEstimator::registerEvent (float targetPhase)
+{
+    if (numPendingEvents == maxPendingEvents)
+        return;
+
+    PendingEvent& event = pendingEvents[numPendingEvents++];
+    event.landingSample = numDecimatedSamples - 1 + compensationSamples;
+    event.targetPhase = targetPhase;
+}
+
+
+void PhaseEstimator::measurePendingEvents()
+{
+    // an event is measured once its landing point is at the middle of the real signal window
+    const int64 measuredSample = numDecimatedSamples - 1 - historySize / 2;
+    int remaining = 0;
+
+    for (int e = 0; e < numPendingEvents; ++e)
+    {
+        const PendingEvent& event = pendingEvents[e];
+
+        if (event.landingSample > measuredSample)
+        {
+            pendingEvents[remaining++] = event;
+            continue;
+        }
+
+        if (event.landingSample == measuredSample)
+        {
+            float mean = 0;
+            for (int n = 0; n < historySize; ++n)
+                mean += history[n];
+            mean /= historySize;
+
+            for (int n = 0; n < historySize; ++n)
+                extended[n] = history[n] - mean;
+
+            FloatVectorOperations::clear (extended + historySize, transformSize - historySize);
+
+            const float error = getAnalyticPhase (extended, historySize / 2) - event.targetPhase;
+            errorCosSum += std::cos (error);
+            errorSinSum += std::sin (error);
+            ++numMeasuredEvents;
+        }
+    }
+
+    numPendingEvents = remaining;
+}
+
+
+float PhaseEstimator::getMeanPhaseError() const
+{
+    if (numMeasuredEvents == 0)
+        return 0;
+
+    return float (std::atan2 (errorSinSum, errorCosSum) * 180.0 / double_Pi);
+}
+
+
+float PhaseEstimator::getPhaseErrorDeviation() const
+{
+    if (numMeasuredEvents == 0)
+        return 0;
+
+    const double resultant = std::sqrt (errorCosSum * errorCosSum + errorSinSum * errorSinSum) / numMeasuredEvents;
+
+    if (resultant <= 0)
+        return 180.0f;
+
+    return float (std::sqrt (-2.0 * std::log (jmin (resultant, 1.0))) * 180.0 / double_Pi);
+}
@@ -0,0 +1,153 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2019 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __PHASEESTIMATOR_H_7D2C4A10__
+#define __PHASEESTIMATOR_H_7D2C4A10__
+
+#include <ProcessorHeaders.h>
+
+
+/**
+
+    Causal estimate of the instantaneous phase of a narrow-band signal, used to
+    trigger at a given phase ahead of time.
+
+    The input is decimated to about targetSampleRate and kept in a window of
+    historySize samples. An autoregressive model fitted to the window (Yule-Walker)
+    forecasts the next forecastSize samples, and the phase is read from the analytic
+    signal (FFT Hilbert transform) of the window extended with the forecast, at the
+    current time plus a latency compensation. With the forecast, the estimated point
+    is far from the edges of the transform, where a causal Hilbert transform is wrong.
+
+    The phase at which each registered event actually landed is measured on the real
+    signal once it has been received, so the estimator reports its own error.
+
+    The input should already be band-passed around the rhythm of interest.
+
+    @see PhaseDetector
+
+*/
+class PhaseEstimator
+{
+public:
+    PhaseEstimator();
+    ~PhaseEstimator();
+
+    /** Sets the input sample rate and clears the state */
+    void prepare (float sampleRate);
+
+    /** Clears the signal and the error statistics */
+    void reset();
+
+    /** Adds an input sample. Returns true when it completed a decimated sample and a new
+        phase estimate is available. */
+    bool addSample (float sample)
+    {
+        decimationSum += sample;
+
+        if (++decimationCount < decimationFactor)
+            return false;
+
+        addDecimatedSample (decimationSum / decimationFactor);
+        decimationSum = 0;
+        decimationCount = 0;
+
+        return numDecimatedSamples >= historySize;
+    }
+
+    /** Returns the phase, in radians in [0, 2pi), predicted at the current time plus the
+        latency compensation. 0 is a peak, pi/2 a falling zero crossing, pi a trough and
+        3pi/2 a rising zero crossing. */
+    float getPredictedPhase() const { return predictedPhase; }
+
+    /** Sets the delay between an event and its effect, which the prediction looks ahead */
+    void setLatencyCompensation (float milliseconds);
+    float getLatencyCompensation() const { return latencyCompensation; }
+
+    /** Records an event triggered now for a target phase, to measure the phase error */
+    void registerEvent (float targetPhase);
+
+    int getNumMeasuredEvents() const { return numMeasuredEvents; }
+
+    /** Circular mean of the phase error, in degrees */
+    float getMeanPhaseError() const;
+
+    /** Circular standard deviation of the phase error, in degrees */
+    float getPhaseErrorDeviation() const;
+
+    static const int targetSampleRate   = 500;
+    static const int historySize        = 384;
+    static const int forecastSize       = 128;
+    static const int modelOrder         = 20;
+    static const int modelUpdateInterval = 16;
+
+private:
+    void addDecimatedSample (float sample);
+    void fitModel();
+    void measurePendingEvents();
+
+    /** Phase of the analytic signal of transformSize samples at an index */
+    float getAnalyticPhase (const float* data, int index);
+
+    static const int transformOrder = 9;
+    static const int transformSize  = 1 << transformOrder;
+    static const int maxPendingEvents = 16;
+
+    FFT forwardTransform;
+    FFT inverseTransform;
+
+    int decimationFactor;
+    int decimationCount;
+    float decimationSum;
+    float decimatedSampleRate;
+
+    HeapBlock<float> history;       // oldest first
+    HeapBlock<float> extended;      // history and forecast, without the mean
+    HeapBlock<FFT::Complex> transformInput;
+    HeapBlock<FFT::Complex> transformOutput;
+    int64 numDecimatedSamples;
+
+    double coefficients[modelOrder + 1];
+    int samplesSinceModelUpdate;
+
+    float latencyCompensation;
+    int compensationSamples;
+    float predictedPhase;
+
+    struct PendingEvent
+    {
+        int64 landingSample;
+        float targetPhase;
+    };
+
+    PendingEvent pendingEvents[maxPendingEvents];
+    int numPendingEvents;
+
+    int numMeasuredEvents;
+    double errorCosSum;
+    double errorSinSum;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PhaseEstimator);
+};
+
+#endif  // __PHASEESTIMATOR_H_7D2C4A10__
@@ -104,6 +104,7 @@ void PulsePalOutput::handleEvent (const EventChannel* eventInfo, const MidiMessa
                 if (eventId == s.eventIndex && sourceId == s.sourceId
                         && eventChannel == s.channel && state)
                 {
+                    LatencyProbe::markTimestamp (LatencyProbe::OUTPUT_HANDLED, ttl->getTimestamp());
                     std::cout << "Trigger " << i + 1 << std::endl;
                     pulsePal.triggerChannel (i + 1);
                 }
@@ -0,0 +1,291 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SharedMemorySink.h"
+#include "SharedMemorySinkEditor.h"
+
+SharedMemorySink::SharedMemorySink()
+    : GenericProcessor  ("Shared Memory Sink")
+    , spikeWaveformSize (0)
+    , regionName        ("open-ephys")
+    , ringSeconds       (1.0)
+    , layoutChanged     (true)
+{
+    setProcessorType (PROCESSOR_TYPE_SINK);
+}
+
+SharedMemorySink::~SharedMemorySink()
+{
+    writer.close();
+}
+
+AudioProcessorEditor* SharedMemorySink::createEditor()
+{
+    editor = new SharedMemorySinkEditor (this, true);
+    return editor;
+}
+
+void SharedMemorySink::updateSettings()
+{
+    streams.clear();
+
+    for (int ch = 0; ch < getTotalDataChannels(); ++ch)
+    {
+        const DataChannel* channel = getDataChannel (ch);
+        int index = findStream (channel->getSourceNodeID(), channel->getSubProcessorIdx());
+
+        if (index < 0)
+        {
+            Stream* stream = new Stream();
+            stream->sourceNodeId    = channel->getSourceNodeID();
+            stream->subProcessorIdx = channel->getSubProcessorIdx();
+            stream->numSamples      = 0;
+            stream->currentWord     = 0;
+            streams.add (stream);
+
+            index = streams.size() - 1;
+        }
+
+        streams[index]->channels.add (ch);
+    }
+
+    // int16 waveforms are scaled into this buffer, so it is sized here rather than per spike
+    spikeWaveformSize = 0;
+
+    for (int ch = 0; ch < getTotalSpikeChannels(); ++ch)
+        spikeWaveformSize = jmax (spikeWaveformSize, getSpikeChannel (ch)->getDataSize());
+
+    spikeWaveform.malloc (jmax (spikeWaveformSize, sizeof (float)), sizeof (char));
+
+    layoutChanged = true;
+}
+
+int SharedMemorySink::findStream (uint16 sourceNodeId, uint16 subProcessorIdx) const
+{
+    for (int i = 0; i < streams.size(); ++i)
+    {
+        if (streams[i]->sourceNodeId == sourceNodeId && streams[i]->subProcessorIdx == subProcessorIdx)
+            return i;
+    }
+
+    return -1;
+}
+
+bool SharedMemorySink::enable()
+{
+    const int numStreams = jmin (streams.size(), SharedMemoryLayout::maxStreams);
+
+    if (streams.size() > numStreams)
+        std::cout << "Shared Memory Sink: only the first " << numStreams << " sources are published" << std::endl;
+
+    if (layoutChanged || ! writer.isOpen())
+    {
+        Array<SharedMemoryWriter::StreamConfig> configs;
+
+        for (int i = 0; i < numStreams; ++i)
+        {
+            const DataChannel* channel = getDataChannel (streams[i]->channels[0]);
+
+            SharedMemoryWriter::StreamConfig config;
+            config.name             = channel->getSourceName() + " " + String (channel->getSubProcessorIdx());
+            config.numChannels      = streams[i]->channels.size();
+            config.sampleRate       = channel->getSampleRate();
+            config.bitVolts         = channel->getBitVolts();
+            config.sourceNodeId     = streams[i]->sourceNodeId;
+            config.subProcessorIdx  = streams[i]->subProcessorIdx;
+            configs.add (config);
+        }
+
+        writer.close();
+
+        if (! writer.create (regionName, configs, ringSeconds, eventCapacity))
+        {
+            std::cout << "Shared Memory Sink: could not create " << regionName << ": " << writer.getLastError() << std::endl;
+            return false;
+        }
+
+        layoutChanged = false;
+    }
+
+    for (int i = 0; i < streams.size(); ++i)
+    {
+        streams[i]->channelPointers.malloc (jmax (1, streams[i]->channels.size()));
+        streams[i]->ttlWords.malloc (maxBlockSize);
+        streams[i]->numSamples = 0;
+        streams[i]->currentWord = 0;
+    }
+
+    writer.start();
+
+    return true;
+}
+
+bool SharedMemorySink::disable()
+{
+    writer.stop();
+
+    Array<SharedMemoryWriter::ReaderStats> stats;
+    writer.getReaderStats (stats);
+
+    for (int i = 0; i < stats.size(); ++i)
+    {
+        std::cout << "Shared Memory Sink: reader " << (int) stats[i].processId
+                  << " overran " << (int64) stats[i].overruns << " times, losing "
+                  << (int64) stats[i].lostFrames << " frames and "
+                  << (int64) stats[i].lostEventBytes << " event bytes" << std::endl;
+    }
+
+    if (writer.getNumDroppedEvents() > 0)
+        std::cout << "Shared Memory Sink: " << writer.getNumDroppedEvents() << " events were too large for the ring" << std::endl;
+
+    return true;
+}
+
+void SharedMemorySink::process (AudioSampleBuffer& buffer)
+{
+    const int numStreams = jmin (streams.size(), SharedMemoryLayout::maxStreams);
+
+    // TTL events update the words from their sample onwards, so every stream starts the
+    // block with the word it ended the last one with
+    for (int i = 0; i < numStreams; ++i)
+    {
+        Stream* stream = streams[i];
+        stream->numSamples = jmin ((int) getNumSamples (stream->channels[0]), (int) maxBlockSize);
+
+        for (int n = 0; n < stream->numSamples; ++n)
+            stream->ttlWords[n] = stream->currentWord;
+    }
+
+    checkForEvents (true);
+
+    for (int i = 0; i < numStreams; ++i)
+    {
+        Stream* stream = streams[i];
+
+        for (int c = 0; c < stream->channels.size(); ++c)
+            stream->channelPointers[c] = buffer.getReadPointer (stream->channels[c]);
+
+        writer.writeFrames (i, stream->channelPointers, stream->numSamples,
+                            (int64) getTimestamp (stream->channels[0]), stream->ttlWords);
+    }
+}
+
+void SharedMemorySink::handleEvent (const EventChannel* eventInfo, const MidiMessage& event, int sampleNum)
+{
+    const int index = findStream (eventInfo->getSourceNodeID(), eventInfo->getSubProcessorIdx());
+    const int streamIndex = index < SharedMemoryLayout::maxStreams ? index : -1;
+
+    const EventChannel::EventChannelTypes type = Event::getEventType (event);
+
+    if (type == EventChannel::TTL)
+    {
+        TTLEventPtr ttl = TTLEvent::deserializeFromMessage (event, eventInfo);
+
+        uint64 word = 0;
+        memcpy (&word, ttl->getTTLWordPointer(), jmin (sizeof (word), eventInfo->getDataSize()));
+
+        if (streamIndex >= 0)
+        {
+            Stream* stream = streams[streamIndex];
+            stream->currentWord = word;
+
+            for (int n = jmax (0, sampleNum); n < stream->numSamples; ++n)
+                stream->ttlWords[n] = word;
+        }
+
+        writer.writeTTL (streamIndex, ttl->getTimestamp(), ttl->getChannel(), ttl->getState(), word);
+    }
+    else if (type == EventChannel::TEXT)
+    {
+        TextEventPtr text = TextEvent::deserializeFromMessage (event, eventInfo);
+        writer.writeText (streamIndex, text->getTimestamp(), text->getText());
+    }
+}
+
+void SharedMemorySink::handleSpike (const SpikeChannel* spikeInfo, const MidiMessage& event, int samplePosition)
+{
+    SpikeEventView spike (event, spikeInfo);
+
+    if (! spike.isValid())
+        return;
+
+    // float waveforms go to the ring straight from the message, int16 ones are scaled first
+    const float* waveform = spike.getDataPointer (0);
+
+    if (waveform == nullptr)
+    {
+        if (spikeInfo->getDataSize() > spikeWaveformSize)
+            return;
+
+        spike.copyWaveform (spikeWaveform);
+        waveform = spikeWaveform;
+    }
+
+    const int index = findStream (spikeInfo->getSourceNodeID(), spikeInfo->getSubProcessorIdx());
+
+    writer.writeSpike (index < SharedMemoryLayout::maxStreams ? index : -1,
+                       spike.getTimestamp(),
+                       getSpikeChannelIndex (spikeInfo->getSourceIndex(), spikeInfo->getSourceNodeID(), spikeInfo->getSubProcessorIdx()),
+                       spike.getSortedID(),
+                       spikeInfo->getNumChannels(),
+                       spikeInfo->getTotalSamples(),
+                       waveform);
+}
+
+void SharedMemorySink::setRegionName (const String& name)
+{
+    if (name.isNotEmpty() && name != regionName)
+    {
+        regionName = name;
+        layoutChanged = true;
+    }
+}
+
+String SharedMemorySink::getRegionName() const
+{
+    return regionName;
+}
+
+void SharedMemorySink::setRingSeconds (double seconds)
+{
+    if (seconds > 0 && seconds != ringSeconds)
+    {
+        ringSeconds = seconds;
+        layoutChanged = true;
+    }
+}
+
+double SharedMemorySink::getRingSeconds() const
+{
+    return ringSeconds;
+}
+
+void SharedMemorySink::getReaderStats (Array<SharedMemoryWriter::ReaderStats>& stats) const
+{
+    writer.getReaderStats (stats);
+}
+
+int64 SharedMemorySink::getNumDroppedEvents() const
+{
+    return writer.getNumDroppedEvents();
+}
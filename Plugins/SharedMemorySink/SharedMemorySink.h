@@ -0,0 +1,104 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SHAREDMEMORYSINK_H_INCLUDED
+#define SHAREDMEMORYSINK_H_INCLUDED
+
+#include <ProcessorHeaders.h>
+#include <SharedMemoryLib.h>
+
+/**
+    Publishes the continuous data, TTL events, text messages and spikes it receives to a
+    shared-memory region, so analysis programs running in other processes can follow
+    acquisition without going through files.
+
+    Each source subprocessor becomes a stream of interleaved float frames in microvolts, with
+    the sample number and TTL word of each frame. The layout is described in
+    SharedMemoryLayout.h, which external programs can include directly.
+
+    Readers never slow acquisition down: the rings are overwritten whether they have been
+    read or not, and readers that fall behind count their own overruns, which the editor shows.
+
+    @see SharedMemoryWriter
+*/
+class SharedMemorySink : public GenericProcessor
+{
+public:
+    SharedMemorySink();
+    ~SharedMemorySink();
+
+    AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override { return true; }
+
+    void process (AudioSampleBuffer& buffer) override;
+
+    void handleEvent (const EventChannel* eventInfo, const MidiMessage& event, int sampleNum) override;
+    void handleSpike (const SpikeChannel* spikeInfo, const MidiMessage& event, int samplePosition) override;
+
+    void updateSettings() override;
+
+    bool enable() override;
+    bool disable() override;
+
+    /** Name of the region. Takes effect on the next acquisition */
+    void setRegionName (const String& name);
+    String getRegionName() const;
+
+    /** Seconds of data each stream keeps for slow readers. Takes effect on the next acquisition */
+    void setRingSeconds (double seconds);
+    double getRingSeconds() const;
+
+    void getReaderStats (Array<SharedMemoryWriter::ReaderStats>& stats) const;
+    int64 getNumDroppedEvents() const;
+
+private:
+    struct Stream
+    {
+        uint16 sourceNodeId;
+        uint16 subProcessorIdx;
+        Array<int> channels;
+        HeapBlock<const float*> channelPointers;
+        HeapBlock<uint64> ttlWords;
+        int numSamples;
+        uint64 currentWord;
+    };
+
+    /** Returns the stream fed by a source subprocessor, or -1 */
+    int findStream (uint16 sourceNodeId, uint16 subProcessorIdx) const;
+
+    OwnedArray<Stream> streams;
+    SharedMemoryWriter writer;
+    HeapBlock<float> spikeWaveform; // room for the largest waveform of the spike channels
+    size_t spikeWaveformSize;
+
+    String regionName;
+    double ringSeconds;
+    bool layoutChanged;
+
+    static const int maxBlockSize = 16384;
+    static const int eventCapacity = 4 << 20;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedMemorySink);
+};
+
+#endif  // SHAREDMEMORYSINK_H_INCLUDED
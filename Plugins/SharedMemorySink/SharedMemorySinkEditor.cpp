@@ -0,0 +1,167 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SharedMemorySinkEditor.h"
+#include "SharedMemorySink.h"
+
+SharedMemorySinkEditor::SharedMemorySinkEditor (GenericProcessor* parentNode, bool useDefaultParameterEditors)
+    : GenericEditor (parentNode, useDefaultParameterEditors)
+{
+    desiredWidth = 180;
+
+    sink = static_cast<SharedMemorySink*> (parentNode);
+
+    nameLabel = new Label ("Name Text", "Region:");
+    nameLabel->setFont (Font ("Small Text", 12, Font::plain));
+    nameLabel->setBounds (10, 30, 60, 20);
+    addAndMakeVisible (nameLabel);
+
+    nameValue = new Label ("Name", sink->getRegionName());
+    nameValue->setEditable (true, false, false);
+    nameValue->addListener (this);
+    nameValue->setBounds (70, 30, 100, 20);
+    nameValue->setColour (Label::textColourId, Colours::darkgrey);
+    addAndMakeVisible (nameValue);
+
+    bufferLabel = new Label ("Buffer Text", "Buffer (s):");
+    bufferLabel->setFont (Font ("Small Text", 12, Font::plain));
+    bufferLabel->setBounds (10, 55, 60, 20);
+    addAndMakeVisible (bufferLabel);
+
+    bufferValue = new Label ("Buffer", String (sink->getRingSeconds()));
+    bufferValue->setEditable (true, false, false);
+    bufferValue->addListener (this);
+    bufferValue->setBounds (70, 55, 100, 20);
+    bufferValue->setColour (Label::textColourId, Colours::darkgrey);
+    addAndMakeVisible (bufferValue);
+
+    readerStatus = new ReaderStatus (sink);
+    readerStatus->setBounds (10, 80, 160, 40);
+    addAndMakeVisible (readerStatus);
+}
+
+SharedMemorySinkEditor::~SharedMemorySinkEditor()
+{
+}
+
+void SharedMemorySinkEditor::labelTextChanged (Label* label)
+{
+    if (label == nameValue)
+    {
+        const String name = label->getText().trim().retainCharacters ("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_.");
+
+        if (name.isNotEmpty())
+            sink->setRegionName (name);
+
+        label->setText (sink->getRegionName(), dontSendNotification);
+    }
+    else if (label == bufferValue)
+    {
+        const double seconds = label->getText().getDoubleValue();
+
+        if (seconds > 0)
+            sink->setRingSeconds (jmin (seconds, 60.0));
+
+        label->setText (String (sink->getRingSeconds()), dontSendNotification);
+    }
+}
+
+void SharedMemorySinkEditor::startAcquisition()
+{
+    nameValue->setEditable (false);
+    bufferValue->setEditable (false);
+
+    readerStatus->start();
+}
+
+void SharedMemorySinkEditor::stopAcquisition()
+{
+    readerStatus->stop();
+
+    nameValue->setEditable (true, false, false);
+    bufferValue->setEditable (true, false, false);
+}
+
+SharedMemorySinkEditor::ReaderStatus::ReaderStatus (SharedMemorySink* sink_)
+    : Label ("Readers", String())
+    , sink  (sink_)
+{
+    setFont (Font ("Small Text", 11, Font::plain));
+    setJustificationType (Justification::topLeft);
+}
+
+void SharedMemorySinkEditor::ReaderStatus::start()
+{
+    timerCallback();
+    startTimer (500);
+}
+
+void SharedMemorySinkEditor::ReaderStatus::stop()
+{
+    stopTimer();
+}
+
+void SharedMemorySinkEditor::ReaderStatus::timerCallback()
+{
+    Array<SharedMemoryWriter::ReaderStats> stats;
+    sink->getReaderStats (stats);
+
+    uint64 overruns = 0;
+    int64 maxLag = 0;
+
+    for (int i = 0; i < stats.size(); ++i)
+    {
+        overruns += stats[i].overruns;
+        maxLag = jmax (maxLag, stats[i].maxLag);
+    }
+
+    String status = String (stats.size()) + (stats.size() == 1 ? " reader" : " readers");
+
+    if (stats.size() > 0)
+        status << ", max lag " << maxLag << "\n" << (int64) overruns << " overruns";
+
+    setText (status, dontSendNotification);
+}
+
+void SharedMemorySinkEditor::saveCustomParameters (XmlElement* xml)
+{
+    XmlElement* info = xml->createNewChildElement ("SHARED_MEMORY");
+
+    info->setAttribute ("name", sink->getRegionName());
+    info->setAttribute ("seconds", sink->getRingSeconds());
+}
+
+void SharedMemorySinkEditor::loadCustomParameters (XmlElement* xml)
+{
+    forEachXmlChildElement (*xml, xmlNode)
+    {
+        if (xmlNode->hasTagName ("SHARED_MEMORY"))
+        {
+            sink->setRegionName (xmlNode->getStringAttribute ("name", sink->getRegionName()));
+            sink->setRingSeconds (xmlNode->getDoubleAttribute ("seconds", sink->getRingSeconds()));
+
+            nameValue->setText (sink->getRegionName(), dontSendNotification);
+            bufferValue->setText (String (sink->getRingSeconds()), dontSendNotification);
+        }
+    }
+}
@@ -0,0 +1,80 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SHAREDMEMORYSINKEDITOR_H_INCLUDED
+#define SHAREDMEMORYSINKEDITOR_H_INCLUDED
+
+#include <EditorHeaders.h>
+
+class SharedMemorySink;
+
+/**
+    User interface for the SharedMemorySink: the name of the region, the seconds of data kept for
+    slow readers and, while acquiring, how many readers follow the region and how far they lag.
+
+    @see SharedMemorySink
+*/
+class SharedMemorySinkEditor : public GenericEditor
+                             , public Label::Listener
+{
+public:
+    SharedMemorySinkEditor (GenericProcessor* parentNode, bool useDefaultParameterEditors);
+    ~SharedMemorySinkEditor();
+
+    void labelTextChanged (Label* label) override;
+
+    void startAcquisition() override;
+    void stopAcquisition() override;
+
+    void saveCustomParameters (XmlElement* xml) override;
+    void loadCustomParameters (XmlElement* xml) override;
+
+private:
+    /** Polls the reader slots of the region while acquisition is running */
+    class ReaderStatus : public Label
+                       , private Timer
+    {
+    public:
+        ReaderStatus (SharedMemorySink* sink);
+
+        void start();
+        void stop();
+
+    private:
+        void timerCallback() override;
+
+        SharedMemorySink* sink;
+    };
+
+    SharedMemorySink* sink;
+
+    ScopedPointer<Label> nameLabel;
+    ScopedPointer<Label> nameValue;
+    ScopedPointer<Label> bufferLabel;
+    ScopedPointer<Label> bufferValue;
+    ScopedPointer<ReaderStatus> readerStatus;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedMemorySinkEditor);
+};
+
+#endif  // SHAREDMEMORYSINKEDITOR_H_INCLUDED
@@ -0,0 +1,130 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SharedMemorySourceEditor.h"
+#include "SharedMemoryThread.h"
+
+SharedMemorySourceEditor::SharedMemorySourceEditor (GenericProcessor* parentNode, SharedMemoryThread* thread_)
+    : GenericEditor (parentNode, false)
+    , thread        (thread_)
+{
+    desiredWidth = 180;
+
+    nameLabel = new Label ("Name Text", "Region:");
+    nameLabel->setFont (Font ("Small Text", 12, Font::plain));
+    nameLabel->setBounds (10, 30, 60, 20);
+    addAndMakeVisible (nameLabel);
+
+    nameValue = new Label ("Name", thread->getRegionName());
+    nameValue->setEditable (true, false, false);
+    nameValue->setBounds (70, 30, 100, 20);
+    nameValue->setColour (Label::textColourId, Colours::darkgrey);
+    addAndMakeVisible (nameValue);
+
+    connectButton = new UtilityButton ("CONNECT", Font ("Small Text", 13, Font::bold));
+    connectButton->setRadius (3.0f);
+    connectButton->setBounds (10, 55, 70, 20);
+    connectButton->addListener (this);
+    addAndMakeVisible (connectButton);
+
+    status = new Label ("Status", String());
+    status->setFont (Font ("Small Text", 11, Font::plain));
+    status->setJustificationType (Justification::topLeft);
+    status->setBounds (10, 80, 160, 40);
+    addAndMakeVisible (status);
+
+    updateStatus();
+}
+
+SharedMemorySourceEditor::~SharedMemorySourceEditor()
+{
+}
+
+void SharedMemorySourceEditor::connect (const String& name)
+{
+    thread->connect (name.trim());
+
+    nameValue->setText (thread->getRegionName(), dontSendNotification);
+    updateStatus();
+
+    CoreServices::updateSignalChain (this);
+}
+
+void SharedMemorySourceEditor::updateStatus()
+{
+    if (! thread->foundInputSource())
+    {
+        status->setText (thread->getLastError().isEmpty() ? String ("Not connected") : thread->getLastError(),
+                         dontSendNotification);
+        return;
+    }
+
+    int numChannels = 0;
+
+    for (int i = 0; i < (int) thread->getNumSubProcessors(); ++i)
+        numChannels += thread->getNumDataOutputs (DataChannel::HEADSTAGE_CHANNEL, i);
+
+    String text;
+    text << (int) thread->getNumSubProcessors() << " streams, " << numChannels << " channels";
+
+    if (thread->getOverruns() > 0)
+        text << "\n" << thread->getOverruns() << " overruns, " << thread->getLostFrames() << " frames lost";
+
+    status->setText (text, dontSendNotification);
+}
+
+void SharedMemorySourceEditor::buttonEvent (Button* button)
+{
+    if (button == connectButton)
+        connect (nameValue->getText());
+}
+
+void SharedMemorySourceEditor::startAcquisition()
+{
+    nameValue->setEditable (false);
+    connectButton->setEnabled (false);
+}
+
+void SharedMemorySourceEditor::stopAcquisition()
+{
+    nameValue->setEditable (true, false, false);
+    connectButton->setEnabled (true);
+
+    updateStatus();
+}
+
+void SharedMemorySourceEditor::saveCustomParameters (XmlElement* xml)
+{
+    XmlElement* info = xml->createNewChildElement ("SHARED_MEMORY");
+
+    info->setAttribute ("name", thread->getRegionName());
+}
+
+void SharedMemorySourceEditor::loadCustomParameters (XmlElement* xml)
+{
+    forEachXmlChildElement (*xml, xmlNode)
+    {
+        if (xmlNode->hasTagName ("SHARED_MEMORY"))
+            connect (xmlNode->getStringAttribute ("name", thread->getRegionName()));
+    }
+}
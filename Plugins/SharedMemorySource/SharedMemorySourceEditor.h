@@ -0,0 +1,65 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SHAREDMEMORYSOURCEEDITOR_H_INCLUDED
+#define SHAREDMEMORYSOURCEEDITOR_H_INCLUDED
+
+#include <EditorHeaders.h>
+
+class SharedMemoryThread;
+
+/**
+    User interface for the SharedMemoryThread: the name of the region to read, a button to
+    connect to it, and the streams it holds.
+
+    @see SharedMemoryThread
+*/
+class SharedMemorySourceEditor : public GenericEditor
+{
+public:
+    SharedMemorySourceEditor (GenericProcessor* parentNode, SharedMemoryThread* thread);
+    ~SharedMemorySourceEditor();
+
+    void buttonEvent (Button* button) override;
+
+    void startAcquisition() override;
+    void stopAcquisition() override;
+
+    void saveCustomParameters (XmlElement* xml) override;
+    void loadCustomParameters (XmlElement* xml) override;
+
+private:
+    void connect (const String& name);
+    void updateStatus();
+
+    SharedMemoryThread* thread;
+
+    ScopedPointer<Label> nameLabel;
+    ScopedPointer<Label> nameValue;
+    ScopedPointer<UtilityButton> connectButton;
+    ScopedPointer<Label> status;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedMemorySourceEditor);
+};
+
+#endif  // SHAREDMEMORYSOURCEEDITOR_H_INCLUDED
@@ -0,0 +1,254 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SharedMemoryThread.h"
+#include "SharedMemorySourceEditor.h"
+
+DataThread* SharedMemoryThread::createDataThread (SourceNode* sn)
+{
+    return new SharedMemoryThread (sn);
+}
+
+SharedMemoryThread::SharedMemoryThread (SourceNode* sn)
+    : DataThread    (sn)
+    , regionName    ("open-ephys")
+{
+    connect (regionName);
+}
+
+SharedMemoryThread::~SharedMemoryThread()
+{
+    reader.close();
+}
+
+GenericEditor* SharedMemoryThread::createEditor (SourceNode* sn)
+{
+    return new SharedMemorySourceEditor (sn, this);
+}
+
+bool SharedMemoryThread::connect (const String& name)
+{
+    regionName = name;
+    streams.clear();
+
+    if (! reader.open (name))
+    {
+        lastError = reader.getLastError();
+        return false;
+    }
+
+    lastError = String();
+
+    for (int i = 0; i < reader.getNumStreams(); ++i)
+    {
+        const SharedMemoryLayout::StreamHeader* header = reader.getStream (i);
+
+        StreamInfo info;
+        info.numChannels = header->numChannels;
+        info.sampleRate  = header->sampleRate;
+        info.bitVolts    = header->bitVolts;
+        streams.add (info);
+    }
+
+    return true;
+}
+
+void SharedMemoryThread::disconnect()
+{
+    reader.close();
+    streams.clear();
+}
+
+String SharedMemoryThread::getRegionName() const
+{
+    return regionName;
+}
+
+String SharedMemoryThread::getLastError() const
+{
+    return lastError;
+}
+
+int64 SharedMemoryThread::getOverruns() const
+{
+    return reader.isOpen() ? (int64) reader.getOverruns() : 0;
+}
+
+int64 SharedMemoryThread::getLostFrames() const
+{
+    return reader.isOpen() ? (int64) reader.getLostFrames() : 0;
+}
+
+bool SharedMemoryThread::foundInputSource()
+{
+    // a writer that starts over replaces the region, and the old one won't get any more data
+    if (reader.isOpen() && ! reader.isRegionValid() && ! isThreadRunning())
+    {
+        lastError = "the writer closed " + regionName;
+        disconnect();
+    }
+
+    return reader.isOpen() && streams.size() > 0;
+}
+
+unsigned int SharedMemoryThread::getNumSubProcessors() const
+{
+    return jmax (1, streams.size());
+}
+
+int SharedMemoryThread::getNumDataOutputs (DataChannel::DataChannelTypes type, int subProcessor) const
+{
+    if (type == DataChannel::HEADSTAGE_CHANNEL && isPositiveAndBelow (subProcessor, streams.size()))
+        return streams.getReference (subProcessor).numChannels;
+    else
+        return 0;
+}
+
+int SharedMemoryThread::getNumTTLOutputs (int subProcessor) const
+{
+    // the whole TTL word of each frame
+    return isPositiveAndBelow (subProcessor, streams.size()) ? 64 : 0;
+}
+
+float SharedMemoryThread::getSampleRate (int subProcessor) const
+{
+    if (isPositiveAndBelow (subProcessor, streams.size()))
+        return streams.getReference (subProcessor).sampleRate;
+    else
+        return 30000.0f;
+}
+
+float SharedMemoryThread::getBitVolts (const DataChannel* chan) const
+{
+    const int subProcessor = chan->getSubProcessorIdx();
+
+    if (isPositiveAndBelow (subProcessor, streams.size()) && streams.getReference (subProcessor).bitVolts > 0)
+        return streams.getReference (subProcessor).bitVolts;
+    else
+        return 0.195f;
+}
+
+void SharedMemoryThread::resizeBuffers()
+{
+    sourceBuffers.clear();
+
+    int maxChannels = 1;
+
+    for (int i = 0; i < (int) getNumSubProcessors(); ++i)
+    {
+        const int numChannels = getNumDataOutputs (DataChannel::HEADSTAGE_CHANNEL, i);
+        const int size = jmax (10000, int (getSampleRate (i) / 4));
+
+        sourceBuffers.add (new DataBuffer (numChannels, size));
+        maxChannels = jmax (maxChannels, numChannels);
+    }
+
+    channelPointers.malloc (maxChannels);
+}
+
+bool SharedMemoryThread::startAcquisition()
+{
+    if (! reader.isRegionValid())
+    {
+        std::cout << "Shared Memory Source: " << regionName << " is not available" << std::endl;
+        return false;
+    }
+
+    for (int i = 0; i < sourceBuffers.size(); ++i)
+        sourceBuffers[i]->clear();
+
+    // stale frames would arrive as one burst, so only what is written from now on is acquired
+    reader.skipToLatest();
+
+    startThread();
+
+    return true;
+}
+
+bool SharedMemoryThread::stopAcquisition()
+{
+    if (isThreadRunning())
+        signalThreadShouldExit();
+
+    waitForThreadToExit (500);
+
+    if (reader.isOpen())
+    {
+        std::cout << "Shared Memory Source: " << (int64) reader.getOverruns() << " overruns, "
+                  << (int64) reader.getLostFrames() << " frames lost" << std::endl;
+    }
+
+    for (int i = 0; i < sourceBuffers.size(); ++i)
+        sourceBuffers[i]->clear();
+
+    return true;
+}
+
+int SharedMemoryThread::readBlock (int stream, DataBuffer* buffer, int startIndex, int blockSize)
+{
+    const int numChannels = streams.getReference (stream).numChannels;
+
+    for (int c = 0; c < numChannels; ++c)
+        channelPointers[c] = buffer->getWritePointer (c, startIndex);
+
+    return reader.readFrames (stream, channelPointers,
+                              buffer->getTimestampPointer (startIndex),
+                              buffer->getEventCodePointer (startIndex),
+                              blockSize);
+}
+
+bool SharedMemoryThread::updateBuffer()
+{
+    bool receivedFrames = false;
+
+    const int numStreams = jmin (streams.size(), sourceBuffers.size());
+
+    for (int i = 0; i < numStreams; ++i)
+    {
+        const int available = (int) reader.getNumAvailableFrames (i);
+
+        if (available == 0)
+            continue;
+
+        DataBuffer* buffer = sourceBuffers[i];
+
+        // frames that don't fit stay in the ring until the processing thread catches up
+        int startIndex1, blockSize1, startIndex2, blockSize2;
+        buffer->prepareToWrite (available, startIndex1, blockSize1, startIndex2, blockSize2);
+
+        int numFrames = readBlock (i, buffer, startIndex1, blockSize1);
+
+        // a short read dropped frames the writer overwrote, so the second block waits for the next pass
+        if (numFrames == blockSize1 && blockSize2 > 0)
+            numFrames += readBlock (i, buffer, startIndex2, blockSize2);
+
+        buffer->finishedWrite (numFrames);
+
+        receivedFrames = receivedFrames || numFrames > 0;
+    }
+
+    if (! receivedFrames)
+        sleep (1);
+
+    return true;
+}
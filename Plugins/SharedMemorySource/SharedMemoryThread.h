@@ -0,0 +1,96 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SHAREDMEMORYTHREAD_H_INCLUDED
+#define SHAREDMEMORYTHREAD_H_INCLUDED
+
+#include <DataThreadHeaders.h>
+#include <SharedMemoryLib.h>
+
+/**
+    Acquires data from a shared-memory region written by another process on the same machine,
+    such as an acquisition daemon, following SharedMemoryLayout.
+
+    Each stream of the region becomes a subprocessor with its own sample rate, channel count and
+    TTL word. Frames are converted from int16 or float straight into the DataBuffer of their
+    subprocessor, and keep the sample numbers and TTL words written with them.
+
+    The streams are read when connecting, so the signal chain has to be updated after the
+    writer changes them.
+
+    @see SharedMemoryReader
+*/
+class SharedMemoryThread : public DataThread
+{
+public:
+    SharedMemoryThread (SourceNode* sn);
+    ~SharedMemoryThread();
+
+    bool foundInputSource() override;
+    int getNumDataOutputs (DataChannel::DataChannelTypes type, int subProcessor) const override;
+    int getNumTTLOutputs (int subProcessor) const override;
+    float getSampleRate (int subProcessor) const override;
+    float getBitVolts (const DataChannel* chan) const override;
+    unsigned int getNumSubProcessors() const override;
+
+    void resizeBuffers() override;
+
+    /** Opens the region with the given name and reads its streams */
+    bool connect (const String& name);
+    void disconnect();
+
+    String getRegionName() const;
+    String getLastError() const;
+
+    int64 getOverruns() const;
+    int64 getLostFrames() const;
+
+    GenericEditor* createEditor (SourceNode* sn) override;
+    static DataThread* createDataThread (SourceNode* sn);
+
+private:
+    bool updateBuffer() override;
+    bool startAcquisition() override;
+    bool stopAcquisition() override;
+
+    /** Reads the next frames of a stream into one block of its DataBuffer */
+    int readBlock (int stream, DataBuffer* buffer, int startIndex, int blockSize);
+
+    struct StreamInfo
+    {
+        int numChannels;
+        float sampleRate;
+        float bitVolts;
+    };
+
+    SharedMemoryReader reader;
+    Array<StreamInfo> streams;
+    String regionName;
+    String lastError;
+
+    HeapBlock<float*> channelPointers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedMemoryThread);
+};
+
+#endif  // SHAREDMEMORYTHREAD_H_INCLUDED
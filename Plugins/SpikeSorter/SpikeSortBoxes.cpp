@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdio.h>
 #include <algorithm>
+#include <limits>
 #include "SpikeSortBoxes.h"
 #include "SpikeSorter.h"
 
@@ -592,7 +593,139 @@ void BoxUnit::updateWaveform(SorterSpikePtr so)
 
 /***********************************************/
 
+// number of cells of the PCA grid along each axis
+static const int pcaGridSize = 16;
+
+static int getGridCell(float v, float gridMin, float cellSize)
+{
+    return jlimit(0, pcaGridSize - 1, (int) ((v - gridMin) / cellSize));
+}
+
+SortUnitSnapshot::SortUnitSnapshot(int version_, const std::vector<BoxUnit>& boxUnits_, const std::vector<PCAUnit>& pcaUnits_)
+    : version(version_), boxUnits(boxUnits_), pcaUnits(pcaUnits_)
+{
+    for (size_t k = 0; k < boxUnits.size(); k++)
+    {
+        boxUnitStart.push_back((int) boxes.size());
+        boxes.insert(boxes.end(), boxUnits[k].lstBoxes.begin(), boxUnits[k].lstBoxes.end());
+    }
+    boxUnitStart.push_back((int) boxes.size());
+
+    gridMinX = gridMinY = std::numeric_limits<float>::max();
+    gridMaxX = gridMaxY = -std::numeric_limits<float>::max();
+    polygons.resize(pcaUnits.size());
+
+    for (size_t k = 0; k < pcaUnits.size(); k++)
+    {
+        const cPolygon& poly = pcaUnits[k].poly;
+        CompiledPolygon& compiled = polygons[k];
+
+        compiled.minX = compiled.minY = std::numeric_limits<float>::max();
+        compiled.maxX = compiled.maxY = -std::numeric_limits<float>::max();
+
+        // polygons with fewer than 3 points hold nothing, so they are left out of the grid
+        if (poly.pts.size() < 3)
+            continue;
+
+        for (size_t i = 0; i < poly.pts.size(); i++)
+        {
+            PointD pt(poly.pts[i].X + poly.offset.X, poly.pts[i].Y + poly.offset.Y);
+            compiled.pts.push_back(pt);
+            compiled.minX = jmin(compiled.minX, pt.X);
+            compiled.minY = jmin(compiled.minY, pt.Y);
+            compiled.maxX = jmax(compiled.maxX, pt.X);
+            compiled.maxY = jmax(compiled.maxY, pt.Y);
+        }
+
+        gridMinX = jmin(gridMinX, compiled.minX);
+        gridMinY = jmin(gridMinY, compiled.minY);
+        gridMaxX = jmax(gridMaxX, compiled.maxX);
+        gridMaxY = jmax(gridMaxY, compiled.maxY);
+    }
+
+    if (gridMinX > gridMaxX)
+        return;
+
+    cellWidth = (gridMaxX - gridMinX) / pcaGridSize;
+    cellHeight = (gridMaxY - gridMinY) / pcaGridSize;
+    if (cellWidth <= 0)
+        cellWidth = 1;
+    if (cellHeight <= 0)
+        cellHeight = 1;
+
+    std::vector<std::vector<int> > cells(pcaGridSize * pcaGridSize);
+    const int numPolygons = (int) polygons.size();
+    for (int k = 0; k < numPolygons; k++)
+    {
+        const CompiledPolygon& compiled = polygons[k];
+        if (compiled.pts.empty())
+            continue;
+
+        const int x0 = getGridCell(compiled.minX, gridMinX, cellWidth);
+        const int x1 = getGridCell(compiled.maxX, gridMinX, cellWidth);
+        const int y0 = getGridCell(compiled.minY, gridMinY, cellHeight);
+        const int y1 = getGridCell(compiled.maxY, gridMinY, cellHeight);
+
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++)
+                cells[y * pcaGridSize + x].push_back(k);
+    }
+
+    for (size_t c = 0; c < cells.size(); c++)
+    {
+        cellStart.push_back((int) cellPolygons.size());
+        cellPolygons.insert(cellPolygons.end(), cells[c].begin(), cells[c].end());
+    }
+    cellStart.push_back((int) cellPolygons.size());
+}
+
+int SortUnitSnapshot::findPCAUnit(PointD p) const
+{
+    // also rejects projections that are not numbers
+    if (cellStart.empty() || !(p.X >= gridMinX && p.X <= gridMaxX && p.Y >= gridMinY && p.Y <= gridMaxY))
+        return -1;
+
+    const int cell = getGridCell(p.Y, gridMinY, cellHeight) * pcaGridSize + getGridCell(p.X, gridMinX, cellWidth);
+
+    for (int i = cellStart[cell]; i < cellStart[cell + 1]; i++)
+    {
+        if (polygons[cellPolygons[i]].isPointInside(p))
+            return cellPolygons[i];
+    }
+    return -1;
+}
+
+// same test as cPolygon::isPointInside, which never finds a point outside the bounding box
+bool SortUnitSnapshot::CompiledPolygon::isPointInside(PointD p) const
+{
+    if (p.X <= minX || p.X > maxX || p.Y < minY || p.Y > maxY)
+        return false;
+
+    bool inside = false;
+    const PointD* oldPoint = &pts.back();
+
+    for (size_t i = 0; i < pts.size(); i++)
+    {
+        const PointD* newPoint = &pts[i];
+        const PointD* p1 = newPoint->X > oldPoint->X ? oldPoint : newPoint;
+        const PointD* p2 = newPoint->X > oldPoint->X ? newPoint : oldPoint;
+
+        if ((newPoint->X < p.X) == (p.X <= oldPoint->X)
+            && ((p.Y - p1->Y) * (p2->X - p1->X) < (p2->Y - p1->Y) * (p.X - p1->X)))
+        {
+            inside = !inside;
+        }
+
+        oldPoint = newPoint;
+    }
+
+    return inside;
+}
+
+/***********************************************/
+
 SpikeSortBoxes::SpikeSortBoxes(UniqueIDgenerator* uniqueIDgenerator_,PCAcomputingThread* pth, int numch, double SamplingRate, int WaveFormLength)
+    : waveformUpdateFifo(1024)
 {
     uniqueIDgenerator = uniqueIDgenerator_;
     computingThread = pth;
@@ -619,12 +752,24 @@ SpikeSortBoxes::SpikeSortBoxes(UniqueIDgenerator* uniqueIDgenerator_,PCAcomputin
 
         spikeBuffer.add(nullptr);
     }
+
+    waveformUpdates.resize(waveformUpdateFifo.getTotalSize());
+    lastSnapshotVersion = -1;
+    sortingVersion = -1;
+    sortingSnapshot = nullptr;
+    pendingSnapshot = nullptr;
+    boxBinsVersion = -1;
+    boxBinsSampleRate = 0;
+    boxBinsNumSamples = 0;
+    publishUnits();
 }
 
 void SpikeSortBoxes::resizeWaveform(int numSamples)
 {
     const ScopedLock myScopedLock(mut);
     //StartCriticalSection();
+    // the spikes still queued have the old length
+    applyWaveformUpdates();
     waveformLength = numSamples;
     delete[] pc1;
     delete[] pc2;
@@ -662,6 +807,7 @@ void SpikeSortBoxes::resizeWaveform(int numSamples)
 
 void SpikeSortBoxes::loadCustomParametersFromXml(XmlElement* electrodeNode)
 {
+    const ScopedLock myScopedLock(mut);
 
     forEachXmlChildElement(*electrodeNode, spikesortNode)
     {
@@ -764,6 +910,8 @@ void SpikeSortBoxes::loadCustomParametersFromXml(XmlElement* electrodeNode)
             }
         }
     }
+
+    publishUnits();
 }
 
 void SpikeSortBoxes::saveCustomParametersToXml(XmlElement* electrodeNode)
@@ -939,6 +1087,7 @@ void SpikeSortBoxes::addPCAunit(PCAUnit unit)
     const ScopedLock myScopedLock(mut);
     //StartCriticalSection();
     pcaUnits.push_back(unit);
+    publishUnits();
     //EndCriticalSection();
 }
 
@@ -951,6 +1100,7 @@ int SpikeSortBoxes::addBoxUnit(int channel)
     int unusedID = uniqueIDgenerator->generateUniqueID(); //generateUnitID();
     BoxUnit unit(unusedID, generateLocalID());
     boxUnits.push_back(unit);
+    publishUnits();
     setSelectedUnitAndBox(unusedID, 0);
     //EndCriticalSection();
     return unusedID;
@@ -973,6 +1123,7 @@ int SpikeSortBoxes::addBoxUnit(int channel, Box B)
     int unusedID = uniqueIDgenerator->generateUniqueID(); //generateUnitID();
     BoxUnit unit(B, unusedID,generateLocalID());
     boxUnits.push_back(unit);
+    publishUnits();
     setSelectedUnitAndBox(unusedID, 0);
     //EndCriticalSection();
     return unusedID;
@@ -1055,6 +1206,7 @@ void SpikeSortBoxes::generateNewIDs()
     {
         pcaUnits[k].UnitID = generateUnitID();
     }
+    publishUnits();
 }
 
 void SpikeSortBoxes::removeAllUnits()
@@ -1062,6 +1214,7 @@ void SpikeSortBoxes::removeAllUnits()
     const ScopedLock myScopedLock(mut);
     boxUnits.clear();
     pcaUnits.clear();
+    publishUnits();
 }
 
 bool SpikeSortBoxes::removeUnit(int unitID)
@@ -1073,6 +1226,7 @@ bool SpikeSortBoxes::removeUnit(int unitID)
         if (boxUnits[k].getUnitID() == unitID)
         {
             boxUnits.erase(boxUnits.begin()+k);
+            publishUnits();
             //EndCriticalSection();
             return true;
         }
@@ -1083,6 +1237,7 @@ bool SpikeSortBoxes::removeUnit(int unitID)
         if (pcaUnits[k].getUnitID() == unitID)
         {
             pcaUnits.erase(pcaUnits.begin()+k);
+            publishUnits();
             //EndCriticalSection();
             return true;
         }
@@ -1108,6 +1263,7 @@ bool SpikeSortBoxes::addBoxToUnit(int channel, int unitID)
             B.y -= 30;
             B.channel = channel;
             boxUnits[k].addBox(B);
+            publishUnits();
             setSelectedUnitAndBox(unitID, (int) boxUnits[k].lstBoxes.size() - 1);
             // EndCriticalSection();
             return true;
@@ -1127,6 +1283,7 @@ bool SpikeSortBoxes::addBoxToUnit(int channel, int unitID, Box B)
         if (boxUnits[k].getUnitID() == unitID)
         {
             boxUnits[k].addBox(B);
+            publishUnits();
             // EndCriticalSection();
             return true;
         }
@@ -1139,6 +1296,7 @@ std::vector<BoxUnit> SpikeSortBoxes::getBoxUnits()
 {
     //StartCriticalSection();
     const ScopedLock myScopedLock(mut);
+    applyWaveformUpdates();
     std::vector<BoxUnit> unitsCopy = boxUnits;
     //EndCriticalSection();
     return unitsCopy;
@@ -1149,6 +1307,7 @@ std::vector<PCAUnit> SpikeSortBoxes::getPCAUnits()
 {
     //StartCriticalSection();
     const ScopedLock myScopedLock(mut);
+    applyWaveformUpdates();
     std::vector<PCAUnit> unitsCopy = pcaUnits;
     //EndCriticalSection();
     return unitsCopy;
@@ -1159,6 +1318,7 @@ void SpikeSortBoxes::updatePCAUnits(std::vector<PCAUnit> _units)
     //StartCriticalSection();
     const ScopedLock myScopedLock(mut);
     pcaUnits = _units;
+    publishUnits();
     //EndCriticalSection();
 }
 
@@ -1167,74 +1327,223 @@ void SpikeSortBoxes::updateBoxUnits(std::vector<BoxUnit> _units)
     const ScopedLock myScopedLock(mut);
     //StartCriticalSection();
     boxUnits = _units;
+    publishUnits();
     //EndCriticalSection();
 }
 
 
 
 
-// tests whether a candidate spike belongs to one of the defined units
-bool SpikeSortBoxes::sortSpike(SorterSpikePtr so, bool PCAfirst)
+void SpikeSortBoxes::publishUnits()
 {
-    const ScopedLock myScopedLock(mut);
-    if (PCAfirst)
+    SortUnitSnapshot* snapshot = new SortUnitSnapshot(++lastSnapshotVersion, boxUnits, pcaUnits);
+    publishedSnapshots.add(snapshot);
+
+    // a snapshot replaced here before the processing thread took it is never used
+    pendingSnapshot.store(snapshot);
+
+    // the processing thread only moves to newer versions, so the older ones can go
+    const int versionInUse = sortingVersion.load();
+    for (int k = publishedSnapshots.size() - 1; k >= 0; k--)
     {
+        if (publishedSnapshots[k]->version < versionInUse)
+            publishedSnapshots.remove(k);
+    }
+}
+
+SortUnitSnapshot* SpikeSortBoxes::getSortingSnapshot()
+{
+    SortUnitSnapshot* latest = pendingSnapshot.exchange(nullptr);
+    if (latest != nullptr)
+    {
+        sortingSnapshot = latest;
+        sortingVersion.store(latest->version);
+    }
+    return sortingSnapshot;
+}
+
+void SpikeSortBoxes::queueWaveformUpdate(int unitID, SorterSpikePtr so)
+{
+    int start1, size1, start2, size2;
+    waveformUpdateFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    // the statistics are only displayed, so updates are dropped while the GUI isn't reading them
+    if (size1 > 0)
+    {
+        waveformUpdates[start1].unitID = unitID;
+        waveformUpdates[start1].spike = so;
+        waveformUpdateFifo.finishedWrite(1);
+    }
+}
 
-        for (int k=0; k<pcaUnits.size(); k++)
+void SpikeSortBoxes::applyWaveformUpdates()
+{
+    int start1, size1, start2, size2;
+    waveformUpdateFifo.prepareToRead(waveformUpdateFifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int n = 0; n < size1 + size2; n++)
+    {
+        WaveformUpdate& update = waveformUpdates[n < size1 ? start1 + n : start2 + n - size1];
+
+        for (size_t k = 0; k < boxUnits.size(); k++)
         {
-            if (pcaUnits[k].isWaveFormInsidePolygon(so))
-            {
-                so->sortedId = pcaUnits[k].getUnitID();
-                so->color[0] = pcaUnits[k].ColorRGB[0];
-                so->color[1] = pcaUnits[k].ColorRGB[1];
-                so->color[2] = pcaUnits[k].ColorRGB[2];
-                return true;
-            }
+            if (boxUnits[k].getUnitID() == update.unitID)
+                boxUnits[k].updateWaveform(update.spike);
         }
-
-        for (int k=0; k<boxUnits.size(); k++)
+        for (size_t k = 0; k < pcaUnits.size(); k++)
         {
-            if (boxUnits[k].isWaveFormInsideAllBoxes(so))
-            {
-                so->sortedId = boxUnits[k].getUnitID();
-                so->color[0] = boxUnits[k].ColorRGB[0];
-                so->color[1] = boxUnits[k].ColorRGB[1];
-                so->color[2] = boxUnits[k].ColorRGB[2];
-                boxUnits[k].updateWaveform(so);
-                return true;
-            }
+            if (pcaUnits[k].getUnitID() == update.unitID)
+                pcaUnits[k].updateWaveform(update.spike);
         }
+
+        // released here so the processing thread never frees a spike when it reuses the slot
+        update.spike = nullptr;
     }
-    else
+
+    waveformUpdateFifo.finishedRead(size1 + size2);
+}
+
+// tests whether a candidate spike belongs to one of the defined units
+bool SpikeSortBoxes::sortSpike(SorterSpikePtr so, bool PCAfirst)
+{
+    return sortSpike(getSortingSnapshot(), so, PCAfirst);
+}
+
+void SpikeSortBoxes::sortSpikes(const Array<SorterSpikePtr>& spikes, bool PCAfirst)
+{
+    SortUnitSnapshot* units = getSortingSnapshot();
+
+    for (int n = 0; n < spikes.size(); n++)
+        sortSpike(units, spikes.getReference(n), PCAfirst);
+}
+
+bool SpikeSortBoxes::sortSpike(SortUnitSnapshot* units, SorterSpikeContainer* so, bool PCAfirst)
+{
+    std::vector<BoxUnit>& sortBoxUnits = units->boxUnits;
+    std::vector<PCAUnit>& sortPCAUnits = units->pcaUnits;
+
+    updateBoxBins(units, so);
+
+    if (PCAfirst)
     {
+        const int k = units->findPCAUnit(PointD(so->pcProj[0], so->pcProj[1]));
+        if (k >= 0)
+        {
+            so->sortedId = sortPCAUnits[k].getUnitID();
+            so->color[0] = sortPCAUnits[k].ColorRGB[0];
+            so->color[1] = sortPCAUnits[k].ColorRGB[1];
+            so->color[2] = sortPCAUnits[k].ColorRGB[2];
+            return true;
+        }
+    }
 
-        for (int k=0; k<boxUnits.size(); k++)
+    const int numBoxUnits = (int) sortBoxUnits.size();
+    for (int k=0; k<numBoxUnits; k++)
+    {
+        if (isWaveFormInsideAllBoxes(units, k, so))
         {
-            if (boxUnits[k].isWaveFormInsideAllBoxes(so))
-            {
-                so->sortedId = boxUnits[k].getUnitID();
-                so->color[0] = boxUnits[k].ColorRGB[0];
-                so->color[1] = boxUnits[k].ColorRGB[1];
-                so->color[2] = boxUnits[k].ColorRGB[2];
-                boxUnits[k].updateWaveform(so);
-                return true;
-            }
+            so->sortedId = sortBoxUnits[k].getUnitID();
+            so->color[0] = sortBoxUnits[k].ColorRGB[0];
+            so->color[1] = sortBoxUnits[k].ColorRGB[1];
+            so->color[2] = sortBoxUnits[k].ColorRGB[2];
+            queueWaveformUpdate(sortBoxUnits[k].getUnitID(), so);
+            return true;
         }
-        for (int k=0; k<pcaUnits.size(); k++)
+    }
+
+    if (!PCAfirst)
+    {
+        const int k = units->findPCAUnit(PointD(so->pcProj[0], so->pcProj[1]));
+        if (k >= 0)
         {
-            if (pcaUnits[k].isWaveFormInsidePolygon(so))
-            {
-                so->sortedId = pcaUnits[k].getUnitID();
-                so->color[0] = pcaUnits[k].ColorRGB[0];
-                so->color[1] = pcaUnits[k].ColorRGB[1];
-                so->color[2] = pcaUnits[k].ColorRGB[2];
-                pcaUnits[k].updateWaveform(so);
-                return true;
-            }
+            so->sortedId = sortPCAUnits[k].getUnitID();
+            so->color[0] = sortPCAUnits[k].ColorRGB[0];
+            so->color[1] = sortPCAUnits[k].ColorRGB[1];
+            so->color[2] = sortPCAUnits[k].ColorRGB[2];
+            queueWaveformUpdate(sortPCAUnits[k].getUnitID(), so);
+            return true;
         }
+    }
+
+    return false;
+}
+
+void SpikeSortBoxes::updateBoxBins(SortUnitSnapshot* units, SorterSpikeContainer* so)
+{
+    const float sampleRate = so->getChannel()->getSampleRate();
+    const int numSamples = so->getChannel()->getTotalSamples();
+
+    if (units->version == boxBinsVersion && sampleRate == boxBinsSampleRate && numSamples == boxBinsNumSamples)
+        return;
+
+    if (sampleRate != boxBinsSampleRate || numSamples != boxBinsNumSamples)
+    {
+        binTimes.resize(numSamples);
+        for (int pt = 0; pt < numSamples; pt++)
+            binTimes[pt] = spikeTimeBinToMicrosecond(so, pt);
+    }
+
+    boxBins.resize(units->boxes.size() * 2);
+    for (size_t k = 0; k < units->boxes.size(); k++)
+    {
+        const Box& box = units->boxes[k];
+        boxBins[k * 2] = microSecondsToSpikeTimeBin(so, box.x);
+        boxBins[k * 2 + 1] = microSecondsToSpikeTimeBin(so, box.x + box.w);
+    }
+
+    boxBinsVersion = units->version;
+    boxBinsSampleRate = sampleRate;
+    boxBinsNumSamples = numSamples;
+}
 
+// same test as BoxUnit::isWaveFormInsideAllBoxes, with the bins of the boxes found beforehand
+bool SpikeSortBoxes::isWaveFormInsideAllBoxes(SortUnitSnapshot* units, int boxUnit, SorterSpikeContainer* so)
+{
+    const int first = units->boxUnitStart[boxUnit];
+    const int last = units->boxUnitStart[boxUnit + 1];
+
+    for (int k = first; k < last; k++)
+    {
+        if (!isWaveFormInsideBox(units->boxes[k], boxBins[k * 2], boxBins[k * 2 + 1], so))
+            return false;
     }
+    return last > first;
+}
+
+// same test as Box::isWaveFormInside
+bool SpikeSortBoxes::isWaveFormInsideBox(const Box& box, int binLeft, int binRight, SorterSpikeContainer* so)
+{
+    if (box.channel < 0 || box.channel >= (int) so->getChannel()->getNumChannels())
+        return false;
+
+    PointD BoxTopLeft(box.x, box.y);
+    PointD BoxBottomLeft(box.x, (box.y - box.h));
+
+    PointD BoxTopRight(box.x + box.w, box.y);
+    PointD BoxBottomRight(box.x + box.w, (box.y - box.h));
 
+    const float top = jmax(BoxTopLeft.Y, BoxBottomLeft.Y);
+    const float bottom = jmin(BoxTopLeft.Y, BoxBottomLeft.Y);
+
+    const float* wave = so->getData() + box.channel * so->getChannel()->getTotalSamples();
+
+    for (int pt = binLeft; pt < binRight; pt++)
+    {
+        // a segment entirely above or below the box can't cross any of its sides
+        if (jmax(wave[pt], wave[pt + 1]) < bottom || jmin(wave[pt], wave[pt + 1]) > top)
+            continue;
+
+        PointD Pwave1(binTimes[pt], wave[pt]);
+        PointD Pwave2(binTimes[pt + 1], wave[pt + 1]);
+
+        if (Box::LineSegmentIntersection(Pwave1, Pwave2, BoxTopLeft, BoxBottomLeft)
+            || Box::LineSegmentIntersection(Pwave1, Pwave2, BoxTopRight, BoxBottomRight)
+            || Box::LineSegmentIntersection(Pwave1, Pwave2, BoxTopLeft, BoxTopRight)
+            || Box::LineSegmentIntersection(Pwave1, Pwave2, BoxBottomLeft, BoxBottomRight))
+        {
+            return true;
+        }
+    }
     return false;
 }
 
@@ -1248,6 +1557,7 @@ bool  SpikeSortBoxes::removeBoxFromUnit(int unitID, int boxIndex)
         if (boxUnits[k].getUnitID() == unitID)
         {
             bool s= boxUnits[k].deleteBox(boxIndex);
+            publishUnits();
             setSelectedUnitAndBox(-1,-1);
             //EndCriticalSection();
             return s;
@@ -79,7 +79,7 @@ public:
     Box();
     Box(int channel);
     Box(float X, float Y, float W, float H, int ch=0);
-    bool LineSegmentIntersection(PointD p11, PointD p12, PointD p21, PointD p22);
+    static bool LineSegmentIntersection(PointD p11, PointD p12, PointD p21, PointD p22);
     bool isWaveFormInside(SorterSpikePtr so);
     double x,y,w,h; // x&w and specified in microseconds. y&h in microvolts
     int channel;
@@ -247,9 +247,54 @@ public:
     Time timer;
 };
 
+// Unit definitions used by the processing thread to sort spikes. A snapshot is never
+// modified once it has been published: every edit builds a new one with a higher version.
+// The units are also compiled when the snapshot is built, so each spike is only tested
+// against the polygons and boxes it could fall in.
+class SortUnitSnapshot : public ReferenceCountedObject
+{
+public:
+    SortUnitSnapshot(int version, const std::vector<BoxUnit>& boxUnits, const std::vector<PCAUnit>& pcaUnits);
+
+    // Returns the index of the first PCA unit whose polygon holds the point, or -1
+    int findPCAUnit(PointD p) const;
+
+    const int version;
+    std::vector<BoxUnit> boxUnits;
+    std::vector<PCAUnit> pcaUnits;
+
+    // The boxes of all box units, one unit after another. Those of unit k are
+    // boxes[boxUnitStart[k]] to boxes[boxUnitStart[k+1]-1]
+    std::vector<Box> boxes;
+    std::vector<int> boxUnitStart;
+
+private:
+    // A polygon with its offset applied, and its bounding box
+    struct CompiledPolygon
+    {
+        bool isPointInside(PointD p) const;
+        std::vector<PointD> pts;
+        float minX, minY, maxX, maxY;
+    };
+
+    std::vector<CompiledPolygon> polygons;
+
+    // Uniform grid over the bounding boxes of the polygons. Cell c lists, in unit order, the
+    // polygons whose bounding box overlaps it: cellPolygons[cellStart[c]] to cellPolygons[cellStart[c+1]-1]
+    float gridMinX, gridMinY, gridMaxX, gridMaxY;
+    float cellWidth, cellHeight;
+    std::vector<int> cellStart;
+    std::vector<int> cellPolygons;
+};
+typedef ReferenceCountedObjectPtr<SortUnitSnapshot> SortUnitSnapshotPtr;
+
 // Sort spikes from a single electrode (which could have any number of channels)
 // using the box method. Any electrode could have an arbitrary number of units specified.
 // Each unit is defined by a set of boxes, which can be placed on any of the given channels.
+// The units are edited under a lock from the GUI and published as snapshots, so sortSpike
+// never waits for the GUI. The spikes of a block can be sorted at once with sortSpikes.
+// Waveform statistics come back through a lock-free queue and are applied to the units
+// the next time the GUI reads them.
 class SpikeSortBoxes
 {
 public:
@@ -261,6 +306,8 @@ public:
 
 	void projectOnPrincipalComponents(SorterSpikePtr so);
 	bool sortSpike(SorterSpikePtr so, bool PCAfirst);
+    // Sorts the spikes in order, as sortSpike does, with the units of a single snapshot
+    void sortSpikes(const Array<SorterSpikePtr>& spikes, bool PCAfirst);
     void RePCA();
     void addPCAunit(PCAUnit unit);
     int addBoxUnit(int channel);
@@ -295,6 +342,29 @@ public:
 private:
     //void  StartCriticalSection();
     //void  EndCriticalSection();
+
+    // Publishes the current units to the processing thread. Called with mut held
+    void publishUnits();
+    // Returns the latest snapshot published. Called from the processing thread only
+    SortUnitSnapshot* getSortingSnapshot();
+    // Passes a sorted spike to the statistics of its unit. Called from the processing thread only
+    void queueWaveformUpdate(int unitID, SorterSpikePtr so);
+    // Applies the statistics updates queued by the processing thread. Called with mut held
+    void applyWaveformUpdates();
+    // Sorts a spike with the given units. Called from the processing thread only
+    bool sortSpike(SortUnitSnapshot* units, SorterSpikeContainer* so, bool PCAfirst);
+    // Finds the waveform bins spanned by the boxes of the units, for spikes shaped like so.
+    // Called from the processing thread only
+    void updateBoxBins(SortUnitSnapshot* units, SorterSpikeContainer* so);
+    bool isWaveFormInsideAllBoxes(SortUnitSnapshot* units, int boxUnit, SorterSpikeContainer* so);
+    bool isWaveFormInsideBox(const Box& box, int binLeft, int binRight, SorterSpikeContainer* so);
+
+    struct WaveformUpdate
+    {
+        int unitID;
+        SorterSpikePtr spike;
+    };
+
     UniqueIDgenerator* uniqueIDgenerator;
     int numChannels, waveformLength;
     int selectedUnit, selectedBox;
@@ -309,6 +379,24 @@ private:
     bool bPCAJobSubmitted,bPCAcomputed,bRePCA;
     std::atomic<bool> bPCAjobFinished ;
 
+    ReferenceCountedArray<SortUnitSnapshot> publishedSnapshots; // guarded by mut
+    int lastSnapshotVersion;
+    std::atomic<SortUnitSnapshot*> pendingSnapshot; // newest snapshot, until the processing thread takes it
+    std::atomic<int> sortingVersion; // version of the snapshot the processing thread sorts with
+    SortUnitSnapshot* sortingSnapshot;
+
+    // The time of each waveform bin, and the first and last bins of each box of the snapshot
+    // they were found for. They depend on the sample rate and length of the spikes, so they
+    // are kept by the processing thread
+    std::vector<float> binTimes;
+    std::vector<int> boxBins;
+    int boxBinsVersion;
+    float boxBinsSampleRate;
+    int boxBinsNumSamples;
+
+    std::vector<WaveformUpdate> waveformUpdates;
+    AbstractFifo waveformUpdateFifo;
+
 
 };
 
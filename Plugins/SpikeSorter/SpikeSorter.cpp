@@ -935,19 +935,19 @@ void SpikeSorter::process(AudioSampleBuffer& buffer)
                         sampleIndex -= (electrode->prePeakSamples+1);
 
 						const SpikeChannel* spikeChan = getSpikeChannel(i);
-						SpikeEvent::SpikeBuffer spikeData(spikeChan);
-						Array<float> thresholds;
+						DetectedSpike* detected = detectedSpikes.add(new DetectedSpike(spikeChan));
+						detected->peakIndex = peakIndex;
 						for (int channel = 0; channel < electrode->numChannels; ++channel)
 						{
-							addWaveformToSpikeObject(spikeData,
+							addWaveformToSpikeObject(detected->data,
 								peakIndex,
 								i,
 								channel);
-							thresholds.add((int)*(electrode->thresholds + channel));
+							detected->thresholds.add((int)*(electrode->thresholds + channel));
 						}
 						int64 timestamp = getTimestamp(electrode->channels[0]) + peakIndex;
 
-						SorterSpikePtr sorterSpike = new SorterSpikeContainer(spikeChan, spikeData, timestamp);
+						SorterSpikePtr sorterSpike = new SorterSpikeContainer(spikeChan, detected->data, timestamp);
 
                         /*
                         bool perfectMatch = true;
@@ -963,32 +963,8 @@ void SpikeSorter::process(AudioSampleBuffer& buffer)
 
                         //for (int xxx = 0; xxx < 1000; xxx++) // overload with spikes for testing purposes
 						electrode->spikeSort->projectOnPrincipalComponents(sorterSpike);
+						detectedSorterSpikes.add(sorterSpike);
 
-                        // Add spike to drawing buffer....
-						electrode->spikeSort->sortSpike(sorterSpike, PCAbeforeBoxes);
-
-
-                        // transfer buffered spikes to spike plot
-                        if (electrode->spikePlot != nullptr)
-                        {
-                            if (electrode->spikeSort->isPCAfinished())
-                            {
-                                electrode->spikeSort->resetJobStatus();
-                                float p1min,p2min, p1max,  p2max;
-                                electrode->spikeSort->getPCArange(p1min,p2min, p1max,  p2max);
-                                electrode->spikePlot->setPCARange(p1min,p2min, p1max,  p2max);
-                            }
-
-
-							electrode->spikePlot->processSpikeObject(sorterSpike);
-                        }
-
-						MetaDataValueArray md;
-						md.add(new MetaDataValue(MetaDataDescriptor::UINT8, 3, sorterSpike->color));
-						SpikeEventPtr newSpike = SpikeEvent::createSpikeEvent(spikeChan, timestamp, thresholds, spikeData, sorterSpike->sortedId, md);
-
-                        addSpike(spikeChan, newSpike, peakIndex);
-                        //prevSpike = newSpike;
                         // advance the sample index
                         sampleIndex = peakIndex + electrode->postPeakSamples;
 
@@ -1001,6 +977,39 @@ void SpikeSorter::process(AudioSampleBuffer& buffer)
 
         } // end cycle through samples
 
+        // sort the spikes of the block at once
+        electrode->spikeSort->sortSpikes(detectedSorterSpikes, PCAbeforeBoxes);
+
+        for (int n = 0; n < detectedSpikes.size(); n++)
+        {
+            DetectedSpike* detected = detectedSpikes[n];
+            SorterSpikeContainer* sorterSpike = detectedSorterSpikes[n];
+
+            // transfer buffered spikes to spike plot
+            if (electrode->spikePlot != nullptr)
+            {
+                if (electrode->spikeSort->isPCAfinished())
+                {
+                    electrode->spikeSort->resetJobStatus();
+                    float p1min,p2min, p1max,  p2max;
+                    electrode->spikeSort->getPCArange(p1min,p2min, p1max,  p2max);
+                    electrode->spikePlot->setPCARange(p1min,p2min, p1max,  p2max);
+                }
+
+                electrode->spikePlot->processSpikeObject(sorterSpike);
+            }
+
+            MetaDataValueArray md;
+            md.add(new MetaDataValue(MetaDataDescriptor::UINT8, 3, sorterSpike->color));
+            SpikeEventPtr newSpike = SpikeEvent::createSpikeEvent(spikeChan, sorterSpike->getTimestamp(), detected->thresholds,
+                                                                  detected->data, sorterSpike->sortedId, md);
+
+            addSpike(spikeChan, newSpike, detected->peakIndex);
+        }
+
+        detectedSpikes.clear();
+        detectedSorterSpikes.clearQuick();
+
         //float vv = getNextSample(currentChannel);
         electrode->lastBufferIndex = sampleIndex - nSamples; // should be negative
 
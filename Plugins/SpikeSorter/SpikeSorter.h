@@ -441,6 +441,20 @@ private:
                                   int& electrodeNumber,
                                   int& currentChannel);
 
+    // A spike found on the electrode being processed. The spikes of a block are sorted
+    // together, then drawn and sent on in the order they were found
+    struct DetectedSpike
+    {
+        DetectedSpike(const SpikeChannel* channel) : data(channel) {}
+
+        SpikeEvent::SpikeBuffer data;
+        Array<float> thresholds;
+        int peakIndex;
+    };
+
+    OwnedArray<DetectedSpike> detectedSpikes;
+    Array<SorterSpikePtr> detectedSorterSpikes;
+
 
     OwnedArray<Electrode> electrodes;
     PCAcomputingThread computingThread;
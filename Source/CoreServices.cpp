@@ -40,7 +40,7 @@ namespace CoreServices
 {
 	void updateSignalChain(GenericEditor* source)
 	{
-		getEditorViewport()->makeEditorVisible(source, false, true);
+		getEditorViewport()->makeEditorVisible(source, false, true, true);
 	}
 
 	bool getRecordingStatus()
@@ -27,6 +27,9 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "MainWindow.h"
 #include "UI/LookAndFeel/CustomLookAndFeel.h"
+#include "Utils/LatencyBenchmark.h"
+#include "Utils/FilterBenchmark.h"
+#include "Utils/FileReaderBenchmark.h"
 
 #include <stdio.h>
 #include <fstream>
@@ -63,6 +66,17 @@ public:
         parameters.addTokens(commandLine," ","\"");
         parameters.removeEmptyStrings();
 
+        // options start with "--", the rest is the signal chain to load
+        StringArray options;
+        for (int i = parameters.size(); --i >= 0;)
+        {
+            if (parameters[i].startsWith("--"))
+            {
+                options.insert(0, parameters[i]);
+                parameters.remove(i);
+            }
+        }
+
 #ifdef WIN32
         //glWinInit();
         if (AllocConsole())
@@ -83,6 +97,21 @@ public:
 
 #endif
 
+        // benchmarks that don't need the signal chain run here and quit
+        if (FilterBenchmark::isRequested(options))
+        {
+            setApplicationReturnValue(FilterBenchmark::run(options));
+            quit();
+            return;
+        }
+
+        if (FileReaderBenchmark::isRequested(options))
+        {
+            setApplicationReturnValue(FileReaderBenchmark::run(options));
+            quit();
+            return;
+        }
+
         customLookAndFeel = new CustomLookAndFeel();
         LookAndFeel::setDefaultLookAndFeel(customLookAndFeel);
 
@@ -97,6 +126,12 @@ public:
         {
             mainWindow = new MainWindow();
         }
+
+        if (LatencyBenchmark::isRequested(options))
+        {
+            latencyBenchmark = new LatencyBenchmark(options);
+            latencyBenchmark->start();
+        }
     }
 
     void shutdown() { }
@@ -104,7 +139,8 @@ public:
     //==============================================================================
     void systemRequestedQuit()
     {
-		mainWindow->shutDownGUI();
+		if (mainWindow != nullptr)
+			mainWindow->shutDownGUI();
         //std::cout << "Quit requested" << std::endl;
         quit();
     }
@@ -128,6 +164,7 @@ public:
 private:
     ScopedPointer <MainWindow> mainWindow;
     ScopedPointer <CustomLookAndFeel> customLookAndFeel;
+    ScopedPointer <LatencyBenchmark> latencyBenchmark;
     std::ofstream console_out;
 };
 
@@ -24,6 +24,7 @@
 #include "MainWindow.h"
 #include "UI/UIComponent.h"
 #include "UI/EditorViewport.h"
+#include "Processors/PluginManager/PluginManager.h"
 #include <stdio.h>
 //-----------------------------------------------------------------------
 
@@ -64,6 +65,13 @@
 	addKeyListener(commandManager.getKeyMappings());
 
 	loadWindowBounds();
+
+	// Start loading the plugin libraries the configuration needs while the window is shown
+	if (!fileToLoad.getFullPathName().isEmpty())
+		ui->getPluginManager()->prefetchPlugins(fileToLoad);
+	else if (shouldReloadOnStartup)
+		ui->getPluginManager()->prefetchPlugins(CoreServices::getSavedStateDirectory().getChildFile("lastConfig.xml"));
+
 	setUsingNativeTitleBar(true);
 	Component::addToDesktop(getDesktopWindowStyleFlags());  // prevents the maximize
 	// button from randomly disappearing
@@ -122,6 +130,7 @@ MainWindow::~MainWindow()
 
 	File lastConfig = CoreServices::getSavedStateDirectory().getChildFile("lastConfig.xml");
 	File recoveryConfig = CoreServices::getSavedStateDirectory().getChildFile("recoveryConfig.xml");
+	ui->getEditorViewport()->cancelRecoveryState();
 	ui->getEditorViewport()->saveState(lastConfig);
 	ui->getEditorViewport()->saveState(recoveryConfig);
 
@@ -326,8 +326,7 @@ AudioConfigurationWindow::~AudioConfigurationWindow()
 
 void AudioConfigurationWindow::closeButtonPressed()
 {
-    File recoveryFile = CoreServices::getSavedStateDirectory().getChildFile("recoveryConfig.xml");
-    AccessClass::getEditorViewport()->saveState(recoveryFile);
+    AccessClass::getEditorViewport()->saveRecoveryState();
 
     controlButton->setToggleState (false, dontSendNotification);
     setVisible (false);
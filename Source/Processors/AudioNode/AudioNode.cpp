@@ -37,7 +37,8 @@ AudioNode::AudioNode()
     //nextAvailableChannel = 2; // keep first two channels empty
     resetConnections();
 
-    tempBuffer = new AudioSampleBuffer(16, 1024);
+    // build the filter banks for the usual rates before acquisition starts
+    PolyphaseResampler::precomputeCommonTables();
 
 }
 
@@ -186,36 +187,40 @@ void AudioNode::prepareToPlay(double sampleRate_, int estimatedSamplesPerBlock)
 
 void AudioNode::recreateBuffers()
 {
-	numSamplesExpected.clear();
-    samplesInBackupBuffer.clear();
-    samplesInOverflowBuffer.clear();
-    ratio.clear();
-    filters.clear();
-    bufferA.clear();
-    bufferB.clear();
-    bufferSwap.clear();
+    streams.clear();
 
     for (int i = 0; i < dataChannelArray.size(); i++)
     {
-        // processor sample rate divided by sound card sample rate
-        numSamplesExpected.add((int)(dataChannelArray[i]->getSampleRate()/destBufferSampleRate*float(estimatedSamples)) + 1);
-        samplesInBackupBuffer.add(0);
-        samplesInOverflowBuffer.add(0);
-        sourceBufferSampleRate.add(dataChannelArray[i]->getSampleRate());
+        uint16 sourceNodeID = dataChannelArray[i]->getSourceNodeID();
+        uint16 subProcessorIdx = dataChannelArray[i]->getSubProcessorIdx();
 
-        filters.add(new Dsp::SmoothedFilterDesign<Dsp::RBJ::Design::LowPass, 1> (1024));
+        AudioStream* stream = nullptr;
+        for (int s = 0; s < streams.size(); s++)
+        {
+            if (streams[s]->sourceNodeID == sourceNodeID && streams[s]->subProcessorIdx == subProcessorIdx)
+            {
+                stream = streams[s];
+                break;
+            }
+        }
 
-        ratio.add(float(numSamplesExpected[i])/float(estimatedSamples));
-        updateFilter(i);
+        if (stream == nullptr)
+        {
+            stream = new AudioStream();
+            stream->sourceNodeID = sourceNodeID;
+            stream->subProcessorIdx = subProcessorIdx;
+            stream->active = false;
 
-        bufferA.add(new AudioSampleBuffer(1,10000));
-        bufferB.add(new AudioSampleBuffer(1,10000));
-        bufferSwap.add(false);
+            // room for several blocks, so jitter between the source and the sound card doesn't drop samples
+            double sourceSampleRate = dataChannelArray[i]->getSampleRate();
+            int samplesPerBlock = int(sourceSampleRate / destBufferSampleRate * estimatedSamples) + 1;
+            stream->resampler.prepare(sourceSampleRate, destBufferSampleRate, 1, jmax(8 * samplesPerBlock, 8192));
 
-    }
+            streams.add(stream);
+        }
 
-//    tempBuffer->setSize(getNumInputs(), 4096);
-    tempBuffer->setSize(1, 4096);
+        stream->channels.add(i);
+    }
 }
 
 bool AudioNode::enable()
@@ -224,268 +229,73 @@ bool AudioNode::enable()
 	return true;
 }
 
-void AudioNode::updateFilter(int i)
-{
-
-    double cutoffFreq = (ratio[i] > 1.0) ? 2 * destBufferSampleRate  // downsample
-                        : destBufferSampleRate / 2; // upsample
-
-    double sampleFreq = (ratio[i] > 1.0) ? sourceBufferSampleRate[i] // downsample
-                        : destBufferSampleRate;  // upsample
-
-    Dsp::Params params;
-    params[0] = sampleFreq; // sample rate
-    params[1] = cutoffFreq; // cutoff frequency
-    params[2] = 1.25; //Q //
-
-    filters[i]->setParams(params);
-
-}
-
 void AudioNode::process(AudioSampleBuffer& buffer)
 {
-    float gain;
     int valuesNeeded = buffer.getNumSamples(); // samples needed to fill out the buffer
 
-    //std::cout << "Buffer size: " << buffer.getNumChannels() << std::endl;
-
     // clear the left and right channels
     buffer.clear(0,0,buffer.getNumSamples());
     buffer.clear(1,0,buffer.getNumSamples());
 
-    if (1)
+    if (dataChannelArray.size() > 0) // we have some channels
     {
+        float* output = buffer.getWritePointer(0);
 
-        AudioSampleBuffer* overflowBuffer;
-        AudioSampleBuffer* backupBuffer;
-
-        int nInputs = dataChannelArray.size();
-        if (nInputs > 0) // we have some channels
+        for (int s = 0; s < streams.size(); s++)
         {
+            AudioStream* stream = streams[s];
+            int samplesAvailable = getNumSourceSamples(stream->sourceNodeID, stream->subProcessorIdx);
+            bool anyMonitored = false;
 
-//            tempBuffer->clear();
-
-            for (int i = 0; i < nInputs; i++) // cycle through them all
+            // resampling is linear, so mixing the monitored channels first gives the same result
+            // as resampling each one of them
+            for (int c = 0; c < stream->channels.size(); c++)
             {
+                int chan = stream->channels[c];
+                if (!dataChannelArray[chan]->isMonitored())
+                    continue;
 
-                if (dataChannelArray[i]->isMonitored())
-                {
-                    tempBuffer->clear();
-                    //std::cout << "Processing channel " << i << std::endl;
-
-                    if (!bufferSwap[i])
-                    {
-                        overflowBuffer = bufferA[i];
-                        backupBuffer = bufferB[i];
-
-                        bufferSwap.set(i,true);
-                    }
-                    else
-                    {
-                        overflowBuffer = bufferB[i];
-                        backupBuffer = bufferA[i];
-
-                        bufferSwap.set(i,false);
-                    }
-
-                    backupBuffer->clear();
-
-                    samplesInOverflowBuffer.set(i,samplesInBackupBuffer[i]); // size of buffer after last round
-                    samplesInBackupBuffer.set(i,0);
+                float gain = volume/(float(0x7fff) * dataChannelArray[chan]->getBitVolts());
+                // Data are floats in units of microvolts, so dividing by bitVolts and 0x7fff (max value for 16b signed)
+                // rescales to between -1 and +1. Audio output starts So, maximum gain applied to maximum data would be 10.
 
-                    int orphanedSamples = 0;
+                const float* source = buffer.getReadPointer(chan + 2); // add 2 to account for output channels
 
-                    // 1. copy overflow buffer
+                if (!anyMonitored)
+                    stream->resampler.pushSamples(0, source, samplesAvailable, gain);
+                else
+                    stream->resampler.addToLastSamples(0, source, samplesAvailable, gain);
 
-                    int samplesToCopyFromOverflowBuffer =
-                        ((samplesInOverflowBuffer[i] <= numSamplesExpected[i]) ?
-                         samplesInOverflowBuffer[i] :
-                         numSamplesExpected[i]);
+                anyMonitored = true;
+            }
 
-                    //std::cout << "Copying " << samplesToCopyFromOverflowBuffer << " samples from overflow buffer of " << samplesInOverflowBuffer[i] << " samples." << std::endl;
-
-                    if (samplesToCopyFromOverflowBuffer > 0) // need to re-add samples from backup buffer
-                    {
-
-                        tempBuffer->addFrom(0,    // destination channel
-                                            0,                // destination start sample
-                                            *overflowBuffer,  // source
-                                            0,                // source channel
-                                            0,                // source start sample
-                                            samplesToCopyFromOverflowBuffer,    // number of samples
-                                            1.0f              // gain to apply
-                                           );
-
-                        int leftoverSamples = samplesInOverflowBuffer[i] - samplesToCopyFromOverflowBuffer;
-
-                        // std::cout << "Samples remaining in overflow buffer: " << leftoverSamples << std::endl;
-
-                        if (leftoverSamples > 0) // move remaining samples to the backup buffer
-                        {
-
-                            backupBuffer->addFrom(0, // destination channel
-                                                  0,                     // destination start sample
-                                                  *overflowBuffer,       // source
-                                                  0,                     // source channel
-                                                  samplesToCopyFromOverflowBuffer,         // source start sample
-                                                  leftoverSamples,       // number of samples
-                                                  1.0f                   // gain to apply
-                                                 );
-                        }
-
-                        samplesInBackupBuffer.set(i,leftoverSamples);
-                    }
-
-                    gain = volume/(float(0x7fff) * dataChannelArray[i]->getBitVolts());
-                    // Data are floats in units of microvolts, so dividing by bitVolts and 0x7fff (max value for 16b signed)
-                    // rescales to between -1 and +1. Audio output starts So, maximum gain applied to maximum data would be 10.
-
-                    int remainingSamples = numSamplesExpected[i] - samplesToCopyFromOverflowBuffer;
-
-                    int samplesAvailable = getNumSourceSamples(dataChannelArray[i]->getSourceNodeID(), dataChannelArray[i]->getSubProcessorIdx());
-
-                    int samplesToCopyFromIncomingBuffer = ((remainingSamples <= samplesAvailable) ?
-                                                           remainingSamples :
-                                                           samplesAvailable);
-
-                    //std::cout << "Copying " << samplesToCopyFromIncomingBuffer << " samples from incoming buffer of " << samplesAvailable << " samples." << std::endl;
-
-
-                    if (samplesToCopyFromIncomingBuffer > 0)
-                    {
-
-                        //tempBuffer->addFrom(i,       // destination channel
-                        tempBuffer->addFrom(0,       // destination channel
-                                            samplesToCopyFromOverflowBuffer,           // destination start sample
-                                            buffer,      // source
-                                            i+2,           // source channel (add 2 to account for output channels)
-                                            0,           // source start sample
-                                            samplesToCopyFromIncomingBuffer, //  number of samples
-                                            gain       // gain to apply
-                                           );
-
-                        //if (destBufferPos == 0)
-                        //  std::cout << "Temp buffer 0 value: " << *tempBuffer->getReadPointer(i,0) << std::endl;
-
-                    }
-
-                    orphanedSamples = samplesAvailable - samplesToCopyFromIncomingBuffer;
-
-                    // std::cout << "Samples remaining in incoming buffer: " << orphanedSamples << std::endl;
-
-                    if (orphanedSamples > 0 && (samplesInBackupBuffer[i] + orphanedSamples < backupBuffer->getNumSamples()))
-                    {
-
-                        backupBuffer->addFrom(0,                            // destination channel
-                                              samplesInBackupBuffer[i],     // destination start sample
-                                              buffer,                       // source
-                                              i+2,                          // source channel (add 2 to account for output channels)
-                                              remainingSamples,             // source start sample
-                                              orphanedSamples,              //  number of samples
-                                              gain                          // gain to apply
-                                             );
+            if (!anyMonitored)
+            {
+                // start from silence the next time one of its channels is monitored
+                if (stream->active)
+                    stream->resampler.reset();
+                stream->active = false;
+                continue;
+            }
 
-                        samplesInBackupBuffer.set(i, samplesInBackupBuffer[i] + orphanedSamples);
+            stream->active = true;
 
-                    }
-
-                    // now that our tempBuffer is ready, we can filter it and copy it into the
-                    // original buffer
-
-                    //std::cout << "Ratio = " << ratio[i] << ", gain = " << gain << std::endl;
-                    //std::cout << "Values needed = " << valuesNeeded << ", channel = " << i << std::endl;
-
-                    if (ratio[i] > 1.00001)
-                    {
-                        // pre-apply filter before downsampling
-                        float* ptr = tempBuffer->getWritePointer(i);
-                        filters[i]->process(numSamplesExpected[i], &ptr);
-                    }
-
-                    // initialize variables
-                    int sourceBufferPos = 0;
-                    int sourceBufferSize = numSamplesExpected[i];
-                    float subSampleOffset = 0.0;
-                    int nextPos = (sourceBufferPos + 1) % sourceBufferSize;
-
-                    int destBufferPos;
-
-                    // code modified from "juce_ResamplingAudioSource.cpp":
-
-                    for (destBufferPos = 0; destBufferPos < valuesNeeded; destBufferPos++)
-                    {
-                        float gain = 1.0;
-                        float alpha = (float) subSampleOffset;
-                        float invAlpha = 1.0f - alpha;
-
-                        // std::cout << "Copying sample " << sourceBufferPos << std::endl;
-
-                        buffer.addFrom(0,    // destChannel
-                                       destBufferPos,  // destSampleOffset
-                                       *tempBuffer,     // source
-                                       //i,    // sourceChannel
-                                       0,       // sourceChannel
-                                       sourceBufferPos,// sourceSampleOffset
-                                       1,        // number of samples
-                                       invAlpha*gain);      // gain to apply to source
-
-                        buffer.addFrom(0,    // destChannel
-                                       destBufferPos,   // destSampleOffset
-                                       *tempBuffer,     // source
-                                       //i,      // sourceChannel
-                                       0,      // sourceChannel
-                                       nextPos,      // sourceSampleOffset
-                                       1,        // number of samples
-                                       alpha*gain);       // gain to apply to source
-
-                        // if (destBufferPos == 0)
-                        //std::cout << "Output buffer 0 value: " << *buffer.getReadPointer(i+2,destBufferPos) << std::endl;
-
-                        subSampleOffset += ratio[i];
-
-                        while (subSampleOffset >= 1.0)
-                        {
-                            if (++sourceBufferPos >= sourceBufferSize)
-                                sourceBufferPos = 0;
-
-                            nextPos = (sourceBufferPos + 1) % sourceBufferSize;
-                            subSampleOffset -= 1.0;
-                        }
-                    }
-
-                    if (ratio[i] < 0.99999)
-                    {
-                        // apply the filter after upsampling
-                        float* ptr = buffer.getWritePointer(0);
-                        filters[i]->process(destBufferPos, &ptr);
-                    }
-
-                    // now copy the channel into the output zone
-
-                    // buffer.addFrom(0,    // destChannel
-                    //                0,  // destSampleOffset
-                    //                buffer,     // source
-                    //                 i+2,    // sourceChannel
-                    //                 0,// sourceSampleOffset
-                    //                 valuesNeeded,        // number of samples
-                    //                 1.0);      // gain to apply to source
-
-                } // if channelPointers[i]->isMonitored
-            } // end cycling through channels
-
-            // Simple implementation of a "noise gate" on audio output
-            expander.process(buffer.getWritePointer(0), // expand the left channel
-                             buffer.getNumSamples());
-
-            // copy the signal into the right channel (no stereo audio yet!)
-            buffer.addFrom(1,    // destChannel
-                           0,  // destSampleOffset
-                           buffer,     // source
-                           0,    // sourceChannel
-                           0,// sourceSampleOffset
-                           valuesNeeded,        // number of samples
-                           1.0);      // gain to apply to source
+            // if the source falls behind the sound card, the remaining samples are left silent
+            stream->resampler.process(&output, valuesNeeded);
         }
+
+        // Simple implementation of a "noise gate" on audio output
+        expander.process(buffer.getWritePointer(0), // expand the left channel
+                         buffer.getNumSamples());
+
+        // copy the signal into the right channel (no stereo audio yet!)
+        buffer.addFrom(1,    // destChannel
+                       0,  // destSampleOffset
+                       buffer,     // source
+                       0,    // sourceChannel
+                       0,// sourceSampleOffset
+                       valuesNeeded,        // number of samples
+                       1.0);      // gain to apply to source
     }
 }
 
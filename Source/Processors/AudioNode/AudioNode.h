@@ -31,6 +31,7 @@
 #include "../GenericProcessor/GenericProcessor.h"
 #include "AudioEditor.h"
 #include "../Dsp/Dsp.h"
+#include "../Dsp/PolyphaseResampler.h"
 
 
 class AudioEditor;
@@ -122,8 +123,6 @@ public:
 
     void prepareToPlay(double sampleRate_, int estimatedSamplesPerBlock) override;
 
-    void updateFilter(int i);
-
 	bool enable() override;
 
 	//Called by ProcessorGraph
@@ -140,29 +139,23 @@ private:
     float volume;
     float noiseGateLevel; // in microvolts
 
-    OwnedArray<AudioSampleBuffer> bufferA;
-    OwnedArray<AudioSampleBuffer> bufferB;
-
-    Array<int> numSamplesExpected;
-
-    Array<int> samplesInBackupBuffer;
-    Array<int> samplesInOverflowBuffer;
-    Array<double> sourceBufferSampleRate;
     double destBufferSampleRate;
 	int estimatedSamples;
 
-    Array<bool> bufferSwap;
-
     Expander expander;
 
-    // sample rate, timebase, and ratio info:
-    Array<double> ratio;
-
-    // major objects:
-    OwnedArray<Dsp::Filter> filters;
-
-    // Temporary buffer for data
-    ScopedPointer<AudioSampleBuffer> tempBuffer;
+    /** All the channels coming from the same subprocessor share a sample rate, so their
+    monitored channels are mixed together and resampled as a single stream */
+    struct AudioStream
+    {
+        uint16 sourceNodeID;
+        uint16 subProcessorIdx;
+        Array<int> channels;
+        PolyphaseResampler resampler;
+        bool active;
+    };
+
+    OwnedArray<AudioStream> streams;
 
 	//private map for datachannels with info relative to multiple processors
 	std::unordered_map<uint16, std::map<uint16, int>> audioDataChannelMap;
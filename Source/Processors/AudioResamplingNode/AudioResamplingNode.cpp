@@ -27,7 +27,7 @@
 AudioResamplingNode::AudioResamplingNode()
     : GenericProcessor("Resampling Node"),
       sourceBufferSampleRate(40000.0), destBufferSampleRate(44100.0),
-      ratio(1.0), lastRatio(1.0), destBuffer(0), tempBuffer(0),
+      destBuffer(0), tempBuffer(0),
       destBufferIsTempBuffer(true), isTransmitting(false), destBufferPos(0)
 {
 
@@ -39,9 +39,6 @@ AudioResamplingNode::AudioResamplingNode()
                          44100.0, // sampleRate
                          128);    // blockSize
 
-    filter = new Dsp::SmoothedFilterDesign
-    <Dsp::RBJ::Design::LowPass, 1> (1024);
-
     if (destBufferIsTempBuffer)
         destBufferWidth = 1024;
     else
@@ -61,7 +58,6 @@ AudioResamplingNode::~AudioResamplingNode()
     delete[] continuousDataBuffer;
     deleteAndZero(tempBuffer);
     deleteAndZero(destBuffer);
-    delete filter;
 }
 
 
@@ -96,7 +92,6 @@ void AudioResamplingNode::prepareToPlay(double sampleRate_, int estimatedSamples
     if (destBufferIsTempBuffer)
     {
         destBufferSampleRate = sampleRate_;
-        tempBuffer->setSize(getNumInputs(), 4096);
     }
     else
     {
@@ -104,6 +99,9 @@ void AudioResamplingNode::prepareToPlay(double sampleRate_, int estimatedSamples
         destBuffer->setSize(getNumInputs(), destBufferWidth);
     }
 
+    // the resampler writes every input channel
+    tempBuffer->setSize(getNumInputs(), 4096);
+
     destBuffer->clear();
     tempBuffer->clear();
 
@@ -112,25 +110,11 @@ void AudioResamplingNode::prepareToPlay(double sampleRate_, int estimatedSamples
     // std::cout << "Temp buffer size: " << tempBuffer->getNumChannels() << " x "
     //           << tempBuffer->getNumSamples() << std::endl;
 
-    updateFilter();
-
-}
-
-void AudioResamplingNode::updateFilter()
-{
-
-    double cutoffFreq = (ratio > 1.0) ? 2 * destBufferSampleRate  // downsample
-                        : destBufferSampleRate / 2; // upsample
+    if (getSampleRate() > 0)
+        sourceBufferSampleRate = getSampleRate();
 
-    double sampleFreq = (ratio > 1.0) ? sourceBufferSampleRate // downsample
-                        : destBufferSampleRate;  // upsample
-
-    Dsp::Params params;
-    params[0] = sampleFreq; // sample rate
-    params[1] = cutoffFreq; // cutoff frequency
-    params[2] = 1.25; //Q //
-
-    filter->setParams(params);
+    // the filter bank only depends on the ratio, so it's designed here instead of on every buffer
+    resampler.prepare(sourceBufferSampleRate, destBufferSampleRate, getNumInputs(), 8192);
 
 }
 
@@ -143,109 +127,29 @@ void AudioResamplingNode::process(AudioSampleBuffer& buffer,
                                   MidiBuffer& midiMessages)
 {
 
-    int nSamps = buffer.getNumSamples(); // WRONG!!!!
-    int valuesNeeded;
-
-    if (destBufferIsTempBuffer)
-    {
-        ratio = float(nSamps) / float(buffer.getNumSamples());
-        valuesNeeded = buffer.getNumSamples();
-    }
-    else
-    {
-        ratio = sourceBufferSampleRate / destBufferSampleRate;
-        valuesNeeded = (int) buffer.getNumSamples() / ratio;
-        //std::cout << std::endl;
-        //std::cout << "Ratio: " << ratio << std::endl;
-        //std::cout << "Values needed: " << valuesNeeded << std::endl;
-    }
-
+    int nSamps = buffer.getNumSamples();
+    int numChannels = resampler.getNumChannels();
 
+    jassert(buffer.getNumChannels() >= numChannels);
 
-    if (lastRatio != ratio)
+    // the resampler keeps the samples it can't use yet, so they are not lost between buffers
+    for (int channel = 0; channel < numChannels; ++channel)
     {
-        updateFilter();
-        lastRatio = ratio;
+        resampler.pushSamples(channel, buffer.getReadPointer(channel), nSamps);
     }
 
+    int valuesNeeded;
 
-    if (ratio > 1.0001)
-    {
-        // pre-apply filter before downsampling
-        filter->process(nSamps, buffer.getArrayOfWritePointers());
-    }
-
-
-    // initialize variables
-    tempBuffer->clear();
-    int sourceBufferPos = 0;
-    int sourceBufferSize = buffer.getNumSamples();
-    float subSampleOffset = 0.0;
-    int nextPos = (sourceBufferPos + 1) % sourceBufferSize;
-
-    int tempBufferPos;
-    //int totalSamples = 0;
-
-    // code modified from "juce_ResamplingAudioSource.cpp":
-
-    for (tempBufferPos = 0; tempBufferPos < valuesNeeded; tempBufferPos++)
-    {
-        float gain = 1.0;
-        float alpha = (float) subSampleOffset;
-        float invAlpha = 1.0f - alpha;
-
-        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
-        {
-
-            tempBuffer->addFrom(channel, 		// destChannel
-                                tempBufferPos,  // destSampleOffset
-                                buffer,			// source
-                                channel,		// sourceChannel
-                                sourceBufferPos,// sourceSampleOffset
-                                1,				// number of samples
-                                invAlpha*gain);      // gain to apply to source
-
-            tempBuffer->addFrom(channel, 		// destChannel
-                                tempBufferPos,   // destSampleOffset
-                                buffer,			// source
-                                channel,			// sourceChannel
-                                nextPos,		 	// sourceSampleOffset
-                                1,				// number of samples
-                                alpha*gain);     	 // gain to apply to source
-
-        }
-
-        subSampleOffset += ratio;
-
-
-
-        while (subSampleOffset >= 1.0)
-        {
-            if (++sourceBufferPos >= sourceBufferSize)
-                sourceBufferPos = 0;
-
-            nextPos = (sourceBufferPos + 1) % sourceBufferSize;
-            subSampleOffset -= 1.0;
-        }
-    }
-
-    // std::cout << sourceBufferPos << " " << tempBufferPos << std::endl;
-
-
-    if (ratio < 0.9999)
-    {
+    if (destBufferIsTempBuffer)
+        valuesNeeded = nSamps;
+    else
+        valuesNeeded = resampler.getNumOutputSamplesAvailable();
 
-        filter->process(tempBufferPos, tempBuffer->getArrayOfWritePointers());
-        // apply the filter after upsampling
-        ///////filter->process (totalSamples, buffer.getArrayOfChannels());
-    }
-    else if (ratio <= 1.0001)
-    {
+    valuesNeeded = jmin(valuesNeeded, tempBuffer->getNumSamples());
 
-        // no resampling is being applied, no need to filter, BUT...
-        // keep the filter stoked with samples to avoid discontinuities
+    tempBuffer->clear(0, valuesNeeded);
 
-    }
+    int tempBufferPos = resampler.process(tempBuffer->getArrayOfWritePointers(), valuesNeeded);
 
     if (destBufferIsTempBuffer)
     {
@@ -261,10 +165,7 @@ void AudioResamplingNode::process(AudioSampleBuffer& buffer,
 
         // copy the temp buffer into the destination buffer
 
-        int pos = 0;
-
-        while (*tempBuffer->getWritePointer(0,pos) != 0)
-            pos++;
+        int pos = tempBufferPos;
 
         int spaceAvailable = destBufferWidth - destBufferPos;
         int blockSize1 = (spaceAvailable > pos) ? pos : spaceAvailable;
@@ -25,7 +25,7 @@
 #define __AUDIORESAMPLINGNODE_H_CFAB182E__
 
 #include "../../../JuceLibraryCode/JuceHeader.h"
-#include "../Dsp/Dsp.h"
+#include "../Dsp/PolyphaseResampler.h"
 #include "../GenericProcessor/GenericProcessor.h"
 
 /**
@@ -33,11 +33,9 @@
   Changes the sample rate of continuous data, specialized for increasing
   the sample rate to 44.1 kHz for audio output.
 
-  Code is based on Juce's ResamplingAudioSource class.
-
-  This processor could be vastly improved by implementing a scheme to handle
-  inputs that do not provide the same amount of samples in each buffer. At the
-  moment, the resampling process shifts the pitch of the incoming signal.
+  Uses a PolyphaseResampler, which keeps the input that has not been consumed
+  between buffers, so inputs that do not provide the same amount of samples in
+  each buffer are resampled without shifting the pitch of the signal.
 
   @see GenericProcessor
 
@@ -55,7 +53,6 @@ public:
     {
         return destBuffer;
     }
-    void updateFilter();
 
     void prepareToPlay(double sampleRate, int estimatedSamplesPerBlock);
     void releaseResources();
@@ -72,12 +69,11 @@ private:
 
     // sample rate, timebase, and ratio info:
     double sourceBufferSampleRate, destBufferSampleRate;
-    double ratio, lastRatio;
     double destBufferTimebaseSecs;
     int destBufferWidth;
 
     // major objects:
-    Dsp::Filter* filter;
+    PolyphaseResampler resampler;
     AudioSampleBuffer* destBuffer;
     AudioSampleBuffer* tempBuffer;
 
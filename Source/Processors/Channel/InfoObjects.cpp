@@ -63,15 +63,15 @@ HistoryObject::~HistoryObject()
 
 String HistoryObject::getHistoricString() const
 {
-	return m_historicString;
+	StringArray entries;
+	for (const HistoryEntry* h = m_history; h != nullptr; h = h->previous)
+		entries.insert(0, h->entry);
+	return entries.joinIntoString(" -> ");
 }
 
 void HistoryObject::addToHistoricString(String entry)
 {
-	if (m_historicString.isEmpty())
-		m_historicString = entry;
-	else
-		m_historicString += (" -> " + entry);
+	m_history = new HistoryEntry(entry, m_history);
 }
 
 //SourceProcessorInfo
@@ -644,6 +644,24 @@ size_t SpikeChannel::getChannelDataSize() const
 	return getTotalSamples()*sizeof(float);
 }
 
+void SpikeChannel::setWaveformEncoding(WaveformEncoding encoding)
+{
+	m_encoding = encoding;
+}
+
+SpikeChannel::WaveformEncoding SpikeChannel::getWaveformEncoding() const
+{
+	return m_encoding;
+}
+
+size_t SpikeChannel::getSerializedDataSize() const
+{
+	if (m_encoding == INT16_WAVEFORM)
+		return getTotalSamples()*getNumChannels()*sizeof(int16);
+	else
+		return getDataSize();
+}
+
 float SpikeChannel::getChannelBitVolts(int index) const
 {
 	if (index < 0 || index >= m_channelBitVolts.size())
@@ -684,6 +702,7 @@ bool SpikeChannel::checkEqual(const InfoObjectCommon& other, bool similar) const
 	if (m_type != o.m_type) return false;
 	if (m_numPostSamples != o.m_numPostSamples) return false;
 	if (m_numPreSamples != o.m_numPreSamples) return false;
+	if (m_encoding != o.m_encoding) return false;
 
 	int nChans = m_channelBitVolts.size();
 	if (nChans != o.m_channelBitVolts.size()) return false;
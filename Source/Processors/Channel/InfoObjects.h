@@ -66,7 +66,9 @@ private:
 	String m_currentNodeName;
 };
 
-/** This class allows creating a string with an historic of all the data a node has gone through */
+/** This class allows creating a string with an historic of all the data a node has gone through.
+The entries are stored as an immutable, reference counted list shared by all the copies of a channel,
+so copying a channel and adding a new entry does not copy the whole history. */
 class PLUGIN_API HistoryObject
 {
 protected:
@@ -80,7 +82,14 @@ public:
 	void addToHistoricString(String entry);
 
 private:
-	String m_historicString;
+	class HistoryEntry : public ReferenceCountedObject
+	{
+	public:
+		HistoryEntry(const String& e, HistoryEntry* p) : entry(e), previous(p) {}
+		const String entry;
+		const ReferenceCountedObjectPtr<HistoryEntry> previous;
+	};
+	ReferenceCountedObjectPtr<HistoryEntry> m_history;
 };
 
 class PLUGIN_API SourceProcessorInfo
@@ -442,6 +451,13 @@ public:
 		INVALID = 100
 	};
 
+	/** How the waveforms of the spikes are stored in serialized spike events */
+	enum WaveformEncoding
+	{
+		FLOAT_WAVEFORM,
+		INT16_WAVEFORM		//!< Rounded to multiples of the bitVolts of each channel, at half the size
+	};
+
 	/** Default constructor 
 		@param type The type of electrode this channel represents (SINGLE, STEREOTRODE, TETRODE)
 		@param source A pointer to the source processor
@@ -481,6 +497,14 @@ public:
 	/** Gets the size in bytes of one channel of the spike object*/
 	size_t getChannelDataSize() const;
 
+	/** Sets how the waveforms are serialized. FLOAT_WAVEFORM by default */
+	void setWaveformEncoding(WaveformEncoding encoding);
+
+	WaveformEncoding getWaveformEncoding() const;
+
+	/** Gets the size in bytes of the waveform of a serialized spike, which depends on the encoding */
+	size_t getSerializedDataSize() const;
+
 	/** Gets the number of channels associated with a specific electrode type */
 	static unsigned int getNumChannels(ElectrodeTypes type);
 
@@ -495,6 +519,7 @@ private:
 	Array<SourceChannelInfo> m_sourceInfo;
 	unsigned int m_numPreSamples{ 8 };
 	unsigned int m_numPostSamples{ 32 };
+	WaveformEncoding m_encoding{ FLOAT_WAVEFORM };
 	Array<float> m_channelBitVolts;
 
 	JUCE_LEAK_DETECTOR(DataChannel);
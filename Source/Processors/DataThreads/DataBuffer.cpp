@@ -27,11 +27,16 @@ DataBuffer::DataBuffer (int chans, int size)
     : abstractFifo  (size)
     , buffer        (chans, size)
     , numChans      (chans)
+    , writeStart    (0)
+    , timestampFifo (size)
+    , eventCodeFifo (size)
 {
     timestampBuffer.malloc (size);
     eventCodeBuffer.malloc (size);
 
 	lastTimestamp = 0;
+
+    resetChanges (size);
 }
 
 
@@ -43,12 +48,15 @@ void DataBuffer::clear()
     buffer.clear();
     abstractFifo.reset();
 	lastTimestamp = 0;
+
+    resetChanges (abstractFifo.getTotalSize());
 }
 
 
 void DataBuffer::resize (int chans, int size)
 {
     buffer.setSize (chans, size);
+    abstractFifo.setTotalSize (size);
 
     timestampBuffer.malloc (size);
     eventCodeBuffer.malloc (size);
@@ -56,6 +64,65 @@ void DataBuffer::resize (int chans, int size)
 	lastTimestamp = 0;
 
     numChans = chans;
+
+    resetChanges (size);
+}
+
+
+void DataBuffer::resetChanges (int size)
+{
+    timestampFifo.setTotalSize (size);
+    eventCodeFifo.setTotalSize (size);
+    timestampChangeList.malloc (size);
+    eventCodeChangeList.malloc (size);
+
+    numSamplesWritten = 0;
+    numSamplesRead = 0;
+    nextTimestamp = 0;
+    lastEventCode = 0;
+}
+
+
+void DataBuffer::recordChanges (int startIndex, int numItems)
+{
+    const int size = abstractFifo.getTotalSize();
+    int index = startIndex;
+
+    for (int i = 0; i < numItems; ++i, index = (index + 1 < size) ? index + 1 : 0)
+    {
+        const int64 ts = timestampBuffer[index];
+        const uint64 eventCode = eventCodeBuffer[index];
+
+        if (ts != nextTimestamp && numSamplesWritten > 0)
+        {
+            int start1, size1, start2, size2;
+            timestampFifo.prepareToWrite (1, start1, size1, start2, size2);
+
+            if (size1 > 0)
+            {
+                timestampChangeList[start1].sampleNumber = numSamplesWritten;
+                timestampChangeList[start1].value = (uint64) ts;
+                timestampFifo.finishedWrite (1);
+            }
+        }
+
+        if (eventCode != lastEventCode)
+        {
+            int start1, size1, start2, size2;
+            eventCodeFifo.prepareToWrite (1, start1, size1, start2, size2);
+
+            if (size1 > 0)
+            {
+                eventCodeChangeList[start1].sampleNumber = numSamplesWritten;
+                eventCodeChangeList[start1].value = eventCode;
+                eventCodeFifo.finishedWrite (1);
+            }
+        }
+
+        nextTimestamp = ts + 1;
+        lastEventCode = eventCode;
+        ++numSamplesWritten;
+    }
 }
 
 int DataBuffer::addToBuffer (float* data, int64* timestamps, uint64* eventCodes, int numItems, int chunkSize)
@@ -97,7 +164,7 @@ int DataBuffer::addToBuffer (float* data, int64* timestamps, uint64* eventCodes,
         }
     }
 
-	
+	recordChanges (startIndex1, idx);
 
     // finish write
     abstractFifo.finishedWrite (idx);
@@ -106,10 +173,83 @@ int DataBuffer::addToBuffer (float* data, int64* timestamps, uint64* eventCodes,
 }
 
 
+int DataBuffer::prepareToWrite (int numItems, int& startIndex1, int& blockSize1, int& startIndex2, int& blockSize2)
+{
+    abstractFifo.prepareToWrite (numItems, startIndex1, blockSize1, startIndex2, blockSize2);
+
+    writeStart = startIndex1;
+
+    return blockSize1 + blockSize2;
+}
+
+
+float* DataBuffer::getWritePointer (int chan, int index)
+{
+    return buffer.getWritePointer (chan, index);
+}
+
+
+int64* DataBuffer::getTimestampPointer (int index)
+{
+    return timestampBuffer + index;
+}
+
+
+uint64* DataBuffer::getEventCodePointer (int index)
+{
+    return eventCodeBuffer + index;
+}
+
+
+void DataBuffer::finishedWrite (int numItems)
+{
+    if (numItems <= 0)
+        return;
+
+    lastTimestamp = timestampBuffer[(writeStart + numItems - 1) % abstractFifo.getTotalSize()];
+
+    recordChanges (writeStart, numItems);
+
+    abstractFifo.finishedWrite (numItems);
+}
+
+
 int DataBuffer::getNumSamples() const { return abstractFifo.getNumReady(); }
 
 
-int DataBuffer::readAllFromBuffer (AudioSampleBuffer& data, uint64* timestamp, uint64* eventCodes, int maxSize, int dstStartChannel, int numChannels)
+template <typename ChangeType, typename ValueType>
+void DataBuffer::readChanges (AbstractFifo& fifo, const Change* changes, int64 firstSample, int64 endSample,
+                              Array<ChangeType>* dest, ValueType ChangeType::* valueMember)
+{
+    int startIndex1, blockSize1, startIndex2, blockSize2;
+    fifo.prepareToRead (fifo.getNumReady(), startIndex1, blockSize1, startIndex2, blockSize2);
+
+    int numRead = 0;
+
+    for (int i = 0; i < blockSize1 + blockSize2; ++i)
+    {
+        const Change& change = changes[i < blockSize1 ? startIndex1 + i : startIndex2 + i - blockSize1];
+
+        if (change.sampleNumber >= endSample)
+            break;
+
+        if (dest != nullptr && change.sampleNumber >= firstSample)
+        {
+            ChangeType c;
+            c.sampleIndex = (int) (change.sampleNumber - numSamplesRead);
+            c.*valueMember = (ValueType) change.value;
+            dest->add (c);
+        }
+
+        ++numRead;
+    }
+
+    fifo.finishedRead (numRead);
+}
+
+
+int DataBuffer::readSamples (AudioSampleBuffer& data, int maxSize, int dstStartChannel, int numChannels,
+                             int& startIndex1, int& blockSize1, int& startIndex2, int& blockSize2)
 {
     // check to see if the maximum size is smaller than the total number of available ints
 
@@ -121,7 +261,6 @@ int DataBuffer::readAllFromBuffer (AudioSampleBuffer& data, uint64* timestamp, u
     //int numItems = (maxSize < abstractFifo.getNumReady()) ?
     //               maxSize : abstractFifo.getNumReady();
 
-    int startIndex1, blockSize1, startIndex2, blockSize2;
     abstractFifo.prepareToRead (numItems, startIndex1, blockSize1, startIndex2, blockSize2);
 
 	int channelsToCopy = numChannels < 0 ? data.getNumChannels() : numChannels;
@@ -137,13 +276,6 @@ int DataBuffer::readAllFromBuffer (AudioSampleBuffer& data, uint64* timestamp, u
                            startIndex1,     // sourceStartSample
                            blockSize1);     // numSamples
         }
-
-        memcpy (timestamp, timestampBuffer + startIndex1, 8);
-        memcpy (eventCodes, eventCodeBuffer + startIndex1, blockSize1 * 8);
-    }
-    else
-    {
-		memcpy(timestamp, &lastTimestamp, 8);
     }
 
     if (blockSize2 > 0)
@@ -157,9 +289,64 @@ int DataBuffer::readAllFromBuffer (AudioSampleBuffer& data, uint64* timestamp, u
                            startIndex2,     // sourceStartSample
                            blockSize2);     // numSamples
         }
+    }
+
+    return numItems;
+}
+
+
+int DataBuffer::readAllFromBuffer (AudioSampleBuffer& data, uint64* timestamp, uint64* eventCodes, int maxSize, int dstStartChannel, int numChannels)
+{
+    int startIndex1, blockSize1, startIndex2, blockSize2;
+    const int numItems = readSamples (data, maxSize, dstStartChannel, numChannels, startIndex1, blockSize1, startIndex2, blockSize2);
+
+    if (blockSize1 > 0)
+    {
+        memcpy (timestamp, timestampBuffer + startIndex1, 8);
+        memcpy (eventCodes, eventCodeBuffer + startIndex1, blockSize1 * 8);
+    }
+    else
+    {
+		memcpy(timestamp, &lastTimestamp, 8);
+    }
+
+    if (blockSize2 > 0)
+    {
         memcpy (eventCodes + blockSize1, eventCodeBuffer + startIndex2, blockSize2 * 8);
     }
 
+    // the changes aren't needed, but have to be passed over with their samples
+    const int64 endSample = numSamplesRead + numItems;
+    readChanges<TimestampSegment> (timestampFifo, timestampChangeList, endSample, endSample, nullptr, &TimestampSegment::timestamp);
+    readChanges<EventCodeChange> (eventCodeFifo, eventCodeChangeList, endSample, endSample, nullptr, &EventCodeChange::eventCode);
+    numSamplesRead = endSample;
+
+    abstractFifo.finishedRead (numItems);
+
+    return numItems;
+}
+
+
+int DataBuffer::readAllFromBuffer (AudioSampleBuffer& data, Array<TimestampSegment>& segments, Array<EventCodeChange>& eventCodeChanges,
+                                   int maxSize, int dstStartChannel, int numChannels)
+{
+    int startIndex1, blockSize1, startIndex2, blockSize2;
+    const int numItems = readSamples (data, maxSize, dstStartChannel, numChannels, startIndex1, blockSize1, startIndex2, blockSize2);
+
+    segments.clearQuick();
+    eventCodeChanges.clearQuick();
+
+    TimestampSegment first;
+    first.sampleIndex = 0;
+    first.timestamp = blockSize1 > 0 ? timestampBuffer[startIndex1] : lastTimestamp;
+    segments.add (first);
+
+    // a timestamp change at the first sample read is already in the first segment
+    const int64 endSample = numSamplesRead + numItems;
+    readChanges (timestampFifo, timestampChangeList, numSamplesRead + 1, endSample, &segments, &TimestampSegment::timestamp);
+    readChanges (eventCodeFifo, eventCodeChangeList, numSamplesRead, endSample, &eventCodeChanges, &EventCodeChange::eventCode);
+    numSamplesRead = endSample;
+
     abstractFifo.finishedRead (numItems);
 
     return numItems;
@@ -30,11 +30,29 @@
 /**
     Manages reading and writing data to a circular buffer.
 
+    As samples are written, the buffer also notes where their timestamps stop increasing
+    by one and where their event codes change, so a reader can get these without going
+    through every sample.
+
     See @DataThread
 */
 class PLUGIN_API DataBuffer
 {
 public:
+    /** A run of samples, starting at sampleIndex, whose timestamps count up from timestamp */
+    struct TimestampSegment
+    {
+        int sampleIndex;
+        int64 timestamp;
+    };
+
+    /** The event code of the samples from sampleIndex on */
+    struct EventCodeChange
+    {
+        int sampleIndex;
+        uint64 eventCode;
+    };
+
     DataBuffer (int chans, int size);
     ~DataBuffer();
 
@@ -55,17 +73,66 @@ public:
     */
     int addToBuffer (float* data, int64* timestamps, uint64* eventCodes, int numItems, int chunkSize=1);
 
+    /** Reserves space for up to numItems samples, for sources that convert their data straight
+        into the buffer instead of staging it for addToBuffer().
+
+        The space is split in at most two blocks of the circular buffer, which are filled through
+        getWritePointer(), getTimestampPointer() and getEventCodePointer(). Nothing is visible to
+        the reader until finishedWrite() is called.
+
+        @return The number of samples reserved.
+    */
+    int prepareToWrite (int numItems, int& startIndex1, int& blockSize1, int& startIndex2, int& blockSize2);
+
+    float* getWritePointer (int chan, int index);
+    int64* getTimestampPointer (int index);
+    uint64* getEventCodePointer (int index);
+
+    /** Publishes the first numItems samples of the space reserved by prepareToWrite(). */
+    void finishedWrite (int numItems);
+
     /** Returns the number of samples currently available in the buffer.*/
     int getNumSamples() const;
 
     /** Copies as many samples as possible from the DataBuffer to an AudioSampleBuffer.*/
     int readAllFromBuffer (AudioSampleBuffer& data, uint64* ts, uint64* eventCodes, int maxSize, int dstStartChannel = 0, int numChannels = -1);
 
+    /** Copies as many samples as possible from the DataBuffer to an AudioSampleBuffer, returning
+        the timestamps and event codes as lists of changes rather than per sample.
+
+        @param segments Filled with the timestamp of the first sample, followed by a segment for
+        every sample whose timestamp isn't one more than the previous sample's.
+        @param eventCodeChanges Filled with the samples whose event code differs from the previous
+        sample's. The event code before the first sample ever written is 0.
+    */
+    int readAllFromBuffer (AudioSampleBuffer& data, Array<TimestampSegment>& segments, Array<EventCodeChange>& eventCodeChanges,
+                           int maxSize, int dstStartChannel = 0, int numChannels = -1);
+
     /** Resizes the data buffer */
     void resize (int chans, int size);
 
 
 private:
+    /** A timestamp or event code change, at the sample with the given index since the buffer was cleared */
+    struct Change
+    {
+        int64 sampleNumber;
+        uint64 value;
+    };
+
+    /** Copies numItems samples to data, returning the index of the first one in the buffer */
+    int readSamples (AudioSampleBuffer& data, int numItems, int dstStartChannel, int numChannels, int& startIndex1, int& blockSize1, int& startIndex2, int& blockSize2);
+
+    /** Passes over the changes to the samples before endSample, adding those from firstSample on to dest */
+    template <typename ChangeType, typename ValueType>
+    void readChanges (AbstractFifo& fifo, const Change* changes, int64 firstSample, int64 endSample,
+                      Array<ChangeType>* dest, ValueType ChangeType::* valueMember);
+
+    /** Notes the changes in the numItems samples written from startIndex on */
+    void recordChanges (int startIndex, int numItems);
+
+    void resetChanges (int size);
+
     AbstractFifo abstractFifo;
     AudioSampleBuffer buffer;
 
@@ -75,6 +142,19 @@ private:
 	int64 lastTimestamp;
 
     int numChans;
+    int writeStart;
+
+    // There is at most one change of each kind per sample, so these never hold more
+    // entries than there are samples in the buffer
+    AbstractFifo timestampFifo;
+    HeapBlock<Change> timestampChangeList;
+    AbstractFifo eventCodeFifo;
+    HeapBlock<Change> eventCodeChangeList;
+
+    int64 numSamplesWritten;
+    int64 numSamplesRead;
+    int64 nextTimestamp;
+    uint64 lastEventCode;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DataBuffer);
 };
@@ -220,6 +220,17 @@ void BiquadBase::applyScale(double scale)
     m_b2 *= scale;
 }
 
+void BiquadBase::setInterpolatedStages(const BiquadBase& from, const BiquadBase& to, double t)
+{
+    const double u = 1 - t;
+    m_a0 = u * from.m_a0 + t * to.m_a0;
+    m_a1 = u * from.m_a1 + t * to.m_a1;
+    m_a2 = u * from.m_a2 + t * to.m_a2;
+    m_b0 = u * from.m_b0 + t * to.m_b0;
+    m_b1 = u * from.m_b1 + t * to.m_b1;
+    m_b2 = u * from.m_b2 + t * to.m_b2;
+}
+
 //------------------------------------------------------------------------------
 
 Biquad::Biquad()
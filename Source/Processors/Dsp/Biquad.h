@@ -107,6 +107,15 @@ public:
         }
     }
 
+    // Same interface as Cascade, so that smoothed designs can
+    // interpolate single biquads and cascades alike
+    int getNumStages() const
+    {
+        return 1;
+    }
+
+    void setInterpolatedStages(const BiquadBase& from, const BiquadBase& to, double t);
+
 protected:
     //
     // These are protected so you can't mess with RBJ biquads
@@ -101,6 +101,27 @@ void Cascade::applyScale(double scale)
     m_stageArray->applyScale(scale);
 }
 
+void Cascade::setInterpolatedStages(const Cascade& from, const Cascade& to, double t)
+{
+    assert(from.m_numStages == to.m_numStages);
+    m_numStages = to.m_numStages;
+    assert(m_numStages <= m_maxStages);
+
+    const double u = 1 - t;
+    const Biquad* a = from.m_stageArray;
+    const Biquad* b = to.m_stageArray;
+    Biquad* stage = m_stageArray;
+    for (int i = m_numStages; --i >= 0; ++a, ++b, ++stage)
+    {
+        stage->m_a0 = u * a->m_a0 + t * b->m_a0;
+        stage->m_a1 = u * a->m_a1 + t * b->m_a1;
+        stage->m_a2 = u * a->m_a2 + t * b->m_a2;
+        stage->m_b0 = u * a->m_b0 + t * b->m_b0;
+        stage->m_b1 = u * a->m_b1 + t * b->m_b1;
+        stage->m_b2 = u * a->m_b2 + t * b->m_b2;
+    }
+}
+
 void Cascade::setLayout(const LayoutBase& proto)
 {
     const int numPoles = proto.getNumPoles();
@@ -128,6 +128,14 @@ public:
         }
     }
 
+    // Set the coefficients of each stage to a linear interpolation between
+    // the matching stages of two cascades with the same layout, t being the
+    // position between them (0 = from, 1 = to). Either cascade may be this one.
+    //
+    // The set of stable second order denominators is convex, so if both
+    // cascades are stable every interpolated one is stable too.
+    void setInterpolatedStages(const Cascade& from, const Cascade& to, double t);
+
 protected:
     Cascade();
 
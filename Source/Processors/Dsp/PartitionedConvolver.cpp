@@ -0,0 +1,377 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PartitionedConvolver.h"
+#include <cmath>
+
+#if JUCE_INTEL && ! (JUCE_MINGW && ! defined (__SSE2__))
+ #define CONVOLVER_USE_SSE 1
+ #include <emmintrin.h>
+#elif __ARM_NEON__
+ #define CONVOLVER_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+namespace
+{
+	const int numLanes = PartitionedConvolver::numLanes;
+
+	/** Operations on numLanes floats at once */
+#if CONVOLVER_USE_SSE
+	typedef __m128 Lanes;
+	inline Lanes loadLanes(const float* p) { return _mm_loadu_ps(p); }
+	inline void storeLanes(float* p, Lanes a) { _mm_storeu_ps(p, a); }
+	inline Lanes broadcast(float x) { return _mm_set1_ps(x); }
+	inline Lanes add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+	inline Lanes sub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+	inline Lanes mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+#elif CONVOLVER_USE_NEON
+	typedef float32x4_t Lanes;
+	inline Lanes loadLanes(const float* p) { return vld1q_f32(p); }
+	inline void storeLanes(float* p, Lanes a) { vst1q_f32(p, a); }
+	inline Lanes broadcast(float x) { return vdupq_n_f32(x); }
+	inline Lanes add(Lanes a, Lanes b) { return vaddq_f32(a, b); }
+	inline Lanes sub(Lanes a, Lanes b) { return vsubq_f32(a, b); }
+	inline Lanes mul(Lanes a, Lanes b) { return vmulq_f32(a, b); }
+#else
+	struct Lanes { float v[numLanes]; };
+	inline Lanes loadLanes(const float* p) { Lanes a; for (int i = 0; i < numLanes; i++) a.v[i] = p[i]; return a; }
+	inline void storeLanes(float* p, Lanes a) { for (int i = 0; i < numLanes; i++) p[i] = a.v[i]; }
+	inline Lanes broadcast(float x) { Lanes a; for (int i = 0; i < numLanes; i++) a.v[i] = x; return a; }
+	inline Lanes add(Lanes a, Lanes b) { for (int i = 0; i < numLanes; i++) a.v[i] += b.v[i]; return a; }
+	inline Lanes sub(Lanes a, Lanes b) { for (int i = 0; i < numLanes; i++) a.v[i] -= b.v[i]; return a; }
+	inline Lanes mul(Lanes a, Lanes b) { for (int i = 0; i < numLanes; i++) a.v[i] *= b.v[i]; return a; }
+#endif
+
+	/** acc += x * h, where x and acc hold numLanes interleaved spectra and h a single one */
+	inline void complexMultiplyAdd(float* accRe, float* accIm,
+		const float* xRe, const float* xIm, const float* hRe, const float* hIm, int numBins)
+	{
+		for (int i = 0; i < numBins; i++)
+		{
+			const int j = i * numLanes;
+			Lanes br = broadcast(hRe[i]);
+			Lanes bi = broadcast(hIm[i]);
+			Lanes ar = loadLanes(xRe + j);
+			Lanes ai = loadLanes(xIm + j);
+			storeLanes(accRe + j, add(loadLanes(accRe + j), sub(mul(ar, br), mul(ai, bi))));
+			storeLanes(accIm + j, add(loadLanes(accIm + j), add(mul(ar, bi), mul(ai, br))));
+		}
+	}
+}
+
+PartitionedConvolver::Kernel::Kernel(const float* impulseResponse, int length, int partitionSize)
+	: sampleRate(0), lowCut(0), highCut(0),
+	m_length(length),
+	m_partitionSize(partitionSize),
+	m_numPartitions((length + partitionSize - 1) / partitionSize)
+{
+	jassert(isPowerOfTwo(partitionSize) && partitionSize >= 4);
+
+	const int fftSize = 2 * m_partitionSize;
+
+	int bits = 0;
+	while ((1 << bits) < fftSize)
+		bits++;
+
+	m_bitReversed.malloc(fftSize);
+	for (int i = 0; i < fftSize; i++)
+	{
+		int r = 0;
+		for (int b = 0; b < bits; b++)
+			r |= ((i >> b) & 1) << (bits - 1 - b);
+		m_bitReversed[i] = r;
+	}
+
+	m_twiddleRe.malloc(fftSize / 2);
+	m_twiddleIm.malloc(fftSize / 2);
+	for (int k = 0; k < fftSize / 2; k++)
+	{
+		m_twiddleRe[k] = float(std::cos(2 * double_Pi * k / fftSize));
+		m_twiddleIm[k] = float(-std::sin(2 * double_Pi * k / fftSize));
+	}
+
+	m_spectraRe.allocate(m_numPartitions * fftSize, true);
+	m_spectraIm.allocate(m_numPartitions * fftSize, true);
+
+	HeapBlock<float> blockRe(fftSize * numLanes, true);
+	HeapBlock<float> blockIm(fftSize * numLanes, true);
+	HeapBlock<float> spectrumRe(fftSize * numLanes);
+	HeapBlock<float> spectrumIm(fftSize * numLanes);
+
+	//the inverse transform isn't normalized, so the scale goes here
+	const float scale = 1.0f / fftSize;
+
+	for (int p = 0; p < m_numPartitions; p++)
+	{
+		for (int i = 0; i < m_partitionSize; i++)
+		{
+			int tap = p * m_partitionSize + i;
+			blockRe[i * numLanes] = (tap < m_length) ? impulseResponse[tap] * scale : 0;
+		}
+
+		performTransform(blockRe, blockIm, spectrumRe, spectrumIm, false);
+
+		float* re = m_spectraRe + p * fftSize;
+		float* im = m_spectraIm + p * fftSize;
+		for (int i = 0; i < fftSize; i++)
+		{
+			re[i] = spectrumRe[i * numLanes];
+			im[i] = spectrumIm[i * numLanes];
+		}
+	}
+}
+
+void PartitionedConvolver::Kernel::performTransform(const float* sourceRe, const float* sourceIm, float* destRe, float* destIm, bool inverse) const
+{
+	const int fftSize = 2 * m_partitionSize;
+
+	for (int i = 0; i < fftSize; i++)
+	{
+		const int j = m_bitReversed[i] * numLanes;
+		storeLanes(destRe + j, loadLanes(sourceRe + i * numLanes));
+		storeLanes(destIm + j, loadLanes(sourceIm + i * numLanes));
+	}
+
+	//iterative radix-2 decimation in time, the inverse uses the conjugate twiddles
+	const float sign = inverse ? -1.0f : 1.0f;
+
+	for (int half = 1; half < fftSize; half *= 2)
+	{
+		const int twiddleStep = fftSize / (2 * half);
+
+		for (int k = 0; k < half; k++)
+		{
+			Lanes wr = broadcast(m_twiddleRe[k * twiddleStep]);
+			Lanes wi = broadcast(sign * m_twiddleIm[k * twiddleStep]);
+
+			for (int a = k; a < fftSize; a += 2 * half)
+			{
+				float* aRe = destRe + a * numLanes;
+				float* aIm = destIm + a * numLanes;
+				float* bRe = aRe + half * numLanes;
+				float* bIm = aIm + half * numLanes;
+
+				Lanes xr = loadLanes(bRe);
+				Lanes xi = loadLanes(bIm);
+				Lanes tr = sub(mul(xr, wr), mul(xi, wi));
+				Lanes ti = add(mul(xr, wi), mul(xi, wr));
+				Lanes yr = loadLanes(aRe);
+				Lanes yi = loadLanes(aIm);
+
+				storeLanes(aRe, add(yr, tr));
+				storeLanes(aIm, add(yi, ti));
+				storeLanes(bRe, sub(yr, tr));
+				storeLanes(bIm, sub(yi, ti));
+			}
+		}
+	}
+}
+
+PartitionedConvolver::PartitionedConvolver()
+	: m_partitionSize(0), m_fftSize(0), m_numPartitions(0), m_historyIndex(0), m_blockPosition(0)
+{
+}
+
+PartitionedConvolver::~PartitionedConvolver()
+{
+}
+
+int PartitionedConvolver::getBandPassKernelLength(double sampleRate, double lowCut)
+{
+	//the transition band of a Blackman window is about 5.5 / length of the sample rate wide,
+	//so make it as wide as the low cut
+	int length = int(std::ceil(5.5 * sampleRate / jmax(lowCut, 0.01)));
+	length = jlimit(31, maxKernelLength, length);
+	return length | 1;
+}
+
+PartitionedConvolver::KernelPtr PartitionedConvolver::getBandPassKernel(double sampleRate, double lowCut, double highCut, int partitionSize)
+{
+	static CriticalSection cacheLock;
+	static ReferenceCountedArray<Kernel> cache;
+
+	const ScopedLock lock(cacheLock);
+	for (int i = cache.size(); --i >= 0;)
+	{
+		Kernel* kernel = cache.getUnchecked(i);
+		if (kernel->sampleRate == sampleRate && kernel->lowCut == lowCut && kernel->highCut == highCut
+			&& kernel->getPartitionSize() == partitionSize)
+			return kernel;
+
+		//forget the kernels no filter is using anymore
+		if (kernel->getReferenceCount() == 1)
+			cache.remove(i);
+	}
+
+	const int length = getBandPassKernelLength(sampleRate, lowCut);
+	const double center = (length - 1) / 2.0;
+	const double low = lowCut / sampleRate;
+	const double high = jmin(highCut / sampleRate, 0.5);
+
+	HeapBlock<float> taps(length);
+	double responseRe = 0;
+	double responseIm = 0;
+	const double normalW = 2 * double_Pi * (high < 0.5 ? (low + high) / 2 : 0.5);
+
+	for (int n = 0; n < length; n++)
+	{
+		double x = n - center;
+		double h;
+		if (x == 0)
+			h = 2 * (high - low);
+		else
+			h = (std::sin(2 * double_Pi * high * x) - std::sin(2 * double_Pi * low * x)) / (double_Pi * x);
+
+		double window = 0.42 - 0.5 * std::cos(2 * double_Pi * n / (length - 1)) + 0.08 * std::cos(4 * double_Pi * n / (length - 1));
+		h *= window;
+		taps[n] = float(h);
+
+		responseRe += h * std::cos(normalW * n);
+		responseIm -= h * std::sin(normalW * n);
+	}
+
+	//unity gain at the center of the pass band
+	const double gain = std::sqrt(responseRe * responseRe + responseIm * responseIm);
+	if (gain > 0)
+		FloatVectorOperations::multiply(taps, float(1.0 / gain), length);
+
+	Kernel* kernel = new Kernel(taps, length, partitionSize);
+	kernel->sampleRate = sampleRate;
+	kernel->lowCut = lowCut;
+	kernel->highCut = highCut;
+	cache.add(kernel);
+	return kernel;
+}
+
+void PartitionedConvolver::prepare(Kernel* kernel)
+{
+	m_kernel = kernel;
+	m_partitionSize = kernel->getPartitionSize();
+	m_fftSize = 2 * m_partitionSize;
+	m_numPartitions = kernel->getNumPartitions();
+
+	const int laneSize = m_fftSize * numLanes;
+
+	m_inputRe.allocate(laneSize, true);
+	m_inputIm.allocate(laneSize, true);
+	m_outputRe.allocate(laneSize, true);
+	m_outputIm.allocate(laneSize, true);
+
+	m_historyRe.allocate(m_numPartitions * laneSize, true);
+	m_historyIm.allocate(m_numPartitions * laneSize, true);
+	m_accumulatorRe.allocate(laneSize, true);
+	m_accumulatorIm.allocate(laneSize, true);
+
+	reset();
+}
+
+void PartitionedConvolver::reset()
+{
+	if (m_kernel == nullptr)
+		return;
+
+	const int laneSize = m_fftSize * numLanes;
+
+	FloatVectorOperations::clear(m_inputRe, laneSize);
+	FloatVectorOperations::clear(m_inputIm, laneSize);
+	FloatVectorOperations::clear(m_outputRe, laneSize);
+	FloatVectorOperations::clear(m_outputIm, laneSize);
+	FloatVectorOperations::clear(m_historyRe, m_numPartitions * laneSize);
+	FloatVectorOperations::clear(m_historyIm, m_numPartitions * laneSize);
+	m_historyIndex = 0;
+	m_blockPosition = 0;
+}
+
+int PartitionedConvolver::getLatency() const
+{
+	if (m_kernel == nullptr)
+		return 0;
+
+	return m_partitionSize + (m_kernel->getLength() - 1) / 2;
+}
+
+void PartitionedConvolver::process(float* const* channels, int numChannels, int numSamples)
+{
+	jassert(m_kernel != nullptr);
+	jassert(numChannels <= maxChannels);
+
+	int offset = 0;
+
+	while (offset < numSamples)
+	{
+		const int n = jmin(numSamples - offset, m_partitionSize - m_blockPosition);
+		const int first = (m_partitionSize + m_blockPosition) * numLanes;
+
+		//take the new samples and hand out the ones computed for the previous block.
+		//Even channels are the real part of a lane, odd ones the imaginary part
+		for (int c = 0; c < numChannels; c++)
+		{
+			float* data = channels[c] + offset;
+			float* in = ((c & 1) ? m_inputIm : m_inputRe) + first + c / 2;
+			const float* out = ((c & 1) ? m_outputIm : m_outputRe) + first + c / 2;
+
+			for (int i = 0; i < n; i++)
+			{
+				in[i * numLanes] = data[i];
+				data[i] = out[i * numLanes];
+			}
+		}
+
+		offset += n;
+		m_blockPosition += n;
+
+		if (m_blockPosition == m_partitionSize)
+		{
+			processPartition();
+			m_blockPosition = 0;
+		}
+	}
+}
+
+void PartitionedConvolver::processPartition()
+{
+	const int laneSize = m_fftSize * numLanes;
+
+	m_historyIndex = (m_historyIndex + m_numPartitions - 1) % m_numPartitions;
+	m_kernel->performTransform(m_inputRe, m_inputIm,
+		m_historyRe + m_historyIndex * laneSize, m_historyIm + m_historyIndex * laneSize, false);
+
+	FloatVectorOperations::clear(m_accumulatorRe, laneSize);
+	FloatVectorOperations::clear(m_accumulatorIm, laneSize);
+
+	for (int p = 0; p < m_numPartitions; p++)
+	{
+		const int slot = (m_historyIndex + p) % m_numPartitions;
+		complexMultiplyAdd(m_accumulatorRe, m_accumulatorIm,
+			m_historyRe + slot * laneSize, m_historyIm + slot * laneSize,
+			m_kernel->getPartitionRe(p), m_kernel->getPartitionIm(p), m_fftSize);
+	}
+
+	//overlap-save: the second half of the circular convolution is the new output block
+	m_kernel->performTransform(m_accumulatorRe, m_accumulatorIm, m_outputRe, m_outputIm, true);
+
+	const int halfSize = m_partitionSize * numLanes;
+	FloatVectorOperations::copy(m_inputRe, m_inputRe + halfSize, halfSize);
+	FloatVectorOperations::copy(m_inputIm, m_inputIm + halfSize, halfSize);
+}
@@ -0,0 +1,163 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PARTITIONEDCONVOLVER_H_INCLUDED
+#define PARTITIONEDCONVOLVER_H_INCLUDED
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+#include "../PluginManager/OpenEphysPlugin.h"
+
+/**
+	Uniformly partitioned FFT convolution with a linear-phase FIR kernel.
+
+	The kernel is split into partitions of partitionSize samples whose spectra are
+	computed once and shared by every convolver using the same kernel. Every time
+	partitionSize input samples have been collected, the newest input block is
+	transformed and the output block is computed in the frequency domain from the
+	spectra of the last input blocks (overlap-save), so the cost per sample grows much
+	more slowly with the kernel length than direct convolution does.
+
+	A convolver filters up to maxChannels channels with the same kernel. Since the
+	kernel is real, channels are transformed in pairs as the real and imaginary parts
+	of one complex signal, and four pairs are transformed at once in the lanes of the
+	vector registers.
+
+	Output is delayed by partitionSize samples, plus the (length - 1) / 2 samples of
+	group delay of the linear-phase kernel.
+
+	prepare() allocates all the needed memory. process() does not allocate and can be
+	called from the processing thread.
+*/
+class PLUGIN_API PartitionedConvolver
+{
+public:
+	class Kernel;
+	typedef ReferenceCountedObjectPtr<Kernel> KernelPtr;
+
+	PartitionedConvolver();
+	~PartitionedConvolver();
+
+	/** Returns a windowed-sinc band-pass kernel partitioned in blocks of partitionSize samples,
+	which must be a power of two. A high cut at or above the Nyquist frequency makes it a
+	high-pass. Kernels with the same settings are shared. */
+	static KernelPtr getBandPassKernel(double sampleRate, double lowCut, double highCut, int partitionSize);
+
+	/** Returns the length of the band-pass kernels for a low cut frequency. The transition
+	band gets wider than the low cut only when the length reaches maxKernelLength. */
+	static int getBandPassKernelLength(double sampleRate, double lowCut);
+
+	/** Sets the kernel, allocates the buffers and clears the state */
+	void prepare(Kernel* kernel);
+
+	/** Clears the buffered samples */
+	void reset();
+
+	/** Filters up to maxChannels channels in place. The number of channels must not change
+	between calls without a reset(). */
+	void process(float* const* channels, int numChannels, int numSamples);
+
+	Kernel* getKernel() const { return m_kernel; }
+
+	/** Returns the delay, in samples, between the input and the output of the convolver */
+	int getLatency() const;
+
+	static const int maxChannels = 8;
+	static const int maxKernelLength = 8191;
+
+	/** Number of complex transforms computed together */
+	static const int numLanes = maxChannels / 2;
+
+private:
+	void processPartition();
+
+	KernelPtr m_kernel;
+
+	int m_partitionSize;
+	int m_fftSize;
+	int m_numPartitions;
+
+	/** All the buffers below hold numLanes interleaved complex signals, stored as separate
+	real and imaginary arrays: element [i * numLanes + lane] is sample or bin i of a lane. */
+
+	/** Last two input blocks */
+	HeapBlock<float> m_inputRe;
+	HeapBlock<float> m_inputIm;
+	/** Output of the last inverse transform. Its second half is the current output block. */
+	HeapBlock<float> m_outputRe;
+	HeapBlock<float> m_outputIm;
+
+	/** Frequency-domain delay line: spectra of the last m_numPartitions input blocks, newest
+	at m_historyIndex */
+	HeapBlock<float> m_historyRe;
+	HeapBlock<float> m_historyIm;
+	HeapBlock<float> m_accumulatorRe;
+	HeapBlock<float> m_accumulatorIm;
+	int m_historyIndex;
+
+	/** Samples of the current block collected so far */
+	int m_blockPosition;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartitionedConvolver);
+};
+
+/**
+	Spectra of the partitions of an FIR kernel, and the transform used to apply it.
+*/
+class PLUGIN_API PartitionedConvolver::Kernel : public ReferenceCountedObject
+{
+public:
+	Kernel(const float* impulseResponse, int length, int partitionSize);
+
+	int getLength() const { return m_length; }
+	int getPartitionSize() const { return m_partitionSize; }
+	int getNumPartitions() const { return m_numPartitions; }
+
+	/** Spectrum of a partition, already scaled for the inverse transform */
+	const float* getPartitionRe(int partition) const { return m_spectraRe + partition * 2 * m_partitionSize; }
+	const float* getPartitionIm(int partition) const { return m_spectraIm + partition * 2 * m_partitionSize; }
+
+	/** Computes the unnormalized transforms of numLanes interleaved signals of 2 * partitionSize
+	points. Source and destination must not overlap. */
+	void performTransform(const float* sourceRe, const float* sourceIm, float* destRe, float* destIm, bool inverse) const;
+
+	/** Settings of the band-pass kernels, used to share them */
+	double sampleRate;
+	double lowCut;
+	double highCut;
+
+private:
+	const int m_length;
+	const int m_partitionSize;
+	const int m_numPartitions;
+
+	HeapBlock<int> m_bitReversed;
+	HeapBlock<float> m_twiddleRe;
+	HeapBlock<float> m_twiddleIm;
+
+	HeapBlock<float> m_spectraRe;
+	HeapBlock<float> m_spectraIm;
+
+	JUCE_DECLARE_NON_COPYABLE(Kernel);
+};
+
+#endif  // PARTITIONEDCONVOLVER_H_INCLUDED
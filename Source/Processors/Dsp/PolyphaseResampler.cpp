@@ -0,0 +1,374 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PolyphaseResampler.h"
+#include <cmath>
+
+#if JUCE_INTEL && ! (JUCE_MINGW && ! defined (__SSE2__))
+ #define RESAMPLER_USE_SSE 1
+ #include <emmintrin.h>
+#elif __ARM_NEON__
+ #define RESAMPLER_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+/** Filter bank of numPhases+1 rows of numTaps coefficients. The extra row allows
+interpolating between adjacent phases without wrapping. */
+class PolyphaseResampler::CoefficientTable : public ReferenceCountedObject
+{
+public:
+	CoefficientTable(int phases, int taps, double cutoffFrequency)
+		: numPhases(phases), numTaps(taps), cutoff(cutoffFrequency)
+	{
+		const double halfTaps = numTaps / 2.0;
+		coefficients.allocate((numPhases + 1) * numTaps, true);
+
+		for (int p = 0; p <= numPhases; p++)
+		{
+			float* row = getRow(p);
+			double phase = double(p) / numPhases;
+			double sum = 0;
+
+			for (int j = 0; j < numTaps; j++)
+			{
+				//distance, in input samples, between tap j and the interpolated position
+				double x = j - (halfTaps - 1) - phase;
+				double sinc = (x == 0) ? 1.0 : std::sin(2 * double_Pi * cutoff * x) / (2 * double_Pi * cutoff * x);
+				double window = 0.42 + 0.5 * std::cos(double_Pi * x / halfTaps) + 0.08 * std::cos(2 * double_Pi * x / halfTaps);
+				double h = sinc * window;
+				row[j] = float(h);
+				sum += h;
+			}
+			//unity gain at DC for every phase
+			FloatVectorOperations::multiply(row, float(1.0 / sum), numTaps);
+		}
+	}
+
+	float* getRow(int phase) const { return coefficients + phase * numTaps; }
+
+	typedef ReferenceCountedObjectPtr<CoefficientTable> Ptr;
+
+	const int numPhases;
+	const int numTaps;
+	const double cutoff;
+
+private:
+	HeapBlock<float> coefficients;
+};
+
+namespace
+{
+	/** Taps are a multiple of 4, so the inner products don't need a scalar tail */
+	inline float dotProduct(const float* a, const float* b, int numTaps)
+	{
+#if RESAMPLER_USE_SSE
+		__m128 acc0 = _mm_setzero_ps();
+		__m128 acc1 = _mm_setzero_ps();
+		int j = 0;
+		for (; j + 8 <= numTaps; j += 8)
+		{
+			acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + j), _mm_loadu_ps(b + j)));
+			acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + j + 4), _mm_loadu_ps(b + j + 4)));
+		}
+		if (j < numTaps)
+			acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + j), _mm_loadu_ps(b + j)));
+		acc0 = _mm_add_ps(acc0, acc1);
+		acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+		acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+		return _mm_cvtss_f32(acc0);
+#elif RESAMPLER_USE_NEON
+		float32x4_t acc = vdupq_n_f32(0);
+		for (int j = 0; j < numTaps; j += 4)
+			acc = vmlaq_f32(acc, vld1q_f32(a + j), vld1q_f32(b + j));
+		float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+		return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#else
+		float acc = 0;
+		for (int j = 0; j < numTaps; j++)
+			acc += a[j] * b[j];
+		return acc;
+#endif
+	}
+
+	int64 greatestCommonDivisor(int64 a, int64 b)
+	{
+		while (b != 0)
+		{
+			int64 t = a % b;
+			a = b;
+			b = t;
+		}
+		return a;
+	}
+
+	/** Returns L and M such that destRate/sourceRate = L/M, or false if the rates are not integers */
+	bool getRationalRatio(double sourceSampleRate, double destSampleRate, int64& up, int64& down)
+	{
+		int64 source = int64(sourceSampleRate + 0.5);
+		int64 dest = int64(destSampleRate + 0.5);
+		if (source <= 0 || dest <= 0 || std::abs(source - sourceSampleRate) > 1e-6 || std::abs(dest - destSampleRate) > 1e-6)
+			return false;
+
+		int64 gcd = greatestCommonDivisor(source, dest);
+		up = dest / gcd;
+		down = source / gcd;
+		return true;
+	}
+
+	/** Taps of the filter. When downsampling the filter must be stretched to the output band,
+	so it needs proportionally more taps */
+	int getNumTaps(double step)
+	{
+		int halfTaps = jmin(roundToInt(8 * jmax(1.0, step)), 128);
+		return (halfTaps + 1) & ~1; //2*halfTaps is a multiple of 4
+	}
+
+	/** Cutoff in cycles per input sample, with some margin below Nyquist for the transition band */
+	double getCutoff(double step)
+	{
+		return 0.45 / jmax(1.0, step);
+	}
+}
+
+PolyphaseResampler::PolyphaseResampler()
+	: m_step(1), m_numChannels(0), m_numTaps(0), m_upFactor(1), m_downFactor(0),
+	m_capacity(0), m_writeIndex(0), m_readIndex(0), m_phaseIndex(0), m_phase(0)
+{
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+}
+
+PolyphaseResampler::CoefficientTable::Ptr PolyphaseResampler::getTable(int numPhases, int numTaps, double cutoff)
+{
+	static CriticalSection cacheLock;
+	static ReferenceCountedArray<CoefficientTable> cache;
+
+	const ScopedLock lock(cacheLock);
+	for (int i = 0; i < cache.size(); i++)
+	{
+		CoefficientTable* table = cache.getUnchecked(i);
+		if (table->numPhases == numPhases && table->numTaps == numTaps && table->cutoff == cutoff)
+			return table;
+	}
+
+	CoefficientTable* table = new CoefficientTable(numPhases, numTaps, cutoff);
+	cache.add(table);
+	return table;
+}
+
+void PolyphaseResampler::precomputeCommonTables()
+{
+	static const double sourceRates[] = { 25000.0, 30000.0 };
+	static const double destRates[] = { 44100.0, 48000.0 };
+
+	for (double sourceRate : sourceRates)
+	{
+		for (double destRate : destRates)
+		{
+			int64 up, down;
+			getRationalRatio(sourceRate, destRate, up, down);
+			double step = sourceRate / destRate;
+			if (up <= maxRationalPhases)
+				getTable(int(up), 2 * getNumTaps(step), getCutoff(step));
+		}
+	}
+}
+
+void PolyphaseResampler::prepare(double sourceSampleRate, double destSampleRate, int numChannels, int maxInputSamples)
+{
+	jassert(sourceSampleRate > 0 && destSampleRate > 0);
+
+	m_step = sourceSampleRate / destSampleRate;
+	m_numChannels = jmax(numChannels, 1);
+	m_numTaps = 2 * getNumTaps(m_step);
+
+	int64 up, down;
+	if (getRationalRatio(sourceSampleRate, destSampleRate, up, down) && up <= maxRationalPhases)
+	{
+		m_upFactor = int(up);
+		m_downFactor = int(down);
+		m_table = getTable(m_upFactor, m_numTaps, getCutoff(m_step));
+	}
+	else
+	{
+		m_upFactor = numInterpolatedPhases;
+		m_downFactor = 0;
+		m_table = getTable(numInterpolatedPhases, m_numTaps, getCutoff(m_step));
+	}
+
+	m_capacity = maxInputSamples + 2 * m_numTaps;
+	m_ringBuffer.setSize(m_numChannels, 2 * m_capacity);
+
+	reset();
+}
+
+void PolyphaseResampler::reset()
+{
+	m_ringBuffer.clear();
+	m_readIndex = 0;
+	m_phaseIndex = 0;
+	m_phase = 0;
+	//Start with half a window of silence so the first output is centered on the first input sample
+	m_writeIndex = m_numTaps / 2 - 1;
+}
+
+void PolyphaseResampler::discardInput(int numSamples)
+{
+	m_readIndex += numSamples;
+}
+
+void PolyphaseResampler::pushSamples(int channel, const float* source, int numSamples, float gain)
+{
+	jassert(channel >= 0 && channel < m_numChannels);
+
+	//Only the last samples fit in the buffer
+	if (numSamples > m_capacity)
+	{
+		source += numSamples - m_capacity;
+		numSamples = m_capacity;
+	}
+
+	int pos = int(m_writeIndex % m_capacity);
+	int firstPart = jmin(numSamples, m_capacity - pos);
+	float* ring = m_ringBuffer.getWritePointer(channel);
+
+	FloatVectorOperations::copyWithMultiply(ring + pos, source, gain, firstPart);
+	FloatVectorOperations::copyWithMultiply(ring + pos + m_capacity, source, gain, firstPart);
+	if (numSamples > firstPart)
+	{
+		FloatVectorOperations::copyWithMultiply(ring, source + firstPart, gain, numSamples - firstPart);
+		FloatVectorOperations::copyWithMultiply(ring + m_capacity, source + firstPart, gain, numSamples - firstPart);
+	}
+
+	//All channels share the indexes, so they advance once the last channel has been written
+	if (channel == m_numChannels - 1)
+	{
+		m_writeIndex += numSamples;
+		int64 overflow = (m_writeIndex - m_readIndex) - m_capacity;
+		if (overflow > 0)
+			discardInput(int(overflow));
+	}
+}
+
+void PolyphaseResampler::addToLastSamples(int channel, const float* source, int numSamples, float gain)
+{
+	jassert(channel >= 0 && channel < m_numChannels);
+
+	if (numSamples > m_capacity)
+	{
+		source += numSamples - m_capacity;
+		numSamples = m_capacity;
+	}
+
+	//if this is the last channel the write index has already advanced
+	int64 start = m_writeIndex - ((channel == m_numChannels - 1) ? numSamples : 0);
+	int pos = int(start % m_capacity);
+	int firstPart = jmin(numSamples, m_capacity - pos);
+	float* ring = m_ringBuffer.getWritePointer(channel);
+
+	FloatVectorOperations::addWithMultiply(ring + pos, source, gain, firstPart);
+	FloatVectorOperations::addWithMultiply(ring + pos + m_capacity, source, gain, firstPart);
+	if (numSamples > firstPart)
+	{
+		FloatVectorOperations::addWithMultiply(ring, source + firstPart, gain, numSamples - firstPart);
+		FloatVectorOperations::addWithMultiply(ring + m_capacity, source + firstPart, gain, numSamples - firstPart);
+	}
+}
+
+int PolyphaseResampler::getNumOutputSamplesAvailable() const
+{
+	//how far the window start can advance while still having a full window of input
+	int64 margin = m_writeIndex - m_readIndex - m_numTaps;
+	if (margin < 0)
+		return 0;
+
+	if (isRational())
+	{
+		//outputs k with floor((phaseIndex + k*M) / L) <= margin
+		int64 limit = (margin + 1) * m_upFactor - m_phaseIndex;
+		return int((limit + m_downFactor - 1) / m_downFactor);
+	}
+
+	return int(std::floor((margin - m_phase) / m_step)) + 1;
+}
+
+int PolyphaseResampler::process(float* const* dest, int numSamples)
+{
+	if (m_table == nullptr)
+		return 0;
+
+	const int numOutput = jmin(numSamples, getNumOutputSamplesAvailable());
+	const int numTaps = m_numTaps;
+	int64 readIndex = m_readIndex;
+
+	if (isRational())
+	{
+		//exact phase: one filter per output position, no interpolation needed
+		int phaseIndex = m_phaseIndex;
+		for (int i = 0; i < numOutput; i++)
+		{
+			const float* coef = m_table->getRow(phaseIndex);
+			int pos = int(readIndex % m_capacity);
+
+			for (int c = 0; c < m_numChannels; c++)
+				dest[c][i] += dotProduct(coef, m_ringBuffer.getReadPointer(c, pos), numTaps);
+
+			phaseIndex += m_downFactor;
+			readIndex += phaseIndex / m_upFactor;
+			phaseIndex %= m_upFactor;
+		}
+		m_phaseIndex = phaseIndex;
+	}
+	else
+	{
+		double phase = m_phase;
+		for (int i = 0; i < numOutput; i++)
+		{
+			double phasePosition = phase * numInterpolatedPhases;
+			int p = int(phasePosition);
+			float alpha = float(phasePosition - p);
+			const float* coefA = m_table->getRow(p);
+			const float* coefB = coefA + numTaps;
+			int pos = int(readIndex % m_capacity);
+
+			for (int c = 0; c < m_numChannels; c++)
+			{
+				const float* window = m_ringBuffer.getReadPointer(c, pos);
+				float a = dotProduct(coefA, window, numTaps);
+				float b = dotProduct(coefB, window, numTaps);
+				dest[c][i] += a + alpha * (b - a);
+			}
+
+			phase += m_step;
+			int advance = int(phase);
+			readIndex += advance;
+			phase -= advance;
+		}
+		m_phase = phase;
+	}
+
+	m_readIndex = readIndex;
+	return numOutput;
+}
@@ -0,0 +1,129 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef POLYPHASERESAMPLER_H_INCLUDED
+#define POLYPHASERESAMPLER_H_INCLUDED
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+#include "../PluginManager/OpenEphysPlugin.h"
+
+/**
+	Windowed-sinc polyphase resampler for one or more channels sharing the same sample rate.
+
+	Input samples are pushed into a per-channel ring buffer, and output samples are
+	computed from it with a bank of precomputed FIR phases, so the anti-aliasing filter
+	is part of the interpolation. All channels advance with the same phase, so they must
+	be pushed the same number of samples.
+
+	When both rates are integers with a small enough ratio (e.g. 30 kHz to 44.1 kHz is
+	147/100) the filter bank has one phase per output position and the phase is tracked
+	as an exact fraction, so no error accumulates across blocks. Other ratios interpolate
+	between the phases of a fixed-size bank.
+
+	Coefficient tables are shared between all resamplers using the same ratio, and the
+	ones for common acquisition-to-audio ratios are built only once.
+
+	prepare() allocates all the needed memory. pushSamples() and process() do not
+	allocate and can be called from the audio thread.
+*/
+class PLUGIN_API PolyphaseResampler
+{
+public:
+	PolyphaseResampler();
+	~PolyphaseResampler();
+
+	/** Configures the resampler and allocates the buffers. maxInputSamples is the largest
+	amount of input samples that can be buffered before the oldest ones are dropped. */
+	void prepare(double sourceSampleRate, double destSampleRate, int numChannels, int maxInputSamples);
+
+	/** Clears the buffered samples and resets the phase */
+	void reset();
+
+	/** Copies samples into the ring buffer of a channel, applying a gain. If the buffer is
+	full, the oldest samples are dropped. */
+	void pushSamples(int channel, const float* source, int numSamples, float gain = 1.0f);
+
+	/** Adds samples to the last numSamples samples pushed to a channel, applying a gain.
+	Used to mix several sources into the same stream before resampling. */
+	void addToLastSamples(int channel, const float* source, int numSamples, float gain = 1.0f);
+
+	/** Returns the number of output samples that can be computed from the buffered input */
+	int getNumOutputSamplesAvailable() const;
+
+	/** Computes up to numSamples output samples for every channel, adding them to dest.
+	Returns the number of samples actually produced. */
+	int process(float* const* dest, int numSamples);
+
+	/** Returns the number of input samples per output sample */
+	double getRatio() const { return m_step; }
+
+	/** Returns true if the phase is tracked as an exact fraction */
+	bool isRational() const { return m_downFactor > 0; }
+
+	int getNumChannels() const { return m_numChannels; }
+
+	/** Builds the coefficient tables for the usual acquisition and sound card rates,
+	so preparing a resampler for them doesn't need to design a filter */
+	static void precomputeCommonTables();
+
+private:
+	class CoefficientTable;
+
+	/** Number of phases of the bank used for ratios that are not rational */
+	static const int numInterpolatedPhases = 64;
+
+	/** Largest number of phases of a rational filter bank */
+	static const int maxRationalPhases = 512;
+
+	static ReferenceCountedObjectPtr<CoefficientTable> getTable(int numPhases, int numTaps, double cutoff);
+
+	void discardInput(int numSamples);
+
+	double m_step;
+	int m_numChannels;
+	int m_numTaps;
+
+	/** Interpolation factor L and decimation factor M, so destRate/sourceRate = L/M.
+	m_downFactor is 0 when the ratio is not rational */
+	int m_upFactor;
+	int m_downFactor;
+
+	ReferenceCountedObjectPtr<CoefficientTable> m_table;
+
+	/** Mirrored ring buffers: every sample is written twice, capacity samples apart, so
+	any window of up to capacity samples can be read contiguously. */
+	AudioSampleBuffer m_ringBuffer;
+	int m_capacity;
+
+	int64 m_writeIndex;
+	int64 m_readIndex;
+
+	/** Position between m_readIndex and the next sample, in units of 1/m_upFactor for rational ratios */
+	int m_phaseIndex;
+	/** Same as above, as a fraction of a sample, for the rest */
+	double m_phase;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PolyphaseResampler);
+};
+
+#endif  // POLYPHASERESAMPLER_H_INCLUDED
@@ -47,6 +47,12 @@ namespace Dsp
 /*
  * Implements smooth modulation of time-varying filter parameters
  *
+ * The filter is only designed when the parameters change. During a
+ * transition the coefficients of each stage are interpolated between
+ * those in use when the change happened and the ones of the new design,
+ * and updated every coefficientUpdateInterval samples, so the cost of a
+ * transition is close to the cost of plain filtering.
+ *
  */
 template <class DesignClass,
          int Channels,
@@ -59,8 +65,11 @@ class SmoothedFilterDesign
 public:
     typedef FilterDesign <DesignClass, Channels, StateType> filter_type_t;
 
+    // Number of samples processed with the same interpolated coefficients
+    static const int coefficientUpdateInterval = 16;
+
     SmoothedFilterDesign(int transitionSamples)
-        : m_transitionSamples(transitionSamples)
+        : m_transitionSamples(std::max(transitionSamples, 1))
         , m_remainingSamples(-1)  // first time flag
     {
     }
@@ -75,44 +84,33 @@ public:
         // If this goes off it means setup() was never called
         assert(m_remainingSamples >= 0);
 
-        // first handle any transition samples
-        int remainingSamples = std::min(m_remainingSamples, numSamples);
+        // first handle any transition samples, one sub-block at a time
+        int transitionSamples = 0;
 
-        if (remainingSamples > 0)
+        while (m_remainingSamples > 0 && transitionSamples < numSamples)
         {
-            // interpolate parameters for each sample
-            const double t = 1. / m_remainingSamples;
-            double dp[maxParameters];
-            for (int i = 0; i < DesignClass::NumParams; ++i)
-                dp[i] = (this->getParams()[i] - m_transitionParams[i]) * t;
-
-            for (int n = 0; n < remainingSamples; ++n)
-            {
-                for (int i = DesignClass::NumParams; --i >=0;)
-                    m_transitionParams[i] += dp[i];
-
-                m_transitionFilter.setParams(m_transitionParams);
-
-                for (int i = numChannels; --i >= 0;)
-                {
-                    Sample* dest = destChannelArray[i]+n;
-                    *dest = this->m_state[i].process(*dest, m_transitionFilter);
-                }
-            }
-
-            m_remainingSamples -= remainingSamples;
-
-            if (m_remainingSamples == 0)
-                m_transitionParams = this->getParams();
+            const int n = std::min(std::min(m_remainingSamples, coefficientUpdateInterval),
+                                   numSamples - transitionSamples);
+
+            m_remainingSamples -= n;
+            m_transitionFilter.setInterpolatedStages(m_startFilter, this->m_design,
+                                                     getTransitionProgress());
+
+            for (int i = 0; i < numChannels; ++i)
+                m_transitionFilter.process(n,
+                                           destChannelArray[i] + transitionSamples,
+                                           this->m_state[i]);
+
+            transitionSamples += n;
         }
 
         // do what's left
-        if (numSamples - remainingSamples > 0)
+        if (numSamples - transitionSamples > 0)
         {
             // no transition
             for (int i = 0; i < numChannels; ++i)
-                this->m_design.process(numSamples - remainingSamples,
-                                       destChannelArray[i] + remainingSamples,
+                this->m_design.process(numSamples - transitionSamples,
+                                       destChannelArray[i] + transitionSamples,
                                        this->m_state[i]);
         }
     }
@@ -128,25 +126,39 @@ public:
     }
 
 protected:
+    // Position of the current transition, 1 when there is none
+    double getTransitionProgress() const
+    {
+        return 1. - double(m_remainingSamples) / m_transitionSamples;
+    }
+
     void doSetParams(const Params& parameters)
     {
-        if (m_remainingSamples >= 0)
+        const bool isFirstTime = m_remainingSamples < 0;
+
+        // start from the coefficients in use right now, which may be
+        // part of the way through a previous transition
+        if (!isFirstTime)
+            m_startFilter.setInterpolatedStages(m_startFilter, this->m_design,
+                                                getTransitionProgress());
+
+        filter_type_t::doSetParams(parameters);
+
+        if (!isFirstTime && m_startFilter.getNumStages() == this->m_design.getNumStages())
         {
             m_remainingSamples = m_transitionSamples;
         }
         else
         {
-            // first time
+            // first time, or the order changed: switch without transition
             m_remainingSamples = 0;
-            m_transitionParams = parameters;
+            m_startFilter.setInterpolatedStages(this->m_design, this->m_design, 1.);
         }
-
-        filter_type_t::doSetParams(parameters);
     }
 
 protected:
-    Params m_transitionParams;
-    DesignClass m_transitionFilter;
+    DesignClass m_startFilter;          // coefficients when the transition started
+    DesignClass m_transitionFilter;     // interpolated coefficients
     int m_transitionSamples;
 
     int m_remainingSamples;        // remaining transition samples
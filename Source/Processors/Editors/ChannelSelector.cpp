@@ -29,7 +29,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../AudioNode/AudioNode.h"
 #include "../ProcessorGraph/ProcessorGraph.h"
 #include "../../UI/GraphViewer.h"
-#include "../../Utils/ListSliceParser.h"
 
 
 static const Colour COLOUR_DROPDOWN_BUTTON_BG   (Colour::fromRGB (48, 63, 159));
@@ -81,29 +80,27 @@ ChannelSelector::ChannelSelector(bool createButtons, Font& titleFont_) :
     noneButton->addListener(this);
     addAndMakeVisible(noneButton);
 
-    // Buttons managers
+    // Channel grids
     // ====================================================================
-    addAndMakeVisible (audioButtonsManager);
-    //addAndMakeVisible (recordButtonsManager);
-    addAndMakeVisible (parameterButtonsManager);
-
-    // Enable fast mode selection for buttons
-    audioButtonsManager.setFastSelectionModeEnabled     (true);
-    recordButtonsManager.setFastSelectionModeEnabled    (true);
-    parameterButtonsManager.setFastSelectionModeEnabled (true);
-
-    audioButtonsManager.setMinPaddingBetweenButtons     (0);
-    recordButtonsManager.setMinPaddingBetweenButtons    (0);
-    parameterButtonsManager.setMinPaddingBetweenButtons (0);
-
-    audioButtonsManager.setColour       (ButtonGroupManager::outlineColourId, Colour (0x0));
-    recordButtonsManager.setColour      (ButtonGroupManager::outlineColourId, Colour (0x0));
-    parameterButtonsManager.setColour   (ButtonGroupManager::outlineColourId, Colour (0x0));
-
-    // Register listeners for buttons
-    audioButtonsManager.setButtonListener      (this);
-    recordButtonsManager.setButtonListener     (this);
-    parameterButtonsManager.setButtonListener  (this);
+    addAndMakeVisible (audioChannelGrid);
+    //addAndMakeVisible (recordChannelGrid);
+    addAndMakeVisible (parameterChannelGrid);
+
+    Font channelFont (titleFont);
+    channelFont.setHeight (11);
+
+    audioChannelGrid.setFont        (channelFont);
+    recordChannelGrid.setFont       (channelFont);
+    parameterChannelGrid.setFont    (channelFont);
+
+    audioChannelGrid.setColour      (ChannelGrid::outlineColourId, Colour (0x0));
+    recordChannelGrid.setColour     (ChannelGrid::outlineColourId, Colour (0x0));
+    parameterChannelGrid.setColour  (ChannelGrid::outlineColourId, Colour (0x0));
+
+    // Register listeners for channels
+    audioChannelGrid.setListener        (this);
+    recordChannelGrid.setListener       (this);
+    parameterChannelGrid.setListener    (this);
     // ====================================================================
 
     // Slicer channels selectors
@@ -138,9 +135,9 @@ ChannelSelector::~ChannelSelector()
     // We will remove it after getting rid of the ugly calling of deleteAllChildren() method.
     // We should really use some RAII technuiqes to avoid calling this method.
     // TODO: refactor the code to follow RAII best principles and to avoid using raw pointers after merge with priyanjitdey94
-    removeChildComponent (&audioButtonsManager);
-    removeChildComponent (&recordButtonsManager);
-    removeChildComponent (&parameterButtonsManager);
+    removeChildComponent (&audioChannelGrid);
+    removeChildComponent (&recordChannelGrid);
+    removeChildComponent (&parameterChannelGrid);
 
     removeChildComponent (&audioSlicerChannelSelector);
     removeChildComponent (&recordSlicerChannelSelector);
@@ -173,36 +170,24 @@ void ChannelSelector::paint(Graphics& g)
 
 void ChannelSelector::setNumChannels(int numChans)
 {
-    int difference = numChans - parameterButtonsManager.getNumButtons();
-
-    // std::cout << difference << " buttons needed." << std::endl;
+    parameterChannelGrid.setNumChannels (numChans, paramsToggled);
 
-    if (difference > 0)
-    {
-        for (int n = 0; n < difference; n++)
-        {
-            addButton();
-        }
-    }
-    else if (difference < 0)
+    if (isNotSink)
     {
-        for (int n = 0; n < -difference; n++)
-        {
-            removeButton();
-        }
+        recordChannelGrid.setNumChannels (numChans);
+        audioChannelGrid.setNumChannels  (numChans);
     }
 
-    const int numButtons = parameterButtonsManager.getNumButtons();
     //Reassign numbers according to the actual channels (useful for channel mapper)
-    for (int n = 0; n < numButtons; ++n)
+    for (int n = 0; n < numChans; ++n)
     {
         int num = ( (GenericEditor*)getParentComponent())->getChannelDisplayNumber (n);
-        static_cast<ChannelSelectorButton*> (parameterButtonsManager.getButtonAt  (n))->setChannel (n + 1, num + 1);
+        parameterChannelGrid.setChannelLabel (n, num + 1);
 
         if (isNotSink)
         {
-            static_cast<ChannelSelectorButton*> (recordButtonsManager.getButtonAt (n))->setChannel (n + 1, num + 1);
-            static_cast<ChannelSelectorButton*> (audioButtonsManager.getButtonAt  (n))->setChannel (n + 1, num + 1);
+            recordChannelGrid.setChannelLabel (n, num + 1);
+            audioChannelGrid.setChannelLabel  (n, num + 1);
         }
     }
 
@@ -211,12 +196,12 @@ void ChannelSelector::setNumChannels(int numChans)
 
 int ChannelSelector::getNumChannels()
 {
-    return parameterButtonsManager.getNumButtons();
+    return parameterChannelGrid.getNumChannels();
 }
 
 void ChannelSelector::shiftChannelsVertical(float amount)
 {
-    if (parameterButtonsManager.getNumButtons() > 16)
+    if (parameterChannelGrid.getNumChannels() > 16)
     {
         offsetUD -= amount * 10;
         offsetUD = jmin(offsetUD, 0.0f);
@@ -233,9 +218,9 @@ void ChannelSelector::refreshButtonBoundaries()
     const int columnWidth   = getDesiredWidth() / (numColumnsGreaterThan100 + 1) + 1;
     const int rowHeight     = 14;
 
-    audioButtonsManager.setButtonSize      (columnWidth, rowHeight);
-    recordButtonsManager.setButtonSize     (columnWidth, rowHeight);
-    parameterButtonsManager.setButtonSize  (columnWidth, rowHeight);
+    audioChannelGrid.setCellSize        (columnWidth, rowHeight);
+    recordChannelGrid.setCellSize       (columnWidth, rowHeight);
+    parameterChannelGrid.setCellSize    (columnWidth, rowHeight);
 
     const int xLoc = offsetLR + 3;
 
@@ -252,30 +237,30 @@ void ChannelSelector::refreshButtonBoundaries()
                                           .withY (audioSlicerChannelSelector.getY())
                                           .withHeight (audioSlicerChannelSelector.getHeight()));
 
-    // Set bounds for buttons managers
+    // Set bounds for channel grids
     // ===================================================================================================
     const int headerHeight              = 25;
     const int tabButtonHeight           = 15;
-    const int buttonsManagerWidth       = getDesiredWidth() - 6;
-    const int defaultButtonsManagerY    = headerHeight;
+    const int channelGridWidth          = getDesiredWidth() - 6;
+    const int defaultChannelGridY       = headerHeight;
 
     // We will use just some hacks to set initial y and height if height is zero,
-    // otherwise we will use the same bounds for buttons maangers
-    int buttonsManagerX = xLoc;
-    parameterButtonsManager.setBounds   (buttonsManagerX,
-                                         parameterButtonsManager.getHeight() == 0 ? defaultButtonsManagerY : parameterButtonsManager.getY(),
-                                         buttonsManagerWidth,
-                                         getHeight() - parameterButtonsManager.getY() - tabButtonHeight);
-    buttonsManagerX -= getDesiredWidth();
-    recordButtonsManager.setBounds      (buttonsManagerX,
-                                         recordButtonsManager.getHeight() == 0 ? defaultButtonsManagerY : recordButtonsManager.getY(),
-                                         buttonsManagerWidth,
-                                         getHeight() - recordButtonsManager.getY() - tabButtonHeight);
-    buttonsManagerX -= getDesiredWidth();
-    audioButtonsManager.setBounds       (buttonsManagerX,
-                                         audioButtonsManager.getHeight() == 0 ? defaultButtonsManagerY : audioButtonsManager.getY(),
-                                         buttonsManagerWidth,
-                                         getHeight() - audioButtonsManager.getY() - tabButtonHeight);
+    // otherwise we will use the same bounds for channel grids
+    int channelGridX = xLoc;
+    parameterChannelGrid.setBounds  (channelGridX,
+                                     parameterChannelGrid.getHeight() == 0 ? defaultChannelGridY : parameterChannelGrid.getY(),
+                                     channelGridWidth,
+                                     getHeight() - parameterChannelGrid.getY() - tabButtonHeight);
+    channelGridX -= getDesiredWidth();
+    recordChannelGrid.setBounds     (channelGridX,
+                                     recordChannelGrid.getHeight() == 0 ? defaultChannelGridY : recordChannelGrid.getY(),
+                                     channelGridWidth,
+                                     getHeight() - recordChannelGrid.getY() - tabButtonHeight);
+    channelGridX -= getDesiredWidth();
+    audioChannelGrid.setBounds      (channelGridX,
+                                     audioChannelGrid.getHeight() == 0 ? defaultChannelGridY : audioChannelGrid.getY(),
+                                     channelGridWidth,
+                                     getHeight() - audioChannelGrid.getY() - tabButtonHeight);
     // ===================================================================================================
 
     /*
@@ -325,61 +310,13 @@ void ChannelSelector::timerCallback()
     refreshButtonBoundaries();
 }
 
-void ChannelSelector::addButton()
-{
-    const int size = parameterButtonsManager.getNumButtons();
-
-    ChannelSelectorButton* b = new ChannelSelectorButton (size + 1, PARAMETER, titleFont);
-    parameterButtonsManager.addButton (b);
-
-    if (paramsToggled)
-        b->setToggleState(true, dontSendNotification);
-    else
-        b->setToggleState(false, dontSendNotification);
-
-    if (!paramsActive)
-        b->setActive(false);
-
-    if (isNotSink)
-    {
-        ChannelSelectorButton* br = new ChannelSelectorButton(size + 1, RECORD, titleFont);
-        recordButtonsManager.addButton (br);
-
-        ChannelSelectorButton* ba = new ChannelSelectorButton(size + 1, AUDIO, titleFont);
-        audioButtonsManager.addButton (ba);
-    }
-}
-
-void ChannelSelector::removeButton()
-{
-    int size = parameterButtonsManager.getNumButtons();
-
-    parameterButtonsManager.removeButton (size - 1);
-
-    if (isNotSink)
-    {
-        recordButtonsManager.removeButton (size - 1);
-        audioButtonsManager.removeButton  (size - 1);
-    }
-}
-
 Array<int> ChannelSelector::getActiveChannels()
 {
-    Array<int> a;
-
     if (! eventsOnly)
-    {
-        const int numButtons = parameterButtonsManager.getNumButtons();
-        for (int i = 0; i < numButtons; ++i)
-        {
-            if (parameterButtonsManager.getButtonAt (i)->getToggleState())
-                a.add (i);
-        }
-    }
-    else
-    {
-        a.add (0);
-    }
+        return parameterChannelGrid.getSelectedChannels();
+
+    Array<int> a;
+    a.add (0);
 
     return a;
 }
@@ -388,18 +325,11 @@ void ChannelSelector::setActiveChannels(Array<int> a)
 {
     //std::cout << "Setting active channels!" << std::endl;
 
-    const int numButtons = parameterButtonsManager.getNumButtons();
-    for (int i = 0; i < numButtons; ++i)
-    {
-        parameterButtonsManager.getButtonAt (i)->setToggleState (false, dontSendNotification);
-    }
+    parameterChannelGrid.setAllStates (false);
 
     for (int i = 0; i < a.size(); i++)
     {
-        if (a[i] < numButtons)
-        {
-            parameterButtonsManager.getButtonAt (a[i])->setToggleState (true, dontSendNotification);
-        }
+        parameterChannelGrid.setState (a[i], true);
     }
 }
 
@@ -407,52 +337,28 @@ void ChannelSelector::inactivateButtons()
 {
     paramsActive = false;
 
-    const int numButtons = parameterButtonsManager.getNumButtons();
-    for (int i = 0; i < numButtons; ++i)
-    {
-        const auto& button = static_cast<ChannelSelectorButton*> (parameterButtonsManager.getButtonAt (i));
-        button->setActive (false);
-        button->repaint();
-    }
+    parameterChannelGrid.setTogglingEnabled (false);
 }
 
 void ChannelSelector::activateButtons()
 {
     paramsActive = true;
 
-    const int numButtons = parameterButtonsManager.getNumButtons();
-    for (int i = 0; i < numButtons; ++i)
-    {
-        const auto& button = static_cast<ChannelSelectorButton*> (parameterButtonsManager.getButtonAt (i));
-        button->setActive (true);
-        button->repaint();
-    }
+    parameterChannelGrid.setTogglingEnabled (true);
 }
 
 void ChannelSelector::inactivateRecButtons()
 {
     recActive = false;
 
-    const int numButtons = recordButtonsManager.getNumButtons();
-    for (int i = 0; i < numButtons; ++i)
-    {
-        const auto& button = static_cast<ChannelSelectorButton*> (recordButtonsManager.getButtonAt (i));
-        button->setActive (false);
-        button->repaint();
-    }
+    recordChannelGrid.setTogglingEnabled (false);
 }
 
 void ChannelSelector::activateRecButtons()
 {
     recActive = true;
 
-    const int numButtons = recordButtonsManager.getNumButtons();
-    for (int i = 0; i < numButtons; ++i)
-    {
-        const auto& button = static_cast<ChannelSelectorButton*> (recordButtonsManager.getButtonAt (i));
-        button->setActive (true);
-        button->repaint();
-    }
+    recordChannelGrid.setTogglingEnabled (true);
 }
 
 void ChannelSelector::refreshParameterColors()
@@ -482,63 +388,44 @@ void ChannelSelector::setRadioStatus(bool radioOn)
     {
         radioStatus = radioOn;
 
-        const int numButtons = parameterButtonsManager.getNumButtons();
-        for (int i = 0; i < numButtons; ++i)
-        {
-            parameterButtonsManager.getButtonAt (i)->setToggleState (false, dontSendNotification);
-        }
-
-        parameterButtonsManager.setRadioButtonMode (radioStatus);
+        parameterChannelGrid.setAllStates (false);
+        parameterChannelGrid.setRadioMode (radioStatus);
     }
 }
 
 bool ChannelSelector::getParamStatus(int chan)
 {
-    if (chan >= 0 && chan < parameterButtonsManager.getNumButtons())
-        return parameterButtonsManager.getButtonAt (chan)->getToggleState();
-    else
-        return false;
+    return parameterChannelGrid.getState (chan);
 }
 
 bool ChannelSelector::getRecordStatus(int chan)
 {
-    if (chan >= 0 && chan < recordButtonsManager.getNumButtons())
-        return recordButtonsManager.getButtonAt (chan)->getToggleState();
-    else
-        return false;
+    return recordChannelGrid.getState (chan);
 }
 
 bool ChannelSelector::getAudioStatus(int chan)
 {
-    if (chan >= 0 && chan < audioButtonsManager.getNumButtons())
-        return audioButtonsManager.getButtonAt (chan)->getToggleState();
-    else
-        return false;
+    return audioChannelGrid.getState (chan);
 }
 
 void ChannelSelector::setParamStatus(int chan, bool b)
 {
-    if (chan >= 0 && chan < parameterButtonsManager.getNumButtons())
-        parameterButtonsManager.getButtonAt (chan)->setToggleState(b, sendNotification);
+    parameterChannelGrid.setState (chan, b, sendNotification);
 }
 
 void ChannelSelector::setRecordStatus(int chan, bool b)
 {
-    if (chan >= 0 && chan < recordButtonsManager.getNumButtons())
-        recordButtonsManager.getButtonAt (chan)->setToggleState(b, sendNotification);
+    recordChannelGrid.setState (chan, b, sendNotification);
 }
 
 void ChannelSelector::setAudioStatus(int chan, bool b)
 {
-    if (chan >= 0 && chan < audioButtonsManager.getNumButtons())
-        audioButtonsManager.getButtonAt (chan)->setToggleState (b, sendNotification);
+    audioChannelGrid.setState (chan, b, sendNotification);
 }
 
 void ChannelSelector::clearAudio()
 {
-    const int numButtons = audioButtonsManager.getNumButtons();
-    for (int chan = 0; chan < numButtons; ++chan)
-        audioButtonsManager.getButtonAt (chan)->setToggleState (false, sendNotification);
+    audioChannelGrid.setAllStates (false, sendNotification);
 }
 
 int ChannelSelector::getDesiredWidth()
@@ -591,21 +478,14 @@ void ChannelSelector::buttonClicked(Button* button)
     }
     else if (button == allButton)
     {
-        // select all active buttons
+        // select all active channels
         if (offsetLR == recordOffset)
         {
-            for (int i = 0; i < recordButtonsManager.getNumButtons(); ++i)
-            {
-                recordButtonsManager.getButtonAt (i)->setToggleState (true, sendNotification);
-            }
-
+            recordChannelGrid.setAllStates (true, sendNotification);
         }
         else if (offsetLR == parameterOffset)
         {
-            for (int i = 0; i < parameterButtonsManager.getNumButtons(); ++i)
-            {
-                parameterButtonsManager.getButtonAt (i)->setToggleState (true, sendNotification);
-            }
+            parameterChannelGrid.setAllStates (true, sendNotification);
         }
         else if (offsetLR == audioOffset)
         {
@@ -614,27 +494,18 @@ void ChannelSelector::buttonClicked(Button* button)
     }
     else if (button == noneButton)
     {
-        // deselect all active buttons
+        // deselect all active channels
         if (offsetLR == recordOffset)
         {
-            for (int i = 0; i < recordButtonsManager.getNumButtons(); ++i)
-            {
-                recordButtonsManager.getButtonAt (i)->setToggleState (false, sendNotification);
-            }
+            recordChannelGrid.setAllStates (false, sendNotification);
         }
         else if (offsetLR == parameterOffset)
         {
-            for (int i = 0; i < parameterButtonsManager.getNumButtons(); ++i)
-            {
-                parameterButtonsManager.getButtonAt (i)->setToggleState (false, sendNotification);
-            }
+            parameterChannelGrid.setAllStates (false, sendNotification);
         }
         else if (offsetLR == audioOffset)
         {
-            for (int i = 0; i < audioButtonsManager.getNumButtons(); ++i)
-            {
-                audioButtonsManager.getButtonAt (i)->setToggleState (false, sendNotification);
-            }
+            audioChannelGrid.setAllStates (false, sendNotification);
         }
 
         if (radioStatus) // if radio buttons are active
@@ -644,130 +515,93 @@ void ChannelSelector::buttonClicked(Button* button)
             editor->channelChanged (-1, false);
         }
     }
-    else
+    refreshParameterColors();
+}
+
+
+void ChannelSelector::channelStateChanged (ChannelGrid* grid, int channel, bool state)
+{
+    GenericEditor* editor = (GenericEditor*) getParentComponent();
+
+    if (grid == &audioChannelGrid)
     {
-        ChannelSelectorButton* b = (ChannelSelectorButton*)button;
+        // get audio node, and inform it of the change
+        const DataChannel* ch = editor->getChannel (channel);
+
+     //   std::cout << "Requesting audio monitor for channel " << ch->nodeIndex + 1 << std::endl;
 
-        if (b->getType() == AUDIO)
+        // change parameter directly on editor
+        //     This is another of those ugly things that will go away once the
+        //     probe audio system is implemented, but is needed to maintain compatibility
+        //     between the older recording system and the newer channel objects.
+        const_cast<DataChannel*>(ch)->setMonitored(state);
+
+        if (acquisitionIsActive) // use setParameter to change audio node's copy of parameter safely, if running
         {
-            // get audio node, and inform it of the change
-            GenericEditor* editor = (GenericEditor*)getParentComponent();
-
-            const DataChannel* ch = editor->getChannel(b->getChannel() - 1);
-            //int channelNum = editor->getStartChannel() + b->getChannel() - 1;
-            bool status = b->getToggleState();
-
-         //   std::cout << "Requesting audio monitor for channel " << ch->nodeIndex + 1 << std::endl;
-            
-            // change parameter directly on editor
-            //     This is another of those ugly things that will go away once the
-            //     probe audio system is implemented, but is needed to maintain compatibility
-            //     between the older recording system and the newer channel objects.
-            const_cast<DataChannel*>(ch)->setMonitored(status);
-
-            
-            if (acquisitionIsActive) // use setParameter to change audio node's copy of parameter safely, if running
-            {
-                AccessClass::getProcessorGraph()->
-                getAudioNode()->setChannelStatus(ch, status);
-            }
+            AccessClass::getProcessorGraph()->
+            getAudioNode()->setChannelStatus(ch, state);
         }
-        else if (b->getType() == RECORD)
-        {
-			
-            // get record node, and inform it of the change
-            GenericEditor* editor = (GenericEditor*)getParentComponent();
-
-            const DataChannel* ch = editor->getChannel(b->getChannel() - 1);
-            //int channelNum = editor->getStartChannel() + b->getChannel() - 1;
-            bool status = b->getToggleState();
-
-            if (acquisitionIsActive) // use setParameter to change parameter safely
-            {
-                               
-                // disable toggling when acquisition is active
-                b->setToggleState(const_cast<DataChannel*>(ch)->getRecordState(), dontSendNotification);
-            }
-            else     // change parameter directly
-            {
-                //std::cout << "Setting record status for channel " << b->getChannel() << std::endl;
-
-				//This is another of those ugly things that will go away once the
-				//probe recording system is implemented, but is needed to maintain compatibility
-				//between the older recording system and the newer channel objects.
-                const_cast<DataChannel*>(ch)->setRecordState(status);
-            }
-
-            AccessClass::getGraphViewer()->repaint();
+    }
+    else if (grid == &recordChannelGrid)
+    {
+        // get record node, and inform it of the change
+        const DataChannel* ch = editor->getChannel (channel);
 
+        if (acquisitionIsActive) // use setParameter to change parameter safely
+        {
+            // disable toggling when acquisition is active
+            recordChannelGrid.setState (channel, const_cast<DataChannel*>(ch)->getRecordState(), dontSendNotification);
         }
-        else // parameter type
+        else     // change parameter directly
         {
-            GenericEditor* editor = (GenericEditor*) getParentComponent();
-            editor->channelChanged (b->getChannel() - 1, b->getToggleState());
-
-            // do nothing
-            if (radioStatus) // if radio buttons are active
-            {
-                // send a message to parent
-                GenericEditor* editor = (GenericEditor*) getParentComponent();
-                editor->channelChanged (b->getChannel(), b->getToggleState());
-            }
+            //std::cout << "Setting record status for channel " << channel + 1 << std::endl;
+
+            //This is another of those ugly things that will go away once the
+            //probe recording system is implemented, but is needed to maintain compatibility
+            //between the older recording system and the newer channel objects.
+            const_cast<DataChannel*>(ch)->setRecordState(state);
         }
 
+        AccessClass::getGraphViewer()->repaint();
+    }
+    else // parameter type
+    {
+        editor->channelChanged (channel, state);
+
+        if (radioStatus) // if radio buttons are active
+        {
+            // send a message to parent
+            editor->channelChanged (channel + 1, state);
+        }
     }
+
     refreshParameterColors();
 }
 
 
-void ChannelSelector::changeChannelsSelectionButtonClicked (SlicerChannelSelectorComponent* sender,
-                                                            Button* buttonThatWasClicked,
-                                                            bool isSelect)
+ChannelGrid* ChannelSelector::getChannelGrid (Channels::ChannelsType channelsType)
 {
-    const Channels::ChannelsType channelsType = sender->getChannelsType();
-
-    TiledButtonGroupManager* buttonsManager = nullptr;
     if (channelsType == Channels::AUDIO_CHANNELS)
-        buttonsManager = &audioButtonsManager;
+        return &audioChannelGrid;
     else if (channelsType == Channels::RECORD_CHANNELS)
-        buttonsManager = &recordButtonsManager;
-    else if (channelsType == Channels::PARAM_CHANNELS)
-        buttonsManager = &parameterButtonsManager;
-
-    jassert (buttonsManager != nullptr);
+        return &recordChannelGrid;
+    else
+        return &parameterChannelGrid;
+}
 
-    Array<int> getBoxList = ListSliceParser::parseStringIntoRange (sender->getText(), audioButtonsManager.getNumButtons());
-    if (getBoxList.size() < 3)
-        return;
 
-    int i = 0;
-    while (i <= getBoxList.size() - 3)
-    {
-        const int lim = getBoxList[i + 1];
-        const int comd = getBoxList[i + 2];
-        for (int fa = getBoxList[i]; fa <= lim; fa += comd)
-        {
-            buttonsManager->getButtonAt (fa)->setToggleState (isSelect, sendNotification);
-        }
-        i += 3;
-    }
+void ChannelSelector::changeChannelsSelectionButtonClicked (SlicerChannelSelectorComponent* sender,
+                                                            Button* buttonThatWasClicked,
+                                                            bool isSelect)
+{
+    getChannelGrid (sender->getChannelsType())->setStatesFromString (sender->getText(), isSelect, sendNotification);
 }
 
 
 void ChannelSelector::channelSelectorCollapsedStateChanged (SlicerChannelSelectorComponent* sender,
                                                             bool isCollapsed)
 {
-    const Channels::ChannelsType channelsType = sender->getChannelsType();
-
-    TiledButtonGroupManager* buttonsManager = nullptr;
-    if (channelsType == Channels::AUDIO_CHANNELS)
-        buttonsManager = &audioButtonsManager;
-    else if (channelsType == Channels::RECORD_CHANNELS)
-        buttonsManager = &recordButtonsManager;
-    else if (channelsType == Channels::PARAM_CHANNELS)
-        buttonsManager = &parameterButtonsManager;
-
-    jassert (buttonsManager != nullptr);
+    ChannelGrid* channelGrid = getChannelGrid (sender->getChannelsType());
 
     const int headerHeight      = 25;
     const int tabButtonHeight   = 15;
@@ -777,10 +611,10 @@ void ChannelSelector::channelSelectorCollapsedStateChanged (SlicerChannelSelecto
         yPos += SlicerChannelSelectorComponent::MAX_HEIGHT - 20;
 
     const int height = getHeight() - yPos - tabButtonHeight;
-    const juce::Rectangle<int> finalBounds (buttonsManager->getX(), yPos, buttonsManager->getWidth(), height);
+    const juce::Rectangle<int> finalBounds (channelGrid->getX(), yPos, channelGrid->getWidth(), height);
 
     auto& componentAnimator = Desktop::getInstance().getAnimator();
-    componentAnimator.animateComponent (buttonsManager, finalBounds, 1.f, DURATION_ANIMATION_COLLAPSE_MS, false, 1.0, 1.0);
+    componentAnimator.animateComponent (channelGrid, finalBounds, 1.f, DURATION_ANIMATION_COLLAPSE_MS, false, 1.0, 1.0);
 }
 
 ///////////// BUTTONS //////////////////////
@@ -982,78 +816,6 @@ void EditorButton::paintButton(Graphics& g, bool isMouseOver, bool isButtonDown)
 }
 
 
-ChannelSelectorButton::ChannelSelectorButton(int num_, int type_, Font& f) : Button("name")
-{
-    isActive = true;
-    num = num_;
-    displayNum = num_;
-    type = type_;
-
-    setClickingTogglesState(true);
-
-    buttonFont = f;
-    buttonFont.setHeight (11);
-}
-
-ChannelSelectorButton::~ChannelSelectorButton() {}
-
-int ChannelSelectorButton::getType()
-{
-    return type;
-}
-
-int ChannelSelectorButton::getChannel()
-{
-    return num;
-}
-
-void ChannelSelectorButton::setChannel(int n)
-{
-    num = n;
-    displayNum = n;
-}
-void ChannelSelectorButton::setChannel(int n, int d)
-{
-    num = n;
-    displayNum = d;
-}
-
-void ChannelSelectorButton::paintButton(Graphics& g, bool isMouseOver, bool isButtonDown)
-{
-    if (isActive)
-    {
-        if (getToggleState() == true)
-            g.setColour(Colours::orange);
-        else
-            g.setColour(Colours::darkgrey);
-
-        if (isMouseOver)
-            g.setColour(Colours::white);
-    }
-    else
-    {
-        if (getToggleState() == true)
-            g.setColour(Colours::yellow);
-        else
-            g.setColour(Colours::lightgrey);
-    }
-
-    // g.fillRect(0,0,getWidth(),getHeight());
-
-    g.setFont(buttonFont);
-
-    // g.drawRect(0,0,getWidth(),getHeight(),1.0);
-
-    g.drawText(String(displayNum), 0, 0, getWidth(), getHeight(), Justification::centred, true);
-}
-
-void ChannelSelectorButton::setActive(bool t)
-{
-    isActive = t;
-    setClickingTogglesState(t);
-}
-
-
 SlicerChannelSelectorComponent::SlicerChannelSelectorComponent (Channels::ChannelsType channelsType,
                                                                 const String& componentName)
     : m_channelsType                (channelsType)
@@ -26,13 +26,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "../../../JuceLibraryCode/JuceHeader.h"
 #include "../Editors/GenericEditor.h"
-#include "../../UI/Utils/TiledButtonGroupManager.h"
+#include "../../UI/Utils/ChannelGrid.h"
 #include "../Channel/InfoObjects.h"
 
 #include <stdio.h>
 
 class ChannelSelectorRegion;
-class ChannelSelectorButton;
 class EditorButton;
 class ChannelSelectorBox;
 class ShowAlertMessage;
@@ -126,6 +125,7 @@ channels to be selected for different purposes.
 */
 class PLUGIN_API ChannelSelector : public Component
                                  , public Button::Listener
+                                 , private ChannelGrid::Listener
                                  , private SlicerChannelSelectorComponent::Listener
                                  , public Timer
 {
@@ -181,22 +181,22 @@ public:
     /** Called immediately after data acquisition ends.*/
     void stopAcquisition();
 
-    /** Inactivates all the ChannelSelectorButtons under the "param" tab.*/
+    /** Inactivates all the channels under the "param" tab.*/
     void inactivateButtons();
 
-    /** Activates all the ChannelSelectorButtons under the "param" tab.*/
+    /** Activates all the channels under the "param" tab.*/
     void activateButtons();
 
-    /** Inactivates all the ChannelSelectorButtons under the "rec" tab.*/
+    /** Inactivates all the channels under the "rec" tab.*/
     void inactivateRecButtons();
 
-    /** Activates all the ChannelSelectorButtons under the "rec" tab.*/
+    /** Activates all the channels under the "rec" tab.*/
     void activateRecButtons();
 
     /** Refreshes Parameter Colors on change*/
     void refreshParameterColors();
 
-    /** Controls the behavior of ChannelSelectorButtons; they can either behave
+    /** Controls the behavior of the "param" channels; they can either behave
     like radio buttons (only one selected at a time) or like toggle buttons (an
     arbitrary number can be selected at once).*/
     void setRadioStatus(bool);
@@ -216,25 +216,25 @@ private:
     EditorButton* allButton;
     EditorButton* noneButton;
 
-    /** An array of ChannelSelectorButtons used to select the channels that
+    /** A grid used to select the channels that
     will be updated when a parameter is changed.
     paramBox: TextBox where user input is taken for param tab.
     */
-    TiledButtonGroupManager parameterButtonsManager;
+    ChannelGrid parameterChannelGrid;
     SlicerChannelSelectorComponent parameterSlicerChannelSelector;
 
-    /** An array of ChannelSelectorButtons used to select the channels that
+    /** A grid used to select the channels that
     are sent to the audio monitor.
     audioBox: TextBox where user input is taken for audio tab
     */
-    TiledButtonGroupManager audioButtonsManager;
+    ChannelGrid audioChannelGrid;
     SlicerChannelSelectorComponent audioSlicerChannelSelector;
 
-    /** An array of ChannelSelectorButtons used to select the channels that
+    /** A grid used to select the channels that
     will be written to disk when the record button is pressed.
     recordBox: TextBox where user input is taken for record tab
     */
-    TiledButtonGroupManager recordButtonsManager;
+    ChannelGrid recordChannelGrid;
     SlicerChannelSelectorComponent recordSlicerChannelSelector;
 
     bool paramsToggled;
@@ -261,16 +261,23 @@ private:
 
     void resized();
 
-    void addButton();
-    void removeButton();
     void refreshButtonBoundaries();
 
+    /** Returns the grid that a slicer channel selector applies to */
+    ChannelGrid* getChannelGrid (Channels::ChannelsType channelsType);
+
     /** Controls the speed of animations. */
     void timerCallback();
 
     /** Draws the ChannelSelector. */
     void paint (Graphics& g);
 
+    // ChannelGrid methods
+    // =================================================================================================
+    /** Informs the editor, audio node or channels when a channel is toggled */
+    void channelStateChanged (ChannelGrid* grid, int channel, bool state) override;
+    // =================================================================================================
+
     // SlicerChannelSelectorComponent methods
     // =================================================================================================
     /** Implements behaviour for button for selecting/deselecting channels using list slicing */
@@ -285,8 +292,6 @@ private:
 
     Font& titleFont;
 
-    enum { AUDIO, RECORD, PARAMETER };
-
     bool acquisitionIsActive;
 
     ChannelSelectorRegion* channelSelectorRegion;
@@ -328,39 +333,4 @@ private:
 };
 
 
-/**
-
-A button within the ChannelSelector representing an individual channel.
-
-@see ChannelSelector
-
-*/
-
-class ChannelSelectorButton : public Button
-{
-public:
-    ChannelSelectorButton(int num, int type, Font& f);
-    ~ChannelSelectorButton();
-
-    int getType();
-    int getChannel();
-    //Channel* getChannel() {return ch;}
-    void setActive(bool t);
-    void setChannel(int n);
-    void setChannel(int n, int d);
-
-private:
-    void paintButton(Graphics& g, bool isMouseOver, bool isButtonDown);
-
-    //Channel* ch;
-
-    int type;
-    int num;
-    int displayNum;
-    Font buttonFont;
-    bool isActive;
-};
-
-
-
 #endif  // __CHANNELSELECTOR_H_68124E35__
@@ -555,8 +555,7 @@ void GenericEditor::update()
     updateVisualizer(); // does nothing unless this method
     // has been implemented
 
-    File recoveryFile = CoreServices::getSavedStateDirectory().getChildFile("recoveryConfig.xml");
-    AccessClass::getEditorViewport()->saveState(recoveryFile);
+    AccessClass::getEditorViewport()->saveRecoveryState();
 
 }
 
@@ -778,7 +778,7 @@ BinaryEventPtr BinaryEvent::deserializeFromMessage(const MidiMessage& msg, const
 }
 
 //SpikeEvent
-SpikeEvent::SpikeEvent(const SpikeChannel* channelInfo, juce::int64 timestamp, Array<float> thresholds, HeapBlock<float>& data, uint16 sortedID)
+SpikeEvent::SpikeEvent(const SpikeChannel* channelInfo, juce::int64 timestamp, const Array<float>& thresholds, HeapBlock<float>& data, uint16 sortedID)
 	: EventBase(SPIKE_EVENT, timestamp, channelInfo->getSourceNodeID(), channelInfo->getSubProcessorIdx(), channelInfo->getSourceIndex()),
 	m_thresholds(thresholds),
 	m_channelInfo(channelInfo),
@@ -832,7 +832,7 @@ const SpikeChannel* SpikeEvent::getChannelInfo() const
 
 void SpikeEvent::serialize(void* dstBuffer, size_t dstSize) const
 {
-	size_t dataSize = m_channelInfo->getDataSize();
+	size_t dataSize = m_channelInfo->getSerializedDataSize();
 	size_t eventSize = dataSize + SPIKE_BASE_SIZE + m_thresholds.size() * sizeof(float);
 	size_t totalSize = eventSize + m_channelInfo->getTotalEventMetaDataSize();
 	if (totalSize < dstSize)
@@ -856,11 +856,26 @@ void SpikeEvent::serialize(void* dstBuffer, size_t dstSize) const
 		*(reinterpret_cast<float*>(buffer + memIdx)) = m_thresholds[i];
 		memIdx += sizeof(float);
 	}
-	memcpy((buffer + memIdx), m_data.getData(), dataSize);
+	if (m_channelInfo->getWaveformEncoding() == SpikeChannel::INT16_WAVEFORM)
+	{
+		int nChans = m_channelInfo->getNumChannels();
+		int nSamples = m_channelInfo->getTotalSamples();
+		int16* dest = reinterpret_cast<int16*>(buffer + memIdx);
+		for (int c = 0; c < nChans; c++)
+		{
+			float bitVolts = m_channelInfo->getChannelBitVolts(c);
+			float scale = bitVolts > 0 ? 1.0f / bitVolts : 1.0f;
+			const float* src = m_data.getData() + c*nSamples;
+			for (int i = 0; i < nSamples; i++)
+				dest[c*nSamples + i] = static_cast<int16>(jlimit(-32768, 32767, roundToInt(src[i] * scale)));
+		}
+	}
+	else
+		memcpy((buffer + memIdx), m_data.getData(), dataSize);
 	serializeMetaData(buffer + eventSize);
 }
 
-SpikeEvent* SpikeEvent::createBasicSpike(const SpikeChannel* channelInfo, juce::int64 timestamp, Array<float> thresholds, SpikeBuffer& dataSource, uint16 sortedID)
+SpikeEvent* SpikeEvent::createBasicSpike(const SpikeChannel* channelInfo, juce::int64 timestamp, const Array<float>& thresholds, SpikeBuffer& dataSource, uint16 sortedID)
 {
 	if (!dataSource.m_ready)
 	{
@@ -894,7 +909,7 @@ SpikeEvent* SpikeEvent::createBasicSpike(const SpikeChannel* channelInfo, juce::
 
 }
 
-SpikeEventPtr SpikeEvent::createSpikeEvent(const SpikeChannel* channelInfo, juce::int64 timestamp, Array<float> thresholds, SpikeBuffer& dataSource, uint16 sortedID)
+SpikeEventPtr SpikeEvent::createSpikeEvent(const SpikeChannel* channelInfo, juce::int64 timestamp, const Array<float>& thresholds, SpikeBuffer& dataSource, uint16 sortedID)
 {
 	if (!channelInfo)
 	{
@@ -913,7 +928,7 @@ SpikeEventPtr SpikeEvent::createSpikeEvent(const SpikeChannel* channelInfo, juce
 	
 }
 
-SpikeEventPtr SpikeEvent::createSpikeEvent(const SpikeChannel* channelInfo, juce::int64 timestamp, Array<float> thresholds, SpikeBuffer& dataSource, uint16 sortedID, const MetaDataValueArray& metaData)
+SpikeEventPtr SpikeEvent::createSpikeEvent(const SpikeChannel* channelInfo, juce::int64 timestamp, const Array<float>& thresholds, SpikeBuffer& dataSource, uint16 sortedID, const MetaDataValueArray& metaData)
 {
 	if (!channelInfo)
 	{
@@ -939,63 +954,26 @@ SpikeEventPtr SpikeEvent::createSpikeEvent(const SpikeChannel* channelInfo, juce
 
 SpikeEventPtr SpikeEvent::deserializeFromMessage(const MidiMessage& msg, const SpikeChannel* channelInfo)
 {
-	int nChans = channelInfo->getNumChannels();
-	size_t totalSize = msg.getRawDataSize();
-	size_t dataSize = channelInfo->getDataSize();
-	size_t thresholdSize = nChans*sizeof(float);
-	size_t metaDataSize = channelInfo->getTotalEventMetaDataSize();
-
-	if (channelInfo->getChannelType() == SpikeChannel::INVALID)
+	SpikeEventView view(msg, channelInfo);
+	if (!view.isValid())
 	{
 		jassertfalse;
 		return nullptr;
 	}
 
-	if (totalSize != (thresholdSize + dataSize + SPIKE_BASE_SIZE + metaDataSize))
-	{
-		jassertfalse;
-		return nullptr;
-	}
+	int nChans = channelInfo->getNumChannels();
+	size_t dataSize = channelInfo->getSerializedDataSize();
+	size_t thresholdSize = nChans*sizeof(float);
+	size_t metaDataSize = channelInfo->getTotalEventMetaDataSize();
 	const uint8* buffer = msg.getRawData();
-	//TODO: remove the mask when the probe system is implemented
-	if (static_cast<EventType>(*(buffer + 0)&0x7F) != SPIKE_EVENT)
-	{
-		jassertfalse;
-		return nullptr;
-	}
 
-	if (static_cast<SpikeChannel::ElectrodeTypes>(*(buffer + 1)) != channelInfo->getChannelType())
-	{
-		jassertfalse;
-		return nullptr;
-	}
-
-	if (*reinterpret_cast<const uint16*>(buffer + 2) != channelInfo->getSourceNodeID())
-	{
-		jassertfalse;
-		return nullptr;
-	}
-
-	if (*reinterpret_cast<const uint16*>(buffer + 4) != channelInfo->getSubProcessorIdx())
-	{
-		jassertfalse;
-		return nullptr;
-	}
-	if (*reinterpret_cast<const uint16*>(buffer + 6) != channelInfo->getSourceIndex())
-	{
-		jassertfalse;
-		return nullptr;
-	}
-
-	juce::int64 timestamp = *(reinterpret_cast<const juce::int64*>(buffer + 8));
-	uint16 sortedID = *(reinterpret_cast<const uint16*>(buffer + 16));
 	Array<float> thresholds;
 	thresholds.addArray(reinterpret_cast<const float*>(buffer + SPIKE_BASE_SIZE), nChans);
 	HeapBlock<float> data;
-	data.malloc(dataSize, sizeof(char));
-	memcpy(data.getData(), (buffer + SPIKE_BASE_SIZE + thresholdSize), dataSize);
+	data.malloc(channelInfo->getDataSize(), sizeof(char));
+	view.copyWaveform(data.getData());
 
-	ScopedPointer<SpikeEvent> event = new SpikeEvent(channelInfo, timestamp, thresholds, data, sortedID);
+	ScopedPointer<SpikeEvent> event = new SpikeEvent(channelInfo, view.getTimestamp(), thresholds, data, view.getSortedID());
 
 	bool ret = true;
 	if (metaDataSize > 0)
@@ -1011,6 +989,115 @@ SpikeEventPtr SpikeEvent::deserializeFromMessage(const MidiMessage& msg, const S
 	}
 }
 
+//SpikeEventView
+SpikeEventView::SpikeEventView(const MidiMessage& msg, const SpikeChannel* channelInfo)
+	: m_buffer(msg.getRawData()),
+	m_channelInfo(channelInfo),
+	m_valid(false)
+{
+	if (!channelInfo || channelInfo->getChannelType() == SpikeChannel::INVALID)
+		return;
+
+	size_t thresholdSize = channelInfo->getNumChannels()*sizeof(float);
+	size_t totalSize = thresholdSize + channelInfo->getSerializedDataSize() + SPIKE_BASE_SIZE + channelInfo->getTotalEventMetaDataSize();
+
+	if (static_cast<size_t>(msg.getRawDataSize()) != totalSize)
+		return;
+
+	//TODO: remove the mask when the probe system is implemented
+	if (static_cast<EventType>(*(m_buffer + 0) & 0x7F) != SPIKE_EVENT)
+		return;
+
+	if (static_cast<SpikeChannel::ElectrodeTypes>(*(m_buffer + 1)) != channelInfo->getChannelType())
+		return;
+
+	if (*reinterpret_cast<const uint16*>(m_buffer + 2) != channelInfo->getSourceNodeID()
+		|| *reinterpret_cast<const uint16*>(m_buffer + 4) != channelInfo->getSubProcessorIdx()
+		|| *reinterpret_cast<const uint16*>(m_buffer + 6) != channelInfo->getSourceIndex())
+		return;
+
+	m_valid = true;
+}
+
+bool SpikeEventView::isValid() const
+{
+	return m_valid;
+}
+
+const SpikeChannel* SpikeEventView::getChannelInfo() const
+{
+	return m_channelInfo;
+}
+
+juce::int64 SpikeEventView::getTimestamp() const
+{
+	return *reinterpret_cast<const juce::int64*>(m_buffer + 8);
+}
+
+uint16 SpikeEventView::getSortedID() const
+{
+	return *reinterpret_cast<const uint16*>(m_buffer + 16);
+}
+
+float SpikeEventView::getThreshold(int chan) const
+{
+	jassert(chan >= 0 && chan < (int)m_channelInfo->getNumChannels());
+	return *reinterpret_cast<const float*>(m_buffer + SPIKE_BASE_SIZE + chan*sizeof(float));
+}
+
+bool SpikeEventView::isQuantized() const
+{
+	return m_channelInfo->getWaveformEncoding() == SpikeChannel::INT16_WAVEFORM;
+}
+
+const float* SpikeEventView::getDataPointer(int chan) const
+{
+	if (isQuantized() || chan < 0 || chan >= (int)m_channelInfo->getNumChannels())
+		return nullptr;
+
+	const uint8* data = m_buffer + SPIKE_BASE_SIZE + m_channelInfo->getNumChannels()*sizeof(float);
+	return reinterpret_cast<const float*>(data) + chan*m_channelInfo->getTotalSamples();
+}
+
+const int16* SpikeEventView::getQuantizedDataPointer(int chan) const
+{
+	if (!isQuantized() || chan < 0 || chan >= (int)m_channelInfo->getNumChannels())
+		return nullptr;
+
+	const uint8* data = m_buffer + SPIKE_BASE_SIZE + m_channelInfo->getNumChannels()*sizeof(float);
+	return reinterpret_cast<const int16*>(data) + chan*m_channelInfo->getTotalSamples();
+}
+
+float SpikeEventView::getSample(int chan, int samp) const
+{
+	jassert(samp >= 0 && samp < (int)m_channelInfo->getTotalSamples());
+
+	if (isQuantized())
+		return getQuantizedDataPointer(chan)[samp] * m_channelInfo->getChannelBitVolts(chan);
+	else
+		return getDataPointer(chan)[samp];
+}
+
+void SpikeEventView::copyWaveform(float* dest) const
+{
+	int nChans = m_channelInfo->getNumChannels();
+	int nSamples = m_channelInfo->getTotalSamples();
+
+	if (!isQuantized())
+	{
+		memcpy(dest, getDataPointer(0), m_channelInfo->getDataSize());
+		return;
+	}
+
+	for (int c = 0; c < nChans; c++)
+	{
+		const int16* src = getQuantizedDataPointer(c);
+		float bitVolts = m_channelInfo->getChannelBitVolts(c);
+		for (int i = 0; i < nSamples; i++)
+			dest[c*nSamples + i] = src[i] * bitVolts;
+	}
+}
+
 SpikeEvent::SpikeBuffer::SpikeBuffer(const SpikeChannel* channelInfo)
 	: m_nChans(channelInfo->getNumChannels()),
 	m_nSamps(channelInfo->getTotalSamples())
@@ -55,7 +55,7 @@ Source electrode index - 2 bytes
 Timestamp - 8 bytes
 sortedID - 2 bytes (defaults to 0)
 Thresholds - 4bytes*nChannels
-Data - 4bytes*nChannels*nSamples
+Data - 4bytes*nChannels*nSamples, or 2bytes*nChannels*nSamples if the SpikeChannel uses INT16_WAVEFORM
 */
 class EventBase;
 class Event;
@@ -296,14 +296,15 @@ public:
 
 	uint16 getSortedID() const;
 
-	static SpikeEventPtr createSpikeEvent(const SpikeChannel* channelInfo, juce::int64 timestamp, Array<float> thresholds, SpikeBuffer& dataSource, uint16 sortedID);
-	static SpikeEventPtr createSpikeEvent(const SpikeChannel* channelInfo, juce::int64 timestamp, Array<float> thresholds, SpikeBuffer& dataSource, uint16 sortedID, const MetaDataValueArray& metaData);
+	static SpikeEventPtr createSpikeEvent(const SpikeChannel* channelInfo, juce::int64 timestamp, const Array<float>& thresholds, SpikeBuffer& dataSource, uint16 sortedID);
+	static SpikeEventPtr createSpikeEvent(const SpikeChannel* channelInfo, juce::int64 timestamp, const Array<float>& thresholds, SpikeBuffer& dataSource, uint16 sortedID, const MetaDataValueArray& metaData);
 
+	/** Creates a copy of a serialized spike. Processors that only read it should use a SpikeEventView instead */
 	static SpikeEventPtr deserializeFromMessage(const MidiMessage& msg, const SpikeChannel* channelInfo);
 private:
 	SpikeEvent() = delete;
-	SpikeEvent(const SpikeChannel* channelInfo, juce::int64 timestamp, Array<float> thresholds, HeapBlock<float>& data, uint16 sortedID);
-	static SpikeEvent* createBasicSpike(const SpikeChannel* channelInfo, juce::int64 timestamp, Array<float> threshold, SpikeBuffer& dataSource, uint16 sortedID);
+	SpikeEvent(const SpikeChannel* channelInfo, juce::int64 timestamp, const Array<float>& thresholds, HeapBlock<float>& data, uint16 sortedID);
+	static SpikeEvent* createBasicSpike(const SpikeChannel* channelInfo, juce::int64 timestamp, const Array<float>& threshold, SpikeBuffer& dataSource, uint16 sortedID);
 
 	const Array<float> m_thresholds;
 	const SpikeChannel* m_channelInfo;
@@ -312,5 +313,43 @@ private:
 	JUCE_LEAK_DETECTOR(SpikeEvent);
 };
 
+/**
+Read-only view of a serialized spike, which reads every field straight from the message
+instead of copying it like SpikeEvent::deserializeFromMessage does. The message must outlive the view.
+*/
+class PLUGIN_API SpikeEventView
+{
+public:
+	SpikeEventView(const MidiMessage& msg, const SpikeChannel* channelInfo);
+
+	/** False if the message doesn't hold a spike of the given channel */
+	bool isValid() const;
+
+	const SpikeChannel* getChannelInfo() const;
+	juce::int64 getTimestamp() const;
+	uint16 getSortedID() const;
+	float getThreshold(int chan) const;
+
+	/** True if the waveform is stored as int16 multiples of the bitVolts of each channel */
+	bool isQuantized() const;
+
+	/** Gets the waveform of one channel, or nullptr if it is quantized */
+	const float* getDataPointer(int chan) const;
+
+	/** Gets the quantized waveform of one channel, or nullptr if it is stored as floats */
+	const int16* getQuantizedDataPointer(int chan) const;
+
+	float getSample(int chan, int samp) const;
+
+	/** Decodes the whole waveform, one channel after the other, into getChannelInfo()->getDataSize() bytes */
+	void copyWaveform(float* dest) const;
+
+private:
+	const uint8* m_buffer;
+	const SpikeChannel* m_channelInfo;
+	bool m_valid;
+	JUCE_LEAK_DETECTOR(SpikeEventView);
+};
+
 
 #endif
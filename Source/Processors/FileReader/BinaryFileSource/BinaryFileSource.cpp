@@ -110,6 +110,108 @@ void BinaryFileSource::updateActiveRecord()
 {
 	m_dataFile = new MemoryMappedFile(m_dataFileArray[activeRecord.get()], MemoryMappedFile::readOnly);
 	m_samplePos = 0;
+
+	loadEventStreams();
+}
+
+void BinaryFileSource::loadEventStreams()
+{
+	eventStreams.clear();
+
+	const int record = activeRecord.get();
+	const float sampleRate = getRecordSampleRate(record);
+
+	// recorded timestamps count samples since acquisition started, the record begins at its first timestamp
+	const int64 firstTimestamp = RecordedEventStream::readFirstTimestamp(m_dataFileArray[record].getSiblingFile("timestamps.npy"), 0);
+
+	Identifier idFolder("folder_name");
+	Identifier idSampleRate("sample_rate");
+	Identifier idNumChannels("num_channels");
+	Identifier idChannels("channels");
+	Identifier idChannelName("channel_name");
+	Identifier idSourceInfo("source_channel_info");
+	Identifier idSourceChannel("source_processor_channel");
+
+	var events = m_jsonData["events"];
+
+	for (int i = 0; i < events.size(); i++)
+	{
+		var ev = events[i];
+
+		// streams from sources with other clocks can't be lined up with the continuous data
+		if (std::abs(float(ev[idSampleRate]) - sampleRate) > 0.5f) continue;
+
+		File folder = m_rootPath.getChildFile("events").getChildFile(ev[idFolder].toString().trimCharactersAtEnd("/"));
+
+		RecordedEventStream::StreamType type;
+		File dataFile;
+
+		if (folder.getChildFile("channel_states.npy").existsAsFile())
+		{
+			type = RecordedEventStream::TTL_STREAM;
+			dataFile = folder.getChildFile("channel_states.npy");
+		}
+		else if (folder.getChildFile("text.npy").existsAsFile())
+		{
+			type = RecordedEventStream::TEXT_STREAM;
+			dataFile = folder.getChildFile("text.npy");
+		}
+		else continue; //binary events aren't replayed
+
+		ScopedPointer<RecordedEventStream> stream = new RecordedEventStream(type, ev[idChannelName], sampleRate, ev[idNumChannels]);
+
+		if (stream->open(folder.getChildFile("timestamps.npy"), dataFile, folder.getChildFile("channels.npy"), File(), firstTimestamp)
+			&& stream->getNumEvents() > 0)
+			eventStreams.add(stream.release());
+	}
+
+	var spikes = m_jsonData["spikes"];
+
+	for (int i = 0; i < spikes.size(); i++)
+	{
+		var sp = spikes[i];
+
+		if (std::abs(float(sp[idSampleRate]) - sampleRate) > 0.5f) continue;
+
+		String folderName = sp[idFolder].toString().trimCharactersAtEnd("/");
+		File folder = m_rootPath.getChildFile("spikes").getChildFile(folderName);
+
+		var channels = sp[idChannels];
+		Array<RecordedElectrodeInfo> electrodes;
+		int channelsPerElectrode = 0;
+
+		for (int e = 0; e < channels.size(); e++)
+		{
+			var sourceInfo = channels[e][idSourceInfo];
+
+			RecordedElectrodeInfo electrode;
+			electrode.name = channels[e][idChannelName];
+
+			for (int c = 0; c < sourceInfo.size(); c++)
+				electrode.channels.add(sourceInfo[c][idSourceChannel]);
+
+			channelsPerElectrode = electrode.channels.size();
+			electrodes.add(electrode);
+		}
+
+		if (electrodes.isEmpty() || channelsPerElectrode <= 0) continue;
+
+		const int preSamples = sp["pre_peak_samples"];
+		const int postSamples = sp["post_peak_samples"];
+
+		// waveforms were scaled with the bitVolts of the first channel of each electrode
+		const int firstChannel = electrodes[0].channels[0];
+		const float bitVolts = getChannelInfo(record, (firstChannel >= 0 && firstChannel < getRecordNumChannels(record)) ? firstChannel : 0).bitVolts;
+
+		ScopedPointer<RecordedEventStream> stream = new RecordedEventStream(RecordedEventStream::SPIKE_STREAM, folderName, sampleRate, channelsPerElectrode);
+		stream->setSpikeInfo(preSamples, postSamples, bitVolts, electrodes);
+
+		if (stream->open(folder.getChildFile("spike_times.npy"), folder.getChildFile("spike_waveforms.npy"),
+			folder.getChildFile("spike_electrode_indices.npy"), folder.getChildFile("spike_clusters.npy"), firstTimestamp)
+			&& stream->getNumEvents() > 0
+			&& stream->getDataSize() == channelsPerElectrode * (preSamples + postSamples) * int(sizeof(int16)))
+			eventStreams.add(stream.release());
+	}
 }
 
 void BinaryFileSource::seekTo(int64 sample)
@@ -149,6 +251,11 @@ void BinaryFileSource::processChannelData(int16* inBuffer, float* outBuffer, int
 	}
 }
 
+void BinaryFileSource::processBlockData(int16* inBuffer, float* const* outBuffers, const int* channels, int numChannels, int64 numSamples)
+{
+	convertInterleavedData(inBuffer, outBuffers, channels, numChannels, numSamples);
+}
+
 bool BinaryFileSource::isReady()
 {
 	return true;
@@ -40,6 +40,8 @@ namespace BinarySource
 
 		void processChannelData(int16* inBuffer, float* outBuffer, int channel, int64 numSamples) override;
 
+		void processBlockData(int16* inBuffer, float* const* outBuffers, const int* channels, int numChannels, int64 numSamples) override;
+
 		bool isReady() override;
 
 	private:
@@ -47,6 +49,9 @@ namespace BinarySource
 		void fillRecordInfo() override;
 		void updateActiveRecord() override;
 
+		/** Maps the events and spikes recorded at the sample rate of the active record */
+		void loadEventStreams();
+
 		ScopedPointer<MemoryMappedFile> m_dataFile;
 		var m_jsonData;
 		Array<File> m_dataFileArray;
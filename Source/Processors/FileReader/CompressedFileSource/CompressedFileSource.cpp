@@ -0,0 +1,297 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "CompressedFileSource.h"
+#include "../../RecordNode/CompressedFormat/CompressedBlockFile.h"
+#include "../../RecordNode/CompressedFormat/ContinuousBlockCodec.h"
+
+using namespace CompressedSource;
+
+CompressedFileSource::CompressedFileSource() : m_decodedBlockIndex(-1), m_samplePos(0)
+{
+	m_index.numChannels = 0;
+	m_index.samplesPerBlock = 0;
+	m_index.numSamples = 0;
+}
+
+CompressedFileSource::~CompressedFileSource()
+{}
+
+bool CompressedFileSource::Open(File file)
+{
+	m_jsonData = JSON::parse(file);
+	if (m_jsonData.isVoid())
+		return false;
+
+	if (m_jsonData["GUI version"].isVoid())
+		return false;
+
+	var cont = m_jsonData["continuous"];
+	if (cont.isVoid() || cont.size() <= 0)
+		return false;
+
+	m_rootPath = file.getParentDirectory();
+
+	return true;
+}
+
+bool CompressedFileSource::readBlockIndex(const File& dataFile, BlockIndex& index)
+{
+	FileInputStream stream(dataFile);
+	if (stream.failedToOpen())
+		return false;
+
+	int64 fileSize = stream.getTotalLength();
+	if (fileSize < CompressedBlockFile::headerSize)
+		return false;
+
+	if (uint32(stream.readInt()) != CompressedBlockFile::fileMagic)
+		return false;
+	stream.readShort(); //version
+	index.numChannels = stream.readShort();
+	index.samplesPerBlock = stream.readInt();
+	index.numSamples = 0;
+	index.offsets.clear();
+	index.firstSamples.clear();
+
+	if (index.numChannels <= 0 || index.samplesPerBlock <= 0)
+		return false;
+
+	//complete file, read the index
+	if (fileSize >= CompressedBlockFile::headerSize + CompressedBlockFile::trailerSize)
+	{
+		stream.setPosition(fileSize - CompressedBlockFile::trailerSize);
+		int64 indexOffset = stream.readInt64();
+		int numBlocks = stream.readInt();
+		stream.readInt(); //timestamp segments
+		int64 numSamples = stream.readInt64();
+
+		if (uint32(stream.readInt()) == CompressedBlockFile::fileMagic
+			&& indexOffset >= CompressedBlockFile::headerSize && indexOffset + int64(numBlocks) * 16 <= fileSize)
+		{
+			stream.setPosition(indexOffset);
+			for (int i = 0; i < numBlocks; i++)
+			{
+				index.offsets.add(stream.readInt64());
+				index.firstSamples.add(stream.readInt64());
+			}
+			index.numSamples = numSamples;
+			return true;
+		}
+	}
+
+	//interrupted recording, walk the blocks
+	std::cout << "No block index found in " << dataFile.getFullPathName() << ", scanning blocks" << std::endl;
+	int64 pos = CompressedBlockFile::headerSize;
+	while (pos + CompressedBlockFile::blockHeaderSize <= fileSize)
+	{
+		stream.setPosition(pos);
+		int64 encodedSize = uint32(stream.readInt());
+		int numSamples = stream.readInt();
+		if (numSamples <= 0 || numSamples > index.samplesPerBlock
+			|| pos + CompressedBlockFile::blockHeaderSize + encodedSize > fileSize)
+			break;
+
+		index.offsets.add(pos);
+		index.firstSamples.add(index.numSamples);
+		index.numSamples += numSamples;
+		pos += CompressedBlockFile::blockHeaderSize + encodedSize;
+	}
+	return true;
+}
+
+void CompressedFileSource::fillRecordInfo()
+{
+	var continuousData = m_jsonData["continuous"];
+
+	//create identifiers to speed up stuff
+	Identifier idFolder("folder_name");
+	Identifier idSampleRate("sample_rate");
+	Identifier idNumChannels("num_channels");
+	Identifier idChannels("channels");
+	Identifier idChannelName("channel_name");
+	Identifier idBitVolts("bit_volts");
+
+	int numProcessors = continuousData.size();
+
+	for (int i = 0; i < numProcessors; i++)
+	{
+		var record = continuousData[i];
+		if (record.isVoid()) continue;
+
+		var channels = record[idChannels];
+		if (channels.isVoid() || channels.size() <= 0) continue;
+
+		RecordInfo info;
+
+		String folderName = record[idFolder];
+		folderName = folderName.trimCharactersAtEnd("/");
+
+		File dataFile = m_rootPath.getChildFile("continuous").getChildFile(folderName).getChildFile("continuous.oecz");
+		if (!dataFile.existsAsFile()) continue;
+
+		int numChannels = record[idNumChannels];
+		BlockIndex index;
+		if (!readBlockIndex(dataFile, index) || index.numChannels != numChannels || index.numSamples <= 0)
+			continue;
+
+		info.name = folderName;
+		info.sampleRate = record[idSampleRate];
+		info.numSamples = index.numSamples;
+
+		for (int c = 0; c < numChannels; c++)
+		{
+			var chan = channels[c];
+			RecordedChannelInfo cInfo;
+
+			cInfo.name = chan[idChannelName];
+			cInfo.bitVolts = chan[idBitVolts];
+
+			info.channels.add(cInfo);
+		}
+
+		infoArray.add(info);
+		numRecords++;
+
+		m_dataFileArray.add(dataFile);
+	}
+}
+
+void CompressedFileSource::updateActiveRecord()
+{
+	const File& dataFile = m_dataFileArray[activeRecord.get()];
+	readBlockIndex(dataFile, m_index);
+	m_dataStream = new FileInputStream(dataFile);
+
+	m_encodedBlock.malloc(ContinuousBlockCodec::getMaxEncodedSize(m_index.numChannels, m_index.samplesPerBlock));
+	m_decodedBlock.malloc(size_t(m_index.numChannels) * m_index.samplesPerBlock);
+	m_scratch.malloc(ContinuousBlockCodec::getScratchSize(m_index.samplesPerBlock));
+	m_decodedBlockIndex = -1;
+	m_samplePos = 0;
+}
+
+int CompressedFileSource::findBlock(int64 sample) const
+{
+	int low = 0;
+	int high = m_index.firstSamples.size() - 1;
+	while (low < high)
+	{
+		int mid = (low + high + 1) / 2;
+		if (m_index.firstSamples[mid] <= sample)
+			low = mid;
+		else
+			high = mid - 1;
+	}
+	return low;
+}
+
+bool CompressedFileSource::decodeBlock(int block)
+{
+	if (block == m_decodedBlockIndex)
+		return true;
+
+	m_decodedBlockIndex = -1;
+	if (!m_dataStream || m_dataStream->failedToOpen())
+		return false;
+
+	m_dataStream->setPosition(m_index.offsets[block]);
+	int64 encodedSize = uint32(m_dataStream->readInt());
+	int numSamples = m_dataStream->readInt();
+
+	if (numSamples <= 0 || numSamples > m_index.samplesPerBlock
+		|| encodedSize > int64(ContinuousBlockCodec::getMaxEncodedSize(m_index.numChannels, m_index.samplesPerBlock))
+		|| m_dataStream->read(m_encodedBlock, int(encodedSize)) != encodedSize)
+	{
+		std::cerr << "Invalid compressed block " << block << " in " << m_dataStream->getFile().getFullPathName() << std::endl;
+		return false;
+	}
+
+	if (!ContinuousBlockCodec::decode(m_encodedBlock, size_t(encodedSize), m_index.numChannels, numSamples, m_decodedBlock, m_scratch))
+	{
+		std::cerr << "Corrupted compressed block " << block << " in " << m_dataStream->getFile().getFullPathName() << std::endl;
+		return false;
+	}
+
+	m_decodedBlockIndex = block;
+	return true;
+}
+
+void CompressedFileSource::seekTo(int64 sample)
+{
+	m_samplePos = sample % getActiveNumSamples();
+}
+
+int CompressedFileSource::readData(int16* buffer, int nSamples)
+{
+	int nChans = getActiveNumChannels();
+	int64 samplesToRead;
+
+	if (m_samplePos + nSamples > getActiveNumSamples())
+	{
+		samplesToRead = getActiveNumSamples() - m_samplePos;
+	}
+	else
+	{
+		samplesToRead = nSamples;
+	}
+
+	int64 samplesRead = 0;
+	while (samplesRead < samplesToRead)
+	{
+		int block = findBlock(m_samplePos);
+		int64 blockStart = m_index.firstSamples[block];
+		int64 blockEnd = (block + 1 < m_index.firstSamples.size()) ? m_index.firstSamples[block + 1] : m_index.numSamples;
+		int64 count = jmin(samplesToRead - samplesRead, blockEnd - m_samplePos);
+
+		if (decodeBlock(block))
+			memcpy(buffer + samplesRead * nChans, m_decodedBlock + (m_samplePos - blockStart) * nChans, count * nChans * sizeof(int16));
+		else
+			zeromem(buffer + samplesRead * nChans, count * nChans * sizeof(int16));
+
+		samplesRead += count;
+		m_samplePos += count;
+	}
+
+	return samplesToRead;
+}
+
+void CompressedFileSource::processChannelData(int16* inBuffer, float* outBuffer, int channel, int64 numSamples)
+{
+	int n = getActiveNumChannels();
+	float bitVolts = getChannelInfo(channel).bitVolts;
+
+	for (int i = 0; i < numSamples; i++)
+	{
+		*(outBuffer + i) = *(inBuffer + (n*i) + channel) * bitVolts;
+	}
+}
+
+void CompressedFileSource::processBlockData(int16* inBuffer, float* const* outBuffers, const int* channels, int numChannels, int64 numSamples)
+{
+	convertInterleavedData(inBuffer, outBuffers, channels, numChannels, numSamples);
+}
+
+bool CompressedFileSource::isReady()
+{
+	return true;
+}
@@ -0,0 +1,92 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef COMPRESSEDFILESOURCE_H_INCLUDED
+#define COMPRESSEDFILESOURCE_H_INCLUDED
+
+#include "../FileSource.h"
+
+namespace CompressedSource
+{
+	/**
+		Reads the continuous data of recordings made with the compressed binary format.
+
+		Blocks are located through the index at the end of each continuous.oecz file, or by
+		walking the block headers if the recording was interrupted before it was written.
+		Only the block being read is kept decoded in memory.
+
+		@see CompressedRecording, ContinuousBlockCodec
+	*/
+	class CompressedFileSource : public FileSource
+	{
+	public:
+		CompressedFileSource();
+		~CompressedFileSource();
+
+		int readData(int16* buffer, int nSamples) override;
+
+		void seekTo(int64 sample) override;
+
+		void processChannelData(int16* inBuffer, float* outBuffer, int channel, int64 numSamples) override;
+
+		void processBlockData(int16* inBuffer, float* const* outBuffers, const int* channels, int numChannels, int64 numSamples) override;
+
+		bool isReady() override;
+
+	private:
+		bool Open(File file) override;
+		void fillRecordInfo() override;
+		void updateActiveRecord() override;
+
+		struct BlockIndex
+		{
+			int numChannels;
+			int samplesPerBlock;
+			int64 numSamples;
+			Array<int64> offsets;
+			Array<int64> firstSamples;
+		};
+
+		static bool readBlockIndex(const File& dataFile, BlockIndex& index);
+
+		/** Returns the block that contains a sample */
+		int findBlock(int64 sample) const;
+		bool decodeBlock(int block);
+
+		var m_jsonData;
+		Array<File> m_dataFileArray;
+		File m_rootPath;
+
+		ScopedPointer<FileInputStream> m_dataStream;
+		BlockIndex m_index;
+
+		HeapBlock<uint8> m_encodedBlock;
+		HeapBlock<int16> m_decodedBlock;
+		HeapBlock<int32> m_scratch;
+		int m_decodedBlockIndex;
+
+		int64 m_samplePos;
+	};
+}
+
+#endif
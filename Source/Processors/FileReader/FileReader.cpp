@@ -28,6 +28,9 @@
 #include "../../Audio/AudioComponent.h"
 #include "../PluginManager/PluginManager.h"
 #include "BinaryFileSource/BinaryFileSource.h"
+#include "CompressedFileSource/CompressedFileSource.h"
+
+#include <algorithm>
 
 
 FileReader::FileReader()
@@ -45,6 +48,11 @@ FileReader::FileReader()
     , m_shouldFillBackBuffer(false)
 	, m_bufferSize(1024)
 	, m_sysSampleRate(44100)
+	, m_samplesPerBlock(1024)
+	, m_blockIndex(0)
+	, m_frontBufferStartBlock(0)
+	, m_backBufferStartBlock(0)
+	, eventQueueSize(0)
 {
     setProcessorType (PROCESSOR_TYPE_SOURCE);
 
@@ -54,10 +62,8 @@ FileReader::FileReader()
     const int numFileSources = AccessClass::getPluginManager()->getNumFileSources();
     for (int i = 0; i < numFileSources; ++i)
     {
-        Plugin::FileSourceInfo info = AccessClass::getPluginManager()->getFileSourceInfo (i);
-
         StringArray extensions;
-        extensions.addTokens (info.extensions, ";", "\"");
+        extensions.addTokens (AccessClass::getPluginManager()->getFileSourceExtensions (i), ";", "\"");
 
         const int numExtensions = extensions.size();
         for (int j = 0; j < numExtensions; ++j)
@@ -99,9 +105,76 @@ AudioProcessorEditor* FileReader::createEditor()
 
 void FileReader::createEventChannels()
 {
-    //editor = new FileReaderEditor (this, true);
+    streamEventChannels.clearQuick();
+
+    if (! input)
+        return;
+
+    const int numStreams = input->getNumEventStreams();
+    for (int i = 0; i < numStreams; ++i)
+    {
+        const RecordedEventStream* stream = input->getEventStream (i);
+        EventChannel* chan = nullptr;
+
+        if (stream->getType() == RecordedEventStream::TTL_STREAM)
+        {
+            chan = new EventChannel (EventChannel::TTL, jlimit (1, 64, stream->getNumChannels()), 0, currentSampleRate, this);
+            chan->setIdentifier ("filereader.ttl");
+        }
+        else if (stream->getType() == RecordedEventStream::TEXT_STREAM)
+        {
+            // recorded texts hold the terminating null
+            chan = new EventChannel (EventChannel::TEXT, 1, jmax (1, stream->getDataSize() - 1), currentSampleRate, this);
+            chan->setIdentifier ("filereader.text");
+        }
+
+        if (chan != nullptr)
+        {
+            chan->setName (stream->getName());
+            chan->setDescription ("Events recorded in " + File (input->getFileName()).getFileName());
+            eventChannelArray.add (chan);
+        }
+
+        streamEventChannels.add (chan);
+    }
+}
+
+void FileReader::createSpikeChannels()
+{
+    streamSpikeChannels.clearQuick();
+
+    if (! input)
+        return;
+
+    const int numStreams = input->getNumEventStreams();
+    for (int i = 0; i < numStreams; ++i)
+    {
+        const RecordedEventStream* stream = input->getEventStream (i);
+        const SpikeChannel::ElectrodeTypes type = SpikeChannel::typeFromNumChannels (stream->getNumChannels());
 
-    //return editor;
+        if (stream->getType() != RecordedEventStream::SPIKE_STREAM
+            || type == SpikeChannel::INVALID
+            || dataChannelArray.size() == 0)
+        {
+            streamSpikeChannels.add (-1);
+            continue;
+        }
+
+        streamSpikeChannels.add (spikeChannelArray.size());
+
+        const Array<RecordedElectrodeInfo>& electrodes = stream->getElectrodes();
+        for (int e = 0; e < electrodes.size(); ++e)
+        {
+            Array<const DataChannel*> chans;
+            for (int c = 0; c < electrodes[e].channels.size(); ++c)
+                chans.add (dataChannelArray[jlimit (0, dataChannelArray.size() - 1, electrodes[e].channels[c])]);
+
+            SpikeChannel* spk = new SpikeChannel (type, this, chans);
+            spk->setNumSamples (stream->getPrePeakSamples(), stream->getPostPeakSamples());
+            spk->setName (electrodes[e].name);
+            spikeChannelArray.add (spk);
+        }
+    }
 }
 
 bool FileReader::isReady()
@@ -163,22 +236,46 @@ bool FileReader::enable()
 	m_bufferSize = ads.bufferSize;
 	if (m_bufferSize == 0) m_bufferSize = 1024;
 
-	m_samplesPerBuffer.set(m_bufferSize * (getDefaultSampleRate() / m_sysSampleRate));
+	m_samplesPerBlock = double(m_bufferSize) * getDefaultSampleRate() / m_sysSampleRate;
+	m_blockIndex = 0;
 
-	bufferA.malloc(currentNumChannels * m_bufferSize * BUFFER_WINDOW_CACHE_SIZE);
-	bufferB.malloc(currentNumChannels * m_bufferSize * BUFFER_WINDOW_CACHE_SIZE);
+	const int maxSamplesPerCache = int(std::ceil(m_samplesPerBlock * BUFFER_WINDOW_CACHE_SIZE)) + 1;
+	bufferA.malloc(currentNumChannels * maxSamplesPerCache);
+	bufferB.malloc(currentNumChannels * maxSamplesPerCache);
 
         // reset stream to beginning
         input->seekTo (startSample);
         currentSample = startSample;
-        readAndFillBufferCache(bufferA); // pre-fill the front buffer with a blocking read
+        readAndFillBufferCache(bufferA, 0); // pre-fill the front buffer with a blocking read
 
 	// set the backbuffer so that on the next call to process() we start with bufferA and buffer
 	// cache window id = 0
 	readBuffer = &bufferB;
+	m_backBufferStartBlock = 0;
 	bufferCacheWindow = 0;
 	m_shouldFillBackBuffer.set(false);
 
+	outputChannels.clearQuick();
+	for (int i = 0; i < currentNumChannels; ++i)
+		outputChannels.add(i);
+
+	eventCursors.clearQuick();
+	int maxSpikeSamples = 0;
+
+	for (int i = 0; i < input->getNumEventStreams(); ++i)
+	{
+		const RecordedEventStream* stream = input->getEventStream(i);
+		EventCursor cursor = { i, 0, 0, 0 };
+		eventCursors.add(cursor);
+
+		if (stream->getType() == RecordedEventStream::SPIKE_STREAM)
+			maxSpikeSamples = jmax(maxSpikeSamples, stream->getPrePeakSamples() + stream->getPostPeakSamples());
+	}
+
+	eventQueue.malloc(jmax(1, eventCursors.size()));
+	spikeBuffer.malloc(jmax(1, maxSpikeSamples));
+	seekEventStreams(startSample);
+
 	startThread(); // start async file reader thread
 
 	return isEnabled;
@@ -224,7 +321,8 @@ bool FileReader::setFile (String fullpath)
 		if (index < numPluginFileSources)
 		{
 			Plugin::FileSourceInfo sourceInfo = AccessClass::getPluginManager()->getFileSourceInfo(index);
-			input = sourceInfo.creator();
+			if (sourceInfo.creator != nullptr)
+				input = sourceInfo.creator();
 		}
 		else
 		{
@@ -316,33 +414,38 @@ void FileReader::updateSettings()
 
 void FileReader::process (AudioSampleBuffer& buffer)
 {
-    const int samplesNeededPerBuffer = int (float (buffer.getNumSamples()) * (getDefaultSampleRate() / m_sysSampleRate));
-    m_samplesPerBuffer.set(samplesNeededPerBuffer);
-    // FIXME: needs to account for the fact that the ratio might not be an exact
-    //        integer value
-    
+    // the ratio between the file and the audio device rates is usually not an integer, so the
+    // block size alternates to keep the total number of samples played exact
+    const int64 blockStart = getSamplesBeforeBlock (m_blockIndex);
+    const int samplesNeededPerBuffer = int (getSamplesBeforeBlock (m_blockIndex + 1) - blockStart);
+
     // if cache window id == 0, we need to read and cache BUFFER_WINDOW_CACHE_SIZE more buffer windows
     if (bufferCacheWindow == 0)
     {
         switchBuffer();
     }
+
+    const int64 cacheOffset = blockStart - getSamplesBeforeBlock (m_frontBufferStartBlock);
     
-    for (int i = 0; i < currentNumChannels; ++i)
-    {
-        // offset readBuffer index by current cache window count * buffer window size * num channels
-        input->processChannelData (*readBuffer + (samplesNeededPerBuffer * currentNumChannels * bufferCacheWindow),
-                                   buffer.getWritePointer (i, 0),
-                                   i,
-                                   samplesNeededPerBuffer);
-    }
+    // offset readBuffer index by the samples of the previous windows in the cache * num channels
+    input->processBlockData (*readBuffer + (cacheOffset * currentNumChannels),
+                             buffer.getArrayOfWritePointers(),
+                             outputChannels.getRawDataPointer(),
+                             currentNumChannels,
+                             samplesNeededPerBuffer);
     
     setTimestampAndSamples(timestamp, samplesNeededPerBuffer);
+
+	if (eventCursors.size() > 0)
+		addRecordedEvents(timestamp, samplesNeededPerBuffer);
+
 	timestamp += samplesNeededPerBuffer;
 
 	static_cast<FileReaderEditor*> (getEditor())->setCurrentTime(samplesToMilliseconds(startSample + timestamp % (stopSample - startSample)));
     
     bufferCacheWindow += 1;
     bufferCacheWindow %= BUFFER_WINDOW_CACHE_SIZE;
+    m_blockIndex++;
 }
 
 
@@ -374,6 +477,171 @@ void FileReader::setParameter (int parameterIndex, float newValue)
 }
 
 
+void FileReader::seekEventStreams (int64 filePosition)
+{
+    eventQueueSize = 0;
+
+    for (int i = 0; i < eventCursors.size(); ++i)
+    {
+        EventCursor& cursor = eventCursors.getReference (i);
+        const RecordedEventStream* stream = input->getEventStream (cursor.stream);
+
+        cursor.event = stream->findFirstEvent (filePosition);
+        cursor.ttlWord = 0;
+
+        if (cursor.event < stream->getNumEvents())
+        {
+            cursor.position = stream->getSamplePosition (cursor.event);
+            eventQueue[eventQueueSize++] = i;
+        }
+    }
+
+    std::make_heap (eventQueue.getData(), eventQueue.getData() + eventQueueSize,
+                    [this] (int a, int b) { return isEarlierEvent (b, a); });
+}
+
+
+void FileReader::addRecordedEvents (int64 blockTimestamp, int numSamples)
+{
+    // same mapping from timestamps to file samples as the continuous data, which loops between start and stop
+    int64 position = startSample + blockTimestamp % (stopSample - startSample);
+    int samplesDone = 0;
+
+    while (samplesDone < numSamples)
+    {
+        const int64 end = jmin (stopSample, position + numSamples - samplesDone);
+
+        addEventsInRange (position, end, samplesDone, blockTimestamp);
+        samplesDone += int (end - position);
+
+        if (end == stopSample)
+        {
+            position = startSample;
+            seekEventStreams (startSample);
+        }
+        else
+        {
+            position = end;
+        }
+    }
+}
+
+
+void FileReader::addEventsInRange (int64 from, int64 to, int sampleOffset, int64 blockTimestamp)
+{
+    auto later = [this] (int a, int b) { return isEarlierEvent (b, a); };
+
+    while (eventQueueSize > 0)
+    {
+        const int next = eventQueue[0];
+        EventCursor& cursor = eventCursors.getReference (next);
+
+        if (cursor.position >= to)
+            break;
+
+        std::pop_heap (eventQueue.getData(), eventQueue.getData() + eventQueueSize, later);
+        --eventQueueSize;
+
+        const int sampleNum = sampleOffset + int (jmax (int64 (0), cursor.position - from));
+        addRecordedEvent (cursor, sampleNum, blockTimestamp + sampleNum);
+
+        const RecordedEventStream* stream = input->getEventStream (cursor.stream);
+
+        if (++cursor.event < stream->getNumEvents())
+        {
+            cursor.position = stream->getSamplePosition (cursor.event);
+            eventQueue[eventQueueSize++] = next;
+            std::push_heap (eventQueue.getData(), eventQueue.getData() + eventQueueSize, later);
+        }
+    }
+}
+
+
+void FileReader::addRecordedEvent (EventCursor& cursor, int sampleNum, int64 eventTimestamp)
+{
+    const RecordedEventStream* stream = input->getEventStream (cursor.stream);
+
+    switch (stream->getType())
+    {
+        case RecordedEventStream::TTL_STREAM:
+        {
+            const EventChannel* chan = streamEventChannels[cursor.stream];
+            if (chan == nullptr) return;
+
+            const int16 state = *static_cast<const int16*> (stream->getData (cursor.event));
+            const int line = std::abs (state) - 1;
+            if (line < 0 || line >= int (chan->getNumChannels())) return;
+
+            if (state > 0)
+                cursor.ttlWord |= uint64 (1) << line;
+            else
+                cursor.ttlWord &= ~(uint64 (1) << line);
+
+            TTLEventPtr event = TTLEvent::createTTLEvent (chan, eventTimestamp, &cursor.ttlWord, sizeof (uint64), uint16 (line));
+            if (event) addEvent (chan, event, sampleNum);
+            break;
+        }
+
+        case RecordedEventStream::TEXT_STREAM:
+        {
+            const EventChannel* chan = streamEventChannels[cursor.stream];
+            if (chan == nullptr) return;
+
+            const char* text = static_cast<const char*> (stream->getData (cursor.event));
+            const int maxLength = stream->getDataSize();
+            int length = 0;
+            while (length < maxLength && text[length] != 0)
+                ++length;
+
+            TextEventPtr event = TextEvent::createTextEvent (chan, eventTimestamp, String::fromUTF8 (text, length));
+            if (event) addEvent (chan, event, sampleNum);
+            break;
+        }
+
+        case RecordedEventStream::SPIKE_STREAM:
+        {
+            const int firstChannel = streamSpikeChannels[cursor.stream];
+            const int electrode = stream->getChannel (cursor.event);
+            if (firstChannel < 0 || electrode < 0 || electrode >= stream->getElectrodes().size()) return;
+
+            const SpikeChannel* chan = spikeChannelArray[firstChannel + electrode];
+            const int numChannels = int (chan->getNumChannels());
+            const int numSamples = int (chan->getTotalSamples());
+            const int16* waveform = static_cast<const int16*> (stream->getData (cursor.event));
+            const float bitVolts = stream->getBitVolts();
+
+            SpikeEvent::SpikeBuffer spikeData (chan);
+            Array<float> thresholds;
+
+            for (int c = 0; c < numChannels; ++c)
+            {
+                for (int s = 0; s < numSamples; ++s)
+                    spikeBuffer[s] = waveform[c * numSamples + s] * bitVolts;
+
+                spikeData.set (c, spikeBuffer, numSamples);
+                thresholds.add (0);
+            }
+
+            SpikeEventPtr spike = SpikeEvent::createSpikeEvent (chan, eventTimestamp, thresholds, spikeData, stream->getSortedId (cursor.event));
+            if (spike) addSpike (chan, spike, sampleNum);
+            break;
+        }
+    }
+}
+
+
+bool FileReader::isEarlierEvent (int cursorA, int cursorB) const
+{
+    return eventCursors.getReference (cursorA).position < eventCursors.getReference (cursorB).position;
+}
+
+
+int64 FileReader::getSamplesBeforeBlock (int64 block) const
+{
+    return (int64) std::floor (double (block) * m_samplesPerBlock);
+}
+
+
 unsigned int FileReader::samplesToMilliseconds (int64 samples) const
 {
     return (unsigned int) (1000.f * float (samples) / currentSampleRate);
@@ -391,6 +659,10 @@ void FileReader::switchBuffer()
         readBuffer = &bufferB;
     else
         readBuffer = &bufferA;
+
+    // the new front buffer holds the windows starting at the current block
+    m_frontBufferStartBlock = m_blockIndex;
+    m_backBufferStartBlock = m_blockIndex + BUFFER_WINDOW_CACHE_SIZE;
     
     m_shouldFillBackBuffer.set(true);
     notify();
@@ -414,17 +686,16 @@ void FileReader::run()
     {
         if (m_shouldFillBackBuffer.compareAndSetBool(false, true))
         {
-            readAndFillBufferCache(*getBackBuffer());
+            readAndFillBufferCache(*getBackBuffer(), m_backBufferStartBlock);
         }
         
         wait(30);
     }
 }
 
-void FileReader::readAndFillBufferCache(HeapBlock<int16> &cacheBuffer)
+void FileReader::readAndFillBufferCache(HeapBlock<int16> &cacheBuffer, int64 startBlock)
 {
-    const int samplesNeededPerBuffer = m_samplesPerBuffer.get();
-    const int samplesNeeded = samplesNeededPerBuffer * BUFFER_WINDOW_CACHE_SIZE;
+    const int samplesNeeded = int (getSamplesBeforeBlock (startBlock + BUFFER_WINDOW_CACHE_SIZE) - getSamplesBeforeBlock (startBlock));
     
     int samplesRead = 0;
     
@@ -470,7 +741,7 @@ StringArray FileReader::getSupportedExtensions() const
 
 int FileReader::getNumBuiltInFileSources() const
 {
-	return 1;
+	return 2;
 }
 
 String FileReader::getBuiltInFileSourceExtensions(int index) const
@@ -479,6 +750,8 @@ String FileReader::getBuiltInFileSourceExtensions(int index) const
 	{
 	case 0: //Binary
 		return "oebin";
+	case 1: //Compressed binary
+		return "oecbin";
 	default:
 		return "";
 	}
@@ -490,6 +763,8 @@ FileSource* FileReader::createBuiltInFileSource(int index) const
 	{
 	case 0:
 		return new BinarySource::BinaryFileSource();
+	case 1:
+		return new CompressedSource::CompressedFileSource();
 	default:
 		return nullptr;
 	}
@@ -70,7 +70,8 @@ public:
 
     bool isFileSupported          (const String& filename) const;
     bool isFileExtensionSupported (const String& ext) const;
-    void createEventChannels();
+    void createEventChannels() override;
+    void createSpikeChannels() override;
 	StringArray getSupportedExtensions() const;
 
 private:
@@ -93,6 +94,9 @@ private:
     int64 bufferCacheWindow; // the current buffer window to read from readBuffer
     Array<RecordedChannelInfo> channelInfo;
 
+    /** File channels converted into each output channel */
+    Array<int> outputChannels;
+
     // for testing purposes only
     int counter;
 
@@ -105,11 +109,55 @@ private:
     HashMap<String, int> supportedExtensions;
     
     Atomic<int> m_shouldFillBackBuffer;
-    Atomic<int> m_samplesPerBuffer;
 
 	unsigned int m_bufferSize;
 	float m_sysSampleRate;
+
+	/** File samples played for each audio block. Usually not an integer, so the size of
+	    each block is taken from the exact sample count at the block boundaries */
+	double m_samplesPerBlock;
+	int64 m_blockIndex;
+	int64 m_frontBufferStartBlock;
+	int64 m_backBufferStartBlock;
+
+	/** Returns the number of file samples played before the given block */
+	int64 getSamplesBeforeBlock(int64 block) const;
     
+    /** Position of the playback in a recorded event stream */
+    struct EventCursor
+    {
+        int stream;
+        int64 event;
+        int64 position;     // file sample of the event
+        uint64 ttlWord;
+    };
+
+    /** Event or spike channels the recorded streams are replayed on, one per stream.
+        Spike streams hold the index of their first spike channel, and -1 otherwise */
+    Array<const EventChannel*> streamEventChannels;
+    Array<int> streamSpikeChannels;
+
+    Array<EventCursor> eventCursors;
+
+    /** Min-heap of the cursors that have events left, ordered by the position of their next event */
+    HeapBlock<int> eventQueue;
+    int eventQueueSize;
+
+    HeapBlock<float> spikeBuffer;
+
+    /** Moves every event stream to its first event at or after the given file sample */
+    void seekEventStreams (int64 filePosition);
+
+    /** Adds the recorded events and spikes of the block, following the playback loop */
+    void addRecordedEvents (int64 blockTimestamp, int numSamples);
+
+    /** Adds the events between two file samples, merging the streams in timestamp order */
+    void addEventsInRange (int64 from, int64 to, int sampleOffset, int64 blockTimestamp);
+
+    void addRecordedEvent (EventCursor& cursor, int sampleNum, int64 eventTimestamp);
+
+    bool isEarlierEvent (int cursorA, int cursorB) const;
+
     /** Swaps the backbuffer to the front and flags the background reader
         thread to update the new backbuffer */
     void switchBuffer();
@@ -122,9 +170,10 @@ private:
     
     /** Reads a chunk of the file that fills an entire buffer cache.
      
-        This method will read into the buffer that passed in by the param 
+        This method will read into the buffer that passed in by the param,
+        the samples of BUFFER_WINDOW_CACHE_SIZE blocks starting at startBlock
      */
-    void readAndFillBufferCache(HeapBlock<int16> &cacheBuffer);
+    void readAndFillBufferCache(HeapBlock<int16> &cacheBuffer, int64 startBlock);
 
 	//Methods for built-in file sources
 	int getNumBuiltInFileSources() const;
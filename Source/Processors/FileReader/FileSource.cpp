@@ -23,6 +23,11 @@
 
 #include "FileSource.h"
 
+#if JUCE_INTEL && ! (JUCE_MINGW && ! defined (__SSE2__))
+ #define FILESOURCE_USE_SSE 1
+ #include <emmintrin.h>
+#endif
+
 
 FileSource::FileSource() 
     : fileOpened    (false)
@@ -108,6 +113,11 @@ void FileSource::setActiveRecord (int index)
 {
 //    activeRecord = index;
     activeRecord.set(index);
+
+    activeBitVolts.clearQuick();
+    for (int i = 0; i < getRecordNumChannels (index); ++i)
+        activeBitVolts.add (infoArray[index].channels[i].bitVolts);
+
     updateActiveRecord();
 }
 
@@ -146,3 +156,122 @@ bool FileSource::isReady()
 {
     return true;
 }
+
+
+void FileSource::processBlockData (int16* inBuffer, float* const* outBuffers, const int* channels, int numChannels, int64 numSamples)
+{
+    for (int i = 0; i < numChannels; ++i)
+        processChannelData (inBuffer, outBuffers[i], channels[i], numSamples);
+}
+
+
+void FileSource::convertInterleavedData (const int16* inBuffer, float* const* outBuffers, const int* channels, int numChannels, int64 numSamples) const
+{
+    const int numInterleaved = activeBitVolts.size();
+    const float* gains = activeBitVolts.begin();
+
+    // enough frames to fill about 16 kB, so all the channels are read from L1
+    const int tileSamples = jlimit (8, 256, (8192 / jmax (1, numInterleaved)) & ~7);
+
+    for (int64 start = 0; start < numSamples; start += tileSamples)
+    {
+        const int tileLength = int (jmin (int64 (tileSamples), numSamples - start));
+        const int16* tile = inBuffer + start * numInterleaved;
+
+        int i = 0;
+        while (i < numChannels)
+        {
+            const int first = channels[i];
+
+#if FILESOURCE_USE_SSE
+            // runs of 8 consecutive channels go through an 8x8 transpose: 8 frames become 8 channels
+            bool isRun = i + 8 <= numChannels && first + 8 <= numInterleaved;
+            for (int k = 1; isRun && k < 8; ++k)
+                isRun = channels[i + k] == first + k;
+
+            if (isRun)
+            {
+                __m128 gain[8];
+                for (int k = 0; k < 8; ++k)
+                    gain[k] = _mm_set1_ps (gains[first + k]);
+
+                const int simdLength = tileLength & ~7;
+
+                for (int s = 0; s < simdLength; s += 8)
+                {
+                    const int16* frame = tile + s * numInterleaved + first;
+                    __m128i r[8];
+                    for (int k = 0; k < 8; ++k)
+                        r[k] = _mm_loadu_si128 ((const __m128i*) (frame + k * numInterleaved));
+
+                    const __m128i a0 = _mm_unpacklo_epi16 (r[0], r[1]);
+                    const __m128i a1 = _mm_unpackhi_epi16 (r[0], r[1]);
+                    const __m128i a2 = _mm_unpacklo_epi16 (r[2], r[3]);
+                    const __m128i a3 = _mm_unpackhi_epi16 (r[2], r[3]);
+                    const __m128i a4 = _mm_unpacklo_epi16 (r[4], r[5]);
+                    const __m128i a5 = _mm_unpackhi_epi16 (r[4], r[5]);
+                    const __m128i a6 = _mm_unpacklo_epi16 (r[6], r[7]);
+                    const __m128i a7 = _mm_unpackhi_epi16 (r[6], r[7]);
+
+                    const __m128i b0 = _mm_unpacklo_epi32 (a0, a2);
+                    const __m128i b1 = _mm_unpackhi_epi32 (a0, a2);
+                    const __m128i b2 = _mm_unpacklo_epi32 (a1, a3);
+                    const __m128i b3 = _mm_unpackhi_epi32 (a1, a3);
+                    const __m128i b4 = _mm_unpacklo_epi32 (a4, a6);
+                    const __m128i b5 = _mm_unpackhi_epi32 (a4, a6);
+                    const __m128i b6 = _mm_unpacklo_epi32 (a5, a7);
+                    const __m128i b7 = _mm_unpackhi_epi32 (a5, a7);
+
+                    __m128i c[8];
+                    c[0] = _mm_unpacklo_epi64 (b0, b4);
+                    c[1] = _mm_unpackhi_epi64 (b0, b4);
+                    c[2] = _mm_unpacklo_epi64 (b1, b5);
+                    c[3] = _mm_unpackhi_epi64 (b1, b5);
+                    c[4] = _mm_unpacklo_epi64 (b2, b6);
+                    c[5] = _mm_unpackhi_epi64 (b2, b6);
+                    c[6] = _mm_unpacklo_epi64 (b3, b7);
+                    c[7] = _mm_unpackhi_epi64 (b3, b7);
+
+                    for (int k = 0; k < 8; ++k)
+                    {
+                        // sign-extend to 32 bits by shifting the duplicated values back down
+                        const __m128i low = _mm_srai_epi32 (_mm_unpacklo_epi16 (c[k], c[k]), 16);
+                        const __m128i high = _mm_srai_epi32 (_mm_unpackhi_epi16 (c[k], c[k]), 16);
+
+                        float* out = outBuffers[i + k] + start + s;
+                        _mm_storeu_ps (out, _mm_mul_ps (_mm_cvtepi32_ps (low), gain[k]));
+                        _mm_storeu_ps (out + 4, _mm_mul_ps (_mm_cvtepi32_ps (high), gain[k]));
+                    }
+                }
+
+                for (int k = 0; k < 8; ++k)
+                {
+                    float* out = outBuffers[i + k] + start;
+                    for (int s = simdLength; s < tileLength; ++s)
+                        out[s] = tile[s * numInterleaved + first + k] * gains[first + k];
+                }
+
+                i += 8;
+                continue;
+            }
+#endif
+            float* out = outBuffers[i] + start;
+            for (int s = 0; s < tileLength; ++s)
+                out[s] = tile[s * numInterleaved + first] * gains[first];
+
+            ++i;
+        }
+    }
+}
+
+
+int FileSource::getNumEventStreams() const
+{
+    return eventStreams.size();
+}
+
+
+const RecordedEventStream* FileSource::getEventStream (int index) const
+{
+    return eventStreams[index];
+}
@@ -26,6 +26,7 @@
 
 #include "../../../JuceLibraryCode/JuceHeader.h"
 #include "../PluginManager/OpenEphysPlugin.h"
+#include "RecordedEventStream.h"
 
 
 struct RecordedChannelInfo
@@ -65,11 +66,27 @@ public:
 
     virtual int readData (int16* buffer, int nSamples) = 0;
     virtual void processChannelData (int16* inBuffer, float* outBuffer, int channel, int64 numSamples) = 0;
+
+    /** Converts a block of interleaved samples, as returned by readData, for several channels at once.
+
+        outBuffers holds one destination for each of the numChannels entries of channels. The default
+        calls processChannelData for each channel; sources that only scale by bitVolts can use
+        convertInterleavedData instead, which goes through the block once.
+    */
+    virtual void processBlockData (int16* inBuffer, float* const* outBuffers, const int* channels, int numChannels, int64 numSamples);
     virtual void seekTo (int64 sample) = 0;
 
     virtual bool isReady();
 
+    /** Events and spikes recorded along with the active record */
+    int getNumEventStreams() const;
+    const RecordedEventStream* getEventStream (int index) const;
+
 protected:
+    /** Deinterleaves and scales by the bitVolts of each channel of the active record, in tiles
+        that stay in the cache while every channel is taken out of them */
+    void convertInterleavedData (const int16* inBuffer, float* const* outBuffers, const int* channels, int numChannels, int64 numSamples) const;
+
     struct RecordInfo
     {
         String name;
@@ -84,6 +101,12 @@ protected:
     Atomic<int> activeRecord;       // atomic to protect against threaded data race in FileReader
     String filename;
 
+    /** bitVolts of the channels of the active record */
+    Array<float> activeBitVolts;
+
+    /** Filled by the sources that can replay events, when the active record changes */
+    OwnedArray<RecordedEventStream> eventStreams;
+
 
 private:
     virtual bool Open (File file) = 0;
@@ -0,0 +1,315 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2019 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "RecordedEventStream.h"
+
+#include <algorithm>
+#include <limits>
+
+
+bool RecordedEventStream::Column::open (const File& npyFile)
+{
+    file = nullptr;
+    data = nullptr;
+    numRecords = 0;
+    recordSize = 0;
+
+    if (! npyFile.existsAsFile())
+        return false;
+
+    file = new MemoryMappedFile (npyFile, MemoryMappedFile::readOnly);
+
+    const char* bytes = static_cast<const char*> (file->getData());
+    const int64 fileSize = (int64) file->getSize();
+
+    if (bytes == nullptr || fileSize < 12 || memcmp (bytes, "\x93NUMPY", 6) != 0)
+    {
+        file = nullptr;
+        return false;
+    }
+
+    // version 1 headers have a 16 bit length, later ones a 32 bit length
+    const int64 headerStart = bytes[6] == 1 ? 10 : 12;
+    const int64 headerLength = bytes[6] == 1 ? ByteOrder::littleEndianShort (bytes + 8)
+                                             : ByteOrder::littleEndianInt (bytes + 8);
+
+    if (headerStart + headerLength > fileSize)
+    {
+        file = nullptr;
+        return false;
+    }
+
+    const String header (bytes + headerStart, (size_t) headerLength);
+
+    // descr is a single type such as '<i8' or '|S256', and the record holds every dimension but the first
+    const String descr = header.fromFirstOccurrenceOf ("'descr':", false, false)
+                               .fromFirstOccurrenceOf ("'", false, false)
+                               .upToFirstOccurrenceOf ("'", false, false);
+
+    StringArray shape;
+    shape.addTokens (header.fromFirstOccurrenceOf ("'shape':", false, false)
+                           .fromFirstOccurrenceOf ("(", false, false)
+                           .upToFirstOccurrenceOf (")", false, false), ",", "");
+    shape.trim();
+    shape.removeEmptyStrings();
+
+    recordSize = descr.substring (2).getIntValue();
+
+    for (int i = 1; i < shape.size(); ++i)
+        recordSize *= shape[i].getIntValue();
+
+    if (recordSize <= 0)
+    {
+        file = nullptr;
+        return false;
+    }
+
+    // the record count in the header is only updated when the file is closed, so take it from the size
+    data = bytes + headerStart + headerLength;
+    numRecords = (fileSize - headerStart - headerLength) / recordSize;
+
+    return true;
+}
+
+
+RecordedEventStream::RecordedEventStream (StreamType type_, const String& name_, float sampleRate_, int numChannels_)
+    : type              (type_)
+    , name              (name_)
+    , sampleRate        (sampleRate_)
+    , numChannels       (numChannels_)
+    , numEvents         (0)
+    , firstTimestamp    (0)
+    , prePeakSamples    (0)
+    , postPeakSamples   (0)
+    , bitVolts          (1.0f)
+{
+}
+
+
+RecordedEventStream::~RecordedEventStream()
+{
+}
+
+
+bool RecordedEventStream::open (const File& timestamps, const File& data, const File& channels,
+                                const File& sortedIds, int64 firstTimestamp_)
+{
+    numEvents = 0;
+    firstTimestamp = firstTimestamp_;
+    timestampIndex.clear();
+    eventOrder.free();
+
+    if (! timestampColumn.open (timestamps) || timestampColumn.recordSize != sizeof (int64))
+        return false;
+
+    if (! dataColumn.open (data))
+        return false;
+
+    numEvents = jmin (timestampColumn.numRecords, dataColumn.numRecords);
+
+    // files that were still being written can be one record apart
+    if (channelColumn.open (channels))
+        numEvents = jmin (numEvents, channelColumn.numRecords);
+
+    if (sortedIdColumn.open (sortedIds))
+        numEvents = jmin (numEvents, sortedIdColumn.numRecords);
+
+    numEvents = jmin (numEvents, (int64) std::numeric_limits<uint32>::max());
+
+    const int64* ts = reinterpret_cast<const int64*> (timestampColumn.data);
+
+    // events are recorded in the order they reach the record node, which is not always the
+    // timestamp order. Only then the whole stream is sorted
+    for (int64 i = 1; i < numEvents; ++i)
+    {
+        if (ts[i] < ts[i - 1])
+        {
+            eventOrder.malloc ((size_t) numEvents);
+
+            for (int64 e = 0; e < numEvents; ++e)
+                eventOrder[e] = (uint32) e;
+
+            std::stable_sort (eventOrder.getData(), eventOrder.getData() + numEvents,
+                              [ts] (uint32 a, uint32 b) { return ts[a] < ts[b]; });
+            break;
+        }
+    }
+
+    timestampIndex.ensureStorageAllocated (int (numEvents / indexStride) + 1);
+
+    for (int64 e = 0; e < numEvents; e += indexStride)
+        timestampIndex.add (getTimestamp (e));
+
+    return true;
+}
+
+
+RecordedEventStream::StreamType RecordedEventStream::getType() const
+{
+    return type;
+}
+
+
+String RecordedEventStream::getName() const
+{
+    return name;
+}
+
+
+float RecordedEventStream::getSampleRate() const
+{
+    return sampleRate;
+}
+
+
+int RecordedEventStream::getNumChannels() const
+{
+    return numChannels;
+}
+
+
+int RecordedEventStream::getDataSize() const
+{
+    return dataColumn.recordSize;
+}
+
+
+int64 RecordedEventStream::getNumEvents() const
+{
+    return numEvents;
+}
+
+
+int64 RecordedEventStream::getRecordIndex (int64 event) const
+{
+    return eventOrder != nullptr ? (int64) eventOrder[event] : event;
+}
+
+
+int64 RecordedEventStream::getTimestamp (int64 event) const
+{
+    return *reinterpret_cast<const int64*> (timestampColumn.get (getRecordIndex (event)));
+}
+
+
+int64 RecordedEventStream::getSamplePosition (int64 event) const
+{
+    return getTimestamp (event) - firstTimestamp;
+}
+
+
+const void* RecordedEventStream::getData (int64 event) const
+{
+    return dataColumn.get (getRecordIndex (event));
+}
+
+
+int RecordedEventStream::getChannel (int64 event) const
+{
+    if (channelColumn.data == nullptr)
+        return 0;
+
+    return int (*reinterpret_cast<const uint16*> (channelColumn.get (getRecordIndex (event)))) - 1;
+}
+
+
+uint16 RecordedEventStream::getSortedId (int64 event) const
+{
+    if (sortedIdColumn.data == nullptr)
+        return 0;
+
+    return *reinterpret_cast<const uint16*> (sortedIdColumn.get (getRecordIndex (event)));
+}
+
+
+int64 RecordedEventStream::findFirstEvent (int64 samplePosition) const
+{
+    const int64 target = samplePosition + firstTimestamp;
+
+    // first indexed event at or after the target. The one we look for is in the stride before it
+    const int64* index = timestampIndex.begin();
+    const int bucket = int (std::lower_bound (index, index + timestampIndex.size(), target) - index);
+
+    if (bucket == 0)
+        return 0;
+
+    int64 low = int64 (bucket - 1) * indexStride + 1;
+    int64 high = jmin (numEvents, int64 (bucket) * indexStride);
+
+    while (low < high)
+    {
+        const int64 mid = low + (high - low) / 2;
+
+        if (getTimestamp (mid) < target)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+
+void RecordedEventStream::setSpikeInfo (int prePeakSamples_, int postPeakSamples_, float bitVolts_,
+                                        const Array<RecordedElectrodeInfo>& electrodes_)
+{
+    prePeakSamples = prePeakSamples_;
+    postPeakSamples = postPeakSamples_;
+    bitVolts = bitVolts_;
+    electrodes = electrodes_;
+}
+
+
+int RecordedEventStream::getPrePeakSamples() const
+{
+    return prePeakSamples;
+}
+
+
+int RecordedEventStream::getPostPeakSamples() const
+{
+    return postPeakSamples;
+}
+
+
+float RecordedEventStream::getBitVolts() const
+{
+    return bitVolts;
+}
+
+
+const Array<RecordedElectrodeInfo>& RecordedEventStream::getElectrodes() const
+{
+    return electrodes;
+}
+
+
+int64 RecordedEventStream::readFirstTimestamp (const File& npyFile, int64 defaultValue)
+{
+    Column column;
+
+    if (! column.open (npyFile) || column.recordSize != sizeof (int64) || column.numRecords <= 0)
+        return defaultValue;
+
+    return *reinterpret_cast<const int64*> (column.get (0));
+}
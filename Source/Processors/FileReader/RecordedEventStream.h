@@ -0,0 +1,155 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2019 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef RECORDEDEVENTSTREAM_H_INCLUDED
+#define RECORDEDEVENTSTREAM_H_INCLUDED
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+#include "../PluginManager/OpenEphysPlugin.h"
+
+
+/** Electrode of a recorded spike stream */
+struct RecordedElectrodeInfo
+{
+    String name;
+    Array<int> channels;    // continuous channels of the record the spikes were detected on
+};
+
+
+/**
+    TTL events, text messages or spikes recorded along with a continuous record.
+
+    Every column is a memory-mapped .npy file holding one record per event, so nothing
+    but the timestamp index is kept in memory. The index holds every indexStride-th
+    timestamp: finding the first event at a given sample is a binary search over it,
+    followed by one over a single stride of the mapped timestamps.
+
+    Timestamps are returned as sample positions in the continuous record, counted from
+    its first sample.
+
+    @see FileSource
+*/
+class PLUGIN_API RecordedEventStream
+{
+public:
+    enum StreamType
+    {
+        TTL_STREAM,
+        TEXT_STREAM,
+        SPIKE_STREAM
+    };
+
+    RecordedEventStream (StreamType type, const String& name, float sampleRate, int numChannels);
+    ~RecordedEventStream();
+
+    /** Maps the columns of the stream and builds the timestamp index.
+
+        @param timestamps   int64 timestamp of each event
+        @param data         TTL channel state (int16, +-(channel + 1)), text or spike waveform
+        @param channels     1-based channel or electrode of each event
+        @param sortedIds    sorted unit of each spike. Optional
+        @param firstTimestamp timestamp of the first sample of the continuous record
+    */
+    bool open (const File& timestamps, const File& data, const File& channels,
+               const File& sortedIds, int64 firstTimestamp);
+
+    StreamType getType()    const;
+    String getName()        const;
+    float getSampleRate()   const;
+
+    /** TTL lines for TTL streams, one for text streams, channels per electrode for spikes */
+    int getNumChannels()    const;
+
+    /** Size in bytes of the data of one event */
+    int getDataSize()       const;
+
+    int64 getNumEvents()    const;
+
+    /** Events are numbered in timestamp order, even if they were not recorded that way */
+    int64 getSamplePosition (int64 event) const;
+    const void* getData     (int64 event) const;
+    int getChannel          (int64 event) const;
+    uint16 getSortedId      (int64 event) const;
+
+    /** Returns the first event at or after the given sample position, or getNumEvents() if there is none */
+    int64 findFirstEvent (int64 samplePosition) const;
+
+    /** Spike streams only */
+    void setSpikeInfo (int prePeakSamples, int postPeakSamples, float bitVolts,
+                       const Array<RecordedElectrodeInfo>& electrodes);
+
+    int getPrePeakSamples()  const;
+    int getPostPeakSamples() const;
+    float getBitVolts()      const;
+
+    const Array<RecordedElectrodeInfo>& getElectrodes() const;
+
+    /** Returns the first value of an int64 .npy file, such as the timestamps of a continuous record */
+    static int64 readFirstTimestamp (const File& npyFile, int64 defaultValue);
+
+    static const int indexStride = 1024;
+
+private:
+    /** Memory-mapped .npy file */
+    struct Column
+    {
+        bool open (const File& file);
+        const char* get (int64 record) const { return data + record * recordSize; }
+
+        ScopedPointer<MemoryMappedFile> file;
+        const char* data = nullptr;
+        int64 numRecords = 0;
+        int recordSize = 0;
+    };
+
+    int64 getRecordIndex (int64 event) const;
+    int64 getTimestamp (int64 event) const;
+
+    const StreamType type;
+    const String name;
+    const float sampleRate;
+    const int numChannels;
+
+    Column timestampColumn;
+    Column dataColumn;
+    Column channelColumn;
+    Column sortedIdColumn;
+
+    int64 numEvents;
+    int64 firstTimestamp;
+
+    Array<int64> timestampIndex;
+
+    /** Recording order of the events, only if they were not recorded in timestamp order */
+    HeapBlock<uint32> eventOrder;
+
+    int prePeakSamples;
+    int postPeakSamples;
+    float bitVolts;
+    Array<RecordedElectrodeInfo> electrodes;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RecordedEventStream);
+};
+
+
+#endif  // RECORDEDEVENTSTREAM_H_INCLUDED
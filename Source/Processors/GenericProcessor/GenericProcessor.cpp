@@ -23,6 +23,7 @@
 #include "GenericProcessor.h"
 #include "../../UI/UIComponent.h"
 #include "../../AccessClass.h"
+#include "../../Utils/LatencyProbe.h"
 
 #include <exception>
 
@@ -784,7 +785,12 @@ int GenericProcessor::checkForEvents(bool checkForSpikes)
 			{
 				int eventIndex = getEventChannelIndex(index, sourceId, subProc);
 				if (eventIndex >= 0)
+				{
+					if (LatencyProbe::isEnabled())
+						LatencyProbe::markTimestamp(LatencyProbe::EVENT_DISPATCHED, EventBase::getTimestamp(message));
+
 					handleEvent(eventChannelArray[eventIndex], message, samplePosition);
+				}
 			}
 			else if (EventBase::getBaseType(message) == EventType::SYSTEM_EVENT && SystemEvent::getSystemEventType(message) == SystemEventType::TIMESTAMP_SYNC_TEXT)
 			{
@@ -794,7 +800,7 @@ int GenericProcessor::checkForEvents(bool checkForSpikes)
 			{
 				int spikeIndex = getSpikeChannelIndex(index, sourceId, subProc);
 				if (spikeIndex >= 0)
-					handleSpike(spikeChannelArray[index], message, samplePosition);
+					handleSpike(spikeChannelArray[spikeIndex], message, samplePosition);
 			}
 		}
 		//Restore the original buffer pointer and, if some new event has been added here, copy it to the original buffer
@@ -828,7 +834,7 @@ void GenericProcessor::addSpike(int channelIndex, const SpikeEvent* event, int s
 
 void GenericProcessor::addSpike(const SpikeChannel* channel, const SpikeEvent* event, int sampleNum)
 {
-	size_t size = channel->getDataSize() + channel->getTotalEventMetaDataSize() + SPIKE_BASE_SIZE + channel->getNumChannels()*sizeof(float);
+	size_t size = channel->getSerializedDataSize() + channel->getTotalEventMetaDataSize() + SPIKE_BASE_SIZE + channel->getNumChannels()*sizeof(float);
 	HeapBlock<char> buffer(size);
 	event->serialize(buffer, size);
 	m_currentMidiBuffer->addEvent(buffer, size, sampleNum >= 0 ? sampleNum : 0);
@@ -31,6 +31,7 @@
 #include "PluginManager.h"
 #include "../../UI/ProcessorList.h"
 #include "../../UI/ControlPanel.h"
+#include "../../CoreServices.h"
 
 
 static inline void closeHandle(decltype(LoadedLibInfo::handle) handle) {
@@ -71,6 +72,7 @@ static void errorMsg(const char *file, int line, const char *msg) {
 
 
 PluginManager::PluginManager()
+	: manifest("PLUGINMANIFEST")
 {
 #ifdef WIN32
 	//Shared directory at the same level as executable
@@ -95,6 +97,8 @@ PluginManager::PluginManager()
 
 PluginManager::~PluginManager()
 {
+	if (prefetchThread != nullptr)
+		prefetchThread->stopThread(-1);
 }
 
 
@@ -113,6 +117,8 @@ void PluginManager::loadAllPlugins()
 	paths.add(File::getSpecialLocation(File::userApplicationDataDirectory).getChildFile(".open-ephys/plugins"));	
 #endif
 
+	loadManifest();
+
     for (auto &pluginPath : paths) {
         if (!pluginPath.isDirectory()) {
             std::cout << "Plugin path not found: " << pluginPath.getFullPathName() 
@@ -122,6 +128,8 @@ void PluginManager::loadAllPlugins()
             loadPlugins(pluginPath);
         }
     }
+
+	saveManifest();
 }
 
 void PluginManager::loadPlugins(const File &pluginPath) {
@@ -144,7 +152,7 @@ void PluginManager::loadPlugins(const File &pluginPath) {
 	for (int i = 0; i < foundDLLs.size(); i++)
 	{
 		std::cout << "Loading Plugin: " << foundDLLs[i].getFileNameWithoutExtension() << "... " << std::flush;
-		int res = loadPlugin(foundDLLs[i].getFullPathName());
+		int res = addLibrary(foundDLLs[i]);
 		if (res < 0)
 		{
 			std::cout << " DLL Load FAILED" << std::endl;
@@ -156,6 +164,12 @@ void PluginManager::loadPlugins(const File &pluginPath) {
 	}
 }
 
+int PluginManager::loadPlugin(const String& pluginLoc) {
+	int res = addLibrary(File(pluginLoc));
+	saveManifest();
+	return res;
+}
+
 /*
 	 Takes the user-specified plugin and begins
 	 dynamic loading process. We want to ensure that
@@ -164,7 +178,7 @@ void PluginManager::loadPlugins(const File &pluginPath) {
 	 and works inside the same POSIX thread as the GUI.
  */
 
-int PluginManager::loadPlugin(const String& pluginLoc) {
+static decltype(LoadedLibInfo::handle) openLibrary(const String& pluginLoc) {
 	/*
 	Load in the selected processor. This takes the
 	dynamic object (.so) and copies it into RAM
@@ -200,10 +214,15 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 
 	if (!handle) {
 		ERROR_MSG("Failed to load plugin DLL");
-		closeHandle(handle);
-		return -1;
 	}
 
+	return handle;
+}
+
+/* Looks up the two functions every plugin library exports, and checks the API version */
+static bool getLibraryFunctions(decltype(LoadedLibInfo::handle) handle, const String& pluginLoc,
+	Plugin::LibraryInfo& libInfo, PluginInfoFunction& piFunction)
+{
 	LibraryInfoFunction infoFunction = 0;
 #ifdef WIN32
 	infoFunction = (LibraryInfoFunction)GetProcAddress(handle, "getLibInfo");
@@ -217,21 +236,18 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 	if (!infoFunction)
 	{
 		ERROR_MSG("Failed to load function 'getLibInfo'");
-		closeHandle(handle);
-		return -1;
+		return false;
 	}
 
-	Plugin::LibraryInfo libInfo;
 	infoFunction(&libInfo);
 
 	if (libInfo.apiVersion != PLUGIN_API_VER)
 	{
 		std::cerr << pluginLoc << " invalid version" << std::endl;
-		closeHandle(handle);
-		return -1;
+		return false;
 	}
 
-	PluginInfoFunction piFunction = 0;
+	piFunction = 0;
 #ifdef WIN32
 	piFunction = (PluginInfoFunction)GetProcAddress(handle, "getPluginInfo");
 #elif defined(__APPLE__)
@@ -244,80 +260,375 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 	if (!piFunction)
 	{
         ERROR_MSG("Failed to load function 'getPluginInfo'");
-		closeHandle(handle);
-		return -1;
+		return false;
 	}
 
-	LoadedLibInfo lib;
-	lib.apiVersion = libInfo.apiVersion;
-	lib.name = libInfo.name;
-	lib.libVersion = libInfo.libVersion;
-	lib.numPlugins = libInfo.numPlugins;
-	lib.handle = handle;
+	return true;
+}
 
-	libArray.add(lib);
+XmlElement* PluginManager::scanLibrary(const File& file, decltype(LoadedLibInfo::handle)& handle)
+{
+	const String pluginLoc = file.getFullPathName();
+
+	handle = openLibrary(pluginLoc);
+
+	if (!handle)
+		return nullptr;
+
+	Plugin::LibraryInfo libInfo;
+	PluginInfoFunction piFunction;
+
+	if (!getLibraryFunctions(handle, pluginLoc, libInfo, piFunction))
+	{
+		closeHandle(handle);
+		handle = 0;
+		return nullptr;
+	}
+
+	XmlElement* entry = new XmlElement("LIBRARY");
+	entry->setAttribute("path", pluginLoc);
+	entry->setAttribute("modified", String(file.getLastModificationTime().toMilliseconds()));
+	entry->setAttribute("size", String(file.getSize()));
+	entry->setAttribute("name", String::fromUTF8(libInfo.name));
+	entry->setAttribute("libVersion", libInfo.libVersion);
+	entry->setAttribute("numPlugins", libInfo.numPlugins);
 
 	Plugin::PluginInfo pInfo;
-	for (int i = 0; i < lib.numPlugins; i++)
+	for (int i = 0; i < libInfo.numPlugins; i++)
 	{
 		if (piFunction(i, &pInfo)) //if somehow there are less plugins than stated, stop adding
 			break;
+
+		XmlElement* plugin = entry->createNewChildElement("PLUGIN");
+		plugin->setAttribute("type", (int)pInfo.type);
+
 		switch (pInfo.type)
 		{
+		case Plugin::PLUGIN_TYPE_PROCESSOR:
+			plugin->setAttribute("name", String::fromUTF8(pInfo.processor.name));
+			plugin->setAttribute("processorType", (int)pInfo.processor.type);
+			break;
+		case Plugin::PLUGIN_TYPE_RECORD_ENGINE:
+			plugin->setAttribute("name", String::fromUTF8(pInfo.recordEngine.name));
+			break;
+		case Plugin::PLUGIN_TYPE_DATA_THREAD:
+			plugin->setAttribute("name", String::fromUTF8(pInfo.dataThread.name));
+			break;
+		case Plugin::PLUGIN_TYPE_FILE_SOURCE:
+			plugin->setAttribute("name", String::fromUTF8(pInfo.fileSource.name));
+			plugin->setAttribute("extensions", String::fromUTF8(pInfo.fileSource.extensions));
+			break;
+		default:
+			std::cerr << pluginLoc << " invalid plugin type: " << pInfo.type << std::endl;
+			entry->removeChildElement(plugin, true);
+			break;
+		}
+	}
+
+	return entry;
+}
+
+int PluginManager::addLibrary(const File& file)
+{
+	const String pluginLoc = file.getFullPathName();
+	const String modified = String(file.getLastModificationTime().toMilliseconds());
+	const String size = String(file.getSize());
+
+	decltype(LoadedLibInfo::handle) handle = 0;
+	XmlElement* entry = nullptr;
+
+	// The manifest is keyed by path, modification time and size, so a rebuilt or updated library is scanned again
+	if (cachedManifest != nullptr)
+	{
+		forEachXmlChildElementWithTagName(*cachedManifest, cached, "LIBRARY")
+		{
+			if (cached->getStringAttribute("path") == pluginLoc
+				&& cached->getStringAttribute("modified") == modified
+				&& cached->getStringAttribute("size") == size)
+			{
+				entry = new XmlElement(*cached);
+				break;
+			}
+		}
+	}
+
+	if (entry == nullptr)
+	{
+		entry = scanLibrary(file, handle);
+
+		if (entry == nullptr)
+			return -1;
+	}
+
+	// A library installed again replaces its old entry
+	forEachXmlChildElementWithTagName(manifest, previous, "LIBRARY")
+	{
+		if (previous->getStringAttribute("path") == pluginLoc)
+		{
+			manifest.removeChildElement(previous, true);
+			break;
+		}
+	}
+
+	manifest.addChildElement(entry);
+
+	const ScopedLock sl(libraryLock);
+
+	LoadedLibInfo lib;
+	lib.path = pluginLoc;
+	lib.libName = entry->getStringAttribute("name");
+	lib.name = lib.libName.toRawUTF8();
+	lib.apiVersion = PLUGIN_API_VER;
+	lib.libVersion = entry->getIntAttribute("libVersion");
+	lib.numPlugins = entry->getIntAttribute("numPlugins");
+	lib.handle = handle;
+
+	libArray.add(lib);
+
+	const int libIndex = libArray.size() - 1;
+
+	forEachXmlChildElementWithTagName(*entry, plugin, "PLUGIN")
+	{
+		const String name = plugin->getStringAttribute("name");
+
+		switch (plugin->getIntAttribute("type"))
+		{
 		case Plugin::PLUGIN_TYPE_PROCESSOR:
 		{
 			LoadedPluginInfo<Plugin::ProcessorInfo> info;
-			info.creator = pInfo.processor.creator;
-			info.name = pInfo.processor.name;
-			info.type = pInfo.processor.type;
-			info.libIndex = libArray.size()-1;
-			Plugin::ProcessorInfo pi = getProcessorInfo(String::fromUTF8(info.name));
-			if(pi.name == nullptr)
+			info.pluginName = name;
+			info.name = info.pluginName.toRawUTF8();
+			info.creator = nullptr;
+			info.type = (Plugin::ProcessorType)plugin->getIntAttribute("processorType");
+			info.libIndex = libIndex;
+			if (findPluginIndex(name, String::empty, processorPlugins) < 0)
 				processorPlugins.add(info);
 			break;
 		}
 		case Plugin::PLUGIN_TYPE_RECORD_ENGINE:
 		{
 			LoadedPluginInfo<Plugin::RecordEngineInfo> info;
-			info.creator = pInfo.recordEngine.creator;
-			info.name = pInfo.recordEngine.name;
-			info.libIndex = libArray.size() - 1;
-			Plugin::RecordEngineInfo rei = getRecordEngineInfo(String::fromUTF8(info.name));
-			if(rei.name == nullptr)
+			info.pluginName = name;
+			info.name = info.pluginName.toRawUTF8();
+			info.creator = nullptr;
+			info.libIndex = libIndex;
+			if (findPluginIndex(name, String::empty, recordEnginePlugins) < 0)
 				recordEnginePlugins.add(info);
 			break;
 		}
 		case Plugin::PLUGIN_TYPE_DATA_THREAD:
 		{
 			LoadedPluginInfo<Plugin::DataThreadInfo> info;
-			info.creator = pInfo.dataThread.creator;
-			info.name = pInfo.dataThread.name;
-			info.libIndex = libArray.size() - 1;
-			Plugin::DataThreadInfo dti = getDataThreadInfo(String::fromUTF8(info.name));
-			if(dti.name == nullptr)
+			info.pluginName = name;
+			info.name = info.pluginName.toRawUTF8();
+			info.creator = nullptr;
+			info.libIndex = libIndex;
+			if (findPluginIndex(name, String::empty, dataThreadPlugins) < 0)
 				dataThreadPlugins.add(info);
 			break;
 		}
 		case Plugin::PLUGIN_TYPE_FILE_SOURCE:
 		{
 			LoadedPluginInfo<Plugin::FileSourceInfo> info;
-			info.creator = pInfo.fileSource.creator;
-			info.name = pInfo.fileSource.name;
-			info.extensions = pInfo.fileSource.extensions;
-			info.libIndex = libArray.size();
-			Plugin::FileSourceInfo fsi = getFileSourceInfo(String::fromUTF8(info.name));
-			if(fsi.name == nullptr)
+			info.pluginName = name;
+			info.name = info.pluginName.toRawUTF8();
+			info.pluginExtensions = plugin->getStringAttribute("extensions");
+			info.extensions = info.pluginExtensions.toRawUTF8();
+			info.creator = nullptr;
+			info.libIndex = libIndex;
+			if (findPluginIndex(name, String::empty, fileSourcePlugins) < 0)
 				fileSourcePlugins.add(info);
 			break;
 		}
 		default:
+			break;
+		}
+	}
+
+	// A library that had to be scanned is already loaded
+	if (handle)
+	{
+		Plugin::LibraryInfo libInfo;
+		PluginInfoFunction piFunction;
+		getLibraryFunctions(handle, pluginLoc, libInfo, piFunction);
+		bindPlugins(libIndex, piFunction);
+	}
+
+	return lib.numPlugins;
+}
+
+bool PluginManager::loadLibrary(int libIndex) const
+{
+	const ScopedLock sl(libraryLock);
+
+	if (libIndex < 0 || libIndex >= libArray.size())
+		return false;
+
+	LoadedLibInfo& lib = libArray.getReference(libIndex);
+
+	if (lib.handle)
+		return true;
+
+	std::cout << "Loading Plugin library: " << lib.libName << std::endl;
+
+	decltype(LoadedLibInfo::handle) handle = openLibrary(lib.path);
+
+	if (!handle)
+		return false;
+
+	Plugin::LibraryInfo libInfo;
+	PluginInfoFunction piFunction;
+
+	if (!getLibraryFunctions(handle, lib.path, libInfo, piFunction)
+		|| lib.libName != String::fromUTF8(libInfo.name))
+	{
+		std::cerr << lib.path << " doesn't match the plugin manifest" << std::endl;
+		closeHandle(handle);
+		return false;
+	}
+
+	lib.handle = handle;
+	bindPlugins(libIndex, piFunction);
+
+	return true;
+}
+
+template<class T, class Creator>
+static void bindPlugin(Array<LoadedPluginInfo<T>>& pluginArray, int libIndex, const char* name, Creator creator)
+{
+	for (int i = 0; i < pluginArray.size(); i++)
+	{
+		LoadedPluginInfo<T>& info = pluginArray.getReference(i);
+
+		if (info.libIndex == libIndex && info.pluginName == String::fromUTF8(name))
+			info.creator = creator;
+	}
+}
+
+void PluginManager::bindPlugins(int libIndex, PluginInfoFunction piFunction) const
+{
+	Plugin::PluginInfo pInfo;
+	for (int i = 0; i < libArray[libIndex].numPlugins; i++)
+	{
+		if (piFunction(i, &pInfo))
+			break;
+
+		switch (pInfo.type)
 		{
-			std::cerr << pluginLoc << " invalid plugin type: " << pInfo.type << std::endl;
+		case Plugin::PLUGIN_TYPE_PROCESSOR:
+			bindPlugin(processorPlugins, libIndex, pInfo.processor.name, pInfo.processor.creator);
+			break;
+		case Plugin::PLUGIN_TYPE_RECORD_ENGINE:
+			bindPlugin(recordEnginePlugins, libIndex, pInfo.recordEngine.name, pInfo.recordEngine.creator);
+			break;
+		case Plugin::PLUGIN_TYPE_DATA_THREAD:
+			bindPlugin(dataThreadPlugins, libIndex, pInfo.dataThread.name, pInfo.dataThread.creator);
+			break;
+		case Plugin::PLUGIN_TYPE_FILE_SOURCE:
+			bindPlugin(fileSourcePlugins, libIndex, pInfo.fileSource.name, pInfo.fileSource.creator);
+			break;
+		default:
 			break;
 		}
+	}
+}
+
+static File getManifestFile()
+{
+	return CoreServices::getSavedStateDirectory().getChildFile("pluginManifest.xml");
+}
+
+void PluginManager::loadManifest()
+{
+	cachedManifest = XmlDocument::parse(getManifestFile());
+
+	// Entries written for another plugin API can't be trusted
+	if (cachedManifest != nullptr
+		&& (!cachedManifest->hasTagName("PLUGINMANIFEST")
+			|| cachedManifest->getIntAttribute("apiVersion") != PLUGIN_API_VER))
+	{
+		cachedManifest = nullptr;
+	}
+}
+
+void PluginManager::saveManifest()
+{
+	manifest.setAttribute("apiVersion", PLUGIN_API_VER);
+
+	if (cachedManifest != nullptr && manifest.isEquivalentTo(cachedManifest, false))
+		return;
+
+	if (!manifest.writeToFile(getManifestFile(), String::empty))
+	{
+		std::cout << "Error! Couldn't write the plugin manifest" << std::endl;
+		return;
+	}
+
+	cachedManifest = new XmlElement(manifest);
+}
+
+class PluginManager::PrefetchThread : public Thread
+{
+public:
+	PrefetchThread(const PluginManager& pm, const Array<int>& libraries)
+		: Thread("Plugin prefetch"), pluginManager(pm), libIndices(libraries)
+	{
+	}
+
+	void run() override
+	{
+		for (int i = 0; i < libIndices.size() && !threadShouldExit(); i++)
+			pluginManager.loadLibrary(libIndices[i]);
+	}
+
+private:
+	const PluginManager& pluginManager;
+	Array<int> libIndices;
+};
+
+void PluginManager::prefetchPlugins(const File& configFile)
+{
+	ScopedPointer<XmlElement> config = XmlDocument::parse(configFile);
+
+	if (config == nullptr)
+		return;
+
+	// A previous prefetch may still be loading libraries, so it is finished before the
+	// handles are looked at
+	if (prefetchThread != nullptr)
+		prefetchThread->stopThread(-1);
+
+	Array<int> libIndices;
+
+	// Processors can be nested in splitters and mergers, so the whole tree is searched
+	Array<XmlElement*> elements;
+	elements.add(config);
+
+	for (int i = 0; i < elements.size(); i++)
+	{
+		forEachXmlChildElement(*elements[i], child)
+		{
+			elements.add(child);
+		}
+
+		if (!elements[i]->hasTagName("PROCESSOR")
+			|| elements[i]->getIntAttribute("pluginType", Plugin::NOT_A_PLUGIN_TYPE) == Plugin::NOT_A_PLUGIN_TYPE)
+			continue;
+
+		const String libName = elements[i]->getStringAttribute("libraryName");
+
+		for (int lib = 0; lib < libArray.size(); lib++)
+		{
+			if (libArray[lib].libName.equalsIgnoreCase(libName) && !libArray[lib].handle)
+				libIndices.addIfNotAlreadyThere(lib);
 		}
 	}
-	return lib.numPlugins;
+
+	if (libIndices.size() == 0)
+		return;
+
+	prefetchThread = new PrefetchThread(*this, libIndices);
+	prefetchThread->startThread();
 }
 
 int PluginManager::getNumProcessors() const
@@ -342,62 +653,100 @@ int PluginManager::getNumFileSources() const
 
 Plugin::ProcessorInfo PluginManager::getProcessorInfo(int index) const
 {
-	if (index < processorPlugins.size())
+	if (index >= 0 && index < processorPlugins.size())
+	{
+		loadLibrary(processorPlugins[index].libIndex);
+		const ScopedLock sl(libraryLock);
 		return processorPlugins[index];
+	}
 	else
 		return getEmptyProcessorInfo();
 }
 
 Plugin::DataThreadInfo PluginManager::getDataThreadInfo(int index) const
 {
-	if (index < dataThreadPlugins.size())
+	if (index >= 0 && index < dataThreadPlugins.size())
+	{
+		loadLibrary(dataThreadPlugins[index].libIndex);
+		const ScopedLock sl(libraryLock);
 		return dataThreadPlugins[index];
+	}
 	else
 		return getEmptyDatathreadInfo();
 }
 
 Plugin::RecordEngineInfo PluginManager::getRecordEngineInfo(int index) const
 {
-	if (index < recordEnginePlugins.size())
+	if (index >= 0 && index < recordEnginePlugins.size())
+	{
+		loadLibrary(recordEnginePlugins[index].libIndex);
+		const ScopedLock sl(libraryLock);
 		return recordEnginePlugins[index];
+	}
 	else 
 		return getEmptyRecordengineInfo();
 }
 
 Plugin::FileSourceInfo PluginManager::getFileSourceInfo(int index) const
 {
-	if (index < fileSourcePlugins.size())
+	if (index >= 0 && index < fileSourcePlugins.size())
+	{
+		loadLibrary(fileSourcePlugins[index].libIndex);
+		const ScopedLock sl(libraryLock);
 		return fileSourcePlugins[index];
+	}
 	else
 		return getEmptyFileSourceInfo();
 }
 
 Plugin::ProcessorInfo PluginManager::getProcessorInfo(String name, String libName) const
 {
-	Plugin::ProcessorInfo i = getEmptyProcessorInfo();
-	findPlugin<Plugin::ProcessorInfo>(name, libName, processorPlugins, i);
-	return i;
+	return getProcessorInfo(findPluginIndex(name, libName, processorPlugins));
 }
 
 Plugin::DataThreadInfo PluginManager::getDataThreadInfo(String name, String libName) const
 {
-	Plugin::DataThreadInfo i = getEmptyDatathreadInfo();
-	findPlugin<Plugin::DataThreadInfo>(name, libName, dataThreadPlugins, i);
-	return i;
+	return getDataThreadInfo(findPluginIndex(name, libName, dataThreadPlugins));
 }
 
 Plugin::RecordEngineInfo PluginManager::getRecordEngineInfo(String name, String libName) const
 {
-	Plugin::RecordEngineInfo i = getEmptyRecordengineInfo();
-	findPlugin<Plugin::RecordEngineInfo>(name, libName, recordEnginePlugins, i);
-	return i;
+	return getRecordEngineInfo(findPluginIndex(name, libName, recordEnginePlugins));
 }
 
 Plugin::FileSourceInfo PluginManager::getFileSourceInfo(String name, String libName) const
 {
-	Plugin::FileSourceInfo i = getEmptyFileSourceInfo();
-	findPlugin<Plugin::FileSourceInfo>(name, libName, fileSourcePlugins, i);
-	return i;
+	return getFileSourceInfo(findPluginIndex(name, libName, fileSourcePlugins));
+}
+
+String PluginManager::getPluginName(Plugin::PluginType type, int index) const
+{
+	switch (type)
+	{
+		case Plugin::PLUGIN_TYPE_PROCESSOR:
+			return processorPlugins[index].pluginName;
+		case Plugin::PLUGIN_TYPE_RECORD_ENGINE:
+			return recordEnginePlugins[index].pluginName;
+		case Plugin::PLUGIN_TYPE_DATA_THREAD:
+			return dataThreadPlugins[index].pluginName;
+		case Plugin::PLUGIN_TYPE_FILE_SOURCE:
+			return fileSourcePlugins[index].pluginName;
+		default:
+			return String::empty;
+	}
+}
+
+Plugin::ProcessorType PluginManager::getProcessorType(int index) const
+{
+	if (index >= 0 && index < processorPlugins.size())
+		return processorPlugins[index].type;
+	else
+		return Plugin::InvalidProcessor;
+}
+
+String PluginManager::getFileSourceExtensions(int index) const
+{
+	return fileSourcePlugins[index].pluginExtensions;
 }
 
 String PluginManager::getLibraryName(int index) const
@@ -405,7 +754,7 @@ String PluginManager::getLibraryName(int index) const
 	if (index < 0 || index >= libArray.size())
 		return String::empty;
 	else
-		return libArray[index].name;
+		return libArray[index].libName;
 }
 
 int PluginManager::getLibraryVersion(int index) const
@@ -467,21 +816,17 @@ Plugin::FileSourceInfo PluginManager::getEmptyFileSourceInfo()
 }
 
 template<class T>
-bool PluginManager::findPlugin(String name, String libName, const Array<LoadedPluginInfo<T>>& pluginArray, T& pluginInfo) const
+int PluginManager::findPluginIndex(String name, String libName, const Array<LoadedPluginInfo<T>>& pluginArray) const
 {
 	for (int i = 0; i < pluginArray.size(); i++)
 	{
-		String pName = String(pluginArray[i].name);
-		if (pName == name)
+		if (pluginArray[i].pluginName == name)
 		{
-			if ((libName.isEmpty()) || (libName == String(libArray[pluginArray[i].libIndex].name)))
-			{
-				pluginInfo = pluginArray[i];
-				return true;
-			}
+			if ((libName.isEmpty()) || (libName == libArray[pluginArray[i].libIndex].libName))
+				return i;
 		}
 	}
-	return false;
+	return -1;
 }
 
 
@@ -39,6 +39,8 @@
 
 struct LoadedLibInfo : public Plugin::LibraryInfo
 {
+	String path;
+	String libName; //owns the text of name, as the library is only loaded when one of its plugins is used
 #ifdef WIN32
 	HINSTANCE handle;
 #elif defined(__APPLE__)
@@ -52,6 +54,8 @@ template<class T>
 struct LoadedPluginInfo : public T
 {
 	int libIndex;
+	String pluginName; //owns the text of name
+	String pluginExtensions; //owns the text of extensions, for file sources
 };
 
 
@@ -79,19 +83,58 @@ public:
 	Plugin::RecordEngineInfo getRecordEngineInfo(String name, String libName = String::empty) const;
 	Plugin::FileSourceInfo getFileSourceInfo(int index) const;
 	Plugin::FileSourceInfo getFileSourceInfo(String name, String libName = String::empty) const;
+
+	/** The info getters above load the library of the plugin the first time it is needed,
+	so its creator can be used. These only look at the plugin manifest */
+	String getPluginName(Plugin::PluginType type, int index) const;
+	Plugin::ProcessorType getProcessorType(int index) const;
+	String getFileSourceExtensions(int index) const;
+
+	/** Starts loading, on a background thread, the libraries of the plugins used by a saved configuration */
+	void prefetchPlugins(const File& configFile);
+
 	String getLibraryName(int index) const;
 	int getLibraryVersion(int index) const;
 	int getLibraryIndexFromPlugin(Plugin::PluginType type, int index);
 
 private:
-	Array<LoadedLibInfo> libArray;
-	Array<LoadedPluginInfo<Plugin::ProcessorInfo>> processorPlugins;
-	Array<LoadedPluginInfo<Plugin::DataThreadInfo>> dataThreadPlugins;
-	Array<LoadedPluginInfo<Plugin::RecordEngineInfo>> recordEnginePlugins;
-	Array<LoadedPluginInfo<Plugin::FileSourceInfo>> fileSourcePlugins;
+	class PrefetchThread;
+
+	/** Registers the plugins of a library, from the manifest cache if the file hasn't changed since
+	it was last scanned, or by loading the library otherwise */
+	int addLibrary(const File& file);
+
+	/** Loads a library and reads its plugin info into a manifest entry. Returns nullptr on failure */
+	XmlElement* scanLibrary(const File& file, decltype(LoadedLibInfo::handle)& handle);
+
+	/** Loads a registered library, if it isn't loaded yet, and binds the creators of its plugins */
+	bool loadLibrary(int libIndex) const;
 
+	/** Sets the creators of the plugins of a library from its getPluginInfo function */
+	void bindPlugins(int libIndex, PluginInfoFunction piFunction) const;
+
+	void loadManifest();
+	void saveManifest();
+
+	/** Returns the index of the plugin with the given name, or -1 */
 	template<class T>
-	bool findPlugin(String name, String libName, const Array<LoadedPluginInfo<T>>& pluginArray, T& pluginInfo) const;
+	int findPluginIndex(String name, String libName, const Array<LoadedPluginInfo<T>>& pluginArray) const;
+
+	/** The libraries are loaded lazily, possibly from the prefetch thread, so everything that
+	reads or sets creators and handles is done under this lock */
+	CriticalSection libraryLock;
+
+	/** Entries read from the manifest cache, and the ones seen this session */
+	ScopedPointer<XmlElement> cachedManifest;
+	XmlElement manifest;
+
+	ScopedPointer<Thread> prefetchThread;
+
+	mutable Array<LoadedLibInfo> libArray;
+	mutable Array<LoadedPluginInfo<Plugin::ProcessorInfo>> processorPlugins;
+	mutable Array<LoadedPluginInfo<Plugin::DataThreadInfo>> dataThreadPlugins;
+	mutable Array<LoadedPluginInfo<Plugin::RecordEngineInfo>> recordEnginePlugins;
+	mutable Array<LoadedPluginInfo<Plugin::FileSourceInfo>> fileSourcePlugins;
 
 	/* Making the info structures have a constructor complicates the DLL interface. 
 	It's easier to just add some static methods to create empty structures for when the calls fail*/
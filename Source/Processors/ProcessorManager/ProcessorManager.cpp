@@ -127,19 +127,14 @@ namespace ProcessorManager
 			getBuiltInProcessorNameAndType(index, name, type);
 			break;
 		case PluginProcessor:
-			{
-				Plugin::ProcessorInfo info = AccessClass::getPluginManager()->getProcessorInfo(index);
-				name = info.name;
-				type = info.type;
-			}
+			// Read from the plugin manifest, so listing plugins doesn't load their libraries
+			name = AccessClass::getPluginManager()->getPluginName(Plugin::PLUGIN_TYPE_PROCESSOR, index);
+			type = AccessClass::getPluginManager()->getProcessorType(index);
 			break;
 		case DataThreadProcessor:
-		{
-			Plugin::DataThreadInfo info = AccessClass::getPluginManager()->getDataThreadInfo(index);
-			name = info.name;
+			name = AccessClass::getPluginManager()->getPluginName(Plugin::PLUGIN_TYPE_DATA_THREAD, index);
 			type = SourceProcessor;
 			break;
-		}
 		default:
 			name = String::empty;
 			type = -1;
@@ -157,6 +152,8 @@ namespace ProcessorManager
 		case PluginProcessor:
 			{
 				Plugin::ProcessorInfo info = AccessClass::getPluginManager()->getProcessorInfo(index);
+				if (info.creator == nullptr)
+					return nullptr;
 				GenericProcessor* proc = info.creator();
 				proc->setPluginData(Plugin::PLUGIN_TYPE_PROCESSOR, index);
 				return proc;
@@ -165,6 +162,8 @@ namespace ProcessorManager
 		case DataThreadProcessor:
 		{
 			Plugin::DataThreadInfo info = AccessClass::getPluginManager()->getDataThreadInfo(index);
+			if (info.creator == nullptr)
+				return nullptr;
 			GenericProcessor* proc = new SourceNode(info.name, info.creator);
 			proc->setPluginData(Plugin::PLUGIN_TYPE_DATA_THREAD, index);
 			return proc;
@@ -190,12 +189,14 @@ namespace ProcessorManager
 			{
 				for (int i = 0; i < pm->getNumProcessors(); i++)
 				{
-					Plugin::ProcessorInfo info = pm->getProcessorInfo(i);
-					if (procName.equalsIgnoreCase(info.name))
+					if (procName.equalsIgnoreCase(pm->getPluginName(Plugin::PLUGIN_TYPE_PROCESSOR, i)))
 					{
 						int libIndex = pm->getLibraryIndexFromPlugin(Plugin::PLUGIN_TYPE_PROCESSOR, i);
 						if (libName.equalsIgnoreCase(pm->getLibraryName(libIndex)) && libVersion == pm->getLibraryVersion(libIndex))
 						{
+							Plugin::ProcessorInfo info = pm->getProcessorInfo(i);
+							if (info.creator == nullptr)
+								break;
 							proc = info.creator();
 							proc->setPluginData(Plugin::PLUGIN_TYPE_PROCESSOR, i);
 							return proc;
@@ -207,12 +208,14 @@ namespace ProcessorManager
 			{
 				for (int i = 0; i < pm->getNumDataThreads(); i++)
 				{
-					Plugin::DataThreadInfo info = pm->getDataThreadInfo(i);
-					if (procName.equalsIgnoreCase(info.name))
+					if (procName.equalsIgnoreCase(pm->getPluginName(Plugin::PLUGIN_TYPE_DATA_THREAD, i)))
 					{
 						int libIndex = pm->getLibraryIndexFromPlugin(Plugin::PLUGIN_TYPE_DATA_THREAD, i);
 						if (libName.equalsIgnoreCase(pm->getLibraryName(libIndex)) && libVersion == pm->getLibraryVersion(libIndex))
 						{
+							Plugin::DataThreadInfo info = pm->getDataThreadInfo(i);
+							if (info.creator == nullptr)
+								break;
 							proc = new SourceNode(info.name, info.creator);
 							proc->setPluginData(Plugin::PLUGIN_TYPE_DATA_THREAD, i);
 							return proc;
@@ -89,14 +89,7 @@ void BinaryRecording::openFiles(File rootFolder, int experimentNumber, int recor
             if (!found)
             {
                 String datPath = getProcessorString(channelInfo);
-                continuousFileNames.add(contPath + datPath + "continuous.dat");
-
-                //std::cout << "Creating file: " << contPath << datPath << "timestamps.npy" << std::endl;
-                ScopedPointer<NpyFile> tFile = new NpyFile(contPath + datPath + "timestamps.npy", NpyType(BaseType::INT64,1));
-                m_dataTimestampFiles.add(tFile.release());
-
-                ScopedPointer<NpyFile> ftsFile = new NpyFile(contPath + datPath + "synchronized_timestamps.npy", NpyType(BaseType::DOUBLE,1));
-                m_dataFloatTimestampFiles.add(ftsFile.release());
+                continuousFileNames.add(contPath + datPath);
 
                 m_fileIndexes.set(recordedChan, nInfoArrays);
                 m_channelIndexes.set(recordedChan, 0);
@@ -124,12 +117,8 @@ void BinaryRecording::openFiles(File rootFolder, int experimentNumber, int recor
     for (int i = 0; i < nFiles; i++)
     {
         int numChannels = jsonChannels.getReference(i).size();
-        ScopedPointer<SequentialBlockFile> bFile = new SequentialBlockFile(numChannels, samplesPerBlock);
-        if (bFile->openFile(continuousFileNames[i]))
-            m_DataFiles.add(bFile.release());
-        else
-            m_DataFiles.add(nullptr);
         DynamicObject::Ptr jsonFile = jsonContinuousfiles.getReference(i).getDynamicObject(); 
+        openContinuousFile(continuousFileNames[i], numChannels, jsonFile);
         jsonFile->setProperty("num_channels", numChannels);
         jsonFile->setProperty("channels", jsonChannels.getReference(i));
     }
@@ -316,12 +305,39 @@ void BinaryRecording::openFiles(File rootFolder, int experimentNumber, int recor
     jsonSettingsFile->setProperty("continuous", jsonContinuousfiles);
     jsonSettingsFile->setProperty("events", jsonEventFiles);
     jsonSettingsFile->setProperty("spikes", jsonSpikeFiles);
-    FileOutputStream settingsFileStream(File(basepath + "structure.oebin"));
+    FileOutputStream settingsFileStream(File(basepath + getStructureFileName()));
 
     jsonSettingsFile->writeAsJSON(settingsFileStream, 2, false);
 
 }
 
+bool BinaryRecording::openContinuousFile(const String& folderPath, int numChannels, DynamicObject* jsonFile)
+{
+    //std::cout << "Creating file: " << folderPath << "timestamps.npy" << std::endl;
+    ScopedPointer<NpyFile> tFile = new NpyFile(folderPath + "timestamps.npy", NpyType(BaseType::INT64,1));
+    m_dataTimestampFiles.add(tFile.release());
+
+    // only this engine is fed through the synchronizer, see RecordThread::run
+    ScopedPointer<NpyFile> ftsFile = new NpyFile(folderPath + "synchronized_timestamps.npy", NpyType(BaseType::DOUBLE,1));
+    m_dataFloatTimestampFiles.add(ftsFile.release());
+
+    ScopedPointer<SequentialBlockFile> bFile = new SequentialBlockFile(numChannels, samplesPerBlock);
+    if (bFile->openFile(folderPath + "continuous.dat"))
+    {
+        m_DataFiles.add(bFile.release());
+        m_channelBlocks.add(new ChannelBlock(numChannels, 2 * samplesPerBlock));
+        return true;
+    }
+    m_DataFiles.add(nullptr);
+    m_channelBlocks.add(nullptr);
+    return false;
+}
+
+String BinaryRecording::getStructureFileName() const
+{
+    return "structure.oebin";
+}
+
 NpyFile* BinaryRecording::createEventMetadataFile(const MetaDataEventObject* channel, String filename, DynamicObject* jsonFile)
 {
     int nMetaData = channel->getEventMetaDataCount();
@@ -461,12 +477,22 @@ void BinaryRecording::createChannelMetaData(const MetaDataInfoObject* channel, D
 
 void BinaryRecording::closeFiles()
 {
+	for (int i = 0; i < m_channelBlocks.size(); i++)
+	{
+		flushChannelBlock(i);
+
+		SequentialBlockFile* file = m_DataFiles[i];
+		if (file && file->getNumDroppedSamples() > 0)
+			std::cout << "[RN] Continuous file " << i << ": " << file->getNumDroppedSamples() << " samples dropped in "
+				<< file->getNumGaps() << " late writes" << std::endl;
+	}
 	resetChannels();
 }
 
 void BinaryRecording::resetChannels()
 {
 	m_DataFiles.clear();
+	m_channelBlocks.clear();
 	m_channelIndexes.clear();
 	m_fileIndexes.clear();
 	m_dataTimestampFiles.clear();
@@ -528,25 +554,17 @@ void BinaryRecording::writeSynchronizedData(int writeChannel, int realChannel, c
     /* Get the file index that belongs to the current recording channel */
 	int fileIndex = m_fileIndexes[writeChannel];
 
-    /* Write the data to that file */
-	m_DataFiles[fileIndex]->writeChannel(
-		getTimestamp(writeChannel) - m_startTS[writeChannel],
+    /* Write the data and its timestamps to that file */
+	writeContinuousChannel(fileIndex,
 		m_channelIndexes[writeChannel],
+		getTimestamp(writeChannel) - m_startTS[writeChannel],
+		getTimestamp(writeChannel),
 		m_intBuffer.getData(), size);
 
-    /* If is first channel in subprocessor */
-	if (m_channelIndexes[writeChannel] == 0)
+    /* If is first channel in subprocessor, and the engine keeps synchronized timestamps */
+	if (m_channelIndexes[writeChannel] == 0 && m_dataFloatTimestampFiles[fileIndex] != nullptr)
     {
 
-		int64 baseTS = getTimestamp(writeChannel);
-		for (int i = 0; i < size; i++)
-            /* Generate int timestamp */ 
-            m_tsBuffer[i] = baseTS + i;     
-
-        /* Write int timestamps to disc */
-		m_dataTimestampFiles[fileIndex]->writeData(m_tsBuffer, size*sizeof(int64));
-		m_dataTimestampFiles[fileIndex]->increaseRecordCount(size);
-
         //LOGD("BinaryRecording::writeSynchronizedData: ", *ftsBuffer);
 
         m_dataFloatTimestampFiles[fileIndex]->writeData(ftsBuffer, size*sizeof(double));
@@ -579,27 +597,111 @@ void BinaryRecording::writeData(int writeChannel, int realChannel, const float*
     /* Get the file index that belongs to the current recording channel */
 	int fileIndex = m_fileIndexes[writeChannel];
 
-    /* Write the data to that file */
-	m_DataFiles[fileIndex]->writeChannel(
-		getTimestamp(writeChannel) - m_startTS[writeChannel],
+    /* Write the data and its timestamps to that file */
+	writeContinuousChannel(fileIndex,
 		m_channelIndexes[writeChannel],
+		getTimestamp(writeChannel) - m_startTS[writeChannel],
+		getTimestamp(writeChannel),
 		m_intBuffer.getData(), size);
 
+}
+
+void BinaryRecording::writeContinuousChannel(int fileIndex, int channelIndex, int64 startPos, int64 timestamp, const int16* data, int size)
+{
+    /* Gather the data, the whole file is interleaved at once in endChannelBlock */
+	ChannelBlock* block = m_channelBlocks[fileIndex];
+	if (block)
+	{
+		int staged = block->numSamples[channelIndex];
+		if (staged > 0 && (block->startPos[channelIndex] + staged != startPos || staged + size > block->capacity))
+		{
+			flushChannelBlock(fileIndex);
+			staged = 0;
+		}
+
+		if (size <= block->capacity)
+		{
+			if (staged == 0)
+				block->startPos.set(channelIndex, startPos);
+			memcpy(block->data + channelIndex * block->capacity + staged, data, size * sizeof(int16));
+			block->numSamples.set(channelIndex, staged + size);
+		}
+		else
+		{
+			m_DataFiles[fileIndex]->writeChannel(startPos, channelIndex, const_cast<int16*>(data), size);
+		}
+	}
+	else if (m_DataFiles[fileIndex])
+	{
+		m_DataFiles[fileIndex]->writeChannel(startPos, channelIndex, const_cast<int16*>(data), size);
+	}
+
     /* If is first channel in subprocessor */
-	if (m_channelIndexes[writeChannel] == 0)
+	if (channelIndex == 0)
     {
 
-		int64 baseTS = getTimestamp(writeChannel);
 		for (int i = 0; i < size; i++)
             /* Generate int timestamp */ 
-            m_tsBuffer[i] = baseTS + i;
+            m_tsBuffer[i] = timestamp + i;
 
         /* Write int timestamps to disc */
 		m_dataTimestampFiles[fileIndex]->writeData(m_tsBuffer, size*sizeof(int64));
 		m_dataTimestampFiles[fileIndex]->increaseRecordCount(size);
         
 	}
+}
+
+void BinaryRecording::endChannelBlock(bool lastBlock)
+{
+	for (int i = 0; i < m_channelBlocks.size(); i++)
+		flushChannelBlock(i);
+}
+
+void BinaryRecording::flushChannelBlock(int fileIndex)
+{
+	ChannelBlock* block = m_channelBlocks[fileIndex];
+	SequentialBlockFile* file = m_DataFiles[fileIndex];
+	if (!block || !file)
+		return;
+
+	int nChannels = block->numSamples.size();
+	bool aligned = true;
+	for (int i = 1; i < nChannels; i++)
+	{
+		if (block->numSamples[i] != block->numSamples[0] || block->startPos[i] != block->startPos[0])
+		{
+			aligned = false;
+			break;
+		}
+	}
 
+	if (aligned)
+	{
+		file->writeBlock(block->startPos[0], block->channels, block->numSamples[0]);
+	}
+	else
+	{
+		/* Channels got different amounts of data, write them one by one */
+		for (int i = 0; i < nChannels; i++)
+		{
+			if (block->numSamples[i] > 0)
+				file->writeChannel(block->startPos[i], i, block->data + i * block->capacity, block->numSamples[i]);
+		}
+	}
+
+	for (int i = 0; i < nChannels; i++)
+		block->numSamples.set(i, 0);
+}
+
+BinaryRecording::ChannelBlock::ChannelBlock(int numChannels, int blockCapacity)
+	: data(numChannels * blockCapacity), channels(numChannels), capacity(blockCapacity)
+{
+	for (int i = 0; i < numChannels; i++)
+	{
+		channels[i] = data + i * capacity;
+		startPos.add(0);
+		numSamples.add(0);
+	}
 }
 
 void BinaryRecording::writeEvent(int eventIndex, const MidiMessage& event)
@@ -22,6 +22,7 @@ public:
 	void resetChannels() override;
 	void writeData(int writeChannel, int realChannel, const float* buffer, int size) override;
 	void writeSynchronizedData(int writeChannel, int realChannel, const float* dataBuffer, const double* ftsBuffer, int size) override;
+	void endChannelBlock(bool lastBlock) override;
 	void writeEvent(int eventIndex, const MidiMessage& event) override;
 	void addSpikeElectrode(int index, const SpikeChannel* elec) override;
 	void writeSpike(int electrodeIndex, const SpikeEvent* spike) override;
@@ -30,6 +31,18 @@ public:
 
 	static RecordEngineManager* getEngineManager();
 
+protected:
+	/** Creates the files that hold the continuous data and sample timestamps of a subprocessor.
+	Called once per subprocessor, in order. folderPath ends with a separator. */
+	virtual bool openContinuousFile(const String& folderPath, int numChannels, DynamicObject* jsonFile);
+
+	/** Writes a block of samples of a channel of a continuous file. startPos is the position
+	relative to the start of the recording and timestamp the one of the first sample */
+	virtual void writeContinuousChannel(int fileIndex, int channelIndex, int64 startPos, int64 timestamp, const int16* data, int size);
+
+	/** Name of the file describing the recording structure */
+	virtual String getStructureFileName() const;
+
 private:
 
     class EventRecording
@@ -42,6 +55,22 @@ private:
         ScopedPointer<NpyFile> extraFile;
     };
 
+    /** Samples of every channel of a continuous file, gathered during a channel block
+    so they can be interleaved into the file all at once */
+    class ChannelBlock
+    {
+    public:
+        ChannelBlock(int numChannels, int capacity);
+
+        HeapBlock<int16> data;
+        HeapBlock<const int16*> channels;
+        Array<int64> startPos;
+        Array<int> numSamples;
+        const int capacity;
+    };
+
+    void flushChannelBlock(int fileIndex);
+
     NpyFile* createEventMetadataFile(const MetaDataEventObject* channel, String fileName, DynamicObject* jsonObject);
 	void createChannelMetaData(const MetaDataInfoObject* channel, DynamicObject* jsonObject);
     void writeEventMetaData(const MetaDataEvent* event, NpyFile* file);
@@ -57,6 +86,7 @@ private:
 
 	OwnedArray<SequentialBlockFile> m_DataFiles;
 	OwnedArray<SequentialBlockFile> m_FTSDataFiles;
+	OwnedArray<ChannelBlock> m_channelBlocks;
 	Array<unsigned int> m_channelIndexes;
 	Array<unsigned int> m_fileIndexes;
 	OwnedArray<EventRecording> m_eventFiles;
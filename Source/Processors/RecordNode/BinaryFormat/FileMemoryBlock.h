@@ -12,14 +12,30 @@ public:
 	{};
 
 	~FileMemoryBlock() {
-		if (~m_flushed)
-		{
-			m_file->write(m_data, m_blockSize*sizeof(StorageType));
-		}
+		flush();
 	};
 
 	inline uint64 getOffset() { return m_offset; }
 	inline StorageType* getData() { return m_data.getData(); }
+
+	/** Writes the whole block to the file, if it hasn't been written yet */
+	void flush()
+	{
+		if (!m_flushed)
+		{
+			m_file->write(m_data, m_blockSize*sizeof(StorageType));
+			m_flushed = true;
+		}
+	}
+
+	/** Prepares an already written block to be used again at another offset */
+	void recycle(uint64 offset)
+	{
+		jassert(m_flushed);
+		m_data.clear(m_blockSize);
+		m_offset = offset;
+		m_flushed = false;
+	}
 	void partialFlush(size_t size, bool markFlushed = true)
 	{
 		//std::cout << "[RN] flushing last block " << size << std::endl;
@@ -32,7 +48,7 @@ private:
 	HeapBlock<StorageType> m_data;
 	FileOutputStream* const m_file;
 	const int m_blockSize;
-	const uint64 m_offset;
+	uint64 m_offset;
 	bool m_flushed{ false };
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FileMemoryBlock);
 };
\ No newline at end of file
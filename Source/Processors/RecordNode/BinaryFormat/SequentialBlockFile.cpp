@@ -23,12 +23,96 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "SequentialBlockFile.h"
 
+#if JUCE_INTEL && ! (JUCE_MINGW && ! defined (__SSE2__))
+ #define BLOCKFILE_USE_SSE 1
+ #include <emmintrin.h>
+#endif
+
+namespace
+{
+	/** Samples interleaved at a time, so the source rows of a group of channels stay in cache */
+	const int interleaveTileSize = 256;
+
+	/** Interleaves numSamples samples of nChannels channels, read from source[c] + sourceOffset,
+	into dest, where consecutive frames are nChannels samples apart */
+	void interleave(int16* dest, const int16* const* source, int sourceOffset, int nChannels, int numSamples)
+	{
+		for (int tile = 0; tile < numSamples; tile += interleaveTileSize)
+		{
+			const int tileSamples = jmin(interleaveTileSize, numSamples - tile);
+			int c = 0;
+
+#if BLOCKFILE_USE_SSE
+			//8x8 transposes: 8 samples of 8 channels become 8 frames of 8 channels
+			for (; c + 8 <= nChannels; c += 8)
+			{
+				const int16* rows[8];
+				for (int k = 0; k < 8; k++)
+					rows[k] = source[c + k] + sourceOffset + tile;
+
+				int16* out = dest + tile * nChannels + c;
+				int s = 0;
+
+				for (; s + 8 <= tileSamples; s += 8)
+				{
+					const __m128i a0 = _mm_unpacklo_epi16(_mm_loadu_si128((const __m128i*)(rows[0] + s)), _mm_loadu_si128((const __m128i*)(rows[1] + s)));
+					const __m128i a1 = _mm_unpackhi_epi16(_mm_loadu_si128((const __m128i*)(rows[0] + s)), _mm_loadu_si128((const __m128i*)(rows[1] + s)));
+					const __m128i a2 = _mm_unpacklo_epi16(_mm_loadu_si128((const __m128i*)(rows[2] + s)), _mm_loadu_si128((const __m128i*)(rows[3] + s)));
+					const __m128i a3 = _mm_unpackhi_epi16(_mm_loadu_si128((const __m128i*)(rows[2] + s)), _mm_loadu_si128((const __m128i*)(rows[3] + s)));
+					const __m128i a4 = _mm_unpacklo_epi16(_mm_loadu_si128((const __m128i*)(rows[4] + s)), _mm_loadu_si128((const __m128i*)(rows[5] + s)));
+					const __m128i a5 = _mm_unpackhi_epi16(_mm_loadu_si128((const __m128i*)(rows[4] + s)), _mm_loadu_si128((const __m128i*)(rows[5] + s)));
+					const __m128i a6 = _mm_unpacklo_epi16(_mm_loadu_si128((const __m128i*)(rows[6] + s)), _mm_loadu_si128((const __m128i*)(rows[7] + s)));
+					const __m128i a7 = _mm_unpackhi_epi16(_mm_loadu_si128((const __m128i*)(rows[6] + s)), _mm_loadu_si128((const __m128i*)(rows[7] + s)));
+
+					const __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+					const __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+					const __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+					const __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+					const __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+					const __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+					const __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+					const __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+					int16* frame = out + s * nChannels;
+					_mm_storeu_si128((__m128i*)(frame), _mm_unpacklo_epi64(b0, b4));
+					_mm_storeu_si128((__m128i*)(frame + nChannels), _mm_unpackhi_epi64(b0, b4));
+					_mm_storeu_si128((__m128i*)(frame + 2 * nChannels), _mm_unpacklo_epi64(b1, b5));
+					_mm_storeu_si128((__m128i*)(frame + 3 * nChannels), _mm_unpackhi_epi64(b1, b5));
+					_mm_storeu_si128((__m128i*)(frame + 4 * nChannels), _mm_unpacklo_epi64(b2, b6));
+					_mm_storeu_si128((__m128i*)(frame + 5 * nChannels), _mm_unpackhi_epi64(b2, b6));
+					_mm_storeu_si128((__m128i*)(frame + 6 * nChannels), _mm_unpacklo_epi64(b3, b7));
+					_mm_storeu_si128((__m128i*)(frame + 7 * nChannels), _mm_unpackhi_epi64(b3, b7));
+				}
+
+				for (; s < tileSamples; s++)
+				{
+					for (int k = 0; k < 8; k++)
+						out[s * nChannels + k] = rows[k][s];
+				}
+			}
+#endif
+
+			for (; c < nChannels; c++)
+			{
+				const int16* row = source[c] + sourceOffset + tile;
+				int16* out = dest + tile * nChannels + c;
+
+				for (int s = 0; s < tileSamples; s++)
+					out[s * nChannels] = row[s];
+			}
+		}
+	}
+}
+
 SequentialBlockFile::SequentialBlockFile(int nChannels, int samplesPerBlock) :
 m_file(nullptr),
 m_nChannels(nChannels),
 m_samplesPerBlock(samplesPerBlock),
 m_blockSize(nChannels*samplesPerBlock),
-m_lastBlockFill(0)
+m_lastBlockFill(0),
+m_nextOffset(0),
+m_droppedSamples(0),
+m_numGaps(0)
 {
 	m_memBlocks.ensureStorageAllocated(blockArrayInitSize);
 	for (int i = 0; i < nChannels; i++)
@@ -37,12 +121,11 @@ m_lastBlockFill(0)
 
 SequentialBlockFile::~SequentialBlockFile()
 {
+	if (m_memBlocks.size() == 0)
+		return;
+
 	//Ensure that all remaining blocks are flushed in order. Keep the last one
-	int n = m_memBlocks.size();
-	for (int i = 0; i < n - 1; i++)
-	{
-		m_memBlocks.remove(0);
-	}
+	releaseBlocks(m_memBlocks.size() - 1);
 
 	//manually flush the last one to avoid trailing zeroes
 	m_memBlocks[0]->partialFlush(m_lastBlockFill * m_nChannels);
@@ -59,7 +142,6 @@ bool SequentialBlockFile::openFile(String filename)
 		Result res = file.create();
 		std::cout << "Re-creating file: " << filename << std::endl;
 	}
-
 	m_file = file.createOutputStream(streamBufferSize);
 	if (!m_file)
 	{
@@ -69,9 +151,35 @@ bool SequentialBlockFile::openFile(String filename)
 
 	//printf("[RN]SequentialBlockFile::added new FileBlock\n");
 	m_memBlocks.add(new FileBlock(m_file, m_blockSize, 0));
+	m_nextOffset = m_samplesPerBlock;
 	return true;
 }
 
+int SequentialBlockFile::getNumLateSamples(uint64 startPos, int nSamples)
+{
+	uint64 firstOffset = m_memBlocks[0]->getOffset();
+	if (startPos >= firstOffset)
+		return 0;
+
+	int lateSamples = (int)jmin<uint64>(nSamples, firstOffset - startPos);
+
+	if (m_numGaps == 0)
+	{
+		printf("[RN]SequentialBlockFile: samples arrived after their block was written to disk, start %llu first block %llu\n",
+			(unsigned long long)startPos, (unsigned long long)firstOffset);
+		fflush(stdout);
+	}
+	m_numGaps++;
+
+	return lateSamples;
+}
+
+void SequentialBlockFile::updateLastBlockFill(int blockIndex, size_t samplePos)
+{
+	if (blockIndex == m_memBlocks.size() - 1 && samplePos > m_lastBlockFill)
+		m_lastBlockFill = samplePos;
+}
+
 bool SequentialBlockFile::writeChannel(uint64 startPos, int channel, int16* data, int nSamples)
 {
 	//printf("[RN]Enter SequentialBlockFile::writeChannel\n");
@@ -80,101 +188,130 @@ bool SequentialBlockFile::writeChannel(uint64 startPos, int channel, int16* data
 		printf("[RN]SequentialBlockFile::writeChannel returned false: (!m_file)\n");
 		return false;
 	}
+	if (nSamples <= 0)
+		return true;
 
-	int bIndex = m_memBlocks.size() - 1;
-	if ((bIndex < 0) || (m_memBlocks[bIndex]->getOffset() + m_samplesPerBlock) < (startPos + nSamples))
-		allocateBlocks(startPos, nSamples);
+	allocateBlocks(startPos, nSamples);
 
-	for (bIndex = m_memBlocks.size() - 1; bIndex >= 0; bIndex--)
-	{
-		if (m_memBlocks[bIndex]->getOffset() <= startPos)
-			break;
-	}
-	if (bIndex < 0)
-	{
-		printf("\r[RN]SequentialBlockFile: Memory block unloaded ahead of time for chan %d start %d ns %d first %d", channel, startPos, nSamples, m_memBlocks[0]->getOffset()); fflush(stdout);
-		for (int i = 0; i < m_nChannels; i++)
-			printf("\r CH: %d last block %d", i, m_currentBlock[i]); fflush(stdout);
-			//std::cout << "channel " << i << " last block " << m_currentBlock[i] << std::endl;
+	//The start of a late channel is lost, the rest can still be written
+	int dataIdx = getNumLateSamples(startPos, nSamples);
+	m_droppedSamples += dataIdx;
+	if (dataIdx == nSamples)
 		return false;
-	}
-	int writtenSamples = 0;
-	int startIdx = startPos - m_memBlocks[bIndex]->getOffset();
-	int startMemPos = startIdx*m_nChannels;
-	int dataIdx = 0;
-	int lastBlockIdx = m_memBlocks.size() - 1;
-	//printf("SequentialBlockFile::Entering write loop...\n");
-	while (writtenSamples < nSamples)
+
+	uint64 pos = startPos + dataIdx;
+	int bIndex = (int)((pos - m_memBlocks[0]->getOffset()) / m_samplesPerBlock);
+	int startIdx = (int)(pos - m_memBlocks[bIndex]->getOffset());
+
+	while (dataIdx < nSamples)
 	{
-		int16* blockPtr = m_memBlocks[bIndex]->getData();
-		int samplesToWrite = jmin((nSamples - writtenSamples), (m_samplesPerBlock - startIdx));
+		int16* blockPtr = m_memBlocks[bIndex]->getData() + startIdx*m_nChannels + channel;
+		int samplesToWrite = jmin((nSamples - dataIdx), (m_samplesPerBlock - startIdx));
 		for (int i = 0; i < samplesToWrite; i++)
 		{
-			//if (writtenSamples == 0 && *(data + dataIdx) == 0)
-			//{
-			//  std::cout << "Found a zero." << std::endl;
-			//  break;
-			//}
-
-			*(blockPtr + startMemPos + channel + i*m_nChannels) = *(data + dataIdx);
+			*(blockPtr + i*m_nChannels) = *(data + dataIdx);
 			dataIdx++;
 		}
-		writtenSamples += samplesToWrite;
-
-		//printf("nSamples: %d, writtenSamples: %d, samplesToWrite: %d\n", nSamples, writtenSamples, samplesToWrite);
 
 		//Update the last block fill index
-		size_t samplePos = startIdx + samplesToWrite;
-		if (bIndex == lastBlockIdx && samplePos > m_lastBlockFill)
-		{
-			m_lastBlockFill = samplePos;
-		}
-
+		updateLastBlockFill(bIndex, startIdx + samplesToWrite);
 		startIdx = 0;
-		startMemPos = 0;
 		bIndex++;
 	}
 	m_currentBlock.set(channel, bIndex - 1); //store the last block a channel was written in
 	return true;
 }
 
-void SequentialBlockFile::allocateBlocks(uint64 startIndex, int numSamples)
+bool SequentialBlockFile::writeBlock(uint64 startPos, const int16* const* channelData, int nSamples)
 {
-	//First deallocate full blocks
-	//Search for the earliest unused block;
-	unsigned int minBlock = 0xFFFFFFFF; //large number;
-	for (int i = 0; i < m_nChannels; i++)
+	if (!m_file)
 	{
-		if (m_currentBlock[i] < minBlock)
-			minBlock = m_currentBlock[i];
+		printf("[RN]SequentialBlockFile::writeBlock returned false: (!m_file)\n");
+		return false;
 	}
+	if (nSamples <= 0)
+		return true;
 
-	//Update block indexes
-	for (int i = 0; i < m_nChannels; i++)
+	allocateBlocks(startPos, nSamples);
+
+	int dataIdx = getNumLateSamples(startPos, nSamples);
+	m_droppedSamples += (int64)dataIdx * m_nChannels;
+	if (dataIdx == nSamples)
+		return false;
+
+	uint64 pos = startPos + dataIdx;
+	int bIndex = (int)((pos - m_memBlocks[0]->getOffset()) / m_samplesPerBlock);
+	int startIdx = (int)(pos - m_memBlocks[bIndex]->getOffset());
+
+	while (dataIdx < nSamples)
 	{
-		m_currentBlock.set(i, m_currentBlock[i] - minBlock);
+		int samplesToWrite = jmin((nSamples - dataIdx), (m_samplesPerBlock - startIdx));
+		interleave(m_memBlocks[bIndex]->getData() + startIdx*m_nChannels, channelData, dataIdx, m_nChannels, samplesToWrite);
+
+		updateLastBlockFill(bIndex, startIdx + samplesToWrite);
+		dataIdx += samplesToWrite;
+		startIdx = 0;
+		bIndex++;
 	}
 
-	m_memBlocks.removeRange(0, minBlock);
+	for (int i = 0; i < m_nChannels; i++)
+		m_currentBlock.set(i, bIndex - 1);
+	return true;
+}
 
-	//for (int i = 0; i < minBlock; i++)
-	//{
-	//Not the most efficient way, as it has to move back all the elements, but it's a simple array of pointers, so it's quick enough
-	//  m_memBlocks.remove(0);
-	//}
+void SequentialBlockFile::allocateBlocks(uint64 startIndex, int numSamples)
+{
+	uint64 endIndex = startIndex + numSamples;
+	if (endIndex <= m_nextOffset)
+		return;
+
+	int newBlocks = (int)((endIndex - m_nextOffset + m_samplesPerBlock - 1) / m_samplesPerBlock); //Fast ceiling division
+
+	//Blocks before the earliest one still in use by a channel can be written
+	int minBlock = -1;
+	for (int i = 0; i < m_nChannels; i++)
+	{
+		if (m_currentBlock[i] >= 0 && (minBlock < 0 || m_currentBlock[i] < minBlock))
+			minBlock = m_currentBlock[i];
+	}
 
-	//Look for the last available position and calculate needed space
-	uint64 lastOffset = m_memBlocks.getLast()->getOffset();
-	uint64 maxAddr = lastOffset + m_samplesPerBlock - 1;
-	uint64 newSpaceNeeded = numSamples - (maxAddr - startIndex);
-	int newBlocks = (newSpaceNeeded + m_samplesPerBlock - 1) / m_samplesPerBlock; //Fast ceiling division
+	//A late channel can't hold more than maxLoadedBlocks in memory, its samples will be dropped instead
+	int blocksToRelease = jmax(minBlock, m_memBlocks.size() + newBlocks - maxLoadedBlocks);
+	releaseBlocks(jlimit(0, m_memBlocks.size(), blocksToRelease));
 
 	for (int i = 0; i < newBlocks; i++)
 	{
-		lastOffset += m_samplesPerBlock;
-		m_memBlocks.add(new FileBlock(m_file, m_blockSize, lastOffset));
+		FileBlock* block;
+		if (m_freeBlocks.size() > 0)
+		{
+			block = m_freeBlocks.removeAndReturn(m_freeBlocks.size() - 1);
+			block->recycle(m_nextOffset);
+		}
+		else
+		{
+			block = new FileBlock(m_file, m_blockSize, m_nextOffset);
+		}
+		m_memBlocks.add(block);
+		m_nextOffset += m_samplesPerBlock;
 	}
-	if (newBlocks > 0)
-		m_lastBlockFill = 0; //we've added some new blocks, so the last one will be empty
+
+	m_lastBlockFill = 0; //we've added some new blocks, so the last one will be empty
 }
 
+void SequentialBlockFile::releaseBlocks(int numBlocks)
+{
+	if (numBlocks <= 0)
+		return;
+
+	for (int i = 0; i < numBlocks; i++)
+	{
+		//Not the most efficient way, as it has to move back all the elements, but it's a simple array of pointers, so it's quick enough
+		FileBlock* block = m_memBlocks.removeAndReturn(0);
+		block->flush();
+		m_freeBlocks.add(block);
+	}
+
+	//Update block indexes. Channels whose block was written stop holding any
+	for (int i = 0; i < m_nChannels; i++)
+		m_currentBlock.set(i, jmax(-1, m_currentBlock[i] - numBlocks));
+}
@@ -6,6 +6,14 @@
 
 typedef FileMemoryBlock<int16> FileBlock;
 
+/**
+	Writes interleaved int16 samples to a file, gathering them in memory blocks of samplesPerBlock
+	samples so channels can be written separately.
+
+	Blocks are written to disk in order once every channel has moved past them, or when more
+	than maxLoadedBlocks would be kept in memory. Samples that arrive for a block that has already
+	been written are dropped, leaving zeros in the file, and counted as a gap.
+*/
 class SequentialBlockFile
 {
 public:
@@ -13,22 +21,49 @@ public:
 	~SequentialBlockFile();
 
 	bool openFile(String filename);
+
+	/** Writes nSamples samples of a channel, starting at sample startPos */
 	bool writeChannel(uint64 startPos, int channel, int16* data, int nSamples);
 
+	/** Writes nSamples samples of every channel at once, starting at sample startPos.
+	channelData holds one pointer per channel */
+	bool writeBlock(uint64 startPos, const int16* const* channelData, int nSamples);
+
+	/** Number of samples, counting all channels, that arrived too late and were dropped */
+	int64 getNumDroppedSamples() const { return m_droppedSamples; }
+
+	/** Number of writes that were partially or completely dropped */
+	int getNumGaps() const { return m_numGaps; }
+
 private:
 	ScopedPointer<FileOutputStream> m_file;
 	const int m_nChannels;
 	const int m_samplesPerBlock;
 	const int m_blockSize;
 	OwnedArray<FileBlock> m_memBlocks;
+	OwnedArray<FileBlock> m_freeBlocks;
 	Array<int> m_currentBlock;
 	size_t m_lastBlockFill;
+	uint64 m_nextOffset;
 
+	int64 m_droppedSamples;
+	int m_numGaps;
+
+	/** Makes sure the blocks holding the samples from startIndex to startIndex + numSamples are loaded */
 	void allocateBlocks(uint64 startIndex, int numSamples);
 
+	/** Writes the first numBlocks blocks to disk and moves them to the pool */
+	void releaseBlocks(int numBlocks);
+
+	/** Returns the number of samples at the start of a write that belong to blocks already written to disk */
+	int getNumLateSamples(uint64 startPos, int nSamples);
+
+	void updateLastBlockFill(int blockIndex, size_t samplePos);
+
 	//Compile-time params
 	const int streamBufferSize{ 0 };
 	const int blockArrayInitSize{ 128 };
+	const int maxLoadedBlocks{ 32 };
 
 };
 #endif // !SEQUENTIALBLOCKFILE_H
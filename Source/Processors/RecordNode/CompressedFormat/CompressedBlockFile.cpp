@@ -0,0 +1,265 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "CompressedBlockFile.h"
+#include "ContinuousBlockCodec.h"
+
+CompressedBlockFile::EncodeJob::EncodeJob(int nChannels, int samplesPerBlock)
+	: ThreadPoolJob("Compressed block encoder"),
+	numChannels(nChannels),
+	blockSize(samplesPerBlock),
+	numSamples(0),
+	encodedSize(0),
+	encodingSeconds(0)
+{
+	planarData.malloc(size_t(nChannels) * samplesPerBlock);
+	encodedData.malloc(ContinuousBlockCodec::getMaxEncodedSize(nChannels, samplesPerBlock));
+	scratch.malloc(ContinuousBlockCodec::getScratchSize(samplesPerBlock));
+}
+
+ThreadPoolJob::JobStatus CompressedBlockFile::EncodeJob::runJob()
+{
+	double start = Time::getMillisecondCounterHiRes();
+	encodedSize = ContinuousBlockCodec::encode(planarData, numChannels, numSamples, encodedData, scratch);
+	encodingSeconds = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+	return jobHasFinished;
+}
+
+CompressedBlockFile::CompressedBlockFile(int nChannels, int samplesPerBlock, ThreadPool* encoderPool) :
+m_file(nullptr),
+m_pool(encoderPool),
+m_nChannels(nChannels),
+m_samplesPerBlock(samplesPerBlock),
+m_firstAssemblingSample(0),
+m_writtenSamples(0),
+m_timestampedSamples(0),
+m_uncompressedBytes(0),
+m_compressedBytes(0),
+m_encodingSeconds(0)
+{
+	for (int i = 0; i < nChannels; i++)
+		m_channelPos.add(0);
+}
+
+CompressedBlockFile::~CompressedBlockFile()
+{
+	close();
+}
+
+void CompressedBlockFile::close()
+{
+	if (!m_file)
+		return;
+
+	submitCompletedBlocks(true);
+	writeEncodedBlocks(true);
+
+	int64 indexOffset = m_file->getPosition();
+	for (int i = 0; i < m_blockOffsets.size(); i++)
+	{
+		m_file->writeInt64(m_blockOffsets[i]);
+		m_file->writeInt64(m_blockFirstSamples[i]);
+	}
+	for (int i = 0; i < m_timestampSegments.size(); i++)
+	{
+		const TimestampSegment& segment = m_timestampSegments.getReference(i);
+		m_file->writeInt64(segment.firstSample);
+		m_file->writeInt64(segment.timestamp);
+		m_file->writeInt64(segment.numSamples);
+	}
+
+	m_file->writeInt64(indexOffset);
+	m_file->writeInt(m_blockOffsets.size());
+	m_file->writeInt(m_timestampSegments.size());
+	m_file->writeInt64(m_writtenSamples);
+	m_file->writeInt(fileMagic);
+	m_file = nullptr;
+}
+
+bool CompressedBlockFile::openFile(String filename)
+{
+	File file(filename);
+	Result res = file.create();
+	if (res.failed())
+	{
+		std::cerr << "Error creating file " << filename << ":" << res.getErrorMessage() << std::endl;
+		return false;
+	}
+
+	m_file = file.createOutputStream();
+	if (!m_file)
+	{
+		std::cerr << "[RN]CompressedBlockFile::openFile could not open " << filename << std::endl;
+		return false;
+	}
+
+	m_file->writeInt(fileMagic);
+	m_file->writeShort(fileVersion);
+	m_file->writeShort(m_nChannels);
+	m_file->writeInt(m_samplesPerBlock);
+	m_file->writeInt(0);
+	return true;
+}
+
+CompressedBlockFile::EncodeJob* CompressedBlockFile::getFreeJob()
+{
+	EncodeJob* job;
+	if (m_freeJobs.size() > 0)
+		job = m_freeJobs.removeAndReturn(m_freeJobs.size() - 1);
+	else
+		job = new EncodeJob(m_nChannels, m_samplesPerBlock);
+	job->numSamples = 0;
+	return job;
+}
+
+bool CompressedBlockFile::writeChannel(int channel, const int16* data, int nSamples)
+{
+	if (!m_file)
+		return false;
+
+	int64 pos = m_channelPos[channel];
+	int written = 0;
+
+	while (written < nSamples)
+	{
+		int blockIndex = int((pos - m_firstAssemblingSample) / m_samplesPerBlock);
+		while (blockIndex >= m_assembling.size())
+			m_assembling.add(getFreeJob());
+
+		int offset = int((pos - m_firstAssemblingSample) % m_samplesPerBlock);
+		int count = jmin(nSamples - written, m_samplesPerBlock - offset);
+		memcpy(m_assembling[blockIndex]->planarData + size_t(channel) * m_samplesPerBlock + offset,
+			data + written, count * sizeof(int16));
+
+		pos += count;
+		written += count;
+	}
+	m_channelPos.set(channel, pos);
+
+	submitCompletedBlocks(false);
+	writeEncodedBlocks(false);
+	return true;
+}
+
+void CompressedBlockFile::addTimestamps(int64 firstTimestamp, int nSamples)
+{
+	int numSegments = m_timestampSegments.size();
+	if (numSegments > 0)
+	{
+		TimestampSegment& last = m_timestampSegments.getReference(numSegments - 1);
+		if (last.timestamp + last.numSamples == firstTimestamp)
+		{
+			last.numSamples += nSamples;
+			m_timestampedSamples += nSamples;
+			return;
+		}
+	}
+
+	TimestampSegment segment;
+	segment.firstSample = m_timestampedSamples;
+	segment.timestamp = firstTimestamp;
+	segment.numSamples = nSamples;
+	m_timestampSegments.add(segment);
+	m_timestampedSamples += nSamples;
+}
+
+void CompressedBlockFile::submitCompletedBlocks(bool flushPartial)
+{
+	int64 minPos = m_channelPos[0];
+	int64 maxPos = m_channelPos[0];
+	for (int c = 1; c < m_nChannels; c++)
+	{
+		minPos = jmin(minPos, m_channelPos[c]);
+		maxPos = jmax(maxPos, m_channelPos[c]);
+	}
+
+	while (m_assembling.size() > 0)
+	{
+		EncodeJob* job = m_assembling[0];
+
+		if (m_firstAssemblingSample + m_samplesPerBlock <= minPos)
+		{
+			job->numSamples = m_samplesPerBlock;
+		}
+		else if (flushPartial && maxPos > m_firstAssemblingSample)
+		{
+			int numSamples = int(jmin(maxPos - m_firstAssemblingSample, int64(m_samplesPerBlock)));
+			for (int c = 0; c < m_nChannels; c++)
+			{
+				int16* channelData = job->planarData + size_t(c) * m_samplesPerBlock;
+				int filled = int(jlimit(int64(0), int64(numSamples), m_channelPos[c] - m_firstAssemblingSample));
+				if (filled < numSamples)
+					zeromem(channelData + filled, (numSamples - filled) * sizeof(int16));
+				//the codec expects the channels packed one after the other
+				if (c > 0)
+					memmove(job->planarData + size_t(c) * numSamples, channelData, numSamples * sizeof(int16));
+			}
+			job->numSamples = numSamples;
+		}
+		else
+		{
+			break;
+		}
+
+		m_assembling.removeObject(job, false);
+		m_firstAssemblingSample += job->numSamples;
+		m_uncompressedBytes += int64(job->numSamples) * m_nChannels * sizeof(int16);
+
+		m_encoding.add(job);
+		m_pool->addJob(job, false);
+	}
+
+	if (flushPartial)
+	{
+		while (m_assembling.size() > 0)
+			m_freeJobs.add(m_assembling.removeAndReturn(0));
+	}
+}
+
+void CompressedBlockFile::writeEncodedBlocks(bool waitForAll)
+{
+	while (m_encoding.size() > 0)
+	{
+		EncodeJob* job = m_encoding[0];
+
+		if (m_pool->contains(job))
+		{
+			if (!waitForAll && m_encoding.size() <= maxPendingBlocks)
+				break;
+			m_pool->waitForJobToFinish(job, -1);
+		}
+
+		m_blockOffsets.add(m_file->getPosition());
+		m_blockFirstSamples.add(m_writtenSamples);
+
+		m_file->writeInt(int(job->encodedSize));
+		m_file->writeInt(job->numSamples);
+		m_file->write(job->encodedData, job->encodedSize);
+
+		m_writtenSamples += job->numSamples;
+		m_compressedBytes += blockHeaderSize + job->encodedSize;
+		m_encodingSeconds += job->encodingSeconds;
+
+		m_freeJobs.add(m_encoding.removeAndReturn(0));
+	}
+}
@@ -0,0 +1,134 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef COMPRESSEDBLOCKFILE_H_INCLUDED
+#define COMPRESSEDBLOCKFILE_H_INCLUDED
+
+#include "../../../../JuceLibraryCode/JuceHeader.h"
+
+/**
+	Writes the continuous data of a subprocessor as a sequence of independently compressed
+	blocks, followed by an index of the blocks and the timestamps of the samples.
+
+	Channels are written one at a time, as with SequentialBlockFile. Once every channel has
+	filled a block, it is compressed by a job of the shared encoder pool, and the compressed
+	blocks are appended to the file in order from the record thread.
+
+	File layout (little endian):
+	- Header: "OECZ", uint16 version, uint16 number of channels, uint32 samples per block, uint32 reserved
+	- Blocks: uint32 encoded size, uint32 number of samples, encoded data (see ContinuousBlockCodec)
+	- Block index: per block, int64 file offset and int64 first sample
+	- Timestamp segments: per run of consecutive timestamps, int64 first sample, int64 first timestamp and int64 number of samples
+	- Trailer: int64 block index offset, uint32 number of blocks, uint32 number of segments, int64 number of samples, "OECZ"
+
+	If the trailer is missing, because the recording was interrupted, the blocks can still be
+	recovered by following their sizes from the header.
+*/
+class CompressedBlockFile
+{
+public:
+	CompressedBlockFile(int nChannels, int samplesPerBlock, ThreadPool* encoderPool);
+
+	~CompressedBlockFile();
+
+	bool openFile(String filename);
+
+	/** Compresses the last partial block, writes the index and closes the file */
+	void close();
+
+	/** Appends samples to a channel */
+	bool writeChannel(int channel, const int16* data, int nSamples);
+
+	/** Registers the timestamps of the next samples of the file. Called once per block of samples, not per channel. */
+	void addTimestamps(int64 firstTimestamp, int nSamples);
+
+	int64 getUncompressedBytes() const { return m_uncompressedBytes; }
+	int64 getCompressedBytes() const { return m_compressedBytes; }
+	/** Total time spent compressing blocks, in the encoder threads */
+	double getEncodingSeconds() const { return m_encodingSeconds; }
+
+	static const uint32 fileMagic = 0x5A43454F; // "OECZ"
+	static const uint16 fileVersion = 1;
+	static const int headerSize = 16;
+	static const int blockHeaderSize = 8;
+	static const int trailerSize = 28;
+
+	struct TimestampSegment
+	{
+		int64 firstSample;
+		int64 timestamp;
+		int64 numSamples;
+	};
+
+private:
+	class EncodeJob : public ThreadPoolJob
+	{
+	public:
+		EncodeJob(int nChannels, int samplesPerBlock);
+		JobStatus runJob() override;
+
+		HeapBlock<int16> planarData;
+		HeapBlock<uint8> encodedData;
+		HeapBlock<int32> scratch;
+		const int numChannels;
+		const int blockSize;
+		int numSamples;
+		size_t encodedSize;
+		double encodingSeconds;
+	};
+
+	EncodeJob* getFreeJob();
+	void submitCompletedBlocks(bool flushPartial);
+	void writeEncodedBlocks(bool waitForAll);
+
+	ScopedPointer<FileOutputStream> m_file;
+	ThreadPool* const m_pool;
+	const int m_nChannels;
+	const int m_samplesPerBlock;
+
+	/** Blocks being filled, starting at m_firstAssemblingSample */
+	OwnedArray<EncodeJob> m_assembling;
+	/** Blocks being compressed, in file order */
+	OwnedArray<EncodeJob> m_encoding;
+	OwnedArray<EncodeJob> m_freeJobs;
+
+	Array<int64> m_channelPos;
+	int64 m_firstAssemblingSample;
+	int64 m_writtenSamples;
+
+	Array<int64> m_blockOffsets;
+	Array<int64> m_blockFirstSamples;
+	Array<TimestampSegment> m_timestampSegments;
+	int64 m_timestampedSamples;
+
+	int64 m_uncompressedBytes;
+	int64 m_compressedBytes;
+	double m_encodingSeconds;
+
+	/** Compressed blocks waiting to be written before the record thread waits for the encoders */
+	const int maxPendingBlocks{ 32 };
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CompressedBlockFile);
+};
+
+#endif  // COMPRESSEDBLOCKFILE_H_INCLUDED
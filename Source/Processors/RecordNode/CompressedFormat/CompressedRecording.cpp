@@ -0,0 +1,119 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "CompressedRecording.h"
+
+CompressedRecording::CompressedRecording()
+{
+	//leave a core for the record thread
+	int numEncoders = jlimit(1, MAX_ENCODER_THREADS, SystemStats::getNumCpus() - 1);
+	m_encoderPool = new ThreadPool(numEncoders);
+}
+
+CompressedRecording::~CompressedRecording()
+{
+	//files wait for their pending blocks, so they must be closed before the pool is destroyed
+	m_compressedFiles.clear();
+	m_encoderPool = nullptr;
+}
+
+String CompressedRecording::getEngineID() const
+{
+	return "COMPRESSED";
+}
+
+String CompressedRecording::getStructureFileName() const
+{
+	return "structure.oecbin";
+}
+
+bool CompressedRecording::openContinuousFile(const String& folderPath, int numChannels, DynamicObject* jsonFile)
+{
+	jsonFile->setProperty("compression", "oecz");
+	jsonFile->setProperty("samples_per_block", samplesPerCompressedBlock);
+
+	ScopedPointer<CompressedBlockFile> cFile = new CompressedBlockFile(numChannels, samplesPerCompressedBlock, m_encoderPool);
+	if (cFile->openFile(folderPath + "continuous.oecz"))
+	{
+		m_compressedFiles.add(cFile.release());
+		return true;
+	}
+	m_compressedFiles.add(nullptr);
+	return false;
+}
+
+void CompressedRecording::writeContinuousChannel(int fileIndex, int channelIndex, int64 startPos, int64 timestamp, const int16* data, int size)
+{
+	CompressedBlockFile* file = m_compressedFiles[fileIndex];
+	if (!file)
+		return;
+
+	//samples are stored back to back, gaps are kept in the timestamp segments
+	file->writeChannel(channelIndex, data, size);
+
+	if (channelIndex == 0)
+		file->addTimestamps(timestamp, size);
+}
+
+void CompressedRecording::closeFiles()
+{
+	int64 uncompressedBytes = 0;
+	int64 compressedBytes = 0;
+	double encodingSeconds = 0;
+
+	for (int i = 0; i < m_compressedFiles.size(); i++)
+	{
+		CompressedBlockFile* file = m_compressedFiles[i];
+		if (!file) continue;
+
+		file->close();
+		uncompressedBytes += file->getUncompressedBytes();
+		compressedBytes += file->getCompressedBytes();
+		encodingSeconds += file->getEncodingSeconds();
+	}
+
+	if (compressedBytes > 0 && encodingSeconds > 0)
+	{
+		std::cout << "Compressed format: " << uncompressedBytes / (1024.0 * 1024.0) << " MB of continuous data stored in "
+			<< compressedBytes / (1024.0 * 1024.0) << " MB (ratio " << double(uncompressedBytes) / compressedBytes << "), encoded at "
+			<< uncompressedBytes / (1024.0 * 1024.0) / encodingSeconds << " MB/s per thread" << std::endl;
+	}
+
+	BinaryRecording::closeFiles();
+}
+
+void CompressedRecording::resetChannels()
+{
+	m_compressedFiles.clear();
+	BinaryRecording::resetChannels();
+}
+
+RecordEngineManager* CompressedRecording::getEngineManager()
+{
+	RecordEngineManager* man = new RecordEngineManager("COMPRESSED", "Compressed binary",
+		&(engineFactory<CompressedRecording>));
+	EngineParameter* param;
+	param = new EngineParameter(EngineParameter::BOOL, 0, "Record TTL full words", true);
+	man->addParameter(param);
+	return man;
+}
@@ -0,0 +1,71 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef COMPRESSEDRECORDING_H_INCLUDED
+#define COMPRESSEDRECORDING_H_INCLUDED
+
+#include "../BinaryFormat/BinaryRecording.h"
+#include "CompressedBlockFile.h"
+
+#define MAX_ENCODER_THREADS 8
+
+/**
+	Binary format with losslessly compressed continuous data.
+
+	Events, spikes and the structure file are the same as in the Binary format, but each
+	subprocessor's continuous data goes to a continuous.oecz file (see CompressedBlockFile)
+	instead of continuous.dat, and its timestamps are stored in that file as runs of
+	consecutive values instead of one int64 per sample in timestamps.npy.
+
+	The structure file is named structure.oecbin so it's read by CompressedFileSource.
+
+	@see BinaryRecording, CompressedBlockFile, ContinuousBlockCodec
+*/
+class CompressedRecording : public BinaryRecording
+{
+public:
+	CompressedRecording();
+	~CompressedRecording();
+
+	String getEngineID() const override;
+
+	void closeFiles() override;
+	void resetChannels() override;
+
+	static RecordEngineManager* getEngineManager();
+
+protected:
+	bool openContinuousFile(const String& folderPath, int numChannels, DynamicObject* jsonFile) override;
+	void writeContinuousChannel(int fileIndex, int channelIndex, int64 startPos, int64 timestamp, const int16* data, int size) override;
+	String getStructureFileName() const override;
+
+private:
+	ScopedPointer<ThreadPool> m_encoderPool;
+	OwnedArray<CompressedBlockFile> m_compressedFiles;
+
+	const int samplesPerCompressedBlock{ 4096 };
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CompressedRecording);
+};
+
+#endif  // COMPRESSEDRECORDING_H_INCLUDED
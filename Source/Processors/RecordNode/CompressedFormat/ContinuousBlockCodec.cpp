@@ -0,0 +1,292 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ContinuousBlockCodec.h"
+
+namespace
+{
+	/** Residuals whose Rice quotient reaches this value are stored verbatim after the escape */
+	const int riceEscape = 24;
+	const int maxRiceParameter = 23;
+
+	inline uint32 zigzag(int32 value)
+	{
+		return (uint32(value) << 1) ^ uint32(value >> 31);
+	}
+
+	inline int32 unzigzag(uint32 value)
+	{
+		return int32(value >> 1) ^ -int32(value & 1);
+	}
+
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(uint8* dest) : m_dest(dest), m_pos(0), m_acc(0), m_bits(0) {}
+
+		/** Writes up to 32 bits */
+		inline void write(uint32 value, int numBits)
+		{
+			m_acc = (m_acc << numBits) | value;
+			m_bits += numBits;
+			while (m_bits >= 8)
+			{
+				m_bits -= 8;
+				m_dest[m_pos++] = uint8(m_acc >> m_bits);
+			}
+		}
+
+		inline void writeRice(uint32 value, int k)
+		{
+			uint32 quotient = value >> k;
+			if (quotient < riceEscape)
+			{
+				//quotient zeros followed by a one
+				write(1, quotient + 1);
+				if (k > 0)
+					write(value & ((1u << k) - 1), k);
+			}
+			else
+			{
+				write(0, riceEscape);
+				write(value, 32);
+			}
+		}
+
+		size_t finish()
+		{
+			if (m_bits > 0)
+				m_dest[m_pos++] = uint8(m_acc << (8 - m_bits));
+			m_bits = 0;
+			return m_pos;
+		}
+
+	private:
+		uint8* m_dest;
+		size_t m_pos;
+		uint64 m_acc;
+		int m_bits;
+	};
+
+	class BitReader
+	{
+	public:
+		BitReader(const uint8* source, size_t size) : m_source(source), m_size(size), m_pos(0), m_acc(0), m_bits(0) {}
+
+		inline void refill()
+		{
+			while (m_bits <= 56)
+			{
+				m_acc = (m_acc << 8) | (m_pos < m_size ? m_source[m_pos] : 0);
+				m_pos++;
+				m_bits += 8;
+			}
+		}
+
+		/** Reads up to 32 bits */
+		inline uint32 read(int numBits)
+		{
+			if (numBits == 0)
+				return 0;
+			if (m_bits < numBits)
+				refill();
+			m_bits -= numBits;
+			return uint32(m_acc >> m_bits) & (numBits == 32 ? 0xFFFFFFFFu : ((1u << numBits) - 1));
+		}
+
+		inline uint32 readRice(int k)
+		{
+			uint32 quotient = 0;
+			for (;;)
+			{
+				if (m_bits == 0)
+					refill();
+				m_bits--;
+				if ((m_acc >> m_bits) & 1)
+					break;
+				if (++quotient == riceEscape)
+					return read(32);
+			}
+			return (quotient << k) | read(k);
+		}
+
+		/** True if more bytes were consumed than available */
+		bool overrun() const { return m_pos - (m_bits / 8) > m_size; }
+
+	private:
+		const uint8* m_source;
+		size_t m_size;
+		size_t m_pos;
+		uint64 m_acc;
+		int m_bits;
+	};
+}
+
+size_t ContinuousBlockCodec::getMaxEncodedSize(int numChannels, int numSamples)
+{
+	//worst case is an escaped residual (56 bits) per sample
+	return size_t(numChannels) * (size_t(numSamples) * 7 + numSamples / partitionSize + 2) + 8;
+}
+
+size_t ContinuousBlockCodec::getScratchSize(int numSamples)
+{
+	return 3 * size_t(numSamples);
+}
+
+size_t ContinuousBlockCodec::encode(const int16* planarData, int numChannels, int numSamples, uint8* dest, int32* scratch)
+{
+	int32* previousDiff = scratch;
+	int32* currentDiff = scratch + numSamples;
+	int32* residual = scratch + 2 * numSamples;
+	BitWriter writer(dest);
+
+	for (int c = 0; c < numChannels; c++)
+	{
+		const int16* x = planarData + size_t(c) * numSamples;
+
+		//cost estimation of every predictor, with the samples before the block taken as zero
+		uint64 cost[4] = { 0, 0, 0, 0 };
+		int32 last = 0, beforeLast = 0;
+		for (int i = 0; i < numSamples; i++)
+		{
+			int32 sample = x[i];
+			int32 diff = sample - last;
+			currentDiff[i] = diff;
+			cost[VERBATIM] += std::abs(sample);
+			cost[FIRST_ORDER] += std::abs(diff);
+			cost[SECOND_ORDER] += std::abs(diff - (last - beforeLast));
+			if (c > 0)
+				cost[INTER_CHANNEL] += std::abs(diff - previousDiff[i]);
+			beforeLast = last;
+			last = sample;
+		}
+
+		int predictor = VERBATIM;
+		for (int p = FIRST_ORDER; p <= (c > 0 ? INTER_CHANNEL : SECOND_ORDER); p++)
+		{
+			if (cost[p] < cost[predictor])
+				predictor = p;
+		}
+
+		switch (predictor)
+		{
+		case VERBATIM:
+			for (int i = 0; i < numSamples; i++)
+				residual[i] = x[i];
+			break;
+		case FIRST_ORDER:
+			memcpy(residual, currentDiff, numSamples * sizeof(int32));
+			break;
+		case SECOND_ORDER:
+			residual[0] = currentDiff[0];
+			for (int i = 1; i < numSamples; i++)
+				residual[i] = currentDiff[i] - currentDiff[i - 1];
+			break;
+		default:
+			for (int i = 0; i < numSamples; i++)
+				residual[i] = currentDiff[i] - previousDiff[i];
+			break;
+		}
+
+		writer.write(uint32(predictor), 2);
+
+		for (int start = 0; start < numSamples; start += partitionSize)
+		{
+			int length = jmin(partitionSize, numSamples - start);
+			uint64 sum = 0;
+			for (int i = start; i < start + length; i++)
+				sum += zigzag(residual[i]);
+
+			//2^k close to the mean residual
+			int k = 0;
+			while (k < maxRiceParameter && (uint64(length) << k) < sum)
+				k++;
+
+			writer.write(uint32(k), 5);
+			for (int i = start; i < start + length; i++)
+				writer.writeRice(zigzag(residual[i]), k);
+		}
+
+		std::swap(previousDiff, currentDiff);
+	}
+
+	return writer.finish();
+}
+
+bool ContinuousBlockCodec::decode(const uint8* source, size_t size, int numChannels, int numSamples, int16* interleavedData, int32* scratch)
+{
+	int32* previousDiff = scratch;
+	int32* currentDiff = scratch + numSamples;
+	int32* residual = scratch + 2 * numSamples;
+	BitReader reader(source, size);
+
+	for (int c = 0; c < numChannels; c++)
+	{
+		int predictor = int(reader.read(2));
+		if (predictor == INTER_CHANNEL && c == 0)
+			return false;
+
+		for (int start = 0; start < numSamples; start += partitionSize)
+		{
+			int length = jmin(partitionSize, numSamples - start);
+			int k = int(reader.read(5));
+			if (k > maxRiceParameter)
+				return false;
+			for (int i = start; i < start + length; i++)
+				residual[i] = unzigzag(reader.readRice(k));
+		}
+
+		if (reader.overrun())
+			return false;
+
+		int16* y = interleavedData + c;
+		int32 last = 0, lastDiff = 0;
+		for (int i = 0; i < numSamples; i++)
+		{
+			int32 sample;
+			switch (predictor)
+			{
+			case VERBATIM:
+				sample = residual[i];
+				break;
+			case FIRST_ORDER:
+				sample = last + residual[i];
+				break;
+			case SECOND_ORDER:
+				sample = last + lastDiff + residual[i];
+				break;
+			default:
+				sample = last + previousDiff[i] + residual[i];
+				break;
+			}
+			lastDiff = sample - last;
+			currentDiff[i] = lastDiff;
+			last = sample;
+			y[size_t(i) * numChannels] = int16(sample);
+		}
+
+		std::swap(previousDiff, currentDiff);
+	}
+
+	return true;
+}
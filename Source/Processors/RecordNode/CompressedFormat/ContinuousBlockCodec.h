@@ -0,0 +1,72 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef CONTINUOUSBLOCKCODEC_H_INCLUDED
+#define CONTINUOUSBLOCKCODEC_H_INCLUDED
+
+#include "../../../../JuceLibraryCode/JuceHeader.h"
+
+/**
+	Lossless codec for blocks of int16 continuous data.
+
+	Each channel is replaced by the residual of the predictor that fits it best in the block:
+	the raw samples, the first or second difference, or the first difference minus the one
+	of the previous channel, which removes the noise and artifacts shared by neighbouring
+	sites. Residuals are Rice-coded in partitions of partitionSize samples, each with its own
+	parameter.
+
+	Blocks don't depend on each other, so they can be encoded in parallel and decoded
+	starting from any of them.
+
+	Encoded block layout (bit stream, MSB first):
+	per channel: 2-bit predictor, then per partition a 5-bit Rice parameter and its residuals.
+*/
+class ContinuousBlockCodec
+{
+public:
+	/** Upper bound of the encoded size of a block */
+	static size_t getMaxEncodedSize(int numChannels, int numSamples);
+
+	/** Size, in int32, of the scratch memory needed for blocks of numSamples samples */
+	static size_t getScratchSize(int numSamples);
+
+	/** Encodes numChannels channels of numSamples samples, stored one channel after the other.
+	Returns the number of bytes written to dest, which must hold getMaxEncodedSize() bytes. */
+	static size_t encode(const int16* planarData, int numChannels, int numSamples, uint8* dest, int32* scratch);
+
+	/** Decodes a block into interleaved samples. Returns false if the data is corrupted. */
+	static bool decode(const uint8* source, size_t size, int numChannels, int numSamples, int16* interleavedData, int32* scratch);
+
+	static const int partitionSize = 256;
+
+private:
+	enum Predictor
+	{
+		VERBATIM = 0,
+		FIRST_ORDER,
+		SECOND_ORDER,
+		INTER_CHANNEL
+	};
+};
+
+#endif  // CONTINUOUSBLOCKCODEC_H_INCLUDED
@@ -130,12 +130,12 @@ private:
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EventQueue);
 };
-//NOTE: Events are sent as midimessages while spikes as spike objects due to the difference on how they are passed to the record node.
-//Once the probe system is implemented, this will be normalized
+//NOTE: Spikes are queued in their serialized form, with the index of their electrode as extra, and only
+//turned into SpikeEvent objects by the record thread, so the processing thread just copies their bytes
 typedef EventQueue<MidiMessage> EventMsgQueue;
-typedef EventQueue<SpikeEvent> SpikeMsgQueue;
+typedef EventQueue<MidiMessage> SpikeMsgQueue;
 typedef ReferenceCountedObjectPtr<AsyncEventMessage<MidiMessage>> EventMessagePtr;
-typedef ReferenceCountedObjectPtr<AsyncEventMessage<SpikeEvent>> SpikeMessagePtr;
+typedef ReferenceCountedObjectPtr<AsyncEventMessage<MidiMessage>> SpikeMessagePtr;
 
 #endif  // EVENTQUEUE_H_INCLUDED
 
@@ -27,13 +27,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 OriginalRecording::OriginalRecording() : separateFiles(false),
 recordingNumber(0), experimentNumber(0), zeroBuffer(1, 50000),
-eventFile(nullptr), messageFile(nullptr), lastProcId(0), procIndex(0)
+flushPending(false), writeFailed(false), openTime(0), droppedBytes(0), eventFile(nullptr), messageFile(nullptr), lastProcId(0), procIndex(0)
 {
-	/*continuousDataIntegerBuffer = new int16[10000];
-	continuousDataFloatBuffer = new float[10000];
-
-	recordMarker = new char[10];*/
-	continuousDataIntegerBuffer.malloc(10000);
 	continuousDataFloatBuffer.malloc(10000);
 	recordMarker.malloc(10);
 
@@ -44,22 +39,28 @@ eventFile(nullptr), messageFile(nullptr), lastProcId(0), procIndex(0)
 	recordMarker[9] = 255;
 
 	zeroBuffer.clear();
+
+	int numWriters = jmin(MAX_WRITER_THREADS, SystemStats::getNumCpus());
+	writerPool = new ThreadPool(numWriters);
+	for (int i = 0; i < numWriters; i++)
+	{
+		writerJobs.add(new WriterJob(this, i, numWriters, jmax(1, MAX_OPEN_CONTINUOUS_FILES / numWriters)));
+	}
 }
 
 OriginalRecording::~OriginalRecording()
 {
 	//Cleanup just in case
-	for (int i = 0; i < fileArray.size(); i++)
+	waitForWriters();
+	for (int i = 0; i < writerJobs.size(); i++)
 	{
-		if (fileArray[i] != nullptr) fclose(fileArray[i]);
+		writerJobs[i]->closeFiles();
 	}
+	writerPool = nullptr;
 	for (int i = 0; i < spikeFileArray.size(); i++)
 	{
 		if (spikeFileArray[i] != nullptr) fclose(spikeFileArray[i]);
 	}
-	/*   delete continuousDataFloatBuffer;
-	delete continuousDataIntegerBuffer;
-	delete recordMarker;*/
 }
 
 String OriginalRecording::getEngineID() const
@@ -74,7 +75,12 @@ void OriginalRecording::addSpikeElectrode(int index, const SpikeChannel* elec)
 
 void OriginalRecording::resetChannels()
 {
-	fileArray.clear();
+	waitForWriters();
+	for (int i = 0; i < writerJobs.size(); i++)
+	{
+		writerJobs[i]->closeFiles();
+	}
+	continuousFiles.clear();
 	spikeFileArray.clear();
 	blockIndex.clear();
 	processorArray.clear();
@@ -94,6 +100,15 @@ void OriginalRecording::openFiles(File rootFolder, int experimentNumber, int rec
 	//openFile(rootFolder, getEventChannel(0), 0);
 	openMessageFile(rootFolder);
 
+	for (int i = 0; i < writerJobs.size(); i++)
+	{
+		writerJobs[i]->bytesWritten = 0;
+	}
+	flushPending = false;
+	writeFailed = false;
+	droppedBytes = 0;
+	openTime = Time::getMillisecondCounterHiRes();
+
 	int nChannels = getNumRecordedChannels();
 
 	for (int i = 0; i < nChannels; i++)
@@ -138,8 +153,6 @@ void OriginalRecording::openFile(File rootFolder, const InfoObjectCommon* ch, in
 
 	bool fileExists = f.exists();
 
-	diskWriteLock.enter();
-
 	chFile = fopen(fullPath.toUTF8(), "ab");
 
 	if (!fileExists)
@@ -168,7 +181,16 @@ void OriginalRecording::openFile(File rootFolder, const InfoObjectCommon* ch, in
 		eventFile = chFile;
 	else
 	{
-		fileArray.add(chFile);
+		//The writers reopen the file when they have data for it, so it isn't held open meanwhile
+		ContinuousFile* file = new ContinuousFile();
+		if (chFile != nullptr)
+			file->path = fullPath;
+		file->scaleFactor = 1.0f / dynamic_cast<const DataChannel*>(ch)->getBitVolts();
+		file->assembling.setSize(2 * RECORDS_PER_FLUSH * RECORD_SIZE);
+		file->assembledBytes = 0;
+		file->flushing.setSize(2 * RECORDS_PER_FLUSH * RECORD_SIZE);
+		file->flushBytes = 0;
+		continuousFiles.add(file);
 		if (ch->getCurrentNodeID() != lastProcId)
 		{
 			lastProcId = ch->getCurrentNodeID();
@@ -180,11 +202,12 @@ void OriginalRecording::openFile(File rootFolder, const InfoObjectCommon* ch, in
 		ChannelInfo* c = new ChannelInfo();
 		c->filename = fileName;
 		c->name = ch->getName();
-		c->startPos = ftell(chFile);
+		c->startPos = chFile != nullptr ? ftell(chFile) : 0;
 		c->bitVolts = dynamic_cast<const DataChannel*>(ch)->getBitVolts();
 		processorArray.getLast()->channels.add(c);
+		if (chFile != nullptr)
+			fclose(chFile);
 	}
-	diskWriteLock.exit();
 
 }
 
@@ -208,8 +231,6 @@ void OriginalRecording::openSpikeFile(File rootFolder, const SpikeChannel* elec,
 
 	bool fileExists = f.exists();
 
-	diskWriteLock.enter();
-
 	spFile = fopen(fullPath.toUTF8(), "ab");
 
 	if (!fileExists)
@@ -217,7 +238,6 @@ void OriginalRecording::openSpikeFile(File rootFolder, const SpikeChannel* elec,
 		String header = generateSpikeHeader(elec);
 		fwrite(header.toUTF8(), 1, header.getNumBytesAsUTF8(), spFile);
 	}
-	diskWriteLock.exit();
 	spikeFileArray.set(channelIndex, spFile);
 
 }
@@ -242,13 +262,10 @@ void OriginalRecording::openMessageFile(File rootFolder)
 
 	//bool fileExists = f.exists();
 
-	diskWriteLock.enter();
-
 	mFile = fopen(fullPath.toUTF8(), "ab");
 
 	//If this file needs a header, it goes here
 
-	diskWriteLock.exit();
 	messageFile = mFile;
 
 }
@@ -403,12 +420,10 @@ void OriginalRecording::writeMessage(String message, uint16 processorID, uint16
 
 	String timestampText(timestamp);
 
-	diskWriteLock.enter();
 	fwrite(timestampText.toUTF8(), 1, timestampText.length(), messageFile);
 	fwrite(" ", 1, 1, messageFile);
 	fwrite(message.toUTF8(), 1, msgLength, messageFile);
 	fwrite("\n", 1, 1, messageFile);
-	diskWriteLock.exit();
 
 }
 
@@ -434,15 +449,10 @@ void OriginalRecording::writeTTLEvent(int eventIndex, const MidiMessage& event)
 	*(data + 13) = static_cast<uint8>(ev->getChannel());
 	*reinterpret_cast<uint16*>(data + 14) = recordingNumber;
 
-
-	diskWriteLock.enter();
-
 	fwrite(&data,					// ptr
 		sizeof(uint8),   							// size of each element
 		16, 		  						// count
 		eventFile);   			// ptr to FILE object
-
-	diskWriteLock.exit();
 }
 
 void OriginalRecording::writeSynchronizedData(int writeChannel, int realChannel, const float* dataBuffer, const double* ftsBuffer, int size) {};
@@ -496,127 +506,247 @@ void OriginalRecording::writeData(int writeChannel, int realChannel, const float
 
 void OriginalRecording::writeContinuousBuffer(const float* data, int nSamples, int writeChannel)
 {
-	// check to see if the file exists
-	if (fileArray[writeChannel] == nullptr)
+	// check to see if the channel is recorded
+	if (continuousFiles[writeChannel]->path.isEmpty())
 		return;
 
-	// scale the data back into the range of int16
-	float scaleFactor = float(0x7fff) * getDataChannel(getRealChannel(writeChannel))->getBitVolts();
-
-	for (int n = 0; n < nSamples; n++)
+	if (blockIndex[writeChannel] == 0)
 	{
-		*(continuousDataFloatBuffer + n) = *(data + n) / scaleFactor;
+		writeTimestampAndSampleCount(writeChannel);
 	}
-	AudioDataConverters::convertFloatToInt16BE(continuousDataFloatBuffer, continuousDataIntegerBuffer, nSamples);
 
-	if (blockIndex[writeChannel] == 0)
+	// scale the data back into the range of int16 and store it big-endian straight into the record
+	FloatVectorOperations::multiply(continuousDataFloatBuffer, data,
+		continuousFiles[writeChannel]->scaleFactor / float(0x7fff), nSamples);
+	AudioDataConverters::convertFloatToInt16BE(continuousDataFloatBuffer,
+		getContinuousWritePointer(writeChannel, 2 * nSamples), nSamples);
+
+	if (blockIndex[writeChannel] + nSamples == BLOCK_LENGTH)
 	{
-		writeTimestampAndSampleCount(fileArray[writeChannel], writeChannel);
+		writeRecordMarker(writeChannel);
 	}
+}
 
-	diskWriteLock.enter();
-
-	size_t count = fwrite(continuousDataIntegerBuffer,      // ptr
-		2,                                // size of each element
-		nSamples,                         // count
-		fileArray[writeChannel]); // ptr to FILE object
+uint8* OriginalRecording::getContinuousWritePointer(int channel, size_t numBytes)
+{
+	ContinuousFile* file = continuousFiles[channel];
+	file->assembling.ensureSize(file->assembledBytes + numBytes);
+	uint8* ptr = static_cast<uint8*>(file->assembling.getData()) + file->assembledBytes;
+	file->assembledBytes += numBytes;
+	if (file->assembledBytes >= RECORDS_PER_FLUSH * RECORD_SIZE)
+		flushPending = true;
+	return ptr;
+}
 
-	//std::cout << channel << " : " << nSamples << " : " << count << std::endl;
+void OriginalRecording::writeTimestampAndSampleCount(int channel)
+{
+	uint16 samps = BLOCK_LENGTH;
 
-	jassert(count == nSamples); // make sure all the data was written
-	(void)count;  // Suppress unused variable warning in release builds
+	int64 ts = getTimestamp(channel) + samplesSinceLastTimestamp[channel];
 
-	diskWriteLock.exit();
+	uint8* ptr = getContinuousWritePointer(channel, 12);
+	memcpy(ptr, &ts, 8);
+	memcpy(ptr + 8, &samps, 2);
+	memcpy(ptr + 10, &recordingNumber, 2);
+}
 
-	if (blockIndex[writeChannel] + nSamples == BLOCK_LENGTH)
-	{
-		writeRecordMarker(fileArray[writeChannel]);
-	}
+void OriginalRecording::writeRecordMarker(int channel)
+{
+	// write a 10-byte marker indicating the end of a record
+	memcpy(getContinuousWritePointer(channel, 10), recordMarker, 10);
 }
 
-void OriginalRecording::writeTimestampAndSampleCount(FILE* file, int channel)
+void OriginalRecording::endChannelBlock(bool lastBlock)
 {
-	diskWriteLock.enter();
+	if (flushPending)
+		flushContinuousFiles();
+}
 
-	uint16 samps = BLOCK_LENGTH;
+void OriginalRecording::flushContinuousFiles()
+{
+	//The previous batch must be on disk before its buffers can be reused
+	waitForWriters();
 
-	// int sourceNodeId = getChannel(channel)->sourceNodeId;
+	if (writeFailed.exchange(false))
+	{
+		std::cerr << "Open Ephys format: unable to write continuous data, keeping it until it can be written" << std::endl;
+		CoreServices::sendStatusMessage("Unable to write continuous data to disk");
+	}
 
-	int64 ts = getTimestamp(channel) + samplesSinceLastTimestamp[channel];
+	int stoppedChannels = 0;
+	for (int i = 0; i < continuousFiles.size(); i++)
+	{
+		ContinuousFile* file = continuousFiles[i];
+		if (file->flushBytes + file->assembledBytes > MAX_BACKLOG_FLUSHES * RECORDS_PER_FLUSH * RECORD_SIZE)
+		{
+			//Dropping records from the middle of the file would break its layout, so the
+			//channel stops here and keeps what was written so far
+			droppedBytes += file->flushBytes + file->assembledBytes;
+			file->flushBytes = 0;
+			file->path = String();
+			stoppedChannels++;
+		}
+		else if (file->flushBytes > 0)
+		{
+			//Data a writer could not write is kept, with the new records after it
+			file->flushing.ensureSize(file->flushBytes + file->assembledBytes);
+			memcpy(static_cast<uint8*>(file->flushing.getData()) + file->flushBytes, file->assembling.getData(), file->assembledBytes);
+			file->flushBytes += file->assembledBytes;
+		}
+		else
+		{
+			file->assembling.swapWith(file->flushing);
+			file->flushBytes = file->assembledBytes;
+		}
+		file->assembledBytes = 0;
+	}
+	flushPending = false;
 
-	fwrite(&ts,                       // ptr
-		8,                               // size of each element
-		1,                               // count
-		file); // ptr to FILE object
+	if (stoppedChannels > 0)
+	{
+		std::cerr << "Open Ephys format: stopped recording " << stoppedChannels << " continuous channels that could not be written" << std::endl;
+		CoreServices::sendStatusMessage("Stopped recording " + String(stoppedChannels) + " channels that could not be written to disk");
+	}
 
-	fwrite(&samps,                           // ptr
-		2,                               // size of each element
-		1,                               // count
-		file); // ptr to FILE object
+	for (int i = 0; i < writerJobs.size(); i++)
+	{
+		writerPool->addJob(writerJobs[i], false);
+	}
+}
 
-	fwrite(&recordingNumber,                         // ptr
-		2,                               // size of each element
-		1,                               // count
-		file); // ptr to FILE object
+void OriginalRecording::waitForWriters()
+{
+	for (int i = 0; i < writerJobs.size(); i++)
+	{
+		writerPool->waitForJobToFinish(writerJobs[i], -1);
+	}
+}
 
-	diskWriteLock.exit();
+OriginalRecording::WriterJob::WriterJob(OriginalRecording* e, int first, int stride, int maxOpen)
+	: ThreadPoolJob("Open Ephys format writer"), bytesWritten(0),
+	engine(e), firstChannel(first), channelStride(stride), maxOpenFiles(maxOpen)
+{
 }
 
-void OriginalRecording::writeRecordMarker(FILE* file)
+ThreadPoolJob::JobStatus OriginalRecording::WriterJob::runJob()
 {
-	// write a 10-byte marker indicating the end of a record
+	for (int i = firstChannel; i < engine->continuousFiles.size(); i += channelStride)
+	{
+		ContinuousFile* file = engine->continuousFiles[i];
+		if (file->flushBytes == 0)
+			continue;
 
-	diskWriteLock.enter();
-	fwrite(recordMarker,        // ptr
-		1,                   // size of each element
-		10,                  // count
-		file);               // ptr to FILE object
+		if (file->file == nullptr)
+		{
+			//The channels are written in the same order on every flush, so closing the file opened
+			//last keeps the others open for the next flush and only the ones past the limit are reopened
+			if (openFiles.size() >= maxOpenFiles)
+			{
+				ContinuousFile* last = openFiles.getLast();
+				openFiles.removeLast();
+				fclose(last->file);
+				last->file = nullptr;
+			}
 
-	diskWriteLock.exit();
+			file->file = fopen(file->path.toUTF8(), "ab");
+			if (file->file == nullptr)
+			{
+				engine->writeFailed = true;
+				continue;
+			}
+			openFiles.add(file);
+		}
+
+		size_t count = fwrite(file->flushing.getData(), 1, file->flushBytes, file->file);
+		bytesWritten += count;
+
+		if (count < file->flushBytes)
+		{
+			//Keep what was not written, it is retried on the next flush
+			uint8* data = static_cast<uint8*>(file->flushing.getData());
+			memmove(data, data + count, file->flushBytes - count);
+			file->flushBytes -= count;
+			engine->writeFailed = true;
+		}
+		else
+		{
+			file->flushBytes = 0;
+		}
+	}
+	return jobHasFinished;
+}
+
+void OriginalRecording::WriterJob::closeFiles()
+{
+	for (int i = 0; i < openFiles.size(); i++)
+	{
+		fclose(openFiles[i]->file);
+		openFiles[i]->file = nullptr;
+	}
+	openFiles.clear();
 }
 
 void OriginalRecording::closeFiles()
 {
-	for (int i = 0; i < fileArray.size(); i++)
+	for (int i = 0; i < continuousFiles.size(); i++)
 	{
-		if (fileArray[i] != nullptr)
+		if (blockIndex[i] < BLOCK_LENGTH)
 		{
-			if (blockIndex[i] < BLOCK_LENGTH)
-			{
-				// fill out the rest of the current buffer
-				writeContinuousBuffer(zeroBuffer.getReadPointer(0), BLOCK_LENGTH - blockIndex[i], i);
-				diskWriteLock.enter();
-				fclose(fileArray[i]);
-				diskWriteLock.exit();
-			}
+			// fill out the rest of the current buffer
+			writeContinuousBuffer(zeroBuffer.getReadPointer(0), BLOCK_LENGTH - blockIndex[i], i);
 		}
 	}
-	fileArray.clear();
+	flushContinuousFiles();
+	waitForWriters();
+	for (int i = 0; i < writerJobs.size(); i++)
+	{
+		writerJobs[i]->closeFiles();
+	}
+
+	int64 totalBytes = 0;
+	for (int i = 0; i < writerJobs.size(); i++)
+	{
+		totalBytes += writerJobs[i]->bytesWritten;
+	}
+	double elapsed = (Time::getMillisecondCounterHiRes() - openTime) / 1000.0;
+	if (elapsed > 0)
+	{
+		std::cout << "Open Ephys format: wrote " << totalBytes / (1024.0 * 1024.0) << " MB of continuous data, "
+			<< totalBytes / (1024.0 * 1024.0) / elapsed << " MB/s over the recording" << std::endl;
+	}
+
+	int64 unwrittenBytes = 0;
+	for (int i = 0; i < continuousFiles.size(); i++)
+	{
+		unwrittenBytes += continuousFiles[i]->flushBytes;
+	}
+	unwrittenBytes += droppedBytes;
+	if (unwrittenBytes > 0)
+	{
+		std::cerr << "Open Ephys format: " << unwrittenBytes << " bytes of continuous data could not be written" << std::endl;
+		CoreServices::sendStatusMessage("Some continuous data could not be written to disk");
+	}
+
+	continuousFiles.clear();
 	blockIndex.clear();
 	samplesSinceLastTimestamp.clear();
 	for (int i = 0; i < spikeFileArray.size(); i++)
 	{
 		if (spikeFileArray[i] != nullptr)
 		{
-			diskWriteLock.enter();
 			fclose(spikeFileArray[i]);
 			spikeFileArray.set(i, nullptr);
-			diskWriteLock.exit();
 		}
 	}
 	if (eventFile != nullptr)
 	{
-		diskWriteLock.enter();
 		fclose(eventFile);
 		eventFile = nullptr;
-		diskWriteLock.exit();
 	}
 	if (messageFile != nullptr)
 	{
-		diskWriteLock.enter();
 		fclose(messageFile);
 		messageFile = nullptr;
-		diskWriteLock.exit();
 	}
 
 	writeXml();
@@ -683,16 +813,12 @@ void OriginalRecording::writeSpike(int electrodeIndex, const SpikeEvent* spike)
 		ptrIdx += sizeof(int16);
 	}
 
-	diskWriteLock.enter();
-
 	fwrite(spikeBuffer, 1, totalBytes, spikeFileArray[electrodeIndex]);
 
 	fwrite(&recordingNumber,                         // ptr
 		2,                               // size of each element
 		1,                               // count
 		spikeFileArray[electrodeIndex]); // ptr to FILE object
-
-	diskWriteLock.exit();
 }
 
 void OriginalRecording::writeXml()
@@ -26,10 +26,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "../RecordEngine.h"
 #include <stdio.h>
 #include <map>
+#include <atomic>
 
 #define HEADER_SIZE 1024
 #define BLOCK_LENGTH 1024
 
+//timestamp + sample count + recording number + samples + record marker
+#define RECORD_SIZE (8 + 2 + 2 + 2 * BLOCK_LENGTH + 10)
+//Number of complete records a channel accumulates before the buffers are handed to the writers
+#define RECORDS_PER_FLUSH 32
+#define MAX_WRITER_THREADS 4
+//Continuous files the writers keep open at once, shared between them. The rest are reopened on each flush
+#define MAX_OPEN_CONTINUOUS_FILES 256
+//Flushes' worth of data a channel can hold back while the disk refuses it before the channel stops recording
+#define MAX_BACKLOG_FLUSHES 4
+
 #define VERSION 0.4
 
 #define VSTR(s) #s
@@ -48,6 +59,7 @@ public:
 	void closeFiles() override;
 	void writeData(int writeChannel, int realChannel, const float* buffer, int size) override;
 	void writeSynchronizedData(int writeChannel, int realChannel, const float* dataBuffer, const double* ftsBuffer, int size) override;
+	void endChannelBlock(bool lastBlock) override;
 	void writeEvent(int eventIndex, const MidiMessage& event) override;
 	void resetChannels() override;
 	void addSpikeElectrode(int index, const SpikeChannel* elec) override;
@@ -61,8 +73,13 @@ private:
 	void openFile(File rootFolder, const InfoObjectCommon* ch, int channelIndex);
 	String generateHeader(const InfoObjectCommon* ch);
 	void writeContinuousBuffer(const float* data, int nSamples, int channel);
-	void writeTimestampAndSampleCount(FILE* file, int channel);
-	void writeRecordMarker(FILE* file);
+	void writeTimestampAndSampleCount(int channel);
+	void writeRecordMarker(int channel);
+
+	/** Swaps the assembled records of every channel into the flush buffers and hands them to the writer pool */
+	void flushContinuousFiles();
+	/** Blocks until all the writer jobs have finished their current batch */
+	void waitForWriters();
 
 	void openSpikeFile(File rootFolder, const SpikeChannel* elec, int channelIndex);
 	String generateSpikeHeader(const SpikeChannel* elec);
@@ -82,14 +99,8 @@ private:
 	bool renameFiles;
 	String renamedPrefix;
 
-	/** Holds data that has been converted from float to int16 before
-	saving.
-	*/
-	HeapBlock<int16> continuousDataIntegerBuffer;
-	//int16* continuousDataIntegerBuffer;
-
-	/** Holds data that has been converted from float to int16 before
-	saving.
+	/** Holds data that has been scaled before being converted to
+	big-endian int16 into the record buffers.
 	*/
 	HeapBlock<float> continuousDataFloatBuffer;
 	//float* continuousDataFloatBuffer;
@@ -100,13 +111,59 @@ private:
 
 	AudioSampleBuffer zeroBuffer;
 
+	/** Continuous records are assembled in memory by the record thread, which is the only one
+	touching the assembling buffer. When a channel fills RECORDS_PER_FLUSH records the assembling
+	and flushing buffers of every channel are swapped and the writer pool appends the flushing
+	buffers to disk. Data a writer fails to write stays in the flushing buffer, and the next
+	records are queued behind it, so it is written once the disk accepts it again. A channel
+	holding back more than MAX_BACKLOG_FLUSHES flushes stops recording.
+	*/
+	struct ContinuousFile
+	{
+		ContinuousFile() : file(nullptr) {}
+
+		String path; // empty if the channel is not recorded
+		FILE* file; // opened and closed by the writer of the channel
+		float scaleFactor;
+		MemoryBlock assembling;
+		size_t assembledBytes;
+		MemoryBlock flushing;
+		size_t flushBytes;
+	};
+
+	/** Writes the channels firstChannel, firstChannel + channelStride... and owns their files,
+	keeping at most maxOpenFiles of them open */
+	class WriterJob : public ThreadPoolJob
+	{
+	public:
+		WriterJob(OriginalRecording* engine, int firstChannel, int channelStride, int maxOpenFiles);
+		JobStatus runJob() override;
+		/** Closes the files of the writer. Must not be called while the job runs */
+		void closeFiles();
+
+		int64 bytesWritten;
+	private:
+		OriginalRecording* const engine;
+		const int firstChannel;
+		const int channelStride;
+		const int maxOpenFiles;
+		Array<ContinuousFile*> openFiles;
+	};
+
+	uint8* getContinuousWritePointer(int channel, size_t numBytes);
+
+	OwnedArray<ContinuousFile> continuousFiles;
+	OwnedArray<WriterJob> writerJobs;
+	ScopedPointer<ThreadPool> writerPool;
+	bool flushPending;
+	std::atomic<bool> writeFailed; // set by a writer that could not write all of its data
+	double openTime;
+	int64 droppedBytes; // held back data of the channels that stopped recording
+
 	FILE* eventFile;
 	FILE* messageFile;
-	Array<FILE*> fileArray;
 	Array<FILE*> spikeFileArray;
 
-	CriticalSection diskWriteLock;
-
 	struct ChannelInfo
 	{
 		String name;
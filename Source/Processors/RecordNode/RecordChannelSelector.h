@@ -1,26 +1,19 @@
 #include "../../../JuceLibraryCode/JuceHeader.h"
 #include "../Editors/GenericEditor.h"
+#include "../../UI/Utils/ChannelGrid.h"
 
 class RecordChannelSelector;
 
 enum Select { ALL, NONE, RANGE };
 
-class ChannelButton : public Button	
+/** A channel grid with the red and grey cells of the record node */
+class RecordChannelGrid : public ChannelGrid
 {
 public:
-	ChannelButton(int id, RecordChannelSelector* parent);
-	~ChannelButton();
-    int getId() { return id; };
+	RecordChannelGrid();
+	~RecordChannelGrid();
 private:
-	void mouseDown(const MouseEvent &event);
-	void mouseDrag(const MouseEvent &event);
-	void mouseUp(const MouseEvent &event);
-
-	int id; 
-	RecordChannelSelector* parent;
-    int width;
-    int height;
-	void paintButton(Graphics& g, bool isMouseOver, bool isButtonDown) override;
+	void paintCell(Graphics& g, const juce::Rectangle<int>& cellBounds, int channel, bool state, bool isMouseOver) override;
 };
 
 class SelectButton : public Button	
@@ -41,43 +34,29 @@ private:
 	//TODO:
 };
 
-class RecordChannelSelector : public Component, public Button::Listener, public TextEditor::Listener
+class RecordChannelSelector : public Component, public Button::Listener, public TextEditor::Listener, public ChannelGrid::Listener
 {
 public:
 	RecordChannelSelector(std::vector<bool> channelStates, bool editable);
 	~RecordChannelSelector();
 
-	void mouseMove(const MouseEvent &event);
-	void mouseDown(const MouseEvent &event);
-	void mouseDrag(const MouseEvent &event);
-	void mouseUp(const MouseEvent &event);
 	void buttonClicked(Button *);
-	void modifierKeysChanged(const ModifierKeys& modifiers);
+	void channelStateChanged(ChannelGrid* grid, int channel, bool state);
+
+	/** Returns the state of every channel, in the order they were given to the constructor */
+	std::vector<bool> getChannelStates() const;
 
 	bool editable;
-	bool isDragging;
-	juce::Point<int> startDragCoords;
-	bool firstButtonSelectedState;
 
 	int nChannels;
 
-	OwnedArray<ChannelButton> channelButtons;
-
 private:
-	int convertStringToInteger(String s);
-	Array<int> parseStringIntoRange(int rangeValue);
-
 	void textEditorReturnKeyPressed(TextEditor &);
 	void updateRangeString();
-	void parseRangeString();
+	RecordChannelGrid channelGrid;
 	OwnedArray<SelectButton> selectButtons;
 	ScopedPointer<RangeEditor> rangeEditor;
 
 	String rangeString;
-	Array<int> channelStates;
-	bool mouseDragged;
-	juce::Rectangle<int> dragBox;
-	Array<int> selectedButtons;
-	bool shiftKeyDown;
     
 };
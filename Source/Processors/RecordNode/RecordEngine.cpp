@@ -29,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "EngineConfigWindow.h"
 #include "OpenEphysFormat/OriginalRecording.h"
 #include "BinaryFormat/BinaryRecording.h"
+#include "CompressedFormat/CompressedRecording.h"
 
 RecordEngine::RecordEngine()
 	: manager(nullptr), recordNode(nullptr)
@@ -253,7 +254,7 @@ void RecordEngineManager::addParameter(EngineParameter* param)
 
 int RecordEngineManager::getNumOfBuiltInEngines()
 {
-	return 2;
+	return 3;
 }
 
 RecordEngineManager* RecordEngineManager::createBuiltInEngineManager(int index)
@@ -264,6 +265,8 @@ RecordEngineManager* RecordEngineManager::createBuiltInEngineManager(int index)
 		return BinaryRecording::getEngineManager();
 	case 1: 
 		return OriginalRecording::getEngineManager();
+	case 2:
+		return CompressedRecording::getEngineManager();
 
 	default:
 		return nullptr;
@@ -284,6 +287,10 @@ RecordEngine* RecordEngineManager::instantiateEngine()
 	{
 		return new BinaryRecording();
 	}
+	else if (id == "COMPRESSED")
+	{
+		return new CompressedRecording();
+	}
 	else if (id == "OPENEPHYS")
 	{
 		return new OriginalRecording();
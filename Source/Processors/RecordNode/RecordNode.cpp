@@ -585,15 +585,20 @@ void RecordNode::handleSpike(const SpikeChannel* spikeInfo, const MidiMessage& e
 {
 
 
-	SpikeEventPtr newSpike = SpikeEvent::deserializeFromMessage(event, spikeInfo);
-	if (!newSpike) 
+	SpikeEventView spike(event, spikeInfo);
+	if (!spike.isValid())
 	{
 		std::cout << "Unable to deserialize spike event!" << std::endl; 
 		return;
 	}
 
 	if (recordSpikes)
-		writeSpike(newSpike, spikeInfo);
+	{
+		int electrodeIndex = getSpikeChannelIndex(spikeInfo->getSourceIndex(), spikeInfo->getSourceNodeID(), spikeInfo->getSubProcessorIdx());
+
+		if (electrodeIndex >= 0)
+			spikeQueue->addEvent(event, spike.getTimestamp(), electrodeIndex);
+	}
 	
 
 }
@@ -737,7 +742,13 @@ void RecordNode::writeSpike(const SpikeEvent *spike, const SpikeChannel *spikeEl
 		int electrodeIndex = getSpikeChannelIndex(spikeElectrode->getSourceIndex(), spikeElectrode->getSourceNodeID(), spikeElectrode->getSubProcessorIdx());
 		
 		if (electrodeIndex >= 0)
-			spikeQueue->addEvent(*spike, spike->getTimestamp(), electrodeIndex);
+		{
+			const SpikeChannel* channel = getSpikeChannel(electrodeIndex);
+			size_t size = channel->getSerializedDataSize() + channel->getTotalEventMetaDataSize() + SPIKE_BASE_SIZE + channel->getNumChannels()*sizeof(float);
+			HeapBlock<char> buffer(size);
+			spike->serialize(buffer, size);
+			spikeQueue->addEvent(MidiMessage(buffer, int(size)), spike->getTimestamp(), electrodeIndex);
+		}
 	}
 }
 
@@ -673,9 +673,7 @@ void FifoMonitor::componentBeingDeleted(Component &component)
 
 	auto* channelSelector = (RecordChannelSelector*)component.getChildComponent(0);
 
-	channelStates.clear();
-	for (auto* btn : channelSelector->channelButtons)
-		channelStates.push_back(btn->getToggleState());
+	channelStates = channelSelector->getChannelStates();
 
 	recordNode->updateChannelStates(srcID, subID, channelStates);
 
@@ -57,7 +57,6 @@ public:
 
 private :
 
-	OwnedArray<ChannelButton> channelButtons;
 	void paint(Graphics &g);
 
 	float fillPercentage;
@@ -213,7 +213,7 @@ void RecordThread::writeSynchronizedData(const AudioSampleBuffer& dataBuffer, co
 		if (spikes[sp] == NULL)
 			std::cout << "Got NULL" << std::endl;
 		else
-			m_engine->writeSpike(spikes[sp]->getExtra(), &spikes[sp]->getData());
+			writeSpike(spikes[sp]);
 		//m_engine->writeSpike(0, &spikes[sp]->getData());
 	}
 }
@@ -279,11 +279,20 @@ void RecordThread::writeData(const AudioSampleBuffer& dataBuffer, int maxSamples
 
 	for (int sp = 0; sp < nSpikes; ++sp)
 	{
-		m_engine->writeSpike(spikes[sp]->getExtra(), &spikes[sp]->getData());
+		writeSpike(spikes[sp]);
 	}
 	
 }
 
+void RecordThread::writeSpike(const SpikeMessagePtr& message)
+{
+	int electrodeIndex = message->getExtra();
+	SpikeEventPtr spike = SpikeEvent::deserializeFromMessage(message->getData(), recordNode->getSpikeChannel(electrodeIndex));
+
+	if (spike != nullptr)
+		m_engine->writeSpike(electrodeIndex, spike);
+}
+
 void RecordThread::forceCloseFiles()
 {
 	if (isThreadRunning() || m_cleanExit)
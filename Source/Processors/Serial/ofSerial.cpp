@@ -3,6 +3,7 @@
 //
 
 #include "ofSerial.h"
+#include "../../Utils/LatencyProbe.h"
 //#include "ofUtils.h"
 //#include "ofTypes.h"
 
@@ -130,6 +131,7 @@ ofSerial::ofSerial()
 #endif
     //---------------------------------------------
     bInited = false;
+    bLoopback = false;
 }
 
 //----------------------------------------------------------------
@@ -283,6 +285,14 @@ void ofSerial::enumerateDevices()
 void ofSerial::close()
 {
 
+    if (bLoopback)
+    {
+        loopbackBuffer.clear();
+        bLoopback = false;
+        bInited = false;
+        return;
+    }
+
     //---------------------------------------------
 #ifdef TARGET_WIN32
     //---------------------------------------------
@@ -336,6 +346,16 @@ bool ofSerial::setup(string portName, int baud)
 {
 
     bInited = false;
+    bLoopback = false;
+
+    if (portName == "loopback")
+    {
+        printf("ofSerialInit: opening loopback port\n\n");
+        loopbackBuffer.clear();
+        bLoopback = true;
+        bInited = true;
+        return true;
+    }
 
     //---------------------------------------------
 #if defined( TARGET_OSX ) || defined( TARGET_LINUX )
@@ -526,6 +546,13 @@ int ofSerial::writeBytes(unsigned char* buffer, int length)
         return OF_SERIAL_ERROR;
     }
 
+    if (bLoopback)
+    {
+        loopbackBuffer.insert(loopbackBuffer.end(), buffer, buffer + length);
+        LatencyProbe::markLatest(LatencyProbe::SERIAL_WRITTEN);
+        return length;
+    }
+
     //---------------------------------------------
 #if defined( TARGET_OSX ) || defined( TARGET_LINUX )
     int numWritten = write(fd, buffer, length);
@@ -538,6 +565,7 @@ int ofSerial::writeBytes(unsigned char* buffer, int length)
     }
 
     //ofLog(OF_LOG_VERBOSE,"ofSerial: numWritten %i", numWritten);
+    LatencyProbe::markLatest(LatencyProbe::SERIAL_WRITTEN);
 
     return numWritten;
 #endif
@@ -552,6 +580,7 @@ int ofSerial::writeBytes(unsigned char* buffer, int length)
         return OF_SERIAL_ERROR;
     }
     //ofLog(OF_LOG_VERBOSE,"ofSerial: numWritten %i", (int)written);
+    LatencyProbe::markLatest(LatencyProbe::SERIAL_WRITTEN);
     return (int)written;
 #else
     return 0;
@@ -570,6 +599,16 @@ int ofSerial::readBytes(unsigned char* buffer, int length)
         return OF_SERIAL_ERROR;
     }
 
+    if (bLoopback)
+    {
+        int nRead = std::min(length, (int) loopbackBuffer.size());
+        if (nRead == 0)
+            return OF_SERIAL_NO_DATA;
+        std::copy(loopbackBuffer.begin(), loopbackBuffer.begin() + nRead, buffer);
+        loopbackBuffer.erase(loopbackBuffer.begin(), loopbackBuffer.begin() + nRead);
+        return nRead;
+    }
+
     //---------------------------------------------
 #if defined( TARGET_OSX ) || defined( TARGET_LINUX )
     int nRead = read(fd, buffer, length);
@@ -611,6 +650,9 @@ bool ofSerial::writeByte(unsigned char singleByte)
     unsigned char tmpByte[1];
     tmpByte[0] = singleByte;
 
+    if (bLoopback)
+        return writeBytes(tmpByte, 1) == 1;
+
     //---------------------------------------------
 #if defined( TARGET_OSX ) || defined( TARGET_LINUX )
     int numWritten = 0;
@@ -623,7 +665,7 @@ bool ofSerial::writeByte(unsigned char singleByte)
         return OF_SERIAL_ERROR;
     }
     //ofLog(OF_LOG_VERBOSE,"ofSerial: written byte");
-
+    LatencyProbe::markLatest(LatencyProbe::SERIAL_WRITTEN);
 
     return (numWritten > 0 ? true : false);
 #endif
@@ -639,6 +681,7 @@ bool ofSerial::writeByte(unsigned char singleByte)
     }
 
     //ofLog(OF_LOG_VERBOSE,"ofSerial: written byte");
+    LatencyProbe::markLatest(LatencyProbe::SERIAL_WRITTEN);
 
     return ((int)written > 0 ? true : false);
 #endif
@@ -659,6 +702,9 @@ int ofSerial::readByte()
     unsigned char tmpByte[1];
     memset(tmpByte, 0, 1);
 
+    if (bLoopback)
+        return readBytes(tmpByte, 1) == 1 ? (int)(tmpByte[0]) : OF_SERIAL_NO_DATA;
+
     //---------------------------------------------
 #if defined( TARGET_OSX ) || defined( TARGET_LINUX )
     int nRead = read(fd, tmpByte, 1);
@@ -699,6 +745,13 @@ void ofSerial::flush(bool flushIn, bool flushOut)
         return;
     }
 
+    if (bLoopback)
+    {
+        if (flushIn)
+            loopbackBuffer.clear();
+        return;
+    }
+
     int flushType = 0;
 
     //---------------------------------------------
@@ -733,6 +786,9 @@ void ofSerial::drain()
         return;
     }
 
+    if (bLoopback)
+        return;
+
 #if defined( TARGET_OSX ) || defined( TARGET_LINUX )
     tcdrain(fd);
 #endif
@@ -748,6 +804,9 @@ int ofSerial::available()
         return OF_SERIAL_ERROR;
     }
 
+    if (bLoopback)
+        return (int) loopbackBuffer.size();
+
     int numBytes = 0;
 
     //---------------------------------------------
@@ -90,7 +90,7 @@ public:
 
     void            close();
     bool            setup();    // use default port, baud (0,9600)
-    bool            setup(string portName, int baudrate);
+    bool            setup(string portName, int baudrate);   // "loopback" opens an in-memory port that echoes what is written
     bool            setup(int deviceNumber, int baudrate);
 
 
@@ -115,6 +115,10 @@ protected:
 
     bool    bInited;
 
+    // stand-in for a serial device: written bytes are kept and returned by the reads
+    bool    bLoopback;
+    vector <unsigned char> loopbackBuffer;
+
 #ifdef TARGET_WIN32
 
     char**        portNamesShort;//[MAX_SERIAL_PORTS];
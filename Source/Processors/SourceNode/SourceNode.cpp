@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include "../../AccessClass.h"
 #include "../PluginManager/OpenEphysPlugin.h"
+#include "../../Utils/LatencyProbe.h"
 
 
 SourceNode::SourceNode (const String& name_, DataThreadCreator dt)
@@ -94,7 +95,6 @@ int SourceNode::getTTLState() const
 void SourceNode::resizeBuffers()
 {
 	inputBuffers.clear();
-	eventCodeBuffers.clear();
 	eventStates.clear();
 	if (dataThread != nullptr)
 	{
@@ -103,7 +103,6 @@ void SourceNode::resizeBuffers()
 		for (int i = 0; i < numSubProcs; i++)
 		{
 			inputBuffers.add(dataThread->getBufferAddress(i));
-			eventCodeBuffers.add(new MemoryBlock(10000*sizeof(uint64)));
 			eventStates.add(0);
 		}
 	}
@@ -200,6 +199,7 @@ void SourceNode::setChannelInfo(int channel, String name, float bitVolts)
 void SourceNode::createEventChannels()
 {
 	ttlChannels.clear();
+	discontinuityChannels.clear();
 	if (dataThread)
 	{
 		//Create base TTL event channels
@@ -219,6 +219,14 @@ void SourceNode::createEventChannels()
 			}
 			else
 				ttlChannels.add(nullptr);
+
+			//Marks where the timestamps of the source jump, with the expected and the actual timestamp
+			EventChannel* discontinuities = new EventChannel(EventChannel::INT64_ARRAY, 1, 2, dataThread->getSampleRate(i), this, i);
+			discontinuities->setName(getName() + " timestamp discontinuities");
+			discontinuities->setDescription("Samples of the source \"" + getName() + "\" whose timestamps do not follow on from the previous ones");
+			discontinuities->setIdentifier("sourcediscontinuity");
+			eventChannelArray.add(discontinuities);
+			discontinuityChannels.add(discontinuities);
 		}
 		//Add other events that the source might create
 		Array<EventChannel*> events;
@@ -381,33 +389,45 @@ void SourceNode::process(AudioSampleBuffer& buffer)
 	{
 		int channelsToCopy = getNumOutputs(sub);
 		
-		int nSamples = inputBuffers[sub]->readAllFromBuffer(buffer, &timestamp, static_cast<uint64*>(eventCodeBuffers[sub]->getData()), buffer.getNumSamples(), copiedChannels, channelsToCopy);
+		int nSamples = inputBuffers[sub]->readAllFromBuffer(buffer, timestampSegments, eventCodeChanges, buffer.getNumSamples(), copiedChannels, channelsToCopy);
 		copiedChannels += channelsToCopy;
+		timestamp = timestampSegments.getReference(0).timestamp;
+
+		if (LatencyProbe::isEnabled())
+			LatencyProbe::markBlock(LatencyProbe::BUFFER_READ, timestamp, nSamples, dataThread->getSampleRate(sub));
 
 		setTimestampAndSamples(timestamp, nSamples, sub); 
 
+		//The first segment holds the block timestamp, any other one is a jump
+		for (int s = 1; s < timestampSegments.size(); ++s)
+		{
+			const DataBuffer::TimestampSegment& previous = timestampSegments.getReference(s - 1);
+			const DataBuffer::TimestampSegment& segment = timestampSegments.getReference(s);
+			int64 jump[2] = { previous.timestamp + segment.sampleIndex - previous.sampleIndex, segment.timestamp };
+			BinaryEventPtr event = BinaryEvent::createBinaryEvent(discontinuityChannels[sub], timestamp + segment.sampleIndex, jump, sizeof(jump));
+			addEvent(discontinuityChannels[sub], event, segment.sampleIndex);
+		}
+
 		if (ttlChannels[sub])
 		{
 			int numEventChannels = ttlChannels[sub]->getNumChannels();
-			// fill event buffer
 			uint64 last = eventStates[sub];
-			for (int i = 0; i < nSamples; ++i)
+			//Only the samples where the TTL word changed are listed
+			for (int i = 0; i < eventCodeChanges.size(); ++i)
 			{
-				uint64 current = *(static_cast<uint64*>(eventCodeBuffers[sub]->getData()) + i);
-				//If there has been no change to the TTL word, avoid doing anything at all here
-				if (last != current)
+				const DataBuffer::EventCodeChange& change = eventCodeChanges.getReference(i);
+				uint64 current = change.eventCode;
+				uint64 changedBits = current ^ last;
+				//Create a TTL event for each bit that has changed
+				for (int c = 0; c < numEventChannels && changedBits != 0; ++c, changedBits >>= 1)
 				{
-					//Create a TTL event for each bit that has changed
-					for (int c = 0; c < numEventChannels; ++c)
+					if (changedBits & 0x01)
 					{
-						if (((current >> c) & 0x01) != ((last >> c) & 0x01))
-						{
-							TTLEventPtr event = TTLEvent::createTTLEvent(ttlChannels[sub], timestamp + i, &current, sizeof(uint64), c);
-							addEvent(ttlChannels[sub], event, i);
-						}
+						TTLEventPtr event = TTLEvent::createTTLEvent(ttlChannels[sub], timestamp + change.sampleIndex, &current, sizeof(uint64), c);
+						addEvent(ttlChannels[sub], event, change.sampleIndex);
 					}
-					last = current;
 				}
+				last = current;
 			}
 			eventStates.set(sub, last);
 		}
@@ -108,9 +108,11 @@ private:
     uint64 timestamp;
     //uint64* eventCodeBuffer;
     //int* eventChannelState;
-    OwnedArray<MemoryBlock> eventCodeBuffers;
+	Array<DataBuffer::TimestampSegment> timestampSegments;
+	Array<DataBuffer::EventCodeChange> eventCodeChanges;
 	Array<uint64> eventStates;
 	Array<EventChannel*> ttlChannels;
+	Array<EventChannel*> discontinuityChannels;
 
     int ttlState;
 	void resizeBuffers();
@@ -31,6 +31,79 @@
 #include "ProcessorList.h"
 #include "../Processors/ProcessorGraph/ProcessorGraph.h"
 
+/** Debounces recovery saves. The settings XML is built on the message thread once the
+signal chain has been quiet for a while, and written to disk by this thread. */
+class EditorViewport::RecoveryStateWriter : public Timer,
+    public Thread
+{
+public:
+    RecoveryStateWriter(EditorViewport* ev)
+        : Thread("Recovery config writer"), viewport(ev)
+    {
+        startThread(2);
+    }
+
+    ~RecoveryStateWriter()
+    {
+        stopTimer();
+        signalThreadShouldExit();
+        notify();
+        stopThread(2000);
+    }
+
+    void scheduleSave()
+    {
+        startTimer(500); // restarting the timer postpones the save
+    }
+
+    void cancel()
+    {
+        stopTimer();
+        {
+            const ScopedLock sl(pendingLock);
+            pendingXml = nullptr;
+        }
+        const ScopedLock sl(writeLock);
+    }
+
+    void timerCallback() override
+    {
+        stopTimer();
+        XmlElement* xml = viewport->createSettingsXml();
+        {
+            const ScopedLock sl(pendingLock);
+            pendingXml = xml;
+        }
+        notify();
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            wait(-1);
+
+            const ScopedLock wl(writeLock);
+            ScopedPointer<XmlElement> xml;
+            {
+                const ScopedLock sl(pendingLock);
+                xml = pendingXml.release();
+            }
+            if (xml != nullptr)
+            {
+                File recoveryFile = CoreServices::getSavedStateDirectory().getChildFile("recoveryConfig.xml");
+                xml->writeToFile(recoveryFile, String::empty);
+            }
+        }
+    }
+
+private:
+    EditorViewport* viewport;
+    ScopedPointer<XmlElement> pendingXml;
+    CriticalSection pendingLock;
+    CriticalSection writeLock;
+};
+
 EditorViewport::EditorViewport()
     : leftmostEditor(0),
       message("Drag-and-drop some rows from the top-left box onto this component!"),
@@ -56,6 +129,8 @@ EditorViewport::EditorViewport()
     signalChainManager = new SignalChainManager(this, editorArray,
                                                 signalChainArray);
 
+    recoveryWriter = new RecoveryStateWriter(this);
+
     upButton = new SignalChainScrollButton(UP);
     downButton = new SignalChainScrollButton(DOWN);
     leftButton = new EditorScrollButton(LEFT);
@@ -83,6 +158,7 @@ EditorViewport::EditorViewport()
 
 EditorViewport::~EditorViewport()
 {
+	recoveryWriter = nullptr;
 	signalChainManager = nullptr;
     deleteAllChildren();
 }
@@ -313,7 +389,8 @@ void EditorViewport::clearSignalChain()
     repaint();
 }
 
-void EditorViewport::makeEditorVisible(GenericEditor* editor, bool highlight, bool updateSettings)
+void EditorViewport::makeEditorVisible(GenericEditor* editor, bool highlight, bool updateSettings,
+                                       bool downstreamOnly)
 {
 
 	if (editor == 0)
@@ -326,7 +403,8 @@ void EditorViewport::makeEditorVisible(GenericEditor* editor, bool highlight, bo
     if (!updateSettings)
         signalChainManager->updateVisibleEditors(editor, 0, 0, ACTIVATE);
     else
-        signalChainManager->updateVisibleEditors(editor, 0, 0, UPDATE);
+        signalChainManager->updateVisibleEditors(editor, 0, 0, UPDATE,
+                                                 downstreamOnly ? editor->getProcessor() : nullptr);
 
     refreshEditors();
 
@@ -1220,6 +1298,29 @@ const String EditorViewport::saveState(File fileToUse, String* xmlText)
     //     return error;
     // }
 
+    XmlElement* xml = createSettingsXml();
+
+    if (! xml->writeToFile(currentFile, String::empty))
+        error = "Couldn't write to file ";
+    else
+        error = "Saved configuration as ";
+
+    error += currentFile.getFileName();
+
+	if (xmlText != nullptr)
+	{
+		(*xmlText) = xml->createDocument(String::empty);
+		if ((*xmlText).isEmpty())
+			(*xmlText) = "Couldn't create configuration xml";
+	}
+
+    delete xml;
+
+    return error;
+}
+
+XmlElement* EditorViewport::createSettingsXml()
+{
     Array<GenericProcessor*> splitPoints;
     /** Used to reset saveOrder at end, to allow saving the same processor multiple times*/
     Array<GenericProcessor*> allProcessors;
@@ -1331,23 +1432,17 @@ const String EditorViewport::saveState(File fileToUse, String* xmlText)
     AccessClass::getProcessorList()->saveStateToXml(xml);
     AccessClass::getUIComponent()->saveStateToXml(xml);  // save the UI settings
 
-    if (! xml->writeToFile(currentFile, String::empty))
-        error = "Couldn't write to file ";
-    else
-        error = "Saved configuration as ";
-
-    error += currentFile.getFileName();
-
-	if (xmlText != nullptr)
-	{
-		(*xmlText) = xml->createDocument(String::empty);
-		if ((*xmlText).isEmpty())
-			(*xmlText) = "Couldn't create configuration xml";
-	}
+    return xml;
+}
 
-    delete xml;
+void EditorViewport::saveRecoveryState()
+{
+    recoveryWriter->scheduleSave();
+}
 
-    return error;
+void EditorViewport::cancelRecoveryState()
+{
+    recoveryWriter->cancel();
 }
 
 const String EditorViewport::loadState(File fileToLoad)
@@ -1371,6 +1466,8 @@ const String EditorViewport::loadState(File fileToLoad)
 
     std::cout << "Loading processor graph." << std::endl;
 
+    double stageStart = Time::getMillisecondCounterHiRes();
+
     Array<GenericProcessor*> splitPoints;
 
     XmlDocument doc(currentFile);
@@ -1418,6 +1515,9 @@ const String EditorViewport::loadState(File fileToLoad)
             break;
         }
     }
+
+    const double parseTime = Time::getMillisecondCounterHiRes() - stageStart;
+
     if (!sameVersion)
     {
         String responseString = "Your configuration file was saved from a different version of the GUI than the one you're using. \n";
@@ -1453,11 +1553,19 @@ const String EditorViewport::loadState(File fileToLoad)
 	}
     clearSignalChain();
 
+    stageStart = Time::getMillisecondCounterHiRes();
+
     String description;// = " ";
     int loadOrder = 0;
 
     GenericProcessor* p;
 
+    // Every processor added or switched would update the settings of the whole signal chain,
+    // which makes loading quadratic in the number of processors. The chain is built first and
+    // updated once; channel parameters are set after that, when the processors have their channels.
+    Array<GenericProcessor*> loadedProcessors;
+    signalChainManager->holdSettingsUpdates();
+
     forEachXmlChildElement(*xml, element)
     {
 
@@ -1520,8 +1628,7 @@ const String EditorViewport::loadState(File fileToLoad)
                     p->loadOrder = loadOrder;
                     p->parametersAsXml = processor;
 
-                    //Sets parameters based on XML files
-                    setParametersByXML(p, processor);
+                    loadedProcessors.add(p);
                     loadOrder++;
 
                     if (p->isSplitter() || p->isMerger())
@@ -1601,8 +1708,20 @@ const String EditorViewport::loadState(File fileToLoad)
         editorArray[i]->deselect();
     }
 
+    const double buildTime = Time::getMillisecondCounterHiRes() - stageStart;
+    stageStart = Time::getMillisecondCounterHiRes();
+
+    signalChainManager->releaseSettingsUpdates();
+
+    //Sets parameters based on XML files
+    for (int i = 0; i < loadedProcessors.size(); i++)
+        setParametersByXML(loadedProcessors[i], loadedProcessors[i]->parametersAsXml);
+
     AccessClass::getProcessorGraph()->restoreParameters();
 
+    const double settingsTime = Time::getMillisecondCounterHiRes() - stageStart;
+    stageStart = Time::getMillisecondCounterHiRes();
+
     AccessClass::getControlPanel()->loadStateFromXml(xml); // load the control panel settings
     AccessClass::getProcessorList()->loadStateFromXml(xml); // load the processor list settings
     AccessClass::getUIComponent()->loadStateFromXml(xml);  // load the UI settings
@@ -1614,6 +1733,11 @@ const String EditorViewport::loadState(File fileToLoad)
 
     AccessClass::getProcessorGraph()->restoreParameters();
 
+    std::cout << "Loaded " << loadedProcessors.size() << " processors: parsing took " << parseTime
+              << " ms, building the signal chain " << buildTime << " ms, updating settings "
+              << settingsTime << " ms and restoring the interface "
+              << Time::getMillisecondCounterHiRes() - stageStart << " ms." << std::endl;
+
     String error = "Opened ";
     error += currentFile.getFileName();
 
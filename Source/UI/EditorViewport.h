@@ -82,8 +82,10 @@ public:
     /** Removes the processor associated with a given editor. */
     void selectEditor(GenericEditor* editor);
 
-    /** Ensures that the user can see the requested editor. */
-    void makeEditorVisible(GenericEditor* editor, bool highlight = true, bool updateSettings = false);
+    /** Ensures that the user can see the requested editor. If downstreamOnly is set, only the
+    settings of the editor's processor and the ones after it are updated. */
+    void makeEditorVisible(GenericEditor* editor, bool highlight = true, bool updateSettings = false,
+                           bool downstreamOnly = false);
 
     /** Updates the boundaries and visibility of all the editors in the signal chain. */
     void refreshEditors();
@@ -152,6 +154,16 @@ public:
 	/** Save the current configuration as an XML file. Reference wrapper*/
 	const String saveState(File filename, String& xmlText);
 
+    /** Creates the XML description of the current configuration. The caller owns the returned element. */
+    XmlElement* createSettingsXml();
+
+    /** Schedules a save of recoveryConfig.xml. Calls made in quick succession are coalesced into a
+    single save, and the file is written on a background thread. */
+    void saveRecoveryState();
+
+    /** Discards any scheduled recovery save and waits for one in progress to finish. */
+    void cancelRecoveryState();
+
     /** Load a saved configuration from an XML file. */
     const String loadState(File filename);
 
@@ -193,6 +205,9 @@ private:
 
     ScopedPointer<SignalChainManager> signalChainManager;
 
+    class RecoveryStateWriter;
+    ScopedPointer<RecoveryStateWriter> recoveryWriter;
+
     Font font;
     Image sourceDropImage;
 
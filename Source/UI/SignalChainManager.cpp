@@ -34,7 +34,7 @@ SignalChainManager::SignalChainManager
  Array<GenericEditor*, CriticalSection>& editorArray_,
  Array<SignalChainTabButton*, CriticalSection>& signalChainArray_)
     : editorArray(editorArray_), signalChainArray(signalChainArray_),
-      ev(ev_), tabSize(30)
+      ev(ev_), tabSize(30), settingsUpdateHolds(0), settingsUpdatePending(false)
 {
     topTab = 0;
 }
@@ -161,7 +161,8 @@ void SignalChainManager::refreshTabs()
 
 
 void SignalChainManager::updateVisibleEditors(GenericEditor* activeEditor,
-                                              int index, int insertionPoint, int action)
+                                              int index, int insertionPoint, int action,
+                                              GenericProcessor* changedProcessor)
 
 {
 
@@ -529,7 +530,7 @@ void SignalChainManager::updateVisibleEditors(GenericEditor* activeEditor,
     if (action != ACTIVATE)
     {
 
-		updateProcessorSettings();
+		updateProcessorSettings(changedProcessor);
     }
 
 
@@ -537,11 +538,19 @@ void SignalChainManager::updateVisibleEditors(GenericEditor* activeEditor,
 
 }
 
-void SignalChainManager::updateProcessorSettings()
+void SignalChainManager::updateProcessorSettings(GenericProcessor* changedProcessor)
 {
+	if (settingsUpdateHolds > 0)
+	{
+		settingsUpdatePending = true;
+		return;
+	}
+
 	// std::cout << "Updating settings." << std::endl;
 
 	Array<GenericProcessor*> splitters;
+	// whether the branch left at each splitter is downstream of the change
+	Array<bool> splitterIsDirty;
 
 	for (int n = 0; n < signalChainArray.size(); n++)
 	{
@@ -550,18 +559,21 @@ void SignalChainManager::updateProcessorSettings()
 		GenericEditor* source = signalChainArray[n]->getEditor();
 		GenericProcessor* p = source->getProcessor();
 
-		//  p->update();
-
-		//  GenericProcessor* dest = p->getDestNode();
+		bool dirty = (changedProcessor == nullptr);
 
 		while (p != 0)
 		{
 			// iterate through processors
-			p->update();
+			if (p == changedProcessor)
+				dirty = true;
+
+			if (dirty)
+				p->update();
 
 			if (p->isSplitter())
 			{
 				splitters.add(p);
+				splitterIsDirty.add(dirty);
 			}
 
 			p = p->getDestNode();
@@ -571,11 +583,28 @@ void SignalChainManager::updateProcessorSettings()
 				splitters.getFirst()->switchIO(); // switch the signal chain
 				p = splitters[0]->getDestNode();
 				splitters.getFirst()->switchIO(); // switch it back
+				dirty = splitterIsDirty.getFirst();
 				splitters.remove(0);
+				splitterIsDirty.remove(0);
 			}
 		}
 	}
 
-    File recoveryFile = CoreServices::getSavedStateDirectory().getChildFile("recoveryConfig.xml");
-    AccessClass::getEditorViewport()->saveState(recoveryFile);
+	AccessClass::getEditorViewport()->saveRecoveryState();
+}
+
+void SignalChainManager::holdSettingsUpdates()
+{
+	settingsUpdateHolds++;
+}
+
+void SignalChainManager::releaseSettingsUpdates()
+{
+	jassert(settingsUpdateHolds > 0);
+
+	if (--settingsUpdateHolds > 0 || !settingsUpdatePending)
+		return;
+
+	settingsUpdatePending = false;
+	updateProcessorSettings();
 }
@@ -49,8 +49,10 @@ public:
                        Array<SignalChainTabButton*, CriticalSection>&);
     ~SignalChainManager();
 
-    /** Updates the editors currently displayed by the EditorViewport.*/
-    void updateVisibleEditors(GenericEditor* activeEditor, int index, int insertionPoint, int action);
+    /** Updates the editors currently displayed by the EditorViewport. If changedProcessor is set,
+    only that processor and the ones downstream of it have their settings updated.*/
+    void updateVisibleEditors(GenericEditor* activeEditor, int index, int insertionPoint, int action,
+                              GenericProcessor* changedProcessor = nullptr);
 
     /** Creates a tab button for a new signal chain. */
     void createNewTab(GenericEditor* editor);
@@ -69,7 +71,16 @@ public:
     /** Clears the signal chain.*/
     void clearSignalChain();
 
-	void updateProcessorSettings();
+    /** Calls update() on the processors of every signal chain, in signal order. If changedProcessor is
+    set, only that processor and the ones downstream of it are updated, as the settings of the rest
+    of the chain cannot have changed.*/
+	void updateProcessorSettings(GenericProcessor* changedProcessor = nullptr);
+
+    /** Defers updateProcessorSettings() while a whole signal chain is being built, as when a
+    configuration is loaded. Holds nest; the last release runs a single update of every signal
+    chain if any was requested in the meantime.*/
+    void holdSettingsUpdates();
+    void releaseSettingsUpdates();
 
 private:
 
@@ -91,6 +102,9 @@ private:
 
     const int tabSize;
 
+    int settingsUpdateHolds;
+    bool settingsUpdatePending;
+
 
 };
 
@@ -0,0 +1,494 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2019 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "ChannelGrid.h"
+#include "../../Utils/ListSliceParser.h"
+
+using namespace juce;
+
+
+static const Colour COLOUR_BORDER (Colour::fromRGB (189, 189, 189));
+
+
+/** The component shown in the viewport. It has the size of the whole grid, but only
+    paints the cells inside the clip region and hands its mouse events to the grid. */
+class ChannelGrid::GridContent : public Component
+{
+public:
+    GridContent (ChannelGrid& owner)
+        : m_owner (owner)
+    {
+        setOpaque (false);
+    }
+
+    void paint (Graphics& g) override
+    {
+        if (m_owner.m_numChannels == 0)
+            return;
+
+        const juce::Rectangle<int> clip = g.getClipBounds();
+
+        const int firstRow = jmax (0, clip.getY() / m_owner.m_verticalStep);
+        const int lastRow  = (clip.getBottom() - 1) / m_owner.m_verticalStep;
+
+        for (int row = firstRow; row <= lastRow; ++row)
+        {
+            for (int column = 0; column < m_owner.m_numColumns; ++column)
+            {
+                const int channel = row * m_owner.m_numColumns + column;
+
+                if (channel >= m_owner.m_numChannels)
+                    return;
+
+                const juce::Rectangle<int> cellBounds = m_owner.getCellBounds (channel);
+
+                if (cellBounds.intersects (clip))
+                    m_owner.paintCell (g, cellBounds, channel, m_owner.m_states[channel],
+                                       channel == m_owner.m_hoveredChannel);
+            }
+        }
+    }
+
+    void mouseMove (const MouseEvent& e) override
+    {
+        m_owner.setHoveredChannel (m_owner.getChannelAtPosition (e.getPosition()));
+    }
+
+    void mouseExit (const MouseEvent& e) override
+    {
+        m_owner.setHoveredChannel (-1);
+    }
+
+    void mouseDown (const MouseEvent& e) override   { m_owner.mouseDownOnContent (e); }
+    void mouseDrag (const MouseEvent& e) override   { m_owner.mouseDragOnContent (e); }
+    void mouseUp   (const MouseEvent& e) override   { m_owner.mouseUpOnContent(); }
+
+private:
+    ChannelGrid& m_owner;
+
+    JUCE_DECLARE_NON_COPYABLE (GridContent)
+};
+
+
+ChannelGrid::ChannelGrid()
+    : m_font                    (11.f)
+    , m_numChannels             (0)
+    , m_cellWidth               (10)
+    , m_cellHeight              (10)
+    , m_minPadding              (0)
+    , m_numColumns              (1)
+    , m_horizontalStep          (10)
+    , m_verticalStep            (10)
+    , m_hoveredChannel          (-1)
+    , m_firstDraggedChannel     (-1)
+    , m_lastDraggedChannel      (-1)
+    , m_isTogglingEnabled       (true)
+    , m_isRadioMode             (false)
+    , m_isSelectByDragging      (true)
+    , m_listener                (nullptr)
+    , m_content                 (new GridContent (*this))
+{
+    setColour (backgroundColourId,  Colour (0x0));
+    setColour (outlineColourId,     COLOUR_BORDER);
+
+    addAndMakeVisible (m_viewport);
+    m_viewport.setViewedComponent (m_content, false);
+    m_viewport.setScrollBarsShown (false, false, true, false);
+}
+
+
+ChannelGrid::~ChannelGrid()
+{
+}
+
+
+void ChannelGrid::paint (Graphics& g)
+{
+    auto floatLocalBounds = getLocalBounds().toFloat();
+    const float cornerSize = 3.f;
+
+    // Fill background
+    g.setColour (findColour (backgroundColourId));
+    g.fillRoundedRectangle (floatLocalBounds.reduced (1, 1), cornerSize);
+
+    // Draw border
+    g.setColour (findColour (outlineColourId));
+    g.drawRoundedRectangle (floatLocalBounds, cornerSize, 1.f);
+}
+
+
+void ChannelGrid::resized()
+{
+    m_viewport.setBounds (getLocalBounds());
+
+    updateLayout();
+}
+
+
+void ChannelGrid::colourChanged()
+{
+    repaint();
+}
+
+
+void ChannelGrid::updateLayout()
+{
+    const int width = getWidth();
+
+    m_numColumns = jmax (1, width / (m_cellWidth + m_minPadding));
+
+    const int padding = m_numColumns > 1
+                            ? jmax (m_minPadding, (width - m_numColumns * m_cellWidth) / (m_numColumns - 1))
+                            : m_minPadding;
+
+    m_horizontalStep = m_cellWidth  + padding;
+    m_verticalStep   = m_cellHeight + padding;
+
+    m_content->setBounds (m_content->getX(), m_content->getY(), width, jmax (getHeight(), getContentHeight()));
+    m_content->repaint();
+}
+
+
+int ChannelGrid::getContentHeight() const
+{
+    const int numRows = (m_numChannels + m_numColumns - 1) / m_numColumns;
+
+    return numRows > 0 ? (numRows - 1) * m_verticalStep + m_cellHeight : 0;
+}
+
+
+juce::Rectangle<int> ChannelGrid::getCellBounds (int channel) const
+{
+    return juce::Rectangle<int> ((channel % m_numColumns) * m_horizontalStep,
+                                 (channel / m_numColumns) * m_verticalStep,
+                                 m_cellWidth,
+                                 m_cellHeight);
+}
+
+
+int ChannelGrid::getChannelAtPosition (juce::Point<int> position) const
+{
+    if (position.x < 0 || position.y < 0)
+        return -1;
+
+    const int column = position.x / m_horizontalStep;
+    const int row    = position.y / m_verticalStep;
+
+    // Positions between the cells don't belong to any channel
+    if (column >= m_numColumns
+        || position.x % m_horizontalStep >= m_cellWidth
+        || position.y % m_verticalStep   >= m_cellHeight)
+        return -1;
+
+    const int channel = row * m_numColumns + column;
+
+    return channel < m_numChannels ? channel : -1;
+}
+
+
+void ChannelGrid::repaintChannel (int channel)
+{
+    if (channel >= 0 && channel < m_numChannels)
+        m_content->repaint (getCellBounds (channel));
+}
+
+
+void ChannelGrid::setHoveredChannel (int channel)
+{
+    if (channel == m_hoveredChannel)
+        return;
+
+    repaintChannel (m_hoveredChannel);
+    m_hoveredChannel = channel;
+    repaintChannel (m_hoveredChannel);
+}
+
+
+void ChannelGrid::paintCell (Graphics& g, const juce::Rectangle<int>& cellBounds,
+                             int channel, bool state, bool isMouseOver)
+{
+    if (m_isTogglingEnabled)
+    {
+        if (isMouseOver)
+            g.setColour (Colours::white);
+        else
+            g.setColour (state ? Colours::orange : Colours::darkgrey);
+    }
+    else
+    {
+        g.setColour (state ? Colours::yellow : Colours::lightgrey);
+    }
+
+    g.setFont (m_font);
+    g.drawText (String (getChannelLabel (channel)), cellBounds, Justification::centred, true);
+}
+
+
+void ChannelGrid::mouseDownOnContent (const MouseEvent& e)
+{
+    const int channel = getChannelAtPosition (e.getPosition());
+
+    m_firstDraggedChannel = channel;
+    m_lastDraggedChannel  = channel;
+
+    if (channel < 0)
+        return;
+
+    if (! m_isTogglingEnabled)
+    {
+        if (m_listener != nullptr)
+            m_listener->channelStateChanged (this, channel, m_states[channel]);
+    }
+    else if (m_isRadioMode && m_states[channel])
+    {
+        // Like radio buttons, clicking the selected channel reports it again
+        if (m_listener != nullptr)
+            m_listener->channelStateChanged (this, channel, true);
+    }
+    else
+    {
+        setState (channel, ! m_states[channel], sendNotification);
+    }
+}
+
+
+void ChannelGrid::mouseDragOnContent (const MouseEvent& e)
+{
+    if (! m_isSelectByDragging
+        || ! m_isTogglingEnabled
+        || m_isRadioMode)
+        return;
+
+    const int channel = getChannelAtPosition (e.getPosition());
+
+    // Remember the first channel on which we started dragging
+    if (m_firstDraggedChannel == -1)
+        m_firstDraggedChannel = channel;
+
+    if (channel == -1
+        || channel == m_lastDraggedChannel)
+        return;
+
+    m_lastDraggedChannel = channel;
+
+    // Shift + drag deselects, drag selects
+    const bool state = ! e.mods.isShiftDown();
+
+    const int fromChannel = jmin (m_firstDraggedChannel, m_lastDraggedChannel);
+    const int toChannel   = jmax (m_firstDraggedChannel, m_lastDraggedChannel);
+
+    for (int i = fromChannel; i <= toChannel; ++i)
+        setState (i, state, sendNotification);
+}
+
+
+void ChannelGrid::mouseUpOnContent()
+{
+    m_firstDraggedChannel = -1;
+    m_lastDraggedChannel  = -1;
+}
+
+
+void ChannelGrid::setNumChannels (int numChannels, bool stateOfNewChannels)
+{
+    numChannels = jmax (0, numChannels);
+
+    if (numChannels < m_numChannels)
+    {
+        m_states.setRange (numChannels, m_numChannels - numChannels, false);
+        m_labels.removeRange (numChannels, m_numChannels - numChannels);
+    }
+    else
+    {
+        m_states.setRange (m_numChannels, numChannels - m_numChannels, stateOfNewChannels);
+
+        for (int i = m_numChannels; i < numChannels; ++i)
+            m_labels.add (i + 1);
+    }
+
+    m_numChannels = numChannels;
+
+    if (m_hoveredChannel >= m_numChannels)
+        m_hoveredChannel = -1;
+
+    updateLayout();
+}
+
+
+int ChannelGrid::getNumChannels() const
+{
+    return m_numChannels;
+}
+
+
+void ChannelGrid::setChannelLabel (int channel, int label)
+{
+    if (channel >= 0
+        && channel < m_numChannels
+        && m_labels.getUnchecked (channel) != label)
+    {
+        m_labels.set (channel, label);
+        repaintChannel (channel);
+    }
+}
+
+
+int ChannelGrid::getChannelLabel (int channel) const
+{
+    return m_labels[channel];
+}
+
+
+bool ChannelGrid::getState (int channel) const
+{
+    return channel >= 0 && channel < m_numChannels && m_states[channel];
+}
+
+
+void ChannelGrid::setState (int channel, bool state, NotificationType notification)
+{
+    if (channel < 0
+        || channel >= m_numChannels
+        || m_states[channel] == state)
+        return;
+
+    // Like radio buttons, the channel that was on is turned off first
+    if (state && m_isRadioMode)
+    {
+        for (int i = m_states.findNextSetBit (0); i >= 0; i = m_states.findNextSetBit (i + 1))
+            setState (i, false, notification);
+    }
+
+    m_states.setBit (channel, state);
+    repaintChannel (channel);
+
+    if (notification != dontSendNotification
+        && m_listener != nullptr)
+        m_listener->channelStateChanged (this, channel, state);
+}
+
+
+void ChannelGrid::setAllStates (bool state, NotificationType notification)
+{
+    if (notification != dontSendNotification
+        && m_listener != nullptr)
+    {
+        for (int i = 0; i < m_numChannels; ++i)
+            setState (i, state, notification);
+    }
+    else
+    {
+        m_states.setRange (0, m_numChannels, state);
+        m_content->repaint();
+    }
+}
+
+
+void ChannelGrid::setStatesFromString (const String& channelRanges, bool state, NotificationType notification)
+{
+    // The parser returns (first, last, step) triples of zero-based, inclusive channel ranges
+    const Array<int> ranges = ListSliceParser::parseStringIntoRange (channelRanges, m_numChannels);
+
+    for (int i = 0; i + 2 < ranges.size(); i += 3)
+    {
+        for (int channel = ranges[i]; channel <= ranges[i + 1]; channel += ranges[i + 2])
+            setState (channel, state, notification);
+    }
+}
+
+
+Array<int> ChannelGrid::getSelectedChannels() const
+{
+    Array<int> channels;
+
+    for (int i = m_states.findNextSetBit (0); i >= 0 && i < m_numChannels; i = m_states.findNextSetBit (i + 1))
+        channels.add (i);
+
+    return channels;
+}
+
+
+void ChannelGrid::setCellSize (int cellWidth, int cellHeight)
+{
+    if (cellWidth == m_cellWidth && cellHeight == m_cellHeight)
+        return;
+
+    m_cellWidth  = jmax (1, cellWidth);
+    m_cellHeight = jmax (1, cellHeight);
+
+    updateLayout();
+}
+
+
+void ChannelGrid::setMinPaddingBetweenCells (int minPadding)
+{
+    m_minPadding = jmax (0, minPadding);
+
+    updateLayout();
+}
+
+
+void ChannelGrid::setTogglingEnabled (bool isTogglingEnabled)
+{
+    m_isTogglingEnabled = isTogglingEnabled;
+
+    m_content->repaint();
+}
+
+
+bool ChannelGrid::isTogglingEnabled() const
+{
+    return m_isTogglingEnabled;
+}
+
+
+void ChannelGrid::setRadioMode (bool isRadioMode)
+{
+    m_isRadioMode = isRadioMode;
+}
+
+
+bool ChannelGrid::isRadioMode() const
+{
+    return m_isRadioMode;
+}
+
+
+void ChannelGrid::setFastSelectionModeEnabled (bool isFastSelectionMode)
+{
+    m_isSelectByDragging = isFastSelectionMode;
+}
+
+
+void ChannelGrid::setFont (const Font& newFont)
+{
+    m_font = newFont;
+
+    m_content->repaint();
+}
+
+
+void ChannelGrid::setListener (Listener* newListener)
+{
+    m_listener = newListener;
+}
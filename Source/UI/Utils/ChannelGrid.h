@@ -0,0 +1,171 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2019 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef CHANNELGRID_H_INCLUDED
+#define CHANNELGRID_H_INCLUDED
+
+#include <JuceHeader.h>
+#include "../../Processors/PluginManager/OpenEphysPlugin.h"
+
+
+/**
+
+    A grid of on/off channel cells, laid out in rows like a TiledButtonGroupManager,
+    but without a component per channel: the states live in a bitset and only the
+    cells that are visible get painted, so thousands of channels cost no more to
+    create or show than a handful.
+
+    Clicking a cell toggles it. Dragging sets the cells between the first and the
+    current one (mouse drag - to select, shift+mouse drag to deselect), and ranges
+    can also be given as text with the ListSliceParser syntax.
+
+    @see ChannelSelector, ListSliceParser
+*/
+class PLUGIN_API ChannelGrid : public Component
+{
+public:
+    ChannelGrid();
+    virtual ~ChannelGrid();
+
+    enum ColourIds
+    {
+        backgroundColourId              = 0x1000200,  /**< The colour used to fill the grid background. */
+        outlineColourId                 = 0x1000201,  /**< The colour used for the outline of the grid. */
+    };
+
+    class PLUGIN_API Listener
+    {
+    public:
+        virtual ~Listener() {}
+
+        /** Called for every channel whose state changed, or that was clicked while toggling is disabled */
+        virtual void channelStateChanged (ChannelGrid* grid, int channel, bool state) = 0;
+    };
+
+    // Component methods
+    // ===========================================================
+    void paint (Graphics& g)    override;
+    void resized()              override;
+    void colourChanged()        override;
+    // ===========================================================
+
+    /** Sets the number of channels. Channels that are added get the given state */
+    void setNumChannels (int numChannels, bool stateOfNewChannels = false);
+
+    int getNumChannels() const;
+
+    /** Sets the number drawn in a channel's cell, which is the channel index + 1 by default */
+    void setChannelLabel (int channel, int label);
+
+    int getChannelLabel (int channel) const;
+
+    bool getState (int channel) const;
+
+    void setState (int channel, bool state, NotificationType notification = dontSendNotification);
+
+    void setAllStates (bool state, NotificationType notification = dontSendNotification);
+
+    /** Sets the state of the channels given as a ListSliceParser string, e.g. "1-4, [8:2:16]" */
+    void setStatesFromString (const String& channelRanges, bool state, NotificationType notification = dontSendNotification);
+
+    /** Returns the indices of all channels that are on */
+    Array<int> getSelectedChannels() const;
+
+    /** Sets the size of each cell */
+    void setCellSize (int cellWidth, int cellHeight);
+
+    /** Sets the minimal padding between cells */
+    void setMinPaddingBetweenCells (int minPadding);
+
+    /** Returns the height needed to show every row */
+    int getContentHeight() const;
+
+    /** When toggling is disabled clicks don't change the states, but are still reported to the listener */
+    void setTogglingEnabled (bool isTogglingEnabled);
+    bool isTogglingEnabled() const;
+
+    /** In radio mode at most one channel is on: turning one on turns the others off */
+    void setRadioMode (bool isRadioMode);
+    bool isRadioMode() const;
+
+    /** Sets whether dragging the mouse sets a range of channels */
+    void setFastSelectionModeEnabled (bool isFastSelectionMode);
+
+    void setFont (const Font& newFont);
+
+    void setListener (Listener* newListener);
+
+protected:
+    /** Draws a single cell. Override it to give the grid another look */
+    virtual void paintCell (Graphics& g, const juce::Rectangle<int>& cellBounds,
+                            int channel, bool state, bool isMouseOver);
+
+    /** Font used for the channel labels */
+    Font m_font;
+
+private:
+    class GridContent;
+
+    // Returns the channel under a position in the content component, or -1
+    int getChannelAtPosition (juce::Point<int> position) const;
+
+    juce::Rectangle<int> getCellBounds (int channel) const;
+
+    void repaintChannel (int channel);
+    void updateLayout();
+
+    void mouseDownOnContent (const MouseEvent& e);
+    void mouseDragOnContent (const MouseEvent& e);
+    void mouseUpOnContent();
+    void setHoveredChannel (int channel);
+
+    BigInteger m_states;
+    Array<int> m_labels;
+    int m_numChannels;
+
+    int m_cellWidth;
+    int m_cellHeight;
+    int m_minPadding;
+    int m_numColumns;
+    int m_horizontalStep;
+    int m_verticalStep;
+
+    int m_hoveredChannel;
+    int m_firstDraggedChannel;
+    int m_lastDraggedChannel;
+
+    bool m_isTogglingEnabled;
+    bool m_isRadioMode;
+    bool m_isSelectByDragging;
+
+    Listener* m_listener;
+
+    Viewport m_viewport;
+    ScopedPointer<Component> m_content;
+
+    // ===========================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChannelGrid)
+};
+
+
+#endif  // CHANNELGRID_H_INCLUDED
@@ -0,0 +1,166 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "FileReaderBenchmark.h"
+#include "../Processors/FileReader/FileSource.h"
+
+namespace
+{
+	String getOption(const StringArray& parameters, const String& name)
+	{
+		for (int i = 0; i < parameters.size(); ++i)
+		{
+			if (parameters[i].startsWith(name + "="))
+				return parameters[i].fromFirstOccurrenceOf("=", false, false).unquoted();
+		}
+		return String();
+	}
+
+	/** A recording of numChannels channels that is never read, with the channel
+	conversion of the Binary source */
+	class SyntheticSource : public FileSource
+	{
+	public:
+		SyntheticSource(int numChannels)
+		{
+			RecordInfo info;
+			info.name = "benchmark";
+			info.numSamples = 0;
+			info.sampleRate = 30000.0f;
+
+			for (int ch = 0; ch < numChannels; ++ch)
+			{
+				RecordedChannelInfo channel;
+				channel.name = "CH" + String(ch + 1);
+				channel.bitVolts = 0.195f * (1 + ch % 3);
+				info.channels.add(channel);
+			}
+
+			infoArray.add(info);
+			numRecords = 1;
+			setActiveRecord(0);
+		}
+
+		int readData(int16*, int) override { return 0; }
+		void seekTo(int64) override {}
+
+		void processChannelData(int16* inBuffer, float* outBuffer, int channel, int64 numSamples) override
+		{
+			int n = getActiveNumChannels();
+			float bitVolts = getChannelInfo(channel).bitVolts;
+
+			for (int i = 0; i < numSamples; i++)
+			{
+				*(outBuffer + i) = *(inBuffer + (n*i) + channel) * bitVolts;
+			}
+		}
+
+		void processBlockData(int16* inBuffer, float* const* outBuffers, const int* channels, int numChannels, int64 numSamples) override
+		{
+			convertInterleavedData(inBuffer, outBuffers, channels, numChannels, numSamples);
+		}
+
+	private:
+		bool Open(File) override { return true; }
+		void fillRecordInfo() override {}
+		void updateActiveRecord() override {}
+	};
+}
+
+bool FileReaderBenchmark::isRequested(const StringArray& parameters)
+{
+	return parameters.contains("--file-reader-benchmark");
+}
+
+int FileReaderBenchmark::run(const StringArray& parameters)
+{
+	String channelList = getOption(parameters, "--channels");
+	if (channelList.isEmpty())
+		channelList = "32,64,128,256,512,1024";
+
+	StringArray tokens;
+	tokens.addTokens(channelList, ",", "");
+
+	const String blockOption = getOption(parameters, "--block-size");
+	const String blocksOption = getOption(parameters, "--blocks");
+	const int blockSize = blockOption.getIntValue() > 0 ? blockOption.getIntValue() : 697;
+	const int numBlocks = blocksOption.getIntValue() > 0 ? blocksOption.getIntValue() : 1000;
+
+	std::cout << "File reader benchmark: blocks of " << blockSize << " samples, " << numBlocks << " blocks per run" << std::endl;
+	std::cout << "channels  per-channel (us)  block (us)  speedup  output" << std::endl;
+
+	int result = 0;
+	Random random(1234);
+
+	for (int t = 0; t < tokens.size(); ++t)
+	{
+		const int numChannels = tokens[t].getIntValue();
+		if (numChannels <= 0)
+			continue;
+
+		SyntheticSource source(numChannels);
+
+		HeapBlock<int16> interleaved(numChannels * blockSize);
+		for (int i = 0; i < numChannels * blockSize; ++i)
+			interleaved[i] = int16(random.nextInt(65536) - 32768);
+
+		Array<int> channels;
+		for (int ch = 0; ch < numChannels; ++ch)
+			channels.add(ch);
+
+		AudioSampleBuffer perChannel(numChannels, blockSize);
+		AudioSampleBuffer block(numChannels, blockSize);
+
+		int64 perChannelTicks = 0;
+		int64 blockTicks = 0;
+
+		for (int b = 0; b < numBlocks; ++b)
+		{
+			int64 start = Time::getHighResolutionTicks();
+			source.FileSource::processBlockData(interleaved, perChannel.getArrayOfWritePointers(), channels.begin(), numChannels, blockSize);
+			perChannelTicks += Time::getHighResolutionTicks() - start;
+
+			start = Time::getHighResolutionTicks();
+			source.processBlockData(interleaved, block.getArrayOfWritePointers(), channels.begin(), numChannels, blockSize);
+			blockTicks += Time::getHighResolutionTicks() - start;
+		}
+
+		bool identical = true;
+		for (int ch = 0; ch < numChannels && identical; ++ch)
+			identical = memcmp(perChannel.getReadPointer(ch), block.getReadPointer(ch), blockSize * sizeof(float)) == 0;
+
+		if (!identical)
+			result = 1;
+
+		const double perChannelUs = 1.0e6 * Time::highResolutionTicksToSeconds(perChannelTicks) / numBlocks;
+		const double blockUs = 1.0e6 * Time::highResolutionTicksToSeconds(blockTicks) / numBlocks;
+
+		std::cout << String(numChannels).paddedLeft(' ', 8)
+			<< String(perChannelUs, 1).paddedLeft(' ', 18)
+			<< String(blockUs, 1).paddedLeft(' ', 12)
+			<< String(perChannelUs / jmax(blockUs, 1.0e-3), 1).paddedLeft(' ', 9)
+			<< (identical ? "  identical" : "  DIFFERENT") << std::endl;
+	}
+
+	return result;
+}
@@ -0,0 +1,54 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef FILEREADERBENCHMARK_H_INCLUDED
+#define FILEREADERBENCHMARK_H_INCLUDED
+
+#include "../../JuceLibraryCode/JuceHeader.h"
+
+/**
+	Times the conversion of the interleaved int16 samples read by the File Reader into float
+	channels, channel by channel as the sources used to do it and in one pass over the block
+	with FileSource::processBlockData, for each channel count given on the command line.
+
+	Started with:
+	open-ephys --file-reader-benchmark [--channels=32,64,128,256,512,1024] [--block-size=697]
+	[--blocks=1000]
+
+	The default block is what the File Reader converts for a 1024-sample buffer at 44.1 kHz
+	when playing a 30 kHz recording. Prints the time per block of both paths and checks that
+	they give the same output, then quits.
+
+	@see FileSource
+*/
+class FileReaderBenchmark
+{
+public:
+	/** Returns true if the command line asks for a benchmark */
+	static bool isRequested(const StringArray& parameters);
+
+	/** Runs the benchmark. Returns the exit code of the application */
+	static int run(const StringArray& parameters);
+};
+
+#endif  // FILEREADERBENCHMARK_H_INCLUDED
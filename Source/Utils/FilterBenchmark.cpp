@@ -0,0 +1,204 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "FilterBenchmark.h"
+#include "../Processors/Dsp/Dsp.h"
+#include "../Processors/Dsp/PartitionedConvolver.h"
+
+namespace
+{
+	const double highCut = 6000.0;
+	const int transitionSamples = 256;
+
+	String getOption(const StringArray& parameters, const String& name)
+	{
+		for (int i = 0; i < parameters.size(); ++i)
+		{
+			if (parameters[i].startsWith(name + "="))
+				return parameters[i].fromFirstOccurrenceOf("=", false, false).unquoted();
+		}
+		return String();
+	}
+
+	Array<double> getListOption(const StringArray& parameters, const String& name, const String& defaultList)
+	{
+		String list = getOption(parameters, name);
+		if (list.isEmpty())
+			list = defaultList;
+
+		StringArray tokens;
+		tokens.addTokens(list, ",", "");
+
+		Array<double> values;
+		for (int i = 0; i < tokens.size(); ++i)
+		{
+			if (tokens[i].getDoubleValue() > 0)
+				values.add(tokens[i].getDoubleValue());
+		}
+		return values;
+	}
+
+	/** Copies the next block of noise into the buffer, the same for every filter */
+	void fillBlock(AudioSampleBuffer& buffer, const AudioSampleBuffer& noise, int block)
+	{
+		const int offset = (block * buffer.getNumSamples()) % (noise.getNumSamples() - buffer.getNumSamples() + 1);
+		for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+			buffer.copyFrom(ch, 0, noise, ch % noise.getNumChannels(), offset, buffer.getNumSamples());
+	}
+}
+
+bool FilterBenchmark::isRequested(const StringArray& parameters)
+{
+	return parameters.contains("--filter-benchmark");
+}
+
+int FilterBenchmark::run(const StringArray& parameters)
+{
+	const Array<double> channelCounts = getListOption(parameters, "--channels", "32,64,128,384");
+	const Array<double> lowCuts = getListOption(parameters, "--low-cuts", "300,100,30");
+	const Array<double> partitionSizes = getListOption(parameters, "--partition-sizes", "64,256,512");
+
+	const String blockOption = getOption(parameters, "--block-size");
+	const String rateOption = getOption(parameters, "--sample-rate");
+	const String secondsOption = getOption(parameters, "--seconds");
+
+	const int blockSize = blockOption.getIntValue() > 0 ? blockOption.getIntValue() : 1024;
+	const double sampleRate = rateOption.getDoubleValue() > 0 ? rateOption.getDoubleValue() : 30000.0;
+	const double seconds = secondsOption.getDoubleValue() > 0 ? secondsOption.getDoubleValue() : 10.0;
+
+	const int numBlocks = jmax(1, int(seconds * sampleRate / blockSize));
+	const double blockMs = 1000.0 * blockSize / sampleRate;
+
+	// a few distinct channels of noise are enough, the filters don't see the difference
+	AudioSampleBuffer noise(8, jmax(blockSize * 4, int(sampleRate)));
+	Random random(1234);
+	for (int ch = 0; ch < noise.getNumChannels(); ++ch)
+	{
+		float* data = noise.getWritePointer(ch);
+		for (int i = 0; i < noise.getNumSamples(); ++i)
+			data[i] = 100.0f * (random.nextFloat() - 0.5f);
+	}
+
+	std::cout << "Filter benchmark: blocks of " << blockSize << " samples at " << sampleRate << " Hz ("
+		<< String(blockMs, 1) << " ms), " << numBlocks << " blocks per run, high cut " << highCut << " Hz" << std::endl;
+	std::cout << "channels  filter                              ms/block  % real time" << std::endl;
+
+	for (int c = 0; c < channelCounts.size(); ++c)
+	{
+		const int numChannels = int(channelCounts[c]);
+
+		const double iirMs = timeIirFilters(numChannels, blockSize, sampleRate, numBlocks, noise);
+		std::cout << String(numChannels).paddedLeft(' ', 8) << "  "
+			<< String("IIR Butterworth order 2").paddedRight(' ', 34)
+			<< String(iirMs, 3).paddedLeft(' ', 10) << String(100.0 * iirMs / blockMs, 2).paddedLeft(' ', 13) << std::endl;
+
+		for (int l = 0; l < lowCuts.size(); ++l)
+		{
+			for (int p = 0; p < partitionSizes.size(); ++p)
+			{
+				const int partitionSize = nextPowerOfTwo(int(partitionSizes[p]));
+				const double firMs = timeFirFilters(numChannels, blockSize, sampleRate, numBlocks, noise, lowCuts[l], partitionSize);
+
+				const String name = "FIR " + String(PartitionedConvolver::getBandPassKernelLength(sampleRate, lowCuts[l]))
+					+ " taps (" + String(lowCuts[l]) + " Hz), part. " + String(partitionSize);
+
+				std::cout << String(numChannels).paddedLeft(' ', 8) << "  " << name.paddedRight(' ', 34)
+					<< String(firMs, 3).paddedLeft(' ', 10) << String(100.0 * firMs / blockMs, 2).paddedLeft(' ', 13) << std::endl;
+			}
+		}
+	}
+
+	return 0;
+}
+
+double FilterBenchmark::timeIirFilters(int numChannels, int blockSize, double sampleRate, int numBlocks, const AudioSampleBuffer& noise)
+{
+	// set up as the Filter Node does, one filter per channel
+	OwnedArray<Dsp::Filter> filters;
+	for (int ch = 0; ch < numChannels; ++ch)
+	{
+		Dsp::Filter* filter = new Dsp::SmoothedFilterDesign
+			<Dsp::Butterworth::Design::BandPass<2>, 1, Dsp::DirectFormII>(transitionSamples);
+
+		Dsp::Params params;
+		params[0] = sampleRate;
+		params[1] = 2;
+		params[2] = (highCut + 300.0) / 2;
+		params[3] = highCut - 300.0;
+		filter->setParams(params);
+
+		filters.add(filter);
+	}
+
+	AudioSampleBuffer buffer(numChannels, blockSize);
+	int64 ticks = 0;
+
+	for (int block = 0; block < numBlocks; ++block)
+	{
+		fillBlock(buffer, noise, block);
+
+		const int64 start = Time::getHighResolutionTicks();
+		for (int ch = 0; ch < numChannels; ++ch)
+		{
+			float* ptr = buffer.getWritePointer(ch);
+			filters[ch]->process(blockSize, &ptr);
+		}
+		ticks += Time::getHighResolutionTicks() - start;
+	}
+
+	return 1000.0 * Time::highResolutionTicksToSeconds(ticks) / numBlocks;
+}
+
+double FilterBenchmark::timeFirFilters(int numChannels, int blockSize, double sampleRate, int numBlocks, const AudioSampleBuffer& noise,
+	double lowCut, int partitionSize)
+{
+	// the Filter Node groups channels that share a kernel, up to maxChannels per convolver
+	PartitionedConvolver::KernelPtr kernel = PartitionedConvolver::getBandPassKernel(sampleRate, lowCut, highCut, partitionSize);
+
+	OwnedArray<PartitionedConvolver> convolvers;
+	for (int ch = 0; ch < numChannels; ch += PartitionedConvolver::maxChannels)
+	{
+		PartitionedConvolver* convolver = new PartitionedConvolver();
+		convolver->prepare(kernel);
+		convolvers.add(convolver);
+	}
+
+	AudioSampleBuffer buffer(numChannels, blockSize);
+	int64 ticks = 0;
+
+	for (int block = 0; block < numBlocks; ++block)
+	{
+		fillBlock(buffer, noise, block);
+		float* const* channels = buffer.getArrayOfWritePointers();
+
+		const int64 start = Time::getHighResolutionTicks();
+		for (int g = 0; g < convolvers.size(); ++g)
+		{
+			const int first = g * PartitionedConvolver::maxChannels;
+			convolvers[g]->process(channels + first, jmin(PartitionedConvolver::maxChannels, numChannels - first), blockSize);
+		}
+		ticks += Time::getHighResolutionTicks() - start;
+	}
+
+	return 1000.0 * Time::highResolutionTicksToSeconds(ticks) / numBlocks;
+}
@@ -0,0 +1,58 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef FILTERBENCHMARK_H_INCLUDED
+#define FILTERBENCHMARK_H_INCLUDED
+
+#include "../../JuceLibraryCode/JuceHeader.h"
+
+/**
+	Times the band-pass filters of the Filter Node on noise: the Butterworth IIR filters and
+	the linear-phase FIR filters, for every combination of channel count, low cut (which sets
+	the FIR kernel length) and partition size given on the command line.
+
+	Started with:
+	open-ephys --filter-benchmark [--channels=32,64,128,384] [--low-cuts=300,100,30]
+	[--partition-sizes=64,256,512] [--block-size=1024] [--sample-rate=30000] [--seconds=10]
+
+	Prints the processing time per block and the fraction of real time it takes, then quits.
+
+	@see PartitionedConvolver
+*/
+class FilterBenchmark
+{
+public:
+	/** Returns true if the command line asks for a benchmark */
+	static bool isRequested(const StringArray& parameters);
+
+	/** Runs the benchmark. Returns the exit code of the application */
+	static int run(const StringArray& parameters);
+
+private:
+	/** Returns the milliseconds spent filtering each block of numChannels channels */
+	static double timeIirFilters(int numChannels, int blockSize, double sampleRate, int numBlocks, const AudioSampleBuffer& noise);
+	static double timeFirFilters(int numChannels, int blockSize, double sampleRate, int numBlocks, const AudioSampleBuffer& noise,
+		double lowCut, int partitionSize);
+};
+
+#endif  // FILTERBENCHMARK_H_INCLUDED
@@ -0,0 +1,177 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "LatencyBenchmark.h"
+#include "LatencyProbe.h"
+#include "../AccessClass.h"
+#include "../CoreServices.h"
+#include "../Audio/AudioComponent.h"
+
+namespace
+{
+	String getOption(const StringArray& parameters, const String& name)
+	{
+		for (int i = 0; i < parameters.size(); ++i)
+		{
+			if (parameters[i].startsWith(name + "="))
+				return parameters[i].fromFirstOccurrenceOf("=", false, false).unquoted();
+		}
+		return String();
+	}
+}
+
+bool LatencyBenchmark::isRequested(const StringArray& parameters)
+{
+	return parameters.contains("--latency-benchmark");
+}
+
+LatencyBenchmark::LatencyBenchmark(const StringArray& parameters)
+	: secondsPerRun(30), runIndex(0), running(false), runEndTime(0)
+{
+	drivers.addTokens(getOption(parameters, "--drivers"), ",", "");
+	drivers.trim();
+	drivers.removeEmptyStrings();
+
+	StringArray sizes;
+	sizes.addTokens(getOption(parameters, "--buffer-sizes"), ",", "");
+	for (int i = 0; i < sizes.size(); ++i)
+	{
+		if (sizes[i].getIntValue() > 0)
+			bufferSizes.add(sizes[i].getIntValue());
+	}
+
+	// keep the current settings for whatever isn't given
+	if (bufferSizes.isEmpty())
+		bufferSizes.add(0);
+	if (drivers.isEmpty())
+		drivers.add(String());
+
+	const String seconds = getOption(parameters, "--seconds");
+	if (seconds.getIntValue() > 0)
+		secondsPerRun = seconds.getIntValue();
+
+	const String output = getOption(parameters, "--output");
+	outputFile = File::getCurrentWorkingDirectory().getChildFile(output.isEmpty() ? "latency_benchmark.csv" : output);
+}
+
+LatencyBenchmark::~LatencyBenchmark()
+{
+	stopTimer();
+}
+
+int LatencyBenchmark::getNumRuns() const
+{
+	return drivers.size() * bufferSizes.size();
+}
+
+void LatencyBenchmark::start()
+{
+	std::cout << "Latency benchmark: " << getNumRuns() << " runs of " << secondsPerRun << " s" << std::endl;
+
+	LatencyProbe::clearRuns();
+	runIndex = 0;
+	running = false;
+
+	startTimer(250);
+}
+
+bool LatencyBenchmark::configureRun()
+{
+	AudioComponent* audio = AccessClass::getAudioComponent();
+	AudioDeviceManager& deviceManager = audio->deviceManager;
+
+	const String driver = drivers[runIndex / bufferSizes.size()];
+	const int bufferSize = bufferSizes[runIndex % bufferSizes.size()];
+
+	if (driver.isNotEmpty() && deviceManager.getCurrentAudioDeviceType() != driver)
+	{
+		deviceManager.setCurrentAudioDeviceType(driver, true);
+
+		if (deviceManager.getCurrentAudioDeviceType() != driver)
+		{
+			std::cout << "Latency benchmark: audio driver " << driver << " is not available" << std::endl;
+			return false;
+		}
+	}
+
+	if (bufferSize > 0)
+	{
+		AudioDeviceManager::AudioDeviceSetup setup;
+		deviceManager.getAudioDeviceSetup(setup);
+		setup.bufferSize = bufferSize;
+
+		const String error = deviceManager.setAudioDeviceSetup(setup, true);
+		if (error.isNotEmpty())
+		{
+			std::cout << "Latency benchmark: can't use a buffer of " << bufferSize << " samples: " << error << std::endl;
+			return false;
+		}
+	}
+
+	LatencyProbe::setContext(deviceManager.getCurrentAudioDeviceType() + ", buffer of " + String(audio->getBufferSize()) + " samples");
+	return true;
+}
+
+void LatencyBenchmark::timerCallback()
+{
+	if (running)
+	{
+		if (Time::getMillisecondCounter() < runEndTime)
+			return;
+
+		CoreServices::setAcquisitionStatus(false);
+		running = false;
+		++runIndex;
+		return;
+	}
+
+	if (runIndex >= getNumRuns())
+	{
+		finish();
+		return;
+	}
+
+	if (!configureRun())
+	{
+		++runIndex;
+		return;
+	}
+
+	CoreServices::setAcquisitionStatus(true);
+	running = true;
+	runEndTime = Time::getMillisecondCounter() + 1000 * secondsPerRun;
+}
+
+void LatencyBenchmark::finish()
+{
+	stopTimer();
+
+	std::cout << LatencyProbe::getReport() << std::endl;
+
+	if (outputFile.replaceWithText(LatencyProbe::getCsvReport()))
+		std::cout << "Latency benchmark: results saved to " << outputFile.getFullPathName() << std::endl;
+	else
+		std::cout << "Latency benchmark: can't write " << outputFile.getFullPathName() << std::endl;
+
+	JUCEApplication::getInstance()->systemRequestedQuit();
+}
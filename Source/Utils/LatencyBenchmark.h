@@ -0,0 +1,77 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef LATENCYBENCHMARK_H_INCLUDED
+#define LATENCYBENCHMARK_H_INCLUDED
+
+#include "../../JuceLibraryCode/JuceHeader.h"
+
+/**
+	Runs the loaded signal chain once for every combination of audio driver and buffer size
+	given on the command line, and writes the latency measured by the LatencyProbe in each run.
+
+	Started with:
+	open-ephys <chain.xml> --latency-benchmark [--drivers=ALSA,JACK] [--buffer-sizes=256,512,1024]
+	[--seconds=30] [--output=latency.csv]
+
+	The signal chain is expected to start with the Latency Test source and end in an output
+	plugin. The application quits once all the runs are done, after printing the report and
+	saving it as comma-separated values.
+
+	@see LatencyProbe
+*/
+class LatencyBenchmark : private Timer
+{
+public:
+	/** Returns true if the command line asks for a benchmark */
+	static bool isRequested(const StringArray& parameters);
+
+	LatencyBenchmark(const StringArray& parameters);
+	~LatencyBenchmark();
+
+	/** Starts the first run */
+	void start();
+
+private:
+	void timerCallback() override;
+
+	/** Selects the driver and buffer size of the current run. Returns false if they can't be used */
+	bool configureRun();
+
+	void finish();
+
+	int getNumRuns() const;
+
+	StringArray drivers;
+	Array<int> bufferSizes;
+	int secondsPerRun;
+	File outputFile;
+
+	int runIndex;
+	bool running;
+	uint32 runEndTime;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyBenchmark);
+};
+
+#endif  // LATENCYBENCHMARK_H_INCLUDED
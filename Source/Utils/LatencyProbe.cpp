@@ -0,0 +1,366 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "LatencyProbe.h"
+
+namespace
+{
+	enum Measure
+	{
+		FIFO_WAIT = 0,
+		CALLBACK_POSITION,
+		EVENT_DISPATCH,
+		OUTPUT_HANDLING,
+		SERIAL_WRITE,
+		TOTAL,
+		NUM_MEASURES
+	};
+
+	const char* const measureNames[NUM_MEASURES] =
+	{
+		"FIFO wait", "Callback position", "Event dispatch", "Output handling", "Serial write", "Total"
+	};
+
+	/** Measure recorded when a pulse goes from the previous stage to each one */
+	const int stageMeasures[LatencyProbe::NUM_STAGES] =
+	{
+		-1, FIFO_WAIT, EVENT_DISPATCH, OUTPUT_HANDLING, SERIAL_WRITE
+	};
+
+	/** Upper edges of the histogram bins, in ms. The last bin holds everything above */
+	const int numBins = 11;
+	const double binEdges[numBins - 1] = { 0.1, 0.2, 0.5, 1.0, 2.0, 5.0, 10.0, 20.0, 50.0, 100.0 };
+
+	/** Pulses in flight. Pulses are usually spaced by hundreds of ms, so only a few are pending at once */
+	const int maxPendingPulses = 64;
+
+	/** Values reserved per measure at the start of a run */
+	const int reservedValues = 16384;
+
+	struct PulseRecord
+	{
+		int64 timestamp;
+		int numSamples;
+		int64 ticks[LatencyProbe::NUM_STAGES];
+	};
+
+	struct Run
+	{
+		String label;
+		int numPulses;
+		Array<float> values[NUM_MEASURES];
+	};
+
+	struct ProbeState
+	{
+		ProbeState() : nextPulse(0)
+		{
+			zeromem(pulses, sizeof(pulses));
+		}
+
+		SpinLock lock;
+		PulseRecord pulses[maxPendingPulses];
+		int nextPulse;
+		String context;
+		ScopedPointer<Run> currentRun;
+		OwnedArray<Run> runs;
+	};
+
+	ProbeState& getState()
+	{
+		static ProbeState state;
+		return state;
+	}
+
+	float ticksToMs(int64 ticks)
+	{
+		return float(Time::highResolutionTicksToSeconds(ticks) * 1000.0);
+	}
+
+	/** Sets the time a pulse reached a stage, if it's the first time, and records the
+	time since the previous stage. Must be called with the lock held */
+	void markRecord(ProbeState& state, PulseRecord& record, LatencyProbe::Stage stage, int64 now)
+	{
+		if (record.ticks[stage] != 0)
+			return;
+
+		record.ticks[stage] = now;
+
+		if (state.currentRun == nullptr || stage == LatencyProbe::PULSE_INJECTED)
+			return;
+
+		if (record.ticks[stage - 1] != 0)
+			state.currentRun->values[stageMeasures[stage]].add(ticksToMs(now - record.ticks[stage - 1]));
+
+		if (stage == LatencyProbe::SERIAL_WRITTEN)
+			state.currentRun->values[TOTAL].add(ticksToMs(now - record.ticks[LatencyProbe::PULSE_INJECTED]));
+	}
+
+	struct Statistics
+	{
+		Statistics(Array<float> values)
+			: count(values.size()), mean(0), p50(0), p90(0), p99(0), max(0)
+		{
+			zeromem(bins, sizeof(bins));
+
+			if (count == 0)
+				return;
+
+			values.sort();
+
+			for (int i = 0; i < count; ++i)
+			{
+				mean += values.getUnchecked(i);
+
+				int bin = 0;
+				while (bin < numBins - 1 && values.getUnchecked(i) > binEdges[bin])
+					++bin;
+				++bins[bin];
+			}
+
+			mean /= count;
+			p50 = values[int(0.5 * (count - 1))];
+			p90 = values[int(0.9 * (count - 1))];
+			p99 = values[int(0.99 * (count - 1))];
+			max = values.getLast();
+		}
+
+		int count;
+		double mean;
+		float p50, p90, p99, max;
+		int bins[numBins];
+	};
+}
+
+Atomic<int> LatencyProbe::enabledFlag;
+
+void LatencyProbe::setEnabled(bool enabled)
+{
+	enabledFlag = enabled ? 1 : 0;
+}
+
+void LatencyProbe::setContext(const String& context)
+{
+	ProbeState& state = getState();
+	const SpinLock::ScopedLockType lock(state.lock);
+	state.context = context;
+}
+
+void LatencyProbe::beginRun(const String& label)
+{
+	ScopedPointer<Run> run = new Run();
+	run->numPulses = 0;
+
+	for (int i = 0; i < NUM_MEASURES; ++i)
+		run->values[i].ensureStorageAllocated(reservedValues);
+
+	ProbeState& state = getState();
+	const SpinLock::ScopedLockType lock(state.lock);
+
+	run->label = state.context.isEmpty() ? label : state.context + ", " + label;
+	zeromem(state.pulses, sizeof(state.pulses));
+	state.nextPulse = 0;
+	state.currentRun = run.release();
+}
+
+void LatencyProbe::endRun()
+{
+	ProbeState& state = getState();
+	const SpinLock::ScopedLockType lock(state.lock);
+
+	if (state.currentRun != nullptr)
+		state.runs.add(state.currentRun.release());
+}
+
+void LatencyProbe::clearRuns()
+{
+	ProbeState& state = getState();
+	const SpinLock::ScopedLockType lock(state.lock);
+	state.runs.clear();
+}
+
+void LatencyProbe::markPulse(int64 timestamp, int numSamples)
+{
+	if (!isEnabled())
+		return;
+
+	const int64 now = Time::getHighResolutionTicks();
+
+	ProbeState& state = getState();
+	const SpinLock::ScopedLockType lock(state.lock);
+
+	PulseRecord& record = state.pulses[state.nextPulse];
+	state.nextPulse = (state.nextPulse + 1) % maxPendingPulses;
+
+	zeromem(&record, sizeof(record));
+	record.timestamp = timestamp;
+	record.numSamples = jmax(1, numSamples);
+	markRecord(state, record, PULSE_INJECTED, now);
+
+	if (state.currentRun != nullptr)
+		++state.currentRun->numPulses;
+}
+
+void LatencyProbe::markBlock(Stage stage, int64 firstTimestamp, int numSamples, float sampleRate)
+{
+	if (!isEnabled() || numSamples <= 0)
+		return;
+
+	const int64 now = Time::getHighResolutionTicks();
+
+	ProbeState& state = getState();
+	const SpinLock::ScopedLockType lock(state.lock);
+
+	for (int i = 0; i < maxPendingPulses; ++i)
+	{
+		PulseRecord& record = state.pulses[i];
+		const int64 offset = record.timestamp - firstTimestamp;
+
+		if (record.ticks[PULSE_INJECTED] == 0 || offset < 0 || offset >= numSamples || record.ticks[stage] != 0)
+			continue;
+
+		markRecord(state, record, stage, now);
+
+		if (state.currentRun != nullptr && sampleRate > 0)
+			state.currentRun->values[CALLBACK_POSITION].add(float(offset * 1000.0 / sampleRate));
+	}
+}
+
+void LatencyProbe::markTimestamp(Stage stage, int64 timestamp)
+{
+	if (!isEnabled())
+		return;
+
+	const int64 now = Time::getHighResolutionTicks();
+
+	ProbeState& state = getState();
+	const SpinLock::ScopedLockType lock(state.lock);
+
+	for (int i = 0; i < maxPendingPulses; ++i)
+	{
+		PulseRecord& record = state.pulses[i];
+
+		if (record.ticks[PULSE_INJECTED] != 0
+			&& timestamp >= record.timestamp
+			&& timestamp < record.timestamp + record.numSamples)
+		{
+			markRecord(state, record, stage, now);
+			return;
+		}
+	}
+}
+
+void LatencyProbe::markLatest(Stage stage)
+{
+	if (!isEnabled() || stage == PULSE_INJECTED)
+		return;
+
+	const int64 now = Time::getHighResolutionTicks();
+
+	ProbeState& state = getState();
+	const SpinLock::ScopedLockType lock(state.lock);
+
+	PulseRecord* latest = nullptr;
+
+	for (int i = 0; i < maxPendingPulses; ++i)
+	{
+		PulseRecord& record = state.pulses[i];
+
+		if (record.ticks[stage - 1] != 0 && record.ticks[stage] == 0
+			&& (latest == nullptr || record.ticks[stage - 1] > latest->ticks[stage - 1]))
+			latest = &record;
+	}
+
+	if (latest != nullptr)
+		markRecord(state, *latest, stage, now);
+}
+
+String LatencyProbe::getReport()
+{
+	ProbeState& state = getState();
+	const SpinLock::ScopedLockType lock(state.lock);
+
+	String report;
+
+	String binHeader;
+	for (int b = 0; b < numBins - 1; ++b)
+		binHeader << String::formatted("%7s", ("<" + String(binEdges[b])).toRawUTF8());
+	binHeader << String::formatted("%7s", (">" + String(binEdges[numBins - 2])).toRawUTF8());
+
+	for (int r = 0; r < state.runs.size(); ++r)
+	{
+		const Run* run = state.runs[r];
+
+		report << run->label << " (" << run->numPulses << " pulses)" << newLine;
+		report << String::formatted("  %-18s %6s %8s %8s %8s %8s %8s  ", "ms", "n", "mean", "p50", "p90", "p99", "max")
+			<< binHeader << newLine;
+
+		for (int m = 0; m < NUM_MEASURES; ++m)
+		{
+			const Statistics stats(run->values[m]);
+
+			report << String::formatted("  %-18s %6d %8.3f %8.3f %8.3f %8.3f %8.3f  ",
+				measureNames[m], stats.count, stats.mean, stats.p50, stats.p90, stats.p99, stats.max);
+
+			for (int b = 0; b < numBins; ++b)
+				report << String::formatted("%7d", stats.bins[b]);
+
+			report << newLine;
+		}
+
+		report << newLine;
+	}
+
+	return report;
+}
+
+String LatencyProbe::getCsvReport()
+{
+	ProbeState& state = getState();
+	const SpinLock::ScopedLockType lock(state.lock);
+
+	String csv = "run,measure,count,mean_ms,p50_ms,p90_ms,p99_ms,max_ms";
+	for (int b = 0; b < numBins - 1; ++b)
+		csv << ",below_" << binEdges[b] << "ms";
+	csv << ",above_" << binEdges[numBins - 2] << "ms" << newLine;
+
+	for (int r = 0; r < state.runs.size(); ++r)
+	{
+		const Run* run = state.runs[r];
+
+		for (int m = 0; m < NUM_MEASURES; ++m)
+		{
+			const Statistics stats(run->values[m]);
+
+			csv << run->label.quoted() << "," << measureNames[m] << "," << stats.count
+				<< String::formatted(",%.4f,%.4f,%.4f,%.4f,%.4f", stats.mean, stats.p50, stats.p90, stats.p99, stats.max);
+
+			for (int b = 0; b < numBins; ++b)
+				csv << "," << stats.bins[b];
+
+			csv << newLine;
+		}
+	}
+
+	return csv;
+}
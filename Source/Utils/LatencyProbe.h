@@ -0,0 +1,99 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef LATENCYPROBE_H_INCLUDED
+#define LATENCYPROBE_H_INCLUDED
+
+#include "../../JuceLibraryCode/JuceHeader.h"
+#include "../Processors/PluginManager/OpenEphysPlugin.h"
+
+/**
+	Measures how long test pulses take to go through the closed-loop path, from the moment
+	a DataThread writes them into its DataBuffer to the moment an output device is written to.
+
+	Pulses are identified by their sample timestamp. Each stage of the path marks the pulses
+	it handles, and the time between consecutive stages is accumulated per run, so runs with
+	different block sizes or audio drivers can be compared side by side.
+
+	All the mark methods return immediately while the probe is disabled, so the hooks can stay
+	in the processing path. While enabled they take a short spin lock and don't allocate unless
+	a run collects more pulses than it reserved memory for.
+
+	@see LatencyBenchmark
+*/
+class PLUGIN_API LatencyProbe
+{
+public:
+	enum Stage
+	{
+		PULSE_INJECTED = 0,	//!< Written into the DataBuffer by the DataThread
+		BUFFER_READ,		//!< Read from the DataBuffer by the SourceNode
+		EVENT_DISPATCHED,	//!< First handleEvent() call for its events in checkForEvents()
+		OUTPUT_HANDLED,		//!< Turned into a command by an output plugin
+		SERIAL_WRITTEN,		//!< Command written to the serial port
+		NUM_STAGES
+	};
+
+	/** Enables or disables the hooks */
+	static void setEnabled(bool enabled);
+	static bool isEnabled() { return enabledFlag.get() != 0; }
+
+	/** Starts a new run. The label is prefixed with the context, if any */
+	static void beginRun(const String& label);
+
+	/** Finishes the current run, keeping its results for the report */
+	static void endRun();
+
+	/** Sets a description of the current settings (audio driver, buffer size...) that is added
+	to the labels of the following runs */
+	static void setContext(const String& context);
+
+	/** Discards the results of all runs */
+	static void clearRuns();
+
+	/** Registers a pulse that starts at timestamp and lasts numSamples samples. Events with a
+	timestamp inside the pulse are considered to be caused by it. */
+	static void markPulse(int64 timestamp, int numSamples);
+
+	/** Marks the pulses that start inside a block of samples read by the SourceNode, recording
+	also their position inside the block */
+	static void markBlock(Stage stage, int64 firstTimestamp, int numSamples, float sampleRate);
+
+	/** Marks the pulse that caused an event with the given timestamp */
+	static void markTimestamp(Stage stage, int64 timestamp);
+
+	/** Marks the most recent pulse that reached the previous stage but not this one, for stages
+	that don't know the timestamp they are dealing with */
+	static void markLatest(Stage stage);
+
+	/** Returns a text table with the statistics and histograms of every run */
+	static String getReport();
+
+	/** Returns the statistics of every run as comma-separated values, one line per run and measure */
+	static String getCsvReport();
+
+private:
+	static Atomic<int> enabledFlag;
+};
+
+#endif  // LATENCYPROBE_H_INCLUDED
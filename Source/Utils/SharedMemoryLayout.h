@@ -0,0 +1,169 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SHAREDMEMORYLAYOUT_H_INCLUDED
+#define SHAREDMEMORYLAYOUT_H_INCLUDED
+
+// This header only depends on the standard library, so processes outside the GUI can include it as is.
+#include <atomic>
+#include <cstdint>
+
+/**
+	Layout of the shared-memory streams written by the Shared Memory Sink and read by
+	external analysis processes, or written by external acquisition processes and read by the
+	Shared Memory Source.
+
+	The region starts with a RegionHeader. Every offset is counted in bytes from the start of
+	the region and is a multiple of 64.
+
+	Continuous data: each stream (one per source subprocessor) is a ring of `capacity` frames.
+	A frame is `numChannels` interleaved samples (int16 or float), with an int64 sample number
+	and a uint64 TTL word in two parallel rings. Frame f is stored at index f % capacity.
+	To write frames [w, w + n) the writer first stores w + n in `writeReserve`, issues a release
+	fence, fills the frames and then stores w + n in `writeSequence` with release semantics.
+	A reader that has consumed the frames below its cursor c:
+	  1. loads writeSequence w (acquire) and reads frames [max(c, w - capacity), w) in place
+	  2. issues an acquire fence and loads writeReserve r. Frames below r - capacity may have
+	     been overwritten while they were being read and must be discarded.
+	The frames that were skipped or discarded are lost: the reader adds them to its slot.
+
+	Events: a byte ring of `eventCapacity` bytes holding records that start with a RecordHeader
+	and are padded to 8 bytes. Records never wrap: when one doesn't fit before the end of the
+	ring, a PADDING record fills the rest of it, or nothing if fewer than sizeof (RecordHeader)
+	bytes are left, in which case readers skip to the start of the ring. `eventWritePosition`
+	and `eventReserve` count bytes written since the writer started and follow the same rules
+	as the frame counters. A reader that falls a whole ring behind can't find the next record
+	boundary, so it skips to eventWritePosition.
+
+	The writer never waits for readers. Readers claim a ReaderSlot by swapping `active` from 0 to
+	their process id, and publish their cursors and overrun counts there for monitoring.
+	`generation` changes every time the writer restarts, which invalidates every cursor.
+*/
+namespace SharedMemoryLayout
+{
+	const uint32_t magic = 0x4d53454f;		// "OESM"
+	const uint32_t version = 1;
+
+	const int maxStreams = 16;
+	const int maxReaders = 16;
+	const int nameLength = 64;
+
+	enum SampleFormat : uint32_t
+	{
+		INT16_SAMPLES = 0,
+		FLOAT_SAMPLES = 1
+	};
+
+	enum RecordType : uint16_t
+	{
+		PADDING_RECORD = 0,
+		TTL_RECORD = 1,
+		TEXT_RECORD = 2,
+		SPIKE_RECORD = 3
+	};
+
+	struct alignas(64) ReaderSlot
+	{
+		std::atomic<uint32_t> active;						// 0 when free, else the process id of the reader
+		uint32_t reserved;
+		std::atomic<uint64_t> streamCursors[maxStreams];	// frames consumed
+		std::atomic<uint64_t> eventCursor;					// event bytes consumed
+		std::atomic<uint64_t> overruns;					// times the reader fell a whole ring behind
+		std::atomic<uint64_t> lostFrames;
+		std::atomic<uint64_t> lostEventBytes;
+	};
+
+	struct alignas(64) StreamHeader
+	{
+		char name[nameLength];			// null-terminated
+		uint32_t numChannels;
+		uint32_t sampleFormat;			// SampleFormat
+		float sampleRate;
+		float bitVolts;					// scale of int16 samples to microvolts, resolution of float samples
+		uint32_t sourceNodeId;
+		uint32_t subProcessorIdx;
+		uint64_t capacity;				// frames in the ring
+		uint64_t dataOffset;			// capacity * numChannels samples
+		uint64_t timestampOffset;		// capacity int64 sample numbers
+		uint64_t ttlOffset;				// capacity uint64 TTL words
+		std::atomic<uint64_t> writeSequence;	// frames written since the writer started
+		std::atomic<uint64_t> writeReserve;		// frames written or being written
+	};
+
+	struct alignas(64) RegionHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t totalSize;
+		std::atomic<uint32_t> generation;
+		std::atomic<uint32_t> writerActive;	// 1 while acquisition is running
+		uint32_t numStreams;
+		uint32_t reserved;
+		uint64_t eventOffset;
+		uint64_t eventCapacity;				// bytes
+		std::atomic<uint64_t> eventWritePosition;
+		std::atomic<uint64_t> eventReserve;
+		ReaderSlot readers[maxReaders];
+		StreamHeader streams[maxStreams];
+	};
+
+	/** Start of every event record */
+	struct RecordHeader
+	{
+		uint32_t size;			// whole record, padded to 8 bytes
+		uint16_t type;			// RecordType
+		uint16_t stream;		// stream with the same source, or 0xffff if there is none
+		int64_t timestamp;		// sample number of the event
+	};
+
+	/** Followed by nothing */
+	struct TTLRecord
+	{
+		RecordHeader header;
+		uint16_t channel;
+		uint8_t state;
+		uint8_t reserved[5];
+		uint64_t word;			// state of all the lines of the event channel after the change
+	};
+
+	/** Followed by the null-terminated UTF-8 text */
+	struct TextRecord
+	{
+		RecordHeader header;
+	};
+
+	/** Followed by numChannels * numSamples float samples, one channel after the other, in microvolts */
+	struct SpikeRecord
+	{
+		RecordHeader header;
+		uint16_t electrode;		// index of the spike channel in the sink
+		uint16_t sortedId;
+		uint16_t numChannels;
+		uint16_t numSamples;
+	};
+
+	inline uint64_t alignTo64 (uint64_t size) { return (size + 63) & ~uint64_t (63); }
+	inline uint32_t alignTo8 (uint32_t size) { return (size + 7) & ~uint32_t (7); }
+}
+
+#endif  // SHAREDMEMORYLAYOUT_H_INCLUDED
@@ -0,0 +1,905 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SharedMemoryStream.h"
+
+#if JUCE_WINDOWS
+ #define NOMINMAX
+ #include <windows.h>
+#else
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <signal.h>
+ #include <errno.h>
+#endif
+
+using namespace SharedMemoryLayout;
+
+namespace
+{
+	uint32 getProcessId()
+	{
+#if JUCE_WINDOWS
+		return (uint32)GetCurrentProcessId();
+#else
+		return (uint32)getpid();
+#endif
+	}
+
+	/** True if the process that claimed a reader slot is gone without releasing it */
+	bool isProcessGone(uint32 processId)
+	{
+#if JUCE_WINDOWS
+		HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, processId);
+		if (process == NULL)
+			return GetLastError() == ERROR_INVALID_PARAMETER;
+		const bool exited = WaitForSingleObject(process, 0) == WAIT_OBJECT_0;
+		CloseHandle(process);
+		return exited;
+#else
+		return kill((pid_t)processId, 0) != 0 && errno == ESRCH;
+#endif
+	}
+
+	const int frameTile = 64;
+}
+
+//SharedMemoryRegion
+
+SharedMemoryRegion::SharedMemoryRegion()
+	: data(nullptr), size(0), isOwner(false)
+#if JUCE_WINDOWS
+	, handle(nullptr)
+#else
+	, fd(-1)
+#endif
+{
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+	close();
+}
+
+bool SharedMemoryRegion::create(const String& regionName, size_t regionSize)
+{
+	close();
+	name = regionName.trimCharactersAtStart("/");
+
+#if JUCE_WINDOWS
+	handle = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		(DWORD)((uint64)regionSize >> 32), (DWORD)(regionSize & 0xffffffff), ("Local\\" + name).toWideCharPointer());
+	if (handle == nullptr)
+	{
+		lastError = "can't create shared memory " + name + " (error " + String((int)GetLastError()) + ")";
+		return false;
+	}
+
+	data = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, regionSize);
+#else
+	const String posixName = "/" + name;
+
+	// a region left behind by a crashed session would keep its old size
+	shm_unlink(posixName.toRawUTF8());
+
+	fd = shm_open(posixName.toRawUTF8(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0 || ftruncate(fd, (off_t)regionSize) != 0)
+	{
+		lastError = "can't create shared memory " + posixName + ": " + String(strerror(errno));
+		close();
+		return false;
+	}
+
+	data = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED)
+		data = nullptr;
+#endif
+
+	isOwner = true;
+	size = regionSize;
+
+	if (data == nullptr)
+	{
+		lastError = "can't map shared memory " + name;
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool SharedMemoryRegion::open(const String& regionName)
+{
+	close();
+	name = regionName.trimCharactersAtStart("/");
+
+#if JUCE_WINDOWS
+	handle = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, ("Local\\" + name).toWideCharPointer());
+	if (handle == nullptr)
+	{
+		lastError = "shared memory " + name + " doesn't exist";
+		return false;
+	}
+
+	data = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if (data != nullptr)
+	{
+		MEMORY_BASIC_INFORMATION info;
+		VirtualQuery(data, &info, sizeof(info));
+		size = info.RegionSize;
+	}
+#else
+	const String posixName = "/" + name;
+
+	fd = shm_open(posixName.toRawUTF8(), O_RDWR, 0);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0)
+	{
+		lastError = "shared memory " + posixName + " doesn't exist";
+		close();
+		return false;
+	}
+
+	size = (size_t)info.st_size;
+	data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED)
+		data = nullptr;
+#endif
+
+	if (data == nullptr)
+	{
+		lastError = "can't map shared memory " + name;
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void SharedMemoryRegion::close()
+{
+#if JUCE_WINDOWS
+	if (data != nullptr)
+		UnmapViewOfFile(data);
+	if (handle != nullptr)
+		CloseHandle(handle);
+	handle = nullptr;
+#else
+	if (data != nullptr)
+		munmap(data, size);
+	if (fd >= 0)
+		::close(fd);
+	if (isOwner)
+		shm_unlink(("/" + name).toRawUTF8());
+	fd = -1;
+#endif
+
+	data = nullptr;
+	size = 0;
+	isOwner = false;
+}
+
+//SharedMemoryWriter
+
+SharedMemoryWriter::SharedMemoryWriter()
+	: header(nullptr), base(nullptr), eventPosition(0), pendingRecordSize(0), droppedEvents(0)
+{
+}
+
+SharedMemoryWriter::~SharedMemoryWriter()
+{
+	close();
+}
+
+bool SharedMemoryWriter::create(const String& name, const Array<StreamConfig>& streams, double ringSeconds, int eventCapacity)
+{
+	close();
+
+	const int numStreams = jmin(streams.size(), maxStreams);
+
+	// lay the rings out after the header
+	uint64 offset = alignTo64(sizeof(RegionHeader));
+	Array<uint64> capacities;
+
+	for (int i = 0; i < numStreams; i++)
+	{
+		const uint64 capacity = (uint64)jmax(1024.0, std::ceil(streams[i].sampleRate * ringSeconds));
+		capacities.add(capacity);
+		offset += alignTo64(capacity * streams[i].numChannels * sizeof(float));
+		offset += 2 * alignTo64(capacity * sizeof(int64));
+	}
+
+	const uint64 eventOffset = offset;
+	const uint64 eventBytes = alignTo64((uint64)jmax(4096, eventCapacity));
+
+	if (!region.create(name, (size_t)(eventOffset + eventBytes)))
+		return false;
+
+	base = static_cast<uint8*>(region.getData());
+	header = new (base) RegionHeader();
+
+	header->version = version;
+	header->totalSize = region.getSize();
+	header->numStreams = numStreams;
+	header->eventOffset = eventOffset;
+	header->eventCapacity = eventBytes;
+
+	offset = alignTo64(sizeof(RegionHeader));
+
+	for (int i = 0; i < numStreams; i++)
+	{
+		const StreamConfig& config = streams[i];
+		StreamHeader& stream = header->streams[i];
+
+		config.name.copyToUTF8(stream.name, nameLength);
+		stream.numChannels = config.numChannels;
+		stream.sampleFormat = FLOAT_SAMPLES;
+		stream.sampleRate = config.sampleRate;
+		stream.bitVolts = config.bitVolts;
+		stream.sourceNodeId = config.sourceNodeId;
+		stream.subProcessorIdx = config.subProcessorIdx;
+		stream.capacity = capacities[i];
+
+		stream.dataOffset = offset;
+		offset += alignTo64(stream.capacity * stream.numChannels * sizeof(float));
+		stream.timestampOffset = offset;
+		offset += alignTo64(stream.capacity * sizeof(int64));
+		stream.ttlOffset = offset;
+		offset += alignTo64(stream.capacity * sizeof(int64));
+	}
+
+	lastTTLWords.clearQuick();
+	lastTTLWords.insertMultiple(0, 0, numStreams);
+
+	// readers check the magic number last
+	std::atomic_thread_fence(std::memory_order_release);
+	header->magic = magic;
+
+	return true;
+}
+
+void SharedMemoryWriter::close()
+{
+	if (header != nullptr)
+	{
+		header->writerActive.store(0);
+		header->magic = 0;
+	}
+
+	header = nullptr;
+	base = nullptr;
+	region.close();
+}
+
+void SharedMemoryWriter::start()
+{
+	if (header == nullptr) return;
+
+	for (uint32 i = 0; i < header->numStreams; i++)
+	{
+		header->streams[i].writeReserve.store(0, std::memory_order_relaxed);
+		header->streams[i].writeSequence.store(0, std::memory_order_relaxed);
+		lastTTLWords.set(i, 0);
+	}
+
+	header->eventReserve.store(0, std::memory_order_relaxed);
+	header->eventWritePosition.store(0, std::memory_order_relaxed);
+	eventPosition = 0;
+	droppedEvents = 0;
+
+	header->generation.fetch_add(1, std::memory_order_release);
+	header->writerActive.store(1, std::memory_order_release);
+}
+
+void SharedMemoryWriter::stop()
+{
+	if (header != nullptr)
+		header->writerActive.store(0, std::memory_order_release);
+}
+
+void SharedMemoryWriter::writeFrames(int streamIndex, const float* const* channelData, int numFrames, int64 firstSampleNumber, const uint64* ttlWords)
+{
+	if (header == nullptr || streamIndex < 0 || streamIndex >= (int)header->numStreams || numFrames <= 0)
+		return;
+
+	StreamHeader& stream = header->streams[streamIndex];
+	const int numChannels = stream.numChannels;
+	const uint64 capacity = stream.capacity;
+	const uint64 sequence = stream.writeSequence.load(std::memory_order_relaxed);
+
+	float* const frames = reinterpret_cast<float*>(base + stream.dataOffset);
+	int64* const sampleNumbers = reinterpret_cast<int64*>(base + stream.timestampOffset);
+	uint64* const words = reinterpret_cast<uint64*>(base + stream.ttlOffset);
+	const uint64 lastWord = lastTTLWords[streamIndex];
+
+	// announce the frames about to be overwritten before touching them
+	stream.writeReserve.store(sequence + numFrames, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	int done = 0;
+	while (done < numFrames)
+	{
+		const uint64 index = (sequence + done) % capacity;
+		const int count = (int)jmin((uint64)(numFrames - done), capacity - index);
+
+		// interleave in tiles of frames, so the destination rows stay in the cache across channels
+		for (int tile = 0; tile < count; tile += frameTile)
+		{
+			const int tileLength = jmin(frameTile, count - tile);
+			float* const dest = frames + (index + tile) * numChannels;
+
+			for (int c = 0; c < numChannels; c++)
+			{
+				const float* src = channelData[c] + done + tile;
+				for (int i = 0; i < tileLength; i++)
+					dest[i * numChannels + c] = src[i];
+			}
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			sampleNumbers[index + i] = firstSampleNumber + done + i;
+			words[index + i] = ttlWords != nullptr ? ttlWords[done + i] : lastWord;
+		}
+
+		done += count;
+	}
+
+	if (ttlWords != nullptr)
+		lastTTLWords.set(streamIndex, ttlWords[numFrames - 1]);
+
+	stream.writeSequence.store(sequence + numFrames, std::memory_order_release);
+}
+
+uint8* SharedMemoryWriter::beginRecord(uint32 size, uint16 type, uint16 stream, int64 timestamp)
+{
+	if (header == nullptr)
+		return nullptr;
+
+	const uint64 capacity = header->eventCapacity;
+	size = alignTo8(size);
+
+	if (size > capacity)
+	{
+		++droppedEvents;
+		return nullptr;
+	}
+
+	uint64 offset = eventPosition % capacity;
+	uint64 padding = 0;
+
+	if (offset + size > capacity)
+	{
+		padding = capacity - offset;
+		offset = 0;
+	}
+
+	header->eventReserve.store(eventPosition + padding + size, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	uint8* const ring = base + header->eventOffset;
+
+	if (padding >= sizeof(RecordHeader))
+	{
+		RecordHeader* pad = reinterpret_cast<RecordHeader*>(ring + capacity - padding);
+		pad->size = (uint32)padding;
+		pad->type = PADDING_RECORD;
+		pad->stream = 0xffff;
+		pad->timestamp = 0;
+	}
+
+	eventPosition += padding;
+
+	RecordHeader* record = reinterpret_cast<RecordHeader*>(ring + offset);
+	record->size = size;
+	record->type = type;
+	record->stream = stream;
+	record->timestamp = timestamp;
+
+	pendingRecordSize = size;
+	return reinterpret_cast<uint8*>(record);
+}
+
+void SharedMemoryWriter::endRecord()
+{
+	eventPosition += pendingRecordSize;
+	header->eventWritePosition.store(eventPosition, std::memory_order_release);
+}
+
+void SharedMemoryWriter::writeTTL(int stream, int64 timestamp, int channel, bool state, uint64 word)
+{
+	TTLRecord* record = reinterpret_cast<TTLRecord*>(beginRecord(sizeof(TTLRecord), TTL_RECORD, (uint16)stream, timestamp));
+	if (record == nullptr) return;
+
+	record->channel = (uint16)channel;
+	record->state = state ? 1 : 0;
+	zeromem(record->reserved, sizeof(record->reserved));
+	record->word = word;
+
+	endRecord();
+}
+
+void SharedMemoryWriter::writeText(int stream, int64 timestamp, const String& text)
+{
+	const char* utf8 = text.toRawUTF8();
+	const uint32 length = (uint32)strlen(utf8) + 1;
+
+	uint8* record = beginRecord(sizeof(TextRecord) + length, TEXT_RECORD, (uint16)stream, timestamp);
+	if (record == nullptr) return;
+
+	memcpy(record + sizeof(TextRecord), utf8, length);
+
+	endRecord();
+}
+
+void SharedMemoryWriter::writeSpike(int stream, int64 timestamp, int electrode, uint16 sortedId, int numChannels, int numSamples, const float* waveform)
+{
+	const uint32 dataSize = (uint32)(numChannels * numSamples) * sizeof(float);
+
+	SpikeRecord* record = reinterpret_cast<SpikeRecord*>(beginRecord(sizeof(SpikeRecord) + dataSize, SPIKE_RECORD, (uint16)stream, timestamp));
+	if (record == nullptr) return;
+
+	record->electrode = (uint16)electrode;
+	record->sortedId = sortedId;
+	record->numChannels = (uint16)numChannels;
+	record->numSamples = (uint16)numSamples;
+	memcpy(record + 1, waveform, dataSize);
+
+	endRecord();
+}
+
+void SharedMemoryWriter::getReaderStats(Array<ReaderStats>& stats) const
+{
+	stats.clearQuick();
+
+	if (header == nullptr) return;
+
+	for (int r = 0; r < maxReaders; r++)
+	{
+		const ReaderSlot& slot = header->readers[r];
+		const uint32 processId = slot.active.load(std::memory_order_acquire);
+		if (processId == 0) continue;
+
+		ReaderStats s;
+		s.processId = processId;
+		s.overruns = slot.overruns.load(std::memory_order_relaxed);
+		s.lostFrames = slot.lostFrames.load(std::memory_order_relaxed);
+		s.lostEventBytes = slot.lostEventBytes.load(std::memory_order_relaxed);
+		s.maxLag = 0;
+
+		for (uint32 i = 0; i < header->numStreams; i++)
+		{
+			const int64 lag = (int64)(header->streams[i].writeSequence.load(std::memory_order_relaxed) - slot.streamCursors[i].load(std::memory_order_relaxed));
+			s.maxLag = jmax(s.maxLag, lag);
+		}
+
+		stats.add(s);
+	}
+}
+
+//SharedMemoryReader
+
+SharedMemoryReader::SharedMemoryReader()
+	: header(nullptr), slot(nullptr), base(nullptr), generation(0), eventCursor(0)
+{
+	zeromem(streamCursors, sizeof(streamCursors));
+}
+
+SharedMemoryReader::~SharedMemoryReader()
+{
+	close();
+}
+
+bool SharedMemoryReader::open(const String& name)
+{
+	close();
+
+	if (!region.open(name))
+	{
+		lastError = region.getLastError();
+		return false;
+	}
+
+	const RegionHeader* h = static_cast<const RegionHeader*>(region.getData());
+
+	if (region.getSize() < sizeof(RegionHeader) || h->magic != magic || h->version != version || h->totalSize > region.getSize())
+	{
+		lastError = "shared memory " + name + " has no open ephys streams";
+		region.close();
+		return false;
+	}
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	// claim a free slot, or one left behind by a reader that is gone
+	RegionHeader* writable = static_cast<RegionHeader*>(region.getData());
+	const uint32 processId = getProcessId();
+
+	for (int pass = 0; pass < 2 && slot == nullptr; pass++)
+	{
+		for (int r = 0; r < maxReaders && slot == nullptr; r++)
+		{
+			uint32 expected = 0;
+			if (pass == 1)
+			{
+				expected = writable->readers[r].active.load();
+				if (expected == 0 || !isProcessGone(expected)) continue;
+			}
+
+			if (writable->readers[r].active.compare_exchange_strong(expected, processId))
+				slot = &writable->readers[r];
+		}
+	}
+
+	if (slot == nullptr)
+	{
+		lastError = "too many readers of shared memory " + name;
+		region.close();
+		return false;
+	}
+
+	header = h;
+	base = static_cast<const uint8*>(region.getData());
+
+	slot->overruns.store(0);
+	slot->lostFrames.store(0);
+	slot->lostEventBytes.store(0);
+
+	// start from the data written from now on
+	skipToLatest();
+
+	return true;
+}
+
+void SharedMemoryReader::close()
+{
+	if (slot != nullptr)
+		slot->active.store(0, std::memory_order_release);
+
+	slot = nullptr;
+	header = nullptr;
+	base = nullptr;
+	region.close();
+}
+
+int SharedMemoryReader::getNumStreams() const
+{
+	return header != nullptr ? (int)header->numStreams : 0;
+}
+
+const StreamHeader* SharedMemoryReader::getStream(int stream) const
+{
+	if (stream < 0 || stream >= getNumStreams())
+		return nullptr;
+
+	return &header->streams[stream];
+}
+
+bool SharedMemoryReader::isWriterActive() const
+{
+	return isRegionValid() && header->writerActive.load(std::memory_order_acquire) != 0;
+}
+
+bool SharedMemoryReader::isRegionValid() const
+{
+	return header != nullptr && header->magic == magic;
+}
+
+void SharedMemoryReader::checkGeneration()
+{
+	const uint32 current = header->generation.load(std::memory_order_acquire);
+	if (current == generation) return;
+
+	// the writer restarted all its counters from zero
+	generation = current;
+	zeromem(streamCursors, sizeof(streamCursors));
+	eventCursor = 0;
+}
+
+int64 SharedMemoryReader::getNumAvailableFrames(int stream)
+{
+	if (getStream(stream) == nullptr)
+		return 0;
+
+	checkGeneration();
+
+	const uint64 written = header->streams[stream].writeSequence.load(std::memory_order_acquire);
+	if (written < streamCursors[stream])
+		return written;
+
+	return (int64)jmin(written - streamCursors[stream], (uint64)header->streams[stream].capacity);
+}
+
+void SharedMemoryReader::skipToLatest()
+{
+	if (header == nullptr)
+		return;
+
+	generation = header->generation.load(std::memory_order_acquire);
+
+	for (uint32 i = 0; i < header->numStreams; i++)
+	{
+		streamCursors[i] = header->streams[i].writeSequence.load(std::memory_order_acquire);
+		slot->streamCursors[i].store(streamCursors[i], std::memory_order_relaxed);
+	}
+
+	eventCursor = header->eventWritePosition.load(std::memory_order_acquire);
+	slot->eventCursor.store(eventCursor, std::memory_order_relaxed);
+}
+
+int SharedMemoryReader::beginRead(int streamIndex, int maxFrames)
+{
+	const StreamHeader& stream = header->streams[streamIndex];
+	const uint64 capacity = stream.capacity;
+	uint64& cursor = streamCursors[streamIndex];
+
+	const uint64 written = stream.writeSequence.load(std::memory_order_acquire);
+
+	if (written < cursor)
+		cursor = 0;
+
+	if (written - cursor > capacity)
+	{
+		slot->overruns.fetch_add(1, std::memory_order_relaxed);
+		slot->lostFrames.fetch_add(written - capacity - cursor, std::memory_order_relaxed);
+		cursor = written - capacity;
+	}
+
+	return (int)jmin((uint64)maxFrames, written - cursor);
+}
+
+int SharedMemoryReader::endRead(int streamIndex, int numFrames)
+{
+	const StreamHeader& stream = header->streams[streamIndex];
+	const uint64 capacity = stream.capacity;
+	uint64& cursor = streamCursors[streamIndex];
+
+	// drop what the writer may have overwritten while it was being copied
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint64 reserved = stream.writeReserve.load(std::memory_order_relaxed);
+	const uint64 firstValid = reserved > capacity ? reserved - capacity : 0;
+
+	int overwritten = 0;
+
+	if (cursor < firstValid)
+	{
+		overwritten = (int)jmin((uint64)numFrames, firstValid - cursor);
+
+		slot->overruns.fetch_add(1, std::memory_order_relaxed);
+		slot->lostFrames.fetch_add(overwritten, std::memory_order_relaxed);
+	}
+
+	cursor += numFrames;
+	slot->streamCursors[streamIndex].store(cursor, std::memory_order_relaxed);
+
+	return overwritten;
+}
+
+int SharedMemoryReader::readFrames(int streamIndex, float* data, int64* sampleNumbers, uint64* ttlWords, int maxFrames)
+{
+	const StreamHeader* stream = getStream(streamIndex);
+	if (stream == nullptr || maxFrames <= 0)
+		return 0;
+
+	checkGeneration();
+
+	const int numFrames = beginRead(streamIndex, maxFrames);
+	if (numFrames == 0)
+		return 0;
+
+	const uint64 capacity = stream->capacity;
+	const uint64 cursor = streamCursors[streamIndex];
+	const int numChannels = stream->numChannels;
+	const float scale = stream->bitVolts;
+	const int64* stampRing = reinterpret_cast<const int64*>(base + stream->timestampOffset);
+	const uint64* wordRing = reinterpret_cast<const uint64*>(base + stream->ttlOffset);
+
+	int done = 0;
+	while (done < numFrames)
+	{
+		const uint64 index = (cursor + done) % capacity;
+		const int count = (int)jmin((uint64)(numFrames - done), capacity - index);
+		const int numSamples = count * numChannels;
+		float* dest = data + (size_t)done * numChannels;
+
+		if (stream->sampleFormat == INT16_SAMPLES)
+		{
+			const int16* src = reinterpret_cast<const int16*>(base + stream->dataOffset) + index * numChannels;
+			for (int i = 0; i < numSamples; i++)
+				dest[i] = src[i] * scale;
+		}
+		else
+		{
+			memcpy(dest, reinterpret_cast<const float*>(base + stream->dataOffset) + index * numChannels, numSamples * sizeof(float));
+		}
+
+		memcpy(sampleNumbers + done, stampRing + index, count * sizeof(int64));
+		memcpy(ttlWords + done, wordRing + index, count * sizeof(uint64));
+
+		done += count;
+	}
+
+	const int overwritten = endRead(streamIndex, numFrames);
+	const int copied = numFrames - overwritten;
+
+	if (overwritten > 0)
+	{
+		memmove(data, data + (size_t)overwritten * numChannels, (size_t)copied * numChannels * sizeof(float));
+		memmove(sampleNumbers, sampleNumbers + overwritten, copied * sizeof(int64));
+		memmove(ttlWords, ttlWords + overwritten, copied * sizeof(uint64));
+	}
+
+	return copied;
+}
+
+int SharedMemoryReader::readFrames(int streamIndex, float* const* channelData, int64* sampleNumbers, uint64* ttlWords, int maxFrames)
+{
+	const StreamHeader* stream = getStream(streamIndex);
+	if (stream == nullptr || maxFrames <= 0)
+		return 0;
+
+	checkGeneration();
+
+	const int numFrames = beginRead(streamIndex, maxFrames);
+	if (numFrames == 0)
+		return 0;
+
+	const uint64 capacity = stream->capacity;
+	const uint64 cursor = streamCursors[streamIndex];
+	const int numChannels = stream->numChannels;
+	const float scale = stream->bitVolts;
+	const int64* stampRing = reinterpret_cast<const int64*>(base + stream->timestampOffset);
+	const uint64* wordRing = reinterpret_cast<const uint64*>(base + stream->ttlOffset);
+
+	int done = 0;
+	while (done < numFrames)
+	{
+		const uint64 index = (cursor + done) % capacity;
+		const int count = (int)jmin((uint64)(numFrames - done), capacity - index);
+
+		// deinterleave in tiles of frames, so the source rows stay in the cache across channels
+		for (int tile = 0; tile < count; tile += frameTile)
+		{
+			const int tileLength = jmin(frameTile, count - tile);
+			const int offset = done + tile;
+
+			if (stream->sampleFormat == INT16_SAMPLES)
+			{
+				const int16* src = reinterpret_cast<const int16*>(base + stream->dataOffset) + (index + tile) * numChannels;
+
+				for (int c = 0; c < numChannels; c++)
+				{
+					float* dest = channelData[c] + offset;
+					for (int i = 0; i < tileLength; i++)
+						dest[i] = src[i * numChannels + c] * scale;
+				}
+			}
+			else
+			{
+				const float* src = reinterpret_cast<const float*>(base + stream->dataOffset) + (index + tile) * numChannels;
+
+				for (int c = 0; c < numChannels; c++)
+				{
+					float* dest = channelData[c] + offset;
+					for (int i = 0; i < tileLength; i++)
+						dest[i] = src[i * numChannels + c];
+				}
+			}
+		}
+
+		memcpy(sampleNumbers + done, stampRing + index, count * sizeof(int64));
+		memcpy(ttlWords + done, wordRing + index, count * sizeof(uint64));
+
+		done += count;
+	}
+
+	const int overwritten = endRead(streamIndex, numFrames);
+	const int copied = numFrames - overwritten;
+
+	if (overwritten > 0)
+	{
+		for (int c = 0; c < numChannels; c++)
+			memmove(channelData[c], channelData[c] + overwritten, copied * sizeof(float));
+
+		memmove(sampleNumbers, sampleNumbers + overwritten, copied * sizeof(int64));
+		memmove(ttlWords, ttlWords + overwritten, copied * sizeof(uint64));
+	}
+
+	return copied;
+}
+
+bool SharedMemoryReader::readEvent(MemoryBlock& record)
+{
+	if (header == nullptr)
+		return false;
+
+	checkGeneration();
+
+	const uint64 capacity = header->eventCapacity;
+	const uint8* ring = base + header->eventOffset;
+
+	for (;;)
+	{
+		const uint64 written = header->eventWritePosition.load(std::memory_order_acquire);
+
+		if (written < eventCursor)
+			eventCursor = 0;
+
+		if (written == eventCursor)
+			return false;
+
+		bool lapped = written - eventCursor > capacity;
+		const uint64 offset = eventCursor % capacity;
+		const uint64 remaining = capacity - offset;
+		RecordHeader recordHeader;
+
+		if (!lapped)
+		{
+			if (remaining < sizeof(RecordHeader))
+			{
+				eventCursor += remaining;
+				continue;
+			}
+
+			memcpy(&recordHeader, ring + offset, sizeof(RecordHeader));
+
+			if (recordHeader.size >= sizeof(RecordHeader) && recordHeader.size <= remaining && recordHeader.type != PADDING_RECORD)
+				record.replaceWith(ring + offset, recordHeader.size);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const uint64 reserved = header->eventReserve.load(std::memory_order_relaxed);
+			lapped = reserved > capacity && eventCursor < reserved - capacity;
+
+			// a record that makes no sense was overwritten halfway
+			lapped = lapped || recordHeader.size < sizeof(RecordHeader) || recordHeader.size > remaining;
+		}
+
+		if (lapped)
+		{
+			// no way to find the next record boundary: skip everything written so far
+			slot->overruns.fetch_add(1, std::memory_order_relaxed);
+			slot->lostEventBytes.fetch_add(written - eventCursor, std::memory_order_relaxed);
+			eventCursor = written;
+			slot->eventCursor.store(eventCursor, std::memory_order_relaxed);
+			continue;
+		}
+
+		eventCursor += recordHeader.size;
+		slot->eventCursor.store(eventCursor, std::memory_order_relaxed);
+
+		if (recordHeader.type != PADDING_RECORD)
+			return true;
+	}
+}
+
+uint64 SharedMemoryReader::getOverruns() const
+{
+	return slot != nullptr ? slot->overruns.load(std::memory_order_relaxed) : 0;
+}
+
+uint64 SharedMemoryReader::getLostFrames() const
+{
+	return slot != nullptr ? slot->lostFrames.load(std::memory_order_relaxed) : 0;
+}
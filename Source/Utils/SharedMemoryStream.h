@@ -0,0 +1,219 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2019 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SHAREDMEMORYSTREAM_H_INCLUDED
+#define SHAREDMEMORYSTREAM_H_INCLUDED
+
+#include "../../JuceLibraryCode/JuceHeader.h"
+#include "../Processors/PluginManager/OpenEphysPlugin.h"
+#include "SharedMemoryLayout.h"
+
+/**
+	Named shared memory: a POSIX shm object, or a file mapping backed by the paging file on Windows.
+*/
+class PLUGIN_API SharedMemoryRegion
+{
+public:
+	SharedMemoryRegion();
+	~SharedMemoryRegion();
+
+	/** Creates a region of the given size, replacing any other region with the same name.
+	The region is removed when this object closes it */
+	bool create(const String& name, size_t size);
+
+	/** Maps a region created by another object or process */
+	bool open(const String& name);
+
+	void close();
+
+	bool isOpen() const { return data != nullptr; }
+	void* getData() const { return data; }
+	size_t getSize() const { return size; }
+
+	String getLastError() const { return lastError; }
+
+private:
+	String name;
+	void* data;
+	size_t size;
+	bool isOwner;
+	String lastError;
+
+#if JUCE_WINDOWS
+	void* handle;
+#else
+	int fd;
+#endif
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedMemoryRegion);
+};
+
+/**
+	Publishes continuous data and events to a shared-memory region, following SharedMemoryLayout.
+
+	Written from the processing thread: nothing here blocks, allocates or looks at the readers,
+	so readers that stall only lose data themselves.
+
+	@see SharedMemoryReader
+*/
+class PLUGIN_API SharedMemoryWriter
+{
+public:
+	struct StreamConfig
+	{
+		String name;
+		int numChannels;
+		float sampleRate;
+		float bitVolts;
+		uint32 sourceNodeId;
+		uint32 subProcessorIdx;
+	};
+
+	struct ReaderStats
+	{
+		uint32 processId;
+		uint64 overruns;
+		uint64 lostFrames;
+		uint64 lostEventBytes;
+		int64 maxLag;		//!< Frames written but not read yet, in the stream the reader is furthest behind
+	};
+
+	SharedMemoryWriter();
+	~SharedMemoryWriter();
+
+	/** Lays out the region for the given streams, with rings holding ringSeconds of data
+	and eventCapacity bytes of events */
+	bool create(const String& name, const Array<StreamConfig>& streams, double ringSeconds, int eventCapacity);
+	void close();
+	bool isOpen() const { return header != nullptr; }
+
+	String getLastError() const { return region.getLastError(); }
+
+	/** Starts a new generation: rings restart from zero and readers drop their cursors */
+	void start();
+	void stop();
+
+	/** Writes numFrames frames of float samples, one pointer per channel of the stream.
+	ttlWords can be null to repeat the last word written */
+	void writeFrames(int stream, const float* const* channelData, int numFrames, int64 firstSampleNumber, const uint64* ttlWords);
+
+	void writeTTL(int stream, int64 timestamp, int channel, bool state, uint64 word);
+	void writeText(int stream, int64 timestamp, const String& text);
+	void writeSpike(int stream, int64 timestamp, int electrode, uint16 sortedId, int numChannels, int numSamples, const float* waveform);
+
+	/** Number of events that didn't fit in the ring at all */
+	int64 getNumDroppedEvents() const { return droppedEvents; }
+
+	void getReaderStats(Array<ReaderStats>& stats) const;
+
+private:
+	/** Returns space for a record of the given size, or nullptr if it can never fit */
+	uint8* beginRecord(uint32 size, uint16 type, uint16 stream, int64 timestamp);
+	void endRecord();
+
+	SharedMemoryRegion region;
+	SharedMemoryLayout::RegionHeader* header;
+	uint8* base;
+
+	Array<uint64> lastTTLWords;
+	uint64 eventPosition;
+	uint32 pendingRecordSize;
+	int64 droppedEvents;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedMemoryWriter);
+};
+
+/**
+	Reads a region published by a SharedMemoryWriter or by an external process following
+	SharedMemoryLayout. Each reader claims its own slot, so any number of them, up to
+	SharedMemoryLayout::maxReaders, can follow the same region at their own pace.
+*/
+class PLUGIN_API SharedMemoryReader
+{
+public:
+	SharedMemoryReader();
+	~SharedMemoryReader();
+
+	bool open(const String& name);
+	void close();
+	bool isOpen() const { return header != nullptr; }
+
+	String getLastError() const { return lastError; }
+
+	int getNumStreams() const;
+	const SharedMemoryLayout::StreamHeader* getStream(int stream) const;
+
+	/** True while the writer is acquiring */
+	bool isWriterActive() const;
+
+	/** False once the writer has closed the region. A writer that starts over creates a new
+	region, which has to be opened again */
+	bool isRegionValid() const;
+
+	/** Copies up to maxFrames of the oldest unread frames of a stream, as interleaved floats
+	scaled to microvolts, with their sample numbers and TTL words. Frames overwritten
+	before they could be read are skipped and counted in the reader slot.
+	Returns the number of frames copied */
+	int readFrames(int stream, float* data, int64* sampleNumbers, uint64* ttlWords, int maxFrames);
+
+	/** Same as above, but writes each channel to its own array, so the frames can go
+	straight into per-channel buffers such as a DataBuffer */
+	int readFrames(int stream, float* const* channelData, int64* sampleNumbers, uint64* ttlWords, int maxFrames);
+
+	/** Number of unread frames of a stream */
+	int64 getNumAvailableFrames(int stream);
+
+	/** Skips every frame and event written so far */
+	void skipToLatest();
+
+	/** Copies the next event record into the given block. Returns false if there is none */
+	bool readEvent(MemoryBlock& record);
+
+	uint64 getOverruns() const;
+	uint64 getLostFrames() const;
+
+private:
+	/** Drops every cursor if the writer restarted */
+	void checkGeneration();
+
+	/** Skips the frames already overwritten and returns how many of the next ones can be read */
+	int beginRead(int stream, int maxFrames);
+
+	/** Moves the cursor past numFrames frames that have been copied, and returns how many of the
+	first ones the writer may have overwritten in the meantime */
+	int endRead(int stream, int numFrames);
+
+	SharedMemoryRegion region;
+	const SharedMemoryLayout::RegionHeader* header;
+	SharedMemoryLayout::ReaderSlot* slot;
+	const uint8* base;
+
+	uint32 generation;
+	uint64 streamCursors[SharedMemoryLayout::maxStreams];
+	uint64 eventCursor;
+	String lastError;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedMemoryReader);
+};
+
+#endif  // SHAREDMEMORYSTREAM_H_INCLUDED